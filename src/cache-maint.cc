@@ -35,9 +35,12 @@
 #include "layout.h"
 #include "main-defines.h"
 #include "main.h"
+#include "metadata-index.h"
 #include "misc.h"
 #include "options.h"
 #include "pixbuf-util.h"
+#include "thumb-index.h"
+#include "thumb-pack.h"
 #include "thumb-standard.h"
 #include "thumb.h"
 #include "ui-fileops.h"
@@ -109,10 +112,20 @@ struct CacheOpsData
 
 	gboolean remote;
 
+	GList *tl_list; /* running thumbnail loaders */
+	gint jobs; /* maximum number of running thumbnail loaders */
+
+	gint count_rendered;
+	gint count_skipped;
+	gint count_failed;
+	goffset bytes; /* size of the rendered source files */
+	gint64 start_time;
+
 	guint idle_id; /* event source id */
 };
 
 constexpr gint PURGE_DIALOG_WIDTH = 400;
+constexpr guint CACHE_MANAGER_RENDER_MAX_JOBS = 16; /**< default upper limit of parallel thumbnail loaders */
 
 /* sorry for complexity (cm->done_list), but need it to remove empty dirs */
 CMData *cache_maintain_data_new(gboolean clear, gboolean metadata, gboolean remote)
@@ -156,6 +169,7 @@ void cache_maintain_home_close(CMData *cm)
  *-----------------------------------------------------------------------------
  */
 static gchar *cache_maintenance_path = nullptr;
+static gint cache_maintenance_jobs = 0;
 
 static void cache_manager_sim_remote(GtkApplication *app, const gchar *path, gboolean recurse, GSourceFunc destroy_func);
 
@@ -167,6 +181,12 @@ static gboolean cache_maintenance_sim_stop_cb(gpointer data)
 
 	g_free(data);
 
+	/* exit() skips the flush in exit_program_final() */
+	cache_sim_pack_flush();
+	thumb_pack_flush();
+	thumb_index_flush();
+	metadata_index_flush();
+
 	exit(EXIT_SUCCESS);
 }
 
@@ -187,12 +207,13 @@ static void cache_maintenance_clean_stop_cb(gpointer data)
 
 
 	cache_maintenance_notification(cm->app,  _("Creating thumbs…"), TRUE);
-	cache_manager_render_remote(cm->app, cache_maintenance_path, TRUE, options->thumbnails.cache_into_dirs, cache_maintenance_render_stop_cb);
+	cache_manager_render_remote(cm->app, cache_maintenance_path, TRUE, options->thumbnails.cache_into_dirs, cache_maintenance_jobs, cache_maintenance_render_stop_cb);
 }
 
-void cache_maintenance(GtkApplication *app, const gchar *path)
+void cache_maintenance(GtkApplication *app, const gchar *path, gint jobs)
 {
 	cache_maintenance_path = g_strdup(path);
+	cache_maintenance_jobs = jobs;
 
 	cache_maintenance_notification(app, _("Cleaning thumbs and sims…"), TRUE);
 
@@ -290,11 +311,22 @@ static gboolean cache_maintain_home_cb(gpointer data)
 
 				gchar *dot = strrchr(path_buf, '.');
 
+				/* The similarity and thumbnail packs belong to the folder, not to a file */
+				const gboolean is_pack = (strcmp(fd_list->name, GQ_CACHE_SIM_PACK) == 0 ||
+				                          strcmp(fd_list->name, GQ_CACHE_THUMB_PACK_NORMAL) == 0 ||
+				                          strcmp(fd_list->name, GQ_CACHE_THUMB_PACK_LARGE) == 0 ||
+				                          strcmp(fd_list->name, GQ_CACHE_THUMB_INDEX) == 0 ||
+				                          strcmp(fd_list->name, GQ_CACHE_METADATA_INDEX) == 0);
+				if (is_pack)
+					{
+					dot = strrchr(path_buf, G_DIR_SEPARATOR);
+					}
+
 				if (dot) *dot = '\0';
 				if ((!cm->metadata && cm->clear) ||
-				    (strlen(path_buf) > base_length && !isfile(path_buf + base_length)) )
+				    (strlen(path_buf) > base_length && !(is_pack ? isdir(path_buf + base_length) : isfile(path_buf + base_length))) )
 					{
-					if (dot) *dot = '.';
+					if (dot) *dot = is_pack ? G_DIR_SEPARATOR : '.';
 					if (!unlink_file(path_buf)) log_printf("failed to delete:%s\n", path_buf);
 					}
 				else
@@ -477,7 +509,10 @@ static void cache_maint_moved(FileData *fd)
 	cache_move(CacheType::METADATA);
 
 	if (options->thumbnails.enable_caching && options->thumbnails.spec_standard)
+		{
+		if (options->thumbnails.pack_store) thumb_pack_moved(src, dest);
 		thumb_std_maint_moved(src, dest);
+		}
 }
 
 static void cache_maint_removed(FileData *fd)
@@ -554,8 +589,8 @@ static void cache_manager_render_reset(CacheOpsData *cd)
 	file_data_list_free(cd->list_dir);
 	cd->list_dir = nullptr;
 
-	thumb_loader_free(reinterpret_cast<ThumbLoader *>(cd->tl));
-	cd->tl = nullptr;
+	g_list_free_full(cd->tl_list, reinterpret_cast<GDestroyNotify>(thumb_loader_free));
+	cd->tl_list = nullptr;
 }
 
 static void cache_manager_render_close_cb(GenericDialog *, gpointer data)
@@ -572,7 +607,16 @@ static void cache_manager_render_close_cb(GenericDialog *, gpointer data)
 static void cache_manager_render_finish(CacheOpsData *cd)
 {
 	cache_manager_render_reset(cd);
-	if (!cd->remote)
+	if (cd->remote)
+		{
+		const gdouble seconds = MAX(g_get_monotonic_time() - cd->start_time, 1) / static_cast<gdouble>(G_USEC_PER_SEC);
+
+		log_printf("Thumbnails rendered: %d, skipped: %d, failed: %d\n", cd->count_rendered, cd->count_skipped, cd->count_failed);
+		log_printf("Time: %.1f s, %.1f files/s, %.1f MB/s, %d parallel jobs\n", seconds,
+		           (cd->count_rendered + cd->count_failed) / seconds,
+		           cd->bytes / seconds / (1024 * 1024), cd->jobs);
+		}
+	else
 		{
 		gq_gtk_entry_set_text(GTK_ENTRY(cd->progress), _("done"));
 		gtk_spinner_stop(GTK_SPINNER(cd->spinner));
@@ -618,68 +662,122 @@ static void cache_manager_render_folder(CacheOpsData *cd, FileData *dir_fd)
 	cd->list_dir = g_list_concat(list_d, cd->list_dir);
 }
 
-static gboolean cache_manager_render_file(CacheOpsData *cd);
+/**
+ * @brief Check for a valid thumbnail of fd without loading anything
+ */
+static gboolean cache_manager_render_cache_valid(const CacheOpsData *cd, const FileData *fd)
+{
+	if (!options->thumbnails.enable_caching) return FALSE;
+
+	if (options->thumbnails.spec_standard)
+		{
+		return thumb_std_maint_cache_time_valid(fd->path, options->thumbnails.max_width, options->thumbnails.max_height, cd->local);
+		}
+
+	g_autofree gchar *cache_path = cache_find_location(CacheType::THUMB, fd->path);
+
+	return cache_time_valid(cache_path, fd->path);
+}
+
+static void cache_manager_render_fill(CacheOpsData *cd);
+
+static void cache_manager_render_thumb_done(ThumbLoader *tl, CacheOpsData *cd)
+{
+	cd->tl_list = g_list_remove(cd->tl_list, tl);
+	thumb_loader_free(tl);
+
+	cache_manager_render_fill(cd);
+}
 
-static void cache_manager_render_thumb_done_cb(ThumbLoader *, gpointer data)
+static void cache_manager_render_thumb_done_cb(ThumbLoader *tl, gpointer data)
 {
 	auto cd = static_cast<CacheOpsData *>(data);
 
-	thumb_loader_free(reinterpret_cast<ThumbLoader *>(cd->tl));
-	cd->tl = nullptr;
+	cd->count_rendered++;
+	cache_manager_render_thumb_done(tl, cd);
+}
 
-	while (cache_manager_render_file(cd));
+static void cache_manager_render_thumb_error_cb(ThumbLoader *tl, gpointer data)
+{
+	auto cd = static_cast<CacheOpsData *>(data);
+
+	cd->count_failed++;
+	cache_manager_render_thumb_done(tl, cd);
 }
 
-static gboolean cache_manager_render_file(CacheOpsData *cd)
+static void cache_manager_render_file(CacheOpsData *cd, FileData *fd)
 {
-	if (cd->list)
+	if (!cd->remote)
 		{
-		FileData *fd;
-		gint success;
+		gq_gtk_entry_set_text(GTK_ENTRY(cd->progress), fd->path);
+		cd->count_done = cd->count_done + 1;
+		gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(cd->progress_bar), static_cast<gdouble>(cd->count_done) / cd->count_total);
+		}
 
-		fd = static_cast<FileData *>(cd->list->data);
-		cd->list = g_list_remove(cd->list, fd);
+	if (cache_manager_render_cache_valid(cd, fd))
+		{
+		cd->count_skipped++;
+		return;
+		}
 
-		cd->tl = reinterpret_cast<ThumbLoaderStd *>(thumb_loader_new(options->thumbnails.max_width, options->thumbnails.max_height));
-		thumb_loader_set_callbacks(reinterpret_cast<ThumbLoader *>(cd->tl),
-					   cache_manager_render_thumb_done_cb,
-					   cache_manager_render_thumb_done_cb,
-					   nullptr, cd);
-		thumb_loader_set_cache(reinterpret_cast<ThumbLoader *>(cd->tl), TRUE, cd->local, TRUE);
-		success = thumb_loader_start(reinterpret_cast<ThumbLoader *>(cd->tl), fd);
-		if (success)
-			{
-			if (!cd->remote)
-				{
-				gq_gtk_entry_set_text(GTK_ENTRY(cd->progress), fd->path);
-				cd->count_done = cd->count_done + 1;
-				gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(cd->progress_bar), static_cast<gdouble>(cd->count_done) / cd->count_total);
-				}
-			}
-		else
-			{
-			thumb_loader_free(reinterpret_cast<ThumbLoader *>(cd->tl));
-			cd->tl = nullptr;
-			}
+	ThumbLoader *tl = thumb_loader_new(options->thumbnails.max_width, options->thumbnails.max_height);
+	thumb_loader_set_callbacks(tl,
+				   cache_manager_render_thumb_done_cb,
+				   cache_manager_render_thumb_error_cb,
+				   nullptr, cd);
+	thumb_loader_set_cache(tl, TRUE, cd->local, TRUE);
+	thumb_loader_set_store_only(tl);
 
-		file_data_unref(fd);
+	/* the loader must be in the list if it calls back before returning */
+	cd->tl_list = g_list_prepend(cd->tl_list, tl);
+	cd->bytes += fd->size;
 
-		return (!success);
+	if (!thumb_loader_start(tl, fd))
+		{
+		cd->count_failed++;
+		cd->tl_list = g_list_remove(cd->tl_list, tl);
+		thumb_loader_free(tl);
 		}
-	if (cd->list_dir)
+}
+
+/**
+ * @brief Start thumbnail loaders until cd->jobs of them are running
+ *
+ * The images are decoded by the image loader threads, then scaled and
+ * written out by the thumbnail store workers, so this renders cd->jobs
+ * thumbnails in parallel. When all files are done the render is finished
+ * and cd->destroy_func is called.
+ */
+static void cache_manager_render_fill(CacheOpsData *cd)
+{
+	while (g_list_length(cd->tl_list) < static_cast<guint>(cd->jobs))
 		{
-		FileData *fd;
+		if (cd->list)
+			{
+			auto *fd = static_cast<FileData *>(cd->list->data);
+			cd->list = g_list_delete_link(cd->list, cd->list);
 
-		fd = static_cast<FileData *>(cd->list_dir->data);
-		cd->list_dir = g_list_remove(cd->list_dir, fd);
+			cache_manager_render_file(cd, fd);
 
-		cache_manager_render_folder(cd, fd);
+			file_data_unref(fd);
+			}
+		else if (cd->list_dir)
+			{
+			auto *fd = static_cast<FileData *>(cd->list_dir->data);
+			cd->list_dir = g_list_delete_link(cd->list_dir, cd->list_dir);
 
-		file_data_unref(fd);
+			cache_manager_render_folder(cd, fd);
 
-		return TRUE;
+			file_data_unref(fd);
+			}
+		else
+			{
+			break;
+			}
 		}
 
+	if (cd->tl_list) return;
+
 	if (!cd->remote)
 		{
 		gq_gtk_entry_set_text(GTK_ENTRY(cd->progress), _("done"));
@@ -690,8 +788,13 @@ static gboolean cache_manager_render_file(CacheOpsData *cd)
 		{
 		g_idle_add(cd->destroy_func, cd);
 		}
+}
 
-	return FALSE;
+static gint cache_manager_render_jobs(gint jobs)
+{
+	if (jobs > 0) return jobs;
+
+	return static_cast<gint>(CLAMP(g_get_num_processors(), 1, CACHE_MANAGER_RENDER_MAX_JOBS));
 }
 
 static void cache_manager_render_start_cb(GenericDialog *, gpointer data)
@@ -739,8 +842,9 @@ static void cache_manager_render_start_cb(GenericDialog *, gpointer data)
 		file_data_unref(dir_fd);
 		g_list_free(list_total);
 		cd->count_done = 0;
+		cd->jobs = cache_manager_render_jobs(0);
 
-		while (cache_manager_render_file(cd));
+		cache_manager_render_fill(cd);
 		}
 }
 
@@ -760,8 +864,9 @@ static void cache_manager_render_start_render_remote(CacheOpsData *cd, const gch
 		dir_fd = file_data_new_dir(path);
 		cache_manager_render_folder(cd, dir_fd);
 		file_data_unref(dir_fd);
-		while (cache_manager_render_file(cd))
-			;
+
+		cd->start_time = g_get_monotonic_time();
+		cache_manager_render_fill(cd);
 		}
 }
 
@@ -832,11 +937,13 @@ static void cache_manager_render_dialog(GtkWidget *widget, const gchar *path)
  * @param path Path to image folder
  * @param recurse
  * @param local Create thumbnails in same folder as images
+ * @param jobs Number of thumbnails rendered in parallel, 0 for the number of processors
  * @param destroy_func Function called when idle loop function terminates
  *
- *
+ * Files with a thumbnail newer than the file are skipped. When done,
+ * the number of rendered files and the throughput are printed.
  */
-void cache_manager_render_remote(GtkApplication *app, const gchar *path, gboolean recurse, gboolean local, GSourceFunc destroy_func)
+void cache_manager_render_remote(GtkApplication *app, const gchar *path, gboolean recurse, gboolean local, gint jobs, GSourceFunc destroy_func)
 {
 	CacheOpsData *cd;
 
@@ -844,6 +951,7 @@ void cache_manager_render_remote(GtkApplication *app, const gchar *path, gboolea
 	cd->recurse = recurse;
 	cd->local = local;
 	cd->remote = TRUE;
+	cd->jobs = cache_manager_render_jobs(jobs);
 	cd->destroy_func = destroy_func;
 	cd->app = app;
 
@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "cache-store.h"
+
+#include <cstring>
+
+#include "cache.h"
+#include "debug.h"
+#include "ui-fileops.h"
+
+/**
+ * @file
+ *
+ * The similarity pack, the thumbnail packs, the thumbnail validation index
+ * and the metadata index each keep one file per source folder, placed in
+ * the Geeqie thumbnail cache folder of the source folder.
+ *
+ * A file is opened when it is first used and kept open for the session.
+ * Changes are kept in memory and written out a few seconds after the last
+ * change, so that a run of changes, like the thumbnails of a new folder,
+ * is written once, and on exit. Entries of source files that have gone are
+ * dropped when a file is first written out in a session, so each source is
+ * checked once per session instead of at every write.
+ */
+
+namespace
+{
+
+struct CacheTableHeader
+{
+	gchar magic[8];
+	guint32 version;
+	guint32 app_version_hash;
+	guint32 record_size;
+	guint32 record_count;
+	guint32 strings_offset;
+	guint32 strings_size;
+};
+
+static_assert(sizeof(CacheTableHeader) == 32, "cache table header must not be padded");
+
+} // namespace
+
+/*
+ *-------------------------------------------------------------------
+ * store
+ *-------------------------------------------------------------------
+ */
+
+CacheStoreFile::CacheStoreFile(const gchar *path, const gchar *source_dir)
+	: path(g_strdup(path))
+	, source_dir(g_strdup(source_dir))
+{
+}
+
+CacheStoreFile::~CacheStoreFile()
+{
+	g_free(path);
+	g_free(source_dir);
+}
+
+void CacheStoreFile::flush()
+{
+	if (!changed()) return;
+
+	write_out(!pruned);
+	pruned = true;
+}
+
+bool CacheStoreFile::source_exists(const gchar *name) const
+{
+	g_autofree gchar *source = g_build_filename(source_dir, name, NULL);
+
+	return isfile(source);
+}
+
+CacheStore::CacheStore(CacheStoreFactory factory, guint flush_delay)
+	: factory(factory)
+	, flush_delay(flush_delay)
+{
+}
+
+/**
+ * @brief Get the file for the folder of a source file
+ * @param source file name of a source file
+ * @param file_name name of the cache file
+ * @param create TRUE to create the cache folder, and to open the file even if it does not exist yet
+ * @returns the file, nullptr if there is none
+ */
+CacheStoreFile *CacheStore::get(const gchar *source, const gchar *file_name, gboolean create)
+{
+	g_autofree gchar *base = nullptr;
+
+	if (create)
+		{
+		base = cache_create_location(CacheType::THUMB, source);
+		}
+	else
+		{
+		g_autofree gchar *cache_path = cache_get_location(CacheType::THUMB, source);
+		if (cache_path) base = remove_level_from_path(cache_path);
+		}
+	if (!base) return nullptr;
+
+	g_autofree gchar *path = g_build_filename(base, file_name, NULL);
+
+	auto it = files.find(path);
+	if (it == files.end())
+		{
+		/* Files are created through the store, so a missing file is looked for once */
+		if (!create && (missing.count(path) > 0 || !isfile(path)))
+			{
+			missing.insert(path);
+			return nullptr;
+			}
+		missing.erase(path);
+
+		g_autofree gchar *source_dir = remove_level_from_path(source);
+		it = files.emplace(path, factory(path, source_dir)).first;
+		}
+
+	return it->second;
+}
+
+/**
+ * @brief Schedule a flush, after a file has been changed
+ *
+ * Each change postpones the flush again.
+ */
+void CacheStore::changed()
+{
+	g_clear_handle_id(&flush_id, g_source_remove);
+	flush_id = g_timeout_add_seconds(flush_delay, flush_cb, this);
+}
+
+gboolean CacheStore::flush_cb(gpointer data)
+{
+	auto *store = static_cast<CacheStore *>(data);
+
+	g_mutex_lock(&store->mutex);
+	store->flush_id = 0;
+	g_mutex_unlock(&store->mutex);
+
+	store->flush();
+
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief Write out the changed files
+ */
+void CacheStore::flush()
+{
+	g_mutex_lock(&mutex);
+
+	g_clear_handle_id(&flush_id, g_source_remove);
+
+	for (auto &[path, file] : files)
+		{
+		file->flush();
+		}
+
+	g_mutex_unlock(&mutex);
+}
+
+/**
+ * @brief Write out the changed files, and close all files
+ */
+void CacheStore::close()
+{
+	g_mutex_lock(&mutex);
+
+	g_clear_handle_id(&flush_id, g_source_remove);
+
+	for (auto &[path, file] : files)
+		{
+		file->flush();
+		delete file;
+		}
+	files.clear();
+	missing.clear();
+
+	g_mutex_unlock(&mutex);
+}
+
+/*
+ *-------------------------------------------------------------------
+ * table file
+ *-------------------------------------------------------------------
+ */
+
+CacheTable::CacheTable(const CacheTableFormat &format, const gchar *path)
+	: format(format)
+	, path(g_strdup(path))
+{
+	map();
+}
+
+CacheTable::~CacheTable()
+{
+	unmap();
+	g_free(path);
+}
+
+void CacheTable::unmap()
+{
+	if (mapped) g_mapped_file_unref(mapped);
+	mapped = nullptr;
+	records = nullptr;
+	record_count = 0;
+	strings = nullptr;
+	strings_size = 0;
+}
+
+/**
+ * @brief Map the file again, it is taken as empty if it is missing or not valid
+ */
+void CacheTable::map()
+{
+	unmap();
+
+	g_autofree gchar *pathl = path_from_utf8(path);
+	mapped = g_mapped_file_new(pathl, FALSE, nullptr);
+	if (!mapped) return;
+
+	const gchar *data = g_mapped_file_get_contents(mapped);
+	const gsize length = g_mapped_file_get_length(mapped);
+	CacheTableHeader header;
+
+	if (length < sizeof(header))
+		{
+		DEBUG_1("%s is not a %s", path, format.description);
+		return;
+		}
+	memcpy(&header, data, sizeof(header));
+
+	const guint32 count = GUINT32_FROM_LE(header.record_count);
+	const guint32 offset = GUINT32_FROM_LE(header.strings_offset);
+	const guint32 size = GUINT32_FROM_LE(header.strings_size);
+
+	if (memcmp(header.magic, format.magic, sizeof(header.magic)) != 0 ||
+	    GUINT32_FROM_LE(header.version) != format.version ||
+	    GUINT32_FROM_LE(header.app_version_hash) != format.app_version_hash ||
+	    GUINT32_FROM_LE(header.record_size) != format.record_size ||
+	    offset != sizeof(header) + (static_cast<gsize>(count) * format.record_size) ||
+	    static_cast<gsize>(offset) + size > length ||
+	    (size > 0 && data[offset + size - 1] != '\0'))
+		{
+		DEBUG_1("%s is not a valid %s", path, format.description);
+		return;
+		}
+
+	records = data + sizeof(header);
+	record_count = count;
+	strings = data + offset;
+	strings_size = size;
+}
+
+const gchar *CacheTable::string_at(guint32 offset) const
+{
+	if (offset >= strings_size) return "";
+
+	return strings + offset;
+}
+
+const gchar *CacheTable::name(guint32 i) const
+{
+	guint32 name_offset;
+	memcpy(&name_offset, records + (static_cast<gsize>(i) * format.record_size), sizeof(name_offset));
+
+	return string_at(GUINT32_FROM_LE(name_offset));
+}
+
+/**
+ * @returns the index of the record of name, -1 if there is none
+ */
+gint CacheTable::find(const gchar *name) const
+{
+	guint32 low = 0;
+	guint32 high = record_count;
+
+	while (low < high)
+		{
+		const guint32 mid = low + ((high - low) / 2);
+
+		if (strcmp(this->name(mid), name) < 0)
+			{
+			low = mid + 1;
+			}
+		else
+			{
+			high = mid;
+			}
+		}
+
+	if (low == record_count || strcmp(this->name(low), name) != 0) return -1;
+
+	return static_cast<gint>(low);
+}
+
+CacheTableWriter::CacheTableWriter(const CacheTableFormat &format)
+	: format(format)
+{
+}
+
+/**
+ * @returns the offset of the string, to be stored in a record
+ */
+guint32 CacheTableWriter::add_string(const std::string &str)
+{
+	const auto it = string_offsets.find(str);
+	if (it != string_offsets.end()) return it->second;
+
+	const guint32 offset = strings.size();
+	strings.append(str);
+	strings.push_back('\0');
+	string_offsets.emplace(str, offset);
+
+	return offset;
+}
+
+/**
+ * @param record format.record_size bytes, little endian
+ */
+void CacheTableWriter::add_record(const void *record)
+{
+	records.append(static_cast<const gchar *>(record), format.record_size);
+	record_count++;
+}
+
+/**
+ * @brief Replace the file of the table, and map it again
+ */
+void CacheTableWriter::write(CacheTable &table)
+{
+	CacheTableHeader header{};
+
+	memcpy(header.magic, format.magic, sizeof(header.magic));
+	header.version = GUINT32_TO_LE(format.version);
+	header.app_version_hash = GUINT32_TO_LE(format.app_version_hash);
+	header.record_size = GUINT32_TO_LE(format.record_size);
+	header.record_count = GUINT32_TO_LE(record_count);
+	header.strings_offset = GUINT32_TO_LE(sizeof(header) + records.size());
+	header.strings_size = GUINT32_TO_LE(strings.size());
+
+	std::string buf;
+	buf.reserve(sizeof(header) + records.size() + strings.size());
+	buf.append(reinterpret_cast<const gchar *>(&header), sizeof(header));
+	buf.append(records);
+	buf.append(strings);
+
+	/* Unmap first, the file is replaced */
+	table.unmap();
+
+	g_autofree gchar *pathl = path_from_utf8(table.path);
+	secure_save(pathl, buf.data(), buf.size());
+
+	table.map();
+}
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CACHE_STORE_H
+#define CACHE_STORE_H
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <glib.h>
+
+/**
+ * @brief A file of the cache that describes the files of one source folder
+ *
+ * The subclass keeps its changes in memory until write_out().
+ */
+class CacheStoreFile
+{
+public:
+	CacheStoreFile(const gchar *path, const gchar *source_dir);
+	virtual ~CacheStoreFile();
+
+	void flush();
+
+protected:
+	/**
+	 * @brief Whether there are changes to write out
+	 */
+	virtual bool changed() const = 0;
+	/**
+	 * @brief Write out the changes
+	 * @param prune drop the entries of source files for which source_exists() fails
+	 */
+	virtual void write_out(bool prune) = 0;
+	bool source_exists(const gchar *name) const;
+
+	gchar *path;
+	gchar *source_dir;
+
+private:
+	bool pruned = false;
+};
+
+using CacheStoreFactory = CacheStoreFile *(*)(const gchar *path, const gchar *source_dir);
+
+/**
+ * @brief The files of one kind opened in this session, by path
+ *
+ * Files are kept open until close(). Changes are written out a few seconds
+ * after the last one, and on close().
+ */
+class CacheStore
+{
+public:
+	CacheStore(CacheStoreFactory factory, guint flush_delay);
+
+	CacheStoreFile *get(const gchar *source, const gchar *file_name, gboolean create);
+	void changed();
+	void flush();
+	void close();
+
+	/**
+	 * Stores used by several threads take this around get() and the
+	 * use of the file. flush() and close() take it themselves.
+	 */
+	GMutex mutex{};
+
+private:
+	static gboolean flush_cb(gpointer data);
+
+	CacheStoreFactory factory;
+	guint flush_delay; /**< seconds after the last change */
+	std::map<std::string, CacheStoreFile *> files;
+	std::set<std::string> missing; /**< Paths of files found not to exist */
+	guint flush_id = 0;
+};
+
+/**
+ * @brief Layout of a table file
+ *
+ * All values are little endian. \n
+ * CacheTableHeader \n
+ * record_count x record_size bytes of records, sorted by name \n
+ * strings_size bytes of strings, each NUL terminated \n
+ *
+ * The first member of each record is the guint32 offset of its name,
+ * relative to the start of the strings. Other strings of a record are
+ * referenced the same way. Equal strings are stored once.
+ */
+struct CacheTableFormat
+{
+	gchar magic[8];
+	guint32 version;
+	guint32 app_version_hash; /**< g_str_hash() of VERSION if the data depends on it, otherwise 0 */
+	guint32 record_size;
+	const gchar *description; /**< For debug messages */
+};
+
+/**
+ * @brief A table file, read in place from the mapped file
+ */
+class CacheTable
+{
+public:
+	CacheTable(const CacheTableFormat &format, const gchar *path);
+	~CacheTable();
+
+	void map();
+
+	guint32 count() const { return record_count; }
+	const gchar *string_at(guint32 offset) const;
+	const gchar *name(guint32 i) const;
+	gint find(const gchar *name) const;
+
+	template<class Record>
+	const Record &record(guint32 i) const
+	{
+		return reinterpret_cast<const Record *>(records)[i];
+	}
+
+private:
+	friend class CacheTableWriter;
+
+	void unmap();
+
+	const CacheTableFormat &format;
+	gchar *path;
+	GMappedFile *mapped = nullptr;
+	const gchar *records = nullptr;
+	guint32 record_count = 0;
+	const gchar *strings = nullptr;
+	guint32 strings_size = 0;
+};
+
+/**
+ * @brief Builds the contents of a table file
+ *
+ * Records must be added in the order of their names.
+ */
+class CacheTableWriter
+{
+public:
+	explicit CacheTableWriter(const CacheTableFormat &format);
+
+	guint32 add_string(const std::string &str);
+	void add_record(const void *record);
+	void write(CacheTable &table);
+
+private:
+	const CacheTableFormat &format;
+	std::string records;
+	guint32 record_count = 0;
+	std::string strings;
+	std::map<std::string, guint32> string_offsets;
+};
+
+#endif /* CACHE_STORE_H */
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -25,13 +25,17 @@
 #include <unistd.h>
 #include <utime.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <map>
+#include <string>
 
 #include <config.h>
 
+#include "cache-store.h"
 #include "main-defines.h"
 #include "md5-util.h"
 #include "options.h"
@@ -58,6 +62,20 @@
  * All data lines should end with a new line char. \n
  * Format is very strict, data must begin with the char immediately following '='. \n
  * Currently SimilarityGrid is always assumed to be 32 x 32 RGB. \n
+ *
+ * This text format is only read, as a fallback. Data is written to
+ * a pack file, one per source folder, in the same cache folder.
+ *
+ *-------------------------------------------------------------------
+ * Cache pack file format (GQ_CACHE_SIM_PACK):
+ *-------------------------------------------------------------------
+ *
+ * A table file as described by CacheTableFormat, with one
+ * CacheSimPackRecord per source file. Its strings are the file names.
+ *
+ * A record is valid when its source_mtime matches the source file. \n
+ * Legacy text files are added to the pack when they are read. The pack
+ * is written out as described in cache-store.cc.
  */
 
 namespace
@@ -151,110 +169,271 @@ gchar *cache_get_location(CacheType type, const gchar *source, gint include_name
 	return path;
 }
 
-} // namespace
-
 /*
  *-------------------------------------------------------------------
- * sim cache data
+ * sim cache pack
  *-------------------------------------------------------------------
  */
 
-CacheData *cache_sim_data_new(const gchar *path)
+constexpr guint CACHE_SIM_PACK_FLUSH_DELAY = 5; /**< seconds after the last change */
+
+enum CacheSimPackFlags : guint32 {
+	CACHE_SIM_PACK_DIMENSIONS = 1 << 0,
+	CACHE_SIM_PACK_DATE       = 1 << 1,
+	CACHE_SIM_PACK_MD5SUM     = 1 << 2,
+	CACHE_SIM_PACK_SIMILARITY = 1 << 3,
+	CACHE_SIM_PACK_FAST_HASH  = 1 << 4
+};
+
+struct CacheSimPackRecord
 {
-	auto *cd = new CacheData();
+	guint32 name_offset; /**< Relative to the start of the strings */
+	guint32 name_length;
+	gint64 source_mtime;
+	guint32 flags;
+	gint32 width;
+	gint32 height;
+	guint32 fast_hash_algorithm; /**< #FAST_HASH_ALGORITHM when \a fast_hash was written */
+	gint64 date;
+	guint8 md5sum[MD5_SIZE];
+	guint8 fast_hash[FAST_HASH_SIZE];
+	guint8 similarity[3 * 1024]; /**< red, then green, then blue grid */
+};
 
-	if (path) cd->load(path);
+static_assert(sizeof(CacheSimPackRecord) == 3144, "cache pack record must not be padded");
 
-	return cd;
-}
+/* The similarity data does not depend on the version of Geeqie */
+const CacheTableFormat cache_sim_pack_format{{'G', 'Q', 'S', 'I', 'M', 'P', 'K', '\n'}, 3, 0, sizeof(CacheSimPackRecord), "cache pack file"};
 
-void cache_sim_data_free(CacheData *cd)
+class CacheSimPack : public CacheStoreFile
 {
-	delete cd;
-}
+public:
+	CacheSimPack(const gchar *pack_path, const gchar *source_dir);
 
-/*
- *-------------------------------------------------------------------
- * sim cache write
- *-------------------------------------------------------------------
- */
+	bool read(const gchar *name, time_t mtime, CacheData &cd) const;
+	void write(const gchar *name, time_t mtime, const CacheData &cd);
+
+protected:
+	bool changed() const override;
+	void write_out(bool prune) override;
+
+private:
+	static CacheSimPackRecord record_from_le(const CacheSimPackRecord &r);
+	static CacheSimPackRecord record_to_le(const CacheSimPackRecord &r);
+
+	CacheTable table;
+
+	std::map<std::string, CacheSimPackRecord> pending; /**< Written, but not yet flushed */
+};
 
-bool CacheData::write_dimensions(GString *gstring) const
+CacheSimPack::CacheSimPack(const gchar *pack_path, const gchar *source_dir)
+	: CacheStoreFile(pack_path, source_dir)
+	, table(cache_sim_pack_format, pack_path)
 {
-	if (!dimensions) return false;
+}
 
-	g_string_append_printf(gstring, "Dimensions=[%d x %d]\n", dimensions->width, dimensions->height);
+CacheSimPackRecord CacheSimPack::record_from_le(const CacheSimPackRecord &r)
+{
+	CacheSimPackRecord h = r;
+
+	h.name_offset = GUINT32_FROM_LE(r.name_offset);
+	h.name_length = GUINT32_FROM_LE(r.name_length);
+	h.source_mtime = GINT64_FROM_LE(r.source_mtime);
+	h.flags = GUINT32_FROM_LE(r.flags);
+	h.width = GINT32_FROM_LE(r.width);
+	h.height = GINT32_FROM_LE(r.height);
+	h.fast_hash_algorithm = GUINT32_FROM_LE(r.fast_hash_algorithm);
+	h.date = GINT64_FROM_LE(r.date);
+
+	return h;
+}
 
-	return true;
+CacheSimPackRecord CacheSimPack::record_to_le(const CacheSimPackRecord &r)
+{
+	/* The conversion is symmetric */
+	return record_from_le(r);
 }
 
-bool CacheData::write_date(GString *gstring) const
+bool CacheSimPack::read(const gchar *name, time_t mtime, CacheData &cd) const
 {
-	if (!date) return false;
+	CacheSimPackRecord r;
+
+	if (const auto it = pending.find(name); it != pending.end())
+		{
+		r = it->second;
+		}
+	else if (const gint i = table.find(name); i >= 0)
+		{
+		r = record_from_le(table.record<CacheSimPackRecord>(i));
+		}
+	else
+		{
+		return false;
+		}
 
-	g_string_append_printf(gstring, "Date=[%ld]\n", *date);
+	if (r.source_mtime != mtime) return false;
+
+	if (r.flags & CACHE_SIM_PACK_DIMENSIONS) cd.set_dimensions({r.width, r.height});
+	if (r.flags & CACHE_SIM_PACK_DATE) cd.date = r.date;
+	if (r.flags & CACHE_SIM_PACK_MD5SUM)
+		{
+		Md5Digest digest;
+		std::copy(std::begin(r.md5sum), std::end(r.md5sum), digest.begin());
+		cd.set_md5sum(digest);
+		}
+	/* A hash of another algorithm is of no use */
+	if ((r.flags & CACHE_SIM_PACK_FAST_HASH) && r.fast_hash_algorithm == FAST_HASH_ALGORITHM)
+		{
+		FastHashDigest digest;
+		std::copy(std::begin(r.fast_hash), std::end(r.fast_hash), digest.begin());
+		cd.set_fast_hash(digest);
+		}
+	if (r.flags & CACHE_SIM_PACK_SIMILARITY)
+		{
+		ImageSimilarityData sd{};
+		std::copy_n(r.similarity, 1024, sd.avg_r.begin());
+		std::copy_n(r.similarity + 1024, 1024, sd.avg_g.begin());
+		std::copy_n(r.similarity + 2048, 1024, sd.avg_b.begin());
+		sd.filled = TRUE;
+		sd.fill_coarse();
+		cd.set_similarity(sd);
+		}
 
 	return true;
 }
 
-bool CacheData::write_md5sum(GString *gstring) const
+void CacheSimPack::write(const gchar *name, time_t mtime, const CacheData &cd)
 {
-	if (!md5sum) return false;
-
-	g_autofree gchar *text = md5_digest_to_text(*md5sum);
+	CacheSimPackRecord r{};
 
-	g_string_append_printf(gstring, "MD5sum=[%s]\n", text);
+	r.source_mtime = mtime;
+	if (cd.dimensions)
+		{
+		r.flags |= CACHE_SIM_PACK_DIMENSIONS;
+		r.width = cd.dimensions->width;
+		r.height = cd.dimensions->height;
+		}
+	if (cd.date)
+		{
+		r.flags |= CACHE_SIM_PACK_DATE;
+		r.date = *cd.date;
+		}
+	if (cd.md5sum)
+		{
+		r.flags |= CACHE_SIM_PACK_MD5SUM;
+		std::copy(cd.md5sum->begin(), cd.md5sum->end(), r.md5sum);
+		}
+	if (cd.fast_hash)
+		{
+		r.flags |= CACHE_SIM_PACK_FAST_HASH;
+		r.fast_hash_algorithm = FAST_HASH_ALGORITHM;
+		std::copy(cd.fast_hash->begin(), cd.fast_hash->end(), r.fast_hash);
+		}
+	if (cd.similarity && cd.similarity->filled)
+		{
+		r.flags |= CACHE_SIM_PACK_SIMILARITY;
+		std::copy(cd.similarity->avg_r.begin(), cd.similarity->avg_r.end(), r.similarity);
+		std::copy(cd.similarity->avg_g.begin(), cd.similarity->avg_g.end(), r.similarity + 1024);
+		std::copy(cd.similarity->avg_b.begin(), cd.similarity->avg_b.end(), r.similarity + 2048);
+		}
 
-	return true;
+	pending[name] = r;
 }
 
-bool CacheData::write_similarity(GString *gstring) const
+bool CacheSimPack::changed() const
 {
-	if (!similarity || !similarity->filled) return false;
+	return !pending.empty();
+}
 
-	g_string_append(gstring, "SimilarityGrid[32 x 32]=");
+void CacheSimPack::write_out(bool prune)
+{
+	std::map<std::string, CacheSimPackRecord> merged;
 
-	guint8 buf[3 * 32];
-	for (guint y = 0; y < 32; y++)
+	for (guint32 i = 0; i < table.count(); i++)
 		{
-		guint s = y * 32;
-		guint n = 0;
+		const gchar *name = table.name(i);
+		if (pending.count(name) > 0) continue;
+		if (prune && !source_exists(name)) continue;
 
-		for (guint x = 0; x < 32; x++)
-			{
-			buf[n++] = similarity->avg_r[s + x];
-			buf[n++] = similarity->avg_g[s + x];
-			buf[n++] = similarity->avg_b[s + x];
-			}
+		merged.emplace(name, record_from_le(table.record<CacheSimPackRecord>(i)));
+		}
+
+	merged.merge(pending);
+	pending.clear();
 
-		g_string_append_len(gstring, (const gchar *)buf, sizeof(buf));
+	CacheTableWriter writer(cache_sim_pack_format);
+
+	for (auto &[name, r] : merged)
+		{
+		r.name_offset = writer.add_string(name);
+		r.name_length = name.size();
+
+		const CacheSimPackRecord le = record_to_le(r);
+		writer.add_record(&le);
 		}
 
-	g_string_append(gstring, "\n");
+	writer.write(table);
+}
+
+/* Accessed from the threads that load cache data, so guarded by the mutex of the store */
+CacheStore cache_sim_packs([](const gchar *path, const gchar *source_dir) -> CacheStoreFile *
+	{
+	return new CacheSimPack(path, source_dir);
+	}, CACHE_SIM_PACK_FLUSH_DELAY);
 
-	return true;
+CacheSimPack *cache_sim_pack_get(const gchar *source, gboolean create)
+{
+	return static_cast<CacheSimPack *>(cache_sim_packs.get(source, GQ_CACHE_SIM_PACK, create));
 }
 
-void CacheData::save(const gchar *source) const
+} // namespace
+
+/*
+ *-------------------------------------------------------------------
+ * sim cache data
+ *-------------------------------------------------------------------
+ */
+
+CacheData *cache_sim_data_new(const gchar *path)
 {
-	g_autofree gchar *base = cache_create_location(CacheType::SIM, source);
-	if (!base) return;
+	auto *cd = new CacheData();
 
-	g_autofree gchar *path = cache_get_location(CacheType::SIM, source);
-	if (!path) return;
+	if (path) cd->load(path);
 
-	g_autofree gchar *pathl = path_from_utf8(path);
+	return cd;
+}
 
-	g_autoptr(GString) gstring = g_string_new("SIMcache\n#" PACKAGE " " VERSION "\n");
+void cache_sim_data_free(CacheData *cd)
+{
+	delete cd;
+}
 
-	write_dimensions(gstring);
-	write_date(gstring);
-	write_md5sum(gstring);
-	write_similarity(gstring);
+/*
+ *-------------------------------------------------------------------
+ * sim cache write
+ *-------------------------------------------------------------------
+ */
 
-	secure_save(pathl, gstring->str, gstring->len);
+void CacheData::save(const gchar *source) const
+{
+	const time_t mtime = filetime(source);
 
-	filetime_set(path, filetime(source));
+	g_mutex_lock(&cache_sim_packs.mutex);
+	CacheSimPack *pack = cache_sim_pack_get(source, TRUE);
+	if (pack)
+		{
+		pack->write(filename_from_path(source), mtime, *this);
+		cache_sim_packs.changed();
+		}
+	g_mutex_unlock(&cache_sim_packs.mutex);
+}
+
+/**
+ * @brief Write all changed packs, and close all packs
+ */
+void cache_sim_pack_flush()
+{
+	cache_sim_packs.close();
 }
 
 /*
@@ -408,6 +587,7 @@ bool CacheData::read_similarity(FILE *f, const gchar *buffer, gint s)
 		}
 
 	sd->filled = TRUE;
+	sd->fill_coarse();
 
 	set_similarity(*sd);
 
@@ -415,6 +595,27 @@ bool CacheData::read_similarity(FILE *f, const gchar *buffer, gint s)
 }
 
 bool CacheData::load(const gchar *source)
+{
+	if (!source) return false;
+
+	const time_t mtime = filetime(source);
+
+	g_mutex_lock(&cache_sim_packs.mutex);
+	CacheSimPack *pack = cache_sim_pack_get(source, FALSE);
+	const bool found = pack && pack->read(filename_from_path(source), mtime, *this);
+	g_mutex_unlock(&cache_sim_packs.mutex);
+
+	if (found) return true;
+
+	if (!load_text(source)) return false;
+
+	/* Migrate the legacy file */
+	save(source);
+
+	return true;
+}
+
+bool CacheData::load_text(const gchar *source)
 {
 	g_autofree gchar *path = cache_find_location(CacheType::SIM, source);
 	if (!path) return false;
@@ -477,6 +678,11 @@ void CacheData::set_md5sum(const Md5Digest &digest)
 	md5sum = digest;
 }
 
+void CacheData::set_fast_hash(const FastHashDigest &digest)
+{
+	fast_hash = digest;
+}
+
 void CacheData::set_similarity(const ImageSimilarityData &sd)
 {
 	if (!sd.filled) return;
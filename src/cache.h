@@ -30,6 +30,7 @@
 
 #include <glib.h>
 
+#include "fast-hash.h"
 #include "geometry.h"
 #include "md5-util.h"
 
@@ -46,6 +47,11 @@ struct ImageSimilarityData;
 #define GQ_CACHE_EXT_METADATA   ".meta"
 #define GQ_CACHE_EXT_XMP_METADATA   ".gq.xmp"
 
+#define GQ_CACHE_SIM_PACK       "sim.gqpack"
+#define GQ_CACHE_THUMB_PACK_NORMAL "thumbs-normal.gqpack"
+#define GQ_CACHE_THUMB_PACK_LARGE  "thumbs-large.gqpack"
+#define GQ_CACHE_THUMB_INDEX       "thumbs-valid.gqindex"
+#define GQ_CACHE_METADATA_INDEX    "metadata.gqindex"
 
 enum class CacheType {
 	THUMB,
@@ -61,18 +67,17 @@ struct CacheData
 
 	void set_dimensions(GqSize dimensions);
 	void set_md5sum(const Md5Digest &digest);
+	void set_fast_hash(const FastHashDigest &digest);
 	void set_similarity(const ImageSimilarityData &sd);
 
 	std::optional<GqSize> dimensions;
 	std::optional<time_t> date;
 	std::optional<Md5Digest> md5sum;
+	std::optional<FastHashDigest> fast_hash; /**< Of #FAST_HASH_ALGORITHM */
 	std::unique_ptr<ImageSimilarityData> similarity;
 
 private:
-	bool write_dimensions(GString *gstring) const;
-	bool write_date(GString *gstring) const;
-	bool write_md5sum(GString *gstring) const;
-	bool write_similarity(GString *gstring) const;
+	bool load_text(const gchar *source);
 
 	bool read_dimensions(FILE *f, const gchar *buffer, gint s);
 	bool read_date(FILE *f, const gchar *buffer, gint s);
@@ -84,6 +89,7 @@ gboolean cache_time_valid(const gchar *cache, const gchar *path);
 
 CacheData *cache_sim_data_new(const gchar *path);
 void cache_sim_data_free(CacheData *cd);
+void cache_sim_pack_flush();
 
 gchar *cache_create_location(CacheType cache_type, const gchar *source);
 gchar *cache_get_location(CacheType cache_type, const gchar *source);
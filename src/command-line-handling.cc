@@ -32,12 +32,14 @@
 #include "compat.h"
 #include "dupe.h"
 #include "exif.h"
+#include "filecache.h"
 #include "filedata.h"
 #include "filefilter.h"
 #include "geometry.h"
 #if HAVE_LUA
 #  include "glua.h"
 #endif
+#include "image-load.h"
 #include "image.h"
 #include "img-view.h"
 #include "intl.h"
@@ -249,7 +251,7 @@ void gq_cache_render(GtkApplication *app, GApplicationCommandLine *, GVariantDic
 	const gchar *text;
 	g_variant_dict_lookup(command_line_options_dict, key->str, "&s", &text);
 
-	cache_manager_render_remote(app, text, recurse, shared, nullptr);
+	cache_manager_render_remote(app, text, recurse, shared, 0, nullptr);
 }
 
 void gq_cache_shared(GtkApplication *, GApplicationCommandLine *, GVariantDict *command_line_options_dict, GList *)
@@ -530,6 +532,18 @@ void gq_geometry(GtkApplication *, GApplicationCommandLine *, GVariantDict *comm
 		}
 }
 
+void print_cache_stats(GApplicationCommandLine *app_command_line, const gchar *name, const FileCacheStats &stats)
+{
+	g_application_command_line_print(app_command_line, "%s: hits %" G_GUINT64_FORMAT " misses %" G_GUINT64_FORMAT " evictions %" G_GUINT64_FORMAT " entries %u size %lu max size %lu\n",
+	                                 name, stats.hits, stats.misses, stats.evictions, stats.entries, stats.size, stats.max_size);
+}
+
+void gq_get_cache_stats(GtkApplication *, GApplicationCommandLine *app_command_line, GVariantDict *, GList *)
+{
+	print_cache_stats(app_command_line, "image", image_cache_get_stats());
+	print_cache_stats(app_command_line, "exif", exif_cache_get_stats());
+}
+
 void gq_get_collection(GtkApplication *, GApplicationCommandLine *app_command_line, GVariantDict *command_line_options_dict, GList *)
 {
 	const gchar *text;
@@ -737,6 +751,24 @@ void gq_get_filelist(GtkApplication *, GApplicationCommandLine *app_command_line
 	file_data_unref(dir_fd);
 }
 
+void print_loader_queue_stats(GApplicationCommandLine *app_command_line, const gchar *name, const ImageLoaderQueueStats &stats)
+{
+	const gint64 latency_average = stats.started ? stats.latency_total / static_cast<gint64>(stats.started) : 0;
+
+	g_application_command_line_print(app_command_line, "%s priority: queued %u started %" G_GUINT64_FORMAT " latency average %" G_GINT64_FORMAT "us max %" G_GINT64_FORMAT "us\n",
+	                                 name, stats.queued, stats.started, latency_average, stats.latency_max);
+}
+
+void gq_get_loader_stats(GtkApplication *, GApplicationCommandLine *app_command_line, GVariantDict *, GList *)
+{
+	const ImageLoaderStats stats = image_loader_get_stats();
+
+	g_application_command_line_print(app_command_line, "threads %u yields %" G_GUINT64_FORMAT " steals %" G_GUINT64_FORMAT "\n",
+	                                 stats.threads, stats.yields, stats.steals);
+	print_loader_queue_stats(app_command_line, "high", stats.high);
+	print_loader_queue_stats(app_command_line, "low", stats.low);
+}
+
 void gq_get_rectangle(GtkApplication *, GApplicationCommandLine *app_command_line, GVariantDict *, GList *)
 {
 	if (!options->draw_rectangle) return;
@@ -1390,12 +1422,14 @@ CommandLineOptionEntry command_line_options[] =
 	{ "first",                       gq_first,                       PRIMARY_REMOTE, GUI  },
 	{ "fullscreen",                  gq_fullscreen,                  PRIMARY_REMOTE, GUI  },
 	{ "geometry",                    gq_geometry,                    PRIMARY_REMOTE, GUI  },
+	{ "get-cache-stats",             gq_get_cache_stats,             REMOTE        , N_A  },
 	{ "get-collection",              gq_get_collection,              PRIMARY_REMOTE, TEXT },
 	{ "get-collection-list",         gq_get_collection_list,         PRIMARY_REMOTE, TEXT },
 	{ "get-destination",             gq_get_destination,             PRIMARY_REMOTE, GUI  },
 	{ "get-file-info",               gq_get_file_info,               REMOTE        , N_A  },
 	{ "get-filelist",                gq_get_filelist<false>,         PRIMARY_REMOTE, GUI  },
 	{ "get-filelist-recurse",        gq_get_filelist<true>,          PRIMARY_REMOTE, GUI  },
+	{ "get-loader-stats",            gq_get_loader_stats,            REMOTE        , N_A  },
 	{ "get-rectangle",               gq_get_rectangle,               REMOTE        , N_A  },
 	{ "get-render-intent",           gq_get_render_intent,           REMOTE        , N_A  },
 	{ "get-selection",               gq_get_selection,               REMOTE        , N_A  },
@@ -1505,7 +1539,10 @@ void gq_cm_dir(GtkApplication *app, GApplicationCommandLine *app_command_line, G
 		exit(EXIT_FAILURE);
 		}
 
-	cache_maintenance(app, folder_path);
+	gint jobs = 0;
+	g_variant_dict_lookup(command_line_options_dict, "jobs", "i", &jobs);
+
+	cache_maintenance(app, folder_path, jobs);
 }
 
 CommandLineOptionEntry command_line_options_cache_maintenance[] =
@@ -23,11 +23,18 @@
 
 #include <sys/time.h>
 
+#include <algorithm>
 #include <array>
 #include <cinttypes>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include <gdk/gdk.h>
 #include <gio/gio.h>
@@ -38,6 +45,7 @@
 #include "compat-deprecated.h"
 #include "compat.h"
 #include "dnd.h"
+#include "fast-hash.h"
 #include "filedata.h"
 #include "history-list.h"
 #include "image-load.h"
@@ -88,32 +96,21 @@ enum DUPE_CHECK_RESULT {
 	DUPE_NAME_MATCH
 };
 
-/** Used for similarity checks. One for each item pushed
- * onto the thread pool.
- */
-struct DupeQueueItem
-{
-	DupeItem *needle;
-	DupeWindow *dw;
-	GList *work; /**< pointer into \a dw->list or \a dw->second_list (#DupeItem) */
-	gint index; /**< The order items pushed onto thread pool. Used to sort returned matches */
-};
-
-/** Used for similarity checks thread. One for each pair match found.
- */
-struct DupeSearchMatch
-{
-	DupeItem *a; /**< \a a / \a b matched pair found */
-	DupeItem *b; /**< \a a / \a b matched pair found */
-	gdouble rank;
-	gint index; /**< The order items pushed onto thread pool. Used to sort returned matches */
-};
-
 constexpr gint DUPE_DEF_WIDTH = 800;
 constexpr gint DUPE_DEF_HEIGHT = 400;
 
 constexpr gdouble DUPE_PROGRESS_PULSE_STEP = 0.0001;
 
+constexpr guint DUPE_COMPARE_TILE_SIZE = 128; /**< Rows and columns of one similarity comparison tile */
+constexpr guint DUPE_COMPARE_POLL_INTERVAL = 50; /**< ms between checks for completed similarity tiles */
+constexpr gint DUPE_PREPARE_DIMENSIONS_THREADS = 2; /**< Header parsing is cheap, the checksum stage gets the other threads */
+
+/* Prefixes of #DupeItem->md5sum when a fast hash is used.
+ * Checksums of different kinds then never compare equal.
+ */
+constexpr gchar DUPE_FAST_HASH_PREFIX[] = "f:"; /**< A hash of the whole file */
+constexpr gchar DUPE_PARTIAL_HASH_PREFIX[] = "p:"; /**< A partial hash no other item has, valid for one check only */
+
 constexpr std::array<GtkTargetEntry, 2> dupe_drag_types{{
 	{ const_cast<gchar *>("text/uri-list"), 0, TARGET_URI_LIST },
 	{ const_cast<gchar *>("text/plain"), 0, TARGET_TEXT_PLAIN }
@@ -129,6 +126,137 @@ GList *dupe_window_list = nullptr;	/**< list of open DupeWindow *s */
 
 } // namespace
 
+/** Used for similarity checks thread. One for each pair match found.
+ */
+struct DupeSearchMatch
+{
+	DupeItem *a; /**< \a a / \a b matched pair found */
+	DupeItem *b; /**< \a a / \a b matched pair found */
+	gdouble rank;
+	guint row; /**< Index of \a b in #DupeCompareEngine->needles. Used to sort returned matches */
+	guint col; /**< Index of \a a in #DupeCompareEngine->candidates. Used to sort returned matches */
+};
+
+/** A band of consecutive needle rows. Its tiles cover all the candidate
+ * columns the rows are compared against.
+ */
+struct DupeCompareBand
+{
+	guint row_start;
+	guint row_end;
+	guint col_start; /**< First candidate column of the first row */
+	guint tile_start; /**< Global index of the first tile of this band */
+	/* Protected by #DupeWindow->search_matches_mutex */
+	guint tiles_left;
+	gboolean done;
+	std::vector<DupeSearchMatch> matches;
+};
+
+/**
+ * @brief Similarity comparison of all item pairs, run on the thread pool
+ *
+ * The pair space (needle rows x candidate columns) is split into square
+ * tiles, which workers claim in order from a shared counter.
+ * Tiles are grouped into bands of rows. A band's matches are handed back
+ * to the main thread, sorted, when its last tile completes.
+ * Bands are linked strictly in order, so the resulting groups do not
+ * depend on how the tiles were scheduled.
+ *
+ * With one set, needles and candidates are the same list and each needle
+ * is only compared with the candidates after it (the upper triangle).
+ *
+ * When an index of the candidates is used, each band is a single tile and
+ * each needle is only compared with the candidates the index returns.
+ *
+ * Items removed from the window while the comparison runs are dropped:
+ * workers skip them and their matches are not linked. They are freed
+ * with the engine, as a worker may still be reading them.
+ */
+struct DupeCompareEngine
+{
+	std::vector<DupeItem *> needles;
+	std::vector<DupeItem *> candidates;
+	gboolean triangle;
+	DupeMatchType mask;
+
+	gboolean use_index;
+	gdouble threshold; /**< Similarity threshold of \a mask */
+	std::once_flag index_once;
+	std::unique_ptr<ImageSimilarityIndex> index; /**< Built by the first worker */
+
+	std::vector<DupeCompareBand> bands;
+	guint tile_count;
+	gint next_tile; /**< Next tile to be claimed by a worker. Atomic */
+
+	guint64 pairs_total;
+	guint64 pairs_done; /**< Protected by #DupeWindow->search_matches_mutex */
+
+	gsize next_band; /**< Next band to be linked. Main thread only */
+
+	std::vector<gint> needle_dropped; /**< Per needle, set when it is removed. Atomic */
+	std::vector<gint> candidate_dropped; /**< Per candidate, set when it is removed. Atomic */
+	std::vector<DupeItem *> dropped; /**< Removed items, freed with the engine. Main thread only */
+};
+
+/** Checksum and dimensions of one item, as found by the #DupePrepareJob workers
+ */
+struct DupePrepareItem
+{
+	DupeItem *di; /**< Main thread only. NULL if the item has been removed */
+	gchar *path;
+	FileFormatClass format_class;
+	gboolean want_checksum;
+	gboolean want_dimensions;
+	gboolean full_hash; /**< Fast hash mode, the partial hash is shared with another item */
+
+	/* Written by the checksum stage */
+	gchar *md5sum;
+	gboolean md5sum_cached;
+	FastHashDigest partial_hash;
+	gboolean partial_hash_done;
+	gboolean partial_hash_complete;
+
+	/* Written by the dimensions stage */
+	gint width;
+	gint height;
+	gboolean dimensions_done; /**< FALSE if the dimensions could not be read from the header */
+	gboolean dimensions_cached;
+};
+
+/**
+ * @brief Checksums and dimensions of the items of both sets, computed before matching
+ *
+ * The checksum stage reads and hashes whole files, the dimensions stage
+ * only parses image headers. Each stage has its own bounded thread pool,
+ * so hashing one file overlaps with reading the headers of others.
+ * Values found in the cache are used without reading the file.
+ *
+ * With a fast hash, the checksum stage first only hashes the size and
+ * both ends of each file. Only items which share this partial hash with
+ * another item are then hashed completely, in a second round.
+ *
+ * Results are merged into the DupeItems on the main thread when both
+ * stages are done. Dimensions that cannot be read from the header are
+ * then found with an image loader, one item per idle call.
+ */
+struct DupePrepareJob
+{
+	std::vector<DupePrepareItem> items;
+	std::vector<DupePrepareItem> collisions; /**< Items of the full hash round */
+	gboolean use_cache;
+	gboolean fast; /**< Use #FastHash instead of MD5 */
+
+	GThreadPool *checksum_pool;
+	GThreadPool *dimensions_pool;
+	gint pending; /**< Stage jobs not yet completed. Atomic */
+	gint total; /**< Stage jobs pushed */
+	gboolean abort;
+
+	gboolean collisions_queued; /**< Main thread only */
+	gboolean merged; /**< Main thread only */
+	gsize next_fallback; /**< Main thread only */
+};
+
 /*
  * Well, after adding the 'compare two sets' option things got a little sloppy in here
  * because we have to account for two 'modes' everywhere. (be careful).
@@ -138,6 +266,8 @@ static void dupe_match_unlink(DupeItem *a, DupeItem *b);
 static DupeItem *dupe_match_find_parent(DupeWindow *dw, DupeItem *child);
 
 static gint dupe_match(DupeItem *a, DupeItem *b, DupeMatchType mask, gdouble *rank, gint fast);
+static gdouble dupe_match_sim_threshold(DupeMatchType mask);
+static void dupe_window_recompare(DupeWindow *dw);
 
 static void dupe_thumb_step(DupeWindow *dw);
 static gint dupe_check_cb(gpointer data);
@@ -156,6 +286,8 @@ static void dupe_init_list_cache(DupeWindow *dw);
 static void dupe_destroy_list_cache(DupeWindow *dw);
 static gboolean dupe_insert_in_list_cache(DupeWindow *dw, FileData *fd);
 
+static void dupe_prepare_job_free(DupeWindow *dw);
+
 static void dupe_match_link(DupeItem *a, DupeItem *b, gdouble rank);
 static gint dupe_match_link_exists(DupeItem *child, DupeItem *parent);
 
@@ -188,67 +320,133 @@ static HardcodedWindowKeyList dupe_window_keys{
 };
 
 /**
- * @brief The function run in threads for similarity checks
- * @param d1 #DupeQueueItem
- * @param d2 #DupeWindow
- *
- * Used only for similarity checks.\n
- * Search \a dqi->list for \a dqi->needle and if a match is
- * found, create a #DupeSearchMatch and add to \a dw->search_matches list\n
- * If \a dw->abort is set, just increment \a dw->thread_count
+ * @brief Compares the item pairs of one tile
+ * @param engine
+ * @param band The band containing the tile
+ * @param tile Index of the tile within the band
+ * @param abort
+ * @param[out] matches
+ * @returns The number of pairs compared
  */
-static void dupe_comparison_func(gpointer d1, gpointer d2)
+static guint64 dupe_compare_tile(DupeCompareEngine *engine, const DupeCompareBand &band, guint tile, const gboolean *abort, std::vector<DupeSearchMatch> &matches)
 {
-	auto dqi = static_cast<DupeQueueItem *>(d1);
-	auto dw = static_cast<DupeWindow *>(d2);
-	DupeSearchMatch *dsm;
-	DupeItem *di;
-	GList *matches = nullptr;
+	const guint col_lo = band.col_start + (tile * DUPE_COMPARE_TILE_SIZE);
+	const guint col_hi = engine->use_index ? engine->candidates.size() : std::min<guint>(col_lo + DUPE_COMPARE_TILE_SIZE, engine->candidates.size());
+	std::vector<guint> cols;
+	guint64 pairs = 0;
 	gdouble rank = 0;
 
-	if (!dw->abort)
+	for (guint row = band.row_start; row < band.row_end; row++)
 		{
-		GList *work = dqi->work;
-		while (work)
+		DupeItem *needle = engine->needles[row];
+		const guint col_start = engine->triangle ? std::max(col_lo, row + 1) : col_lo;
+
+		const auto check = [engine, needle, row, &rank, &matches](guint col)
 			{
-			di = static_cast<DupeItem *>(work->data);
+			DupeItem *di = engine->candidates[col];
+
+			if (g_atomic_int_get(&engine->candidate_dropped[col])) return;
 
-			/* forward for second set, back for simple compare */
-			if (dw->second_set)
+			if (dupe_match(di, needle, engine->mask, &rank, TRUE))
 				{
-				work = work->next;
+				matches.push_back({di, needle, rank, row, col});
 				}
-			else
+			};
+
+		if (g_atomic_int_get(&engine->needle_dropped[row]))
+			{
+			/* Removed, its pairs are only counted */
+			}
+		else if (engine->use_index)
+			{
+			cols.clear();
+			engine->index->find_candidates(needle->simd, engine->threshold, cols);
+			std::sort(cols.begin(), cols.end());
+
+			for (const guint col : cols)
 				{
-				work = work->prev;
+				if (col >= col_start && col < col_hi) check(col);
 				}
-
-			if (dupe_match(di, dqi->needle, dqi->dw->match_mask, &rank, TRUE))
+			}
+		else
+			{
+			for (guint col = col_start; col < col_hi; col++)
 				{
-				dsm = g_new0(DupeSearchMatch, 1);
-				dsm->a = di;
-				dsm->b = dqi->needle;
-				dsm->rank = rank;
-				matches = g_list_prepend(matches, dsm);
-				dsm->index = dqi->index;
+				check(col);
 				}
+			}
+
+		if (col_hi > col_start) pairs += col_hi - col_start;
+
+		if (g_atomic_int_get(abort)) break;
+		}
+
+	return pairs;
+}
 
-			if (dw->abort)
+/**
+ * @brief The function run in threads for similarity checks
+ * @param d1 #DupeCompareEngine
+ * @param d2 #DupeWindow
+ *
+ * Used only for similarity checks.\n
+ * One instance is pushed for each worker. Each claims tiles until none
+ * are left and stores the matches found in the tile's band. \n
+ * If \a dw->abort is set, stop claiming tiles. \n
+ * On exit increment \a dw->thread_count and signal \a dw->thread_count_cond
+ */
+static void dupe_comparison_func(gpointer d1, gpointer d2)
+{
+	auto engine = static_cast<DupeCompareEngine *>(d1);
+	auto dw = static_cast<DupeWindow *>(d2);
+	std::vector<DupeSearchMatch> matches;
+
+	if (engine->use_index)
+		{
+		std::call_once(engine->index_once, [engine]()
+			{
+			std::vector<const ImageSimilarityData *> items;
+
+			items.reserve(engine->candidates.size());
+			for (DupeItem *di : engine->candidates)
 				{
-				break;
+				items.push_back(di->simd);
 				}
-			}
+			engine->index = std::make_unique<ImageSimilarityIndex>(items);
+			});
+		}
+
+	while (!g_atomic_int_get(&dw->abort))
+		{
+		const gint tile = g_atomic_int_add(&engine->next_tile, 1);
+		if (tile >= static_cast<gint>(engine->tile_count)) break;
+
+		/* Find the band containing this tile */
+		auto band = std::upper_bound(engine->bands.begin(), engine->bands.end(), static_cast<guint>(tile),
+		                             [](guint t, const DupeCompareBand &b){ return t < b.tile_start; }) - 1;
+
+		matches.clear();
+		const guint64 pairs = dupe_compare_tile(engine, *band, tile - band->tile_start, &dw->abort, matches);
 
-		matches = g_list_reverse(matches);
 		g_mutex_lock(&dw->search_matches_mutex);
-		dw->search_matches = g_list_concat(dw->search_matches, matches);
+		engine->pairs_done += pairs;
+		band->matches.insert(band->matches.end(), matches.begin(), matches.end());
+		band->tiles_left--;
+		if (band->tiles_left == 0)
+			{
+			std::sort(band->matches.begin(), band->matches.end(), [](const DupeSearchMatch &a, const DupeSearchMatch &b)
+				{
+				return a.row != b.row ? a.row < b.row : a.col < b.col;
+				});
+			band->done = TRUE;
+			}
 		g_mutex_unlock(&dw->search_matches_mutex);
 		}
 
 	g_mutex_lock(&dw->thread_count_mutex);
 	dw->thread_count++;
+	g_cond_signal(&dw->thread_count_cond);
 	g_mutex_unlock(&dw->thread_count_mutex);
-	g_free(dqi);
 }
 
 /*
@@ -506,8 +704,20 @@ static void dupe_item_write_cache(DupeItem *di)
 
 	CacheData cd{};
 
+	/* Keep what is cached already, such as a checksum of the other kind */
+	cd.load(di->fd->path);
+
 	if (di->width != 0) cd.set_dimensions({di->width, di->height});
-	if (di->md5sum)
+	if (!di->md5sum || g_str_has_prefix(di->md5sum, DUPE_PARTIAL_HASH_PREFIX))
+		{
+		/* Nothing to store */
+		}
+	else if (g_str_has_prefix(di->md5sum, DUPE_FAST_HASH_PREFIX))
+		{
+		FastHashDigest digest;
+		if (fast_hash_digest_from_text(di->md5sum + strlen(DUPE_FAST_HASH_PREFIX), digest)) cd.set_fast_hash(digest);
+		}
+	else
 		{
 		Md5Digest digest;
 		if (md5_digest_from_text(di->md5sum, digest)) cd.set_md5sum(digest);
@@ -1326,6 +1536,20 @@ static void dupe_match_rank(DupeWindow *dw)
  * ------------------------------------------------------------------
  */
 
+/**
+ * @brief Minimum similarity for a match
+ * @param mask One of the #DUPE_MATCH_SIM types
+ * @returns 0.0 to 1.0
+ */
+static gdouble dupe_match_sim_threshold(DupeMatchType mask)
+{
+	if (mask & DUPE_MATCH_SIM_HIGH) return 0.95;
+	if (mask & DUPE_MATCH_SIM_MED) return 0.90;
+	if (mask & DUPE_MATCH_SIM_CUSTOM) return static_cast<gdouble>(options->duplicates_similarity_threshold) / 100.0;
+
+	return 0.85;
+}
+
 /**
  * @brief
  * @param[in] a
@@ -1420,12 +1644,7 @@ static gboolean dupe_match(DupeItem *a, DupeItem *b, DupeMatchType mask, gdouble
 	if (mask & DUPE_MATCH_SIM)
 		{
 		gdouble f;
-		gdouble m;
-
-		if (mask & DUPE_MATCH_SIM_HIGH) m = 0.95;
-		else if (mask & DUPE_MATCH_SIM_MED) m = 0.90;
-		else if (mask & DUPE_MATCH_SIM_CUSTOM) m = static_cast<gdouble>(options->duplicates_similarity_threshold) / 100.0;
-		else m = 0.85;
+		const gdouble m = dupe_match_sim_threshold(mask);
 
 		if (fast)
 			{
@@ -1817,41 +2036,181 @@ static void dupe_array_check(DupeWindow *dw)
 }
 
 /**
- * @brief Look for similarity match
+ * @brief Start the similarity comparison on the thread pool
  * @param dw
- * @param needle
- * @param start
  *
  * Only used for similarity checks.\n
- * Called from dupe_check_cb.
- * Called for each entry in the list.
- * Steps through the list looking for matches against needle.
- * Pushes a #DupeQueueItem onto thread pool queue.
+ * Called from dupe_check_cb when setup is done.
+ * Splits the pair space into bands and tiles, and pushes one
+ * #dupe_comparison_func job per worker thread.
  */
-static void dupe_list_check_match(DupeWindow *dw, DupeItem *needle, GList *start)
+static void dupe_compare_engine_start(DupeWindow *dw)
 {
-	GList *work;
-	DupeQueueItem *dqi;
+	auto engine = new DupeCompareEngine();
 
-	if (dw->second_set)
+	/* Needles are taken from the end of set 1, as the list is worked backwards */
+	for (GList *work = g_list_last(dw->list); work; work = work->prev)
 		{
-		work = dw->second_list;
+		engine->needles.push_back(static_cast<DupeItem *>(work->data));
 		}
-	else if (start)
+
+	if (dw->second_set)
 		{
-		work = start;
+		for (GList *work = dw->second_list; work; work = work->next)
+			{
+			engine->candidates.push_back(static_cast<DupeItem *>(work->data));
+			}
+		engine->triangle = FALSE;
 		}
 	else
 		{
-		work = g_list_last(dw->list);
+		engine->candidates = engine->needles;
+		engine->triangle = TRUE;
+		}
+
+	engine->needle_dropped.resize(engine->needles.size(), FALSE);
+	engine->candidate_dropped.resize(engine->candidates.size(), FALSE);
+
+	engine->mask = dw->match_mask;
+	engine->threshold = dupe_match_sim_threshold(engine->mask);
+	/* Below a threshold of zero every pair matches, unloaded images included */
+	engine->use_index = (engine->threshold > 0.0);
+
+	const guint rows = engine->needles.size();
+	const guint cols = engine->candidates.size();
+
+	for (guint row = 0; row < rows; row += DUPE_COMPARE_TILE_SIZE)
+		{
+		DupeCompareBand band;
+
+		band.row_start = row;
+		band.row_end = std::min(row + DUPE_COMPARE_TILE_SIZE, rows);
+		band.col_start = engine->triangle ? std::min(row + 1, cols) : 0;
+		band.tile_start = engine->tile_count;
+		if (engine->use_index)
+			{
+			band.tiles_left = (cols > band.col_start) ? 1 : 0;
+			}
+		else
+			{
+			band.tiles_left = (cols - band.col_start + DUPE_COMPARE_TILE_SIZE - 1) / DUPE_COMPARE_TILE_SIZE;
+			}
+		band.done = (band.tiles_left == 0);
+
+		for (guint r = band.row_start; r < band.row_end; r++)
+			{
+			engine->pairs_total += engine->triangle ? cols - std::min(r + 1, cols) : cols;
+			}
+
+		engine->tile_count += band.tiles_left;
+		engine->bands.push_back(std::move(band));
+		}
+
+	dw->compare_engine = engine;
+
+	const gint workers = options->threads.duplicates > 0 ? options->threads.duplicates : get_cpu_cores();
+
+	for (gint i = 0; i < workers; i++)
+		{
+		dw->queue_count++;
+		g_thread_pool_push(dw->dupe_comparison_thread_pool, engine, nullptr);
+		}
+}
+
+/**
+ * @brief Link the matches of all bands completed so far
+ * @param dw
+ * @returns TRUE if all bands have been linked
+ *
+ * Only used for similarity checks. Runs on the main thread.
+ */
+static gboolean dupe_compare_engine_link_ready(DupeWindow *dw)
+{
+	DupeCompareEngine *engine = dw->compare_engine;
+
+	while (engine->next_band < engine->bands.size())
+		{
+		std::vector<DupeSearchMatch> matches;
+
+		g_mutex_lock(&dw->search_matches_mutex);
+		DupeCompareBand &band = engine->bands[engine->next_band];
+		const gboolean done = band.done;
+		if (done) std::swap(matches, band.matches);
+		g_mutex_unlock(&dw->search_matches_mutex);
+
+		if (!done) return FALSE;
+
+		for (const DupeSearchMatch &match : matches)
+			{
+			if (engine->needle_dropped[match.row] || engine->candidate_dropped[match.col]) continue;
+
+			if (!dupe_match_link_exists(match.a, match.b))
+				{
+				dupe_match_link(match.a, match.b, match.rank);
+				}
+			}
+
+		engine->next_band++;
+		}
+
+	return TRUE;
+}
+
+/**
+ * @brief Stop the similarity comparison and wait for the workers to exit
+ * @param dw
+ */
+static void dupe_compare_engine_free(DupeWindow *dw)
+{
+	if (!dw->compare_engine) return;
+
+	g_atomic_int_set(&dw->abort, TRUE);
+
+	g_mutex_lock(&dw->thread_count_mutex);
+	while (dw->thread_count < dw->queue_count) // Wait for the queue to empty
+		{
+		g_cond_wait(&dw->thread_count_cond, &dw->thread_count_mutex);
+		}
+	g_mutex_unlock(&dw->thread_count_mutex);
+
+	for (DupeItem *di : dw->compare_engine->dropped)
+		{
+		dupe_item_free(di);
 		}
 
-	dqi = g_new0(DupeQueueItem, 1);
-	dqi->needle = needle;
-	dqi->dw = dw;
-	dqi->work = work;
-	dqi->index = dw->queue_count;
-	g_thread_pool_push(dw->dupe_comparison_thread_pool, dqi, nullptr);
+	delete dw->compare_engine;
+	dw->compare_engine = nullptr;
+}
+
+/**
+ * @brief Drop an item from the similarity comparison in progress
+ * @param dw
+ * @param di
+ * @returns TRUE if the engine took over freeing \a di
+ */
+static gboolean dupe_compare_engine_drop(DupeWindow *dw, DupeItem *di)
+{
+	DupeCompareEngine *engine = dw->compare_engine;
+	gboolean found = FALSE;
+
+	for (gsize i = 0; i < engine->needles.size(); i++)
+		{
+		if (engine->needles[i] != di) continue;
+
+		g_atomic_int_set(&engine->needle_dropped[i], TRUE);
+		found = TRUE;
+		}
+	for (gsize i = 0; i < engine->candidates.size(); i++)
+		{
+		if (engine->candidates[i] != di) continue;
+
+		g_atomic_int_set(&engine->candidate_dropped[i], TRUE);
+		found = TRUE;
+		}
+
+	if (found) engine->dropped.push_back(di);
+
+	return found;
 }
 
 /*
@@ -1980,16 +2339,10 @@ static void dupe_check_stop(DupeWindow *dw)
 {
 	g_clear_handle_id(&dw->idle_id, g_source_remove);
 
-	dw->abort = TRUE;
-
-	while (dw->thread_count < dw->queue_count) // Wait for the queue to empty
-		{
-		dupe_window_update_progress(dw, nullptr, 0.0, FALSE);
-		widget_set_cursor(dw->listview, -1);
-		}
-
-	g_list_free(dw->search_matches);
-	dw->search_matches = nullptr;
+	dupe_compare_engine_free(dw);
+	dupe_prepare_job_free(dw);
+	dupe_window_update_progress(dw, nullptr, 0.0, FALSE);
+	widget_set_cursor(dw->listview, -1);
 
 	if (dw->idle_id || dw->img_loader || dw->thumb_loader)
 		{
@@ -2082,107 +2435,461 @@ static GList *dupe_setup_point_step(DupeWindow *dw, GList *p)
 	return nullptr;
 }
 
+static gchar *dupe_fast_hash_key(const gchar *prefix, const FastHashDigest &digest)
+{
+	g_autofree gchar *text = fast_hash_digest_to_text(digest);
+
+	return g_strconcat(prefix, text, NULL);
+}
+
 /**
- * @brief Generates the sumcheck or dimensions
- * @param list Set1 or set2
- * @returns TRUE/FALSE = not completed/completed
+ * @brief The checksum stage of #DupePrepareJob
+ * @param data #DupePrepareItem
+ * @param user_data #DupePrepareJob
  *
- * Ensures that the DIs contain the MD5SUM or dimensions for all items in
- * the list. One item at a time. Re-enters if not completed.
+ * An empty checksum is set if the file cannot be read, it matches nothing.
  */
-static gboolean create_checksums_dimensions(DupeWindow *dw, GList *list)
+static void dupe_prepare_checksum_func(gpointer data, gpointer user_data)
 {
-		if ((dw->match_mask & DUPE_MATCH_SUM) ||
-			(dw->match_mask & DUPE_MATCH_NAME_CONTENT) ||
-			(dw->match_mask & DUPE_MATCH_NAME_CI_CONTENT))
+	auto item = static_cast<DupePrepareItem *>(data);
+	auto job = static_cast<DupePrepareJob *>(user_data);
+
+	if (g_atomic_int_get(&job->abort))
+		{
+		/* Skip */
+		}
+	else if (!job->fast)
+		{
+		if (job->use_cache)
 			{
-			/* MD5SUM only */
-			if (!dw->setup_point) dw->setup_point = list; // setup_point clear on 1st entry
+			CacheData cd{};
+			if (cd.load(item->path) && cd.md5sum)
+				{
+				item->md5sum = md5_digest_to_text(cd.md5sum.value());
+				item->md5sum_cached = TRUE;
+				}
+			}
 
-			while (dw->setup_point)
+		if (!item->md5sum)
+			{
+			item->md5sum = md5_text_from_file_utf8(item->path, "");
+			}
+		}
+	else if (!item->full_hash)
+		{
+		CacheData cd{};
+
+		/* A cached full hash makes reading the file unnecessary */
+		if (job->use_cache && cd.load(item->path) && cd.fast_hash)
+			{
+			item->md5sum = dupe_fast_hash_key(DUPE_FAST_HASH_PREFIX, cd.fast_hash.value());
+			item->md5sum_cached = TRUE;
+			}
+		else
+			{
+			g_autofree gchar *pathl = path_from_utf8(item->path);
+
+			item->partial_hash_done = fast_hash_get_partial_digest_from_file(pathl, item->partial_hash, item->partial_hash_complete);
+			if (!item->partial_hash_done)
 				{
-				auto di = static_cast<DupeItem *>(dw->setup_point->data);
+				item->md5sum = g_strdup("");
+				}
+			}
+		}
+	else
+		{
+		CacheData cd{};
 
-				dw->setup_point = dupe_setup_point_step(dw, dw->setup_point);
-				dw->setup_n++;
+		if (job->use_cache && cd.load(item->path) && cd.fast_hash)
+			{
+			item->md5sum = dupe_fast_hash_key(DUPE_FAST_HASH_PREFIX, cd.fast_hash.value());
+			item->md5sum_cached = TRUE;
+			}
+		else
+			{
+			g_autofree gchar *pathl = path_from_utf8(item->path);
+			FastHashDigest digest;
 
-				if (!di->md5sum)
-					{
-					dupe_window_update_progress(dw, _("Reading checksums…"),
-						dw->setup_count == 0 ? 0.0 : static_cast<gdouble>(dw->setup_n - 1) / dw->setup_count, FALSE);
+			if (fast_hash_get_digest_from_file(pathl, digest))
+				{
+				item->md5sum = dupe_fast_hash_key(DUPE_FAST_HASH_PREFIX, digest);
+				}
+			else
+				{
+				item->md5sum = g_strdup("");
+				}
+			}
+		}
 
-					if (options->thumbnails.enable_caching)
-						{
-						dupe_item_read_cache(di);
-						if (di->md5sum)
-							{
-							return TRUE;
-							}
-						}
+	g_atomic_int_add(&job->pending, -1);
+}
 
-					di->md5sum = md5_text_from_file_utf8(di->fd->path, "");
-					if (options->thumbnails.enable_caching)
-						{
-						dupe_item_write_cache(di);
-						}
-					return TRUE;
-					}
+/**
+ * @brief The dimensions stage of #DupePrepareJob
+ * @param data #DupePrepareItem
+ * @param user_data #DupePrepareJob
+ *
+ * Only the image header is read. Formats which GdkPixbuf cannot probe,
+ * and non-image formats, are left for the image loader.
+ */
+static void dupe_prepare_dimensions_func(gpointer data, gpointer user_data)
+{
+	auto item = static_cast<DupePrepareItem *>(data);
+	auto job = static_cast<DupePrepareJob *>(user_data);
+
+	if (!g_atomic_int_get(&job->abort))
+		{
+		if (job->use_cache)
+			{
+			CacheData cd{};
+			if (cd.load(item->path) && cd.dimensions)
+				{
+				item->width = cd.dimensions->width;
+				item->height = cd.dimensions->height;
+				item->dimensions_done = TRUE;
+				item->dimensions_cached = TRUE;
 				}
-			dupe_setup_reset(dw);
 			}
 
-		if ((dw->match_mask & DUPE_MATCH_DIM)  )
+		if (!item->dimensions_done && item->format_class == FORMAT_CLASS_IMAGE)
 			{
-			/* Dimensions only */
-			if (!dw->setup_point) dw->setup_point = list;
+			g_autofree gchar *pathl = path_from_utf8(item->path);
 
-			while (dw->setup_point)
+			item->dimensions_done = (gdk_pixbuf_get_file_info(pathl, &item->width, &item->height) != nullptr);
+			}
+		}
+
+	g_atomic_int_add(&job->pending, -1);
+}
+
+/**
+ * @brief Start computing the checksums and dimensions of both sets
+ * @param dw
+ * @returns FALSE if there is nothing to compute
+ *
+ * With a fast hash, #DupeItem->md5sum holds DUPE_FAST_HASH_PREFIX or
+ * DUPE_PARTIAL_HASH_PREFIX followed by the hash. Checksums of the other
+ * kind, and partial hash keys, are recomputed.
+ */
+static gboolean dupe_prepare_job_start(DupeWindow *dw)
+{
+	const gboolean want_md5sum = (dw->match_mask & DUPE_MATCH_SUM) ||
+	                             (dw->match_mask & DUPE_MATCH_NAME_CONTENT) ||
+	                             (dw->match_mask & DUPE_MATCH_NAME_CI_CONTENT);
+	const gboolean want_dimensions = (dw->match_mask & DUPE_MATCH_DIM);
+
+	if (!want_md5sum && !want_dimensions) return FALSE;
+
+	auto job = new DupePrepareJob();
+	job->use_cache = options->thumbnails.enable_caching;
+	job->fast = want_md5sum && (options->duplicates_fast_checksum & dw->match_mask);
+
+	for (GList *set : {dw->list, dw->second_list})
+		{
+		for (GList *work = set; work; work = work->next)
+			{
+			auto di = static_cast<DupeItem *>(work->data);
+			DupePrepareItem item{};
+
+			if (want_md5sum && di->md5sum)
 				{
-				auto di = static_cast<DupeItem *>(dw->setup_point->data);
+				const gboolean fast_key = g_str_has_prefix(di->md5sum, DUPE_FAST_HASH_PREFIX);
+				const gboolean partial_key = g_str_has_prefix(di->md5sum, DUPE_PARTIAL_HASH_PREFIX);
 
-				dw->setup_point = dupe_setup_point_step(dw, dw->setup_point);
-				dw->setup_n++;
-				if (di->width == 0 && di->height == 0)
+				if (partial_key || (job->fast ? !fast_key && di->md5sum[0] != '\0' : fast_key))
 					{
-					dupe_window_update_progress(dw, _("Reading dimensions…"),
-						dw->setup_count == 0 ? 0.0 : static_cast<gdouble>(dw->setup_n - 1) / dw->setup_count, FALSE);
+					g_clear_pointer(&di->md5sum, g_free);
+					}
+				}
 
-					if (options->thumbnails.enable_caching)
-						{
-						dupe_item_read_cache(di);
-						if (di->width != 0 || di->height != 0)
-							{
-							return TRUE;
-							}
-						}
+			/* In fast mode the checksum stage only reads partial hashes */
+			item.want_checksum = want_md5sum && (job->fast ? !di->partial_hash_done && !di->md5sum : !di->md5sum);
+			item.want_dimensions = want_dimensions && di->width == 0 && di->height == 0;
 
-					image_load_dimensions(di->fd, &di->width, &di->height);
-					di->dimensions = (di->width << 16) + di->height;
-					if (options->thumbnails.enable_caching)
-						{
-						dupe_item_write_cache(di);
-						}
-					return TRUE;
-					}
+			if (item.want_checksum || item.want_dimensions)
+				{
+				item.di = di;
+				item.path = g_strdup(di->fd->path);
+				item.format_class = di->fd->format_class;
+				job->items.push_back(item);
 				}
-			dupe_setup_reset(dw);
 			}
+		}
+
+	/* Partial hash keys are always regrouped */
+	if (job->items.empty() && !job->fast)
+		{
+		delete job;
+		return FALSE;
+		}
+
+	const gint threads = options->threads.duplicates > 0 ? options->threads.duplicates : get_cpu_cores();
+
+	job->checksum_pool = g_thread_pool_new(dupe_prepare_checksum_func, job, std::max(1, threads - DUPE_PREPARE_DIMENSIONS_THREADS), FALSE, nullptr);
+	job->dimensions_pool = g_thread_pool_new(dupe_prepare_dimensions_func, job, std::min(threads, DUPE_PREPARE_DIMENSIONS_THREADS), FALSE, nullptr);
+
+	for (DupePrepareItem &item : job->items)
+		{
+		if (item.want_checksum) job->total++;
+		if (item.want_dimensions) job->total++;
+		}
+	job->pending = job->total;
+
+	for (DupePrepareItem &item : job->items)
+		{
+		if (item.want_checksum) g_thread_pool_push(job->checksum_pool, &item, nullptr);
+		if (item.want_dimensions) g_thread_pool_push(job->dimensions_pool, &item, nullptr);
+		}
+
+	dw->prepare_job = job;
+
+	return TRUE;
+}
+
+/**
+ * @brief Set the fast hash keys of all items from their partial hashes
+ * @param dw
+ *
+ * Items with a partial hash nobody else has cannot have the same content
+ * as any other item, and get a partial hash key. The others are queued
+ * for the full hash round. Items with a full hash from the cache have no
+ * partial hash, so a unique partial hash only counts if no such item has
+ * the same size.
+ */
+static void dupe_prepare_job_group(DupeWindow *dw)
+{
+	DupePrepareJob *job = dw->prepare_job;
+	std::map<FastHashDigest, std::vector<DupeItem *>> groups;
+	std::set<gint64> full_hash_sizes;
+
+	for (GList *set : {dw->list, dw->second_list})
+		{
+		for (GList *work = set; work; work = work->next)
+			{
+			auto di = static_cast<DupeItem *>(work->data);
+			if (!di->partial_hash_done)
+				{
+				if (di->md5sum && g_str_has_prefix(di->md5sum, DUPE_FAST_HASH_PREFIX)) full_hash_sizes.insert(di->fd->size);
+				continue;
+				}
+
+			/* Small files were read completely, and differ in size from all others */
+			if (di->partial_hash_complete)
+				{
+				if (!di->md5sum) di->md5sum = dupe_fast_hash_key(DUPE_FAST_HASH_PREFIX, di->partial_hash);
+				continue;
+				}
+
+			groups[di->partial_hash].push_back(di);
+			}
+		}
+
+	for (const auto &[partial_hash, group] : groups)
+		{
+		for (DupeItem *di : group)
+			{
+			if (di->md5sum) continue;
+
+			if (group.size() == 1 && full_hash_sizes.count(di->fd->size) == 0)
+				{
+				di->md5sum = dupe_fast_hash_key(DUPE_PARTIAL_HASH_PREFIX, partial_hash);
+				continue;
+				}
+
+			DupePrepareItem item{};
+			item.di = di;
+			item.path = g_strdup(di->fd->path);
+			item.want_checksum = TRUE;
+			item.full_hash = TRUE;
+			job->collisions.push_back(item);
+			}
+		}
+}
+
+/**
+ * @brief Copy the results of the stages into the DupeItems
+ * @param dw
+ * @returns TRUE if the full hash round has been queued
+ */
+static gboolean dupe_prepare_job_merge(DupeWindow *dw)
+{
+	DupePrepareJob *job = dw->prepare_job;
+	std::vector<DupePrepareItem> &items = job->collisions_queued ? job->collisions : job->items;
+
+	for (DupePrepareItem &item : items)
+		{
+		DupeItem *di = item.di;
+		if (!di) continue;
+
+		gboolean changed = FALSE;
+
+		if (item.partial_hash_done)
+			{
+			di->partial_hash = item.partial_hash;
+			di->partial_hash_done = TRUE;
+			di->partial_hash_complete = item.partial_hash_complete;
+			}
+
+		if (item.md5sum && !di->md5sum)
+			{
+			di->md5sum = g_steal_pointer(&item.md5sum);
+			changed = changed || (!item.md5sum_cached && di->md5sum[0] != '\0');
+			}
+
+		if (item.dimensions_done && di->width == 0 && di->height == 0)
+			{
+			di->width = item.width;
+			di->height = item.height;
+			di->dimensions = (di->width << 16) + di->height;
+			changed = changed || !item.dimensions_cached;
+			}
+
+		if (changed && job->use_cache)
+			{
+			dupe_item_write_cache(di);
+			}
+		}
+
+	if (job->fast && !job->collisions_queued)
+		{
+		dupe_prepare_job_group(dw);
+		job->collisions_queued = TRUE;
+
+		if (!job->collisions.empty())
+			{
+			job->total += job->collisions.size();
+			g_atomic_int_add(&job->pending, job->collisions.size());
+
+			for (DupePrepareItem &item : job->collisions)
+				{
+				g_thread_pool_push(job->checksum_pool, &item, nullptr);
+				}
+
+			return TRUE;
+			}
+		}
+
+	/* All stage jobs have completed, this only joins the threads */
+	g_thread_pool_free(job->checksum_pool, FALSE, TRUE);
+	job->checksum_pool = nullptr;
+	g_thread_pool_free(job->dimensions_pool, FALSE, TRUE);
+	job->dimensions_pool = nullptr;
+
+	job->merged = TRUE;
 
 	return FALSE;
 }
 
 /**
- * @brief Compare func. for sorting search matches
- * @param a #DupeSearchMatch
- * @param b #DupeSearchMatch
- * @returns
+ * @brief Find the dimensions of the next item which the header probe could not handle
+ * @param dw
+ * @returns FALSE if no items are left
+ */
+static gboolean dupe_prepare_job_fallback_step(DupeWindow *dw)
+{
+	DupePrepareJob *job = dw->prepare_job;
+
+	while (job->next_fallback < job->items.size())
+		{
+		DupePrepareItem &item = job->items[job->next_fallback++];
+		DupeItem *di = item.di;
+
+		if (!di || !item.want_dimensions || item.dimensions_done) continue;
+
+		dupe_window_update_progress(dw, _("Reading dimensions…"),
+			static_cast<gdouble>(job->next_fallback) / job->items.size(), FALSE);
+
+		image_load_dimensions(di->fd, &di->width, &di->height);
+		di->dimensions = (di->width << 16) + di->height;
+		if (job->use_cache)
+			{
+			dupe_item_write_cache(di);
+			}
+
+		return TRUE;
+		}
+
+	return FALSE;
+}
+
+/**
+ * @brief Stop computing checksums and dimensions and wait for the workers to exit
+ * @param dw
+ */
+static void dupe_prepare_job_free(DupeWindow *dw)
+{
+	DupePrepareJob *job = dw->prepare_job;
+	if (!job) return;
+
+	g_atomic_int_set(&job->abort, TRUE);
+
+	/* Queued items are dropped, running ones are waited for */
+	if (job->checksum_pool) g_thread_pool_free(job->checksum_pool, TRUE, TRUE);
+	if (job->dimensions_pool) g_thread_pool_free(job->dimensions_pool, TRUE, TRUE);
+
+	for (auto *items : {&job->items, &job->collisions})
+		{
+		for (DupePrepareItem &item : *items)
+			{
+			g_free(item.path);
+			g_free(item.md5sum);
+			}
+		}
+
+	delete job;
+	dw->prepare_job = nullptr;
+}
+
+/**
+ * @brief Generates the sumcheck or dimensions
+ * @param dw
+ * @returns TRUE/FALSE = not completed/completed
  *
- * Used only for similarity checks\n
- * Sorts search matches on order they were inserted into the pool queue
+ * Ensures that the DIs of both sets contain the MD5SUM or dimensions.
+ * The work is done by a #DupePrepareJob. While its workers run, this is
+ * polled from a timeout instead of idle, and \a dw->idle_id is replaced.
  */
-static gint sort_func(gconstpointer a, gconstpointer b)
+static gboolean create_checksums_dimensions(DupeWindow *dw)
 {
-	return static_cast<const DupeSearchMatch *>(a)->index - static_cast<const DupeSearchMatch *>(b)->index;
+	if (dw->setup_mask & DUPE_MATCH_SUM) return FALSE;
+
+	DupePrepareJob *job = dw->prepare_job;
+
+	if (!job)
+		{
+		if (dupe_prepare_job_start(dw))
+			{
+			dupe_window_update_progress(dw, _("Reading checksums…"), 0.0, FALSE);
+			dw->idle_id = g_timeout_add(DUPE_COMPARE_POLL_INTERVAL, dupe_check_cb, dw);
+			return TRUE;
+			}
+		}
+	else if (!job->merged)
+		{
+		const gint pending = g_atomic_int_get(&job->pending);
+
+		if (pending > 0)
+			{
+			dupe_window_update_progress(dw, _("Reading checksums…"),
+				static_cast<gdouble>(job->total - pending) / job->total, FALSE);
+			return TRUE;
+			}
+
+		if (dupe_prepare_job_merge(dw)) return TRUE;
+
+		dw->idle_id = g_idle_add(dupe_check_cb, dw);
+		return TRUE;
+		}
+	else if (dupe_prepare_job_fallback_step(dw))
+		{
+		return TRUE;
+		}
+
+	dupe_prepare_job_free(dw);
+	dw->setup_mask = static_cast<DupeMatchType>(dw->setup_mask | DUPE_MATCH_SUM);
+	dupe_setup_reset(dw);
+
+	return FALSE;
 }
 
 /**
@@ -2198,7 +2905,6 @@ static gint sort_func(gconstpointer a, gconstpointer b)
 static gboolean dupe_check_cb(gpointer data)
 {
 	auto dw = static_cast<DupeWindow *>(data);
-	DupeSearchMatch *search_match_list_item;
 
 	if (!dw->idle_id)
 		{
@@ -2207,19 +2913,12 @@ static gboolean dupe_check_cb(gpointer data)
 
 	if (!dw->setup_done) /* Clear on 1st entry */
 		{
-		if (dw->list)
-			{
-			if (create_checksums_dimensions(dw, dw->list))
-				{
-				return G_SOURCE_CONTINUE;
-				}
-			}
-		if (dw->second_list)
+		const guint idle_id = dw->idle_id;
+
+		if (create_checksums_dimensions(dw))
 			{
-			if (create_checksums_dimensions(dw, dw->second_list))
-				{
-				return G_SOURCE_CONTINUE;
-				}
+			/* The source is replaced when switching between polling the workers and idle */
+			return (dw->idle_id == idle_id) ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
 			}
 		if ((dw->match_mask & DUPE_MATCH_SIM) &&
 		    !(dw->setup_mask & DUPE_MATCH_SIM_MED) )
@@ -2284,44 +2983,24 @@ static gboolean dupe_check_cb(gpointer data)
 	if (!dw->working)
 		{
 		/* Similarity check threads may still be running */
-		if (dw->setup_count > 0 && (dw->match_mask & DUPE_MATCH_SIM))
+		if (dw->compare_engine)
 			{
-			if( dw->thread_count < dw->queue_count)
+			DupeCompareEngine *engine = dw->compare_engine;
+			const gboolean linked = dupe_compare_engine_link_ready(dw);
+
+			if (!linked || dw->thread_count < dw->queue_count)
 				{
-				g_autofree gchar *progress_text = g_strdup_printf("%s %d/%d", _("Comparing"), dw->thread_count, dw->queue_count);
+				g_mutex_lock(&dw->search_matches_mutex);
+				const gdouble fraction = engine->pairs_total ? static_cast<gdouble>(engine->pairs_done) / engine->pairs_total : 1.0;
+				g_mutex_unlock(&dw->search_matches_mutex);
+				g_autofree gchar *progress_text = g_strdup_printf("%s %d%%", _("Comparing"), static_cast<gint>(fraction * 100.0));
 
-				dupe_window_update_progress(dw, progress_text, (gdouble)dw->thread_count / dw->queue_count, TRUE);
+				dupe_window_update_progress(dw, progress_text, fraction, TRUE);
 
 				return G_SOURCE_CONTINUE;
 				}
 
-			if (dw->search_matches_sorted == nullptr)
-				{
-				dw->search_matches_sorted = g_list_sort(dw->search_matches, sort_func);
-				dupe_setup_reset(dw);
-				}
-
-			while (dw->search_matches_sorted)
-				{
-				dw->setup_n++;
-				dupe_window_update_progress(dw, _("Sorting…"), 0.0, FALSE);
-				search_match_list_item = static_cast<DupeSearchMatch *>(dw->search_matches_sorted->data);
-
-				if (!dupe_match_link_exists(search_match_list_item->a, search_match_list_item->b))
-					{
-					dupe_match_link(search_match_list_item->a, search_match_list_item->b, search_match_list_item->rank);
-					}
-
-				dw->search_matches_sorted = dw->search_matches_sorted->next;
-
-				if (dw->search_matches_sorted != nullptr)
-					{
-					return G_SOURCE_CONTINUE;
-					}
-				}
-			g_list_free(dw->search_matches); // FIXME dw->search_matches doesn't point at the start of the list after g_list_sort() call
-			dw->search_matches = nullptr;
-			dw->search_matches_sorted = nullptr;
+			dupe_compare_engine_free(dw);
 			dw->setup_count = 0;
 			}
 		else
@@ -2354,13 +3033,15 @@ static gboolean dupe_check_cb(gpointer data)
 	/* Setup done - working */
 	if (dw->match_mask & DUPE_MATCH_SIM)
 		{
-		/* This is the similarity comparison */
-		dupe_list_check_match(dw, static_cast<DupeItem *>(dw->working->data), dw->working);
-		dupe_window_update_progress(dw, _("Queuing…"), dw->setup_count == 0 ? 0.0 : static_cast<gdouble>(dw->setup_n) / dw->setup_count, FALSE);
-		dw->setup_n++;
-		dw->queue_count++;
+		/* This is the similarity comparison.
+		 * The thread pool processes the entire list, this is polled until done
+		 */
+		dw->working = nullptr;
+		dupe_window_update_progress(dw, _("Comparing…"), 0.0, FALSE);
+		dupe_compare_engine_start(dw);
 
-		dw->working = dw->working->prev; /* Is NULL when complete */
+		dw->idle_id = g_timeout_add(DUPE_COMPARE_POLL_INTERVAL, dupe_check_cb, dw);
+		return G_SOURCE_REMOVE;
 		}
 	else
 		{
@@ -2382,6 +3063,9 @@ static void dupe_check_start(DupeWindow *dw)
 	dw->setup_count = g_list_length(dw->list);
 	if (dw->second_set) dw->setup_count += g_list_length(dw->second_list);
 
+	/* A running comparison or job may have missed items added since */
+	dupe_compare_engine_free(dw);
+	dupe_prepare_job_free(dw);
 	dw->setup_mask = DUPE_MATCH_NONE;
 	dupe_setup_reset(dw);
 
@@ -2391,7 +3075,6 @@ static void dupe_check_start(DupeWindow *dw)
 	widget_set_cursor(dw->listview, GDK_WATCH);
 	dw->queue_count = 0;
 	dw->thread_count = 0;
-	dw->search_matches_sorted = nullptr;
 	dw->abort = FALSE;
 
 	if (dw->idle_id) return;
@@ -2414,9 +3097,26 @@ static gboolean dupe_check_start_cb(gpointer data)
 
 static void dupe_item_remove(DupeWindow *dw, DupeItem *di)
 {
+	gboolean dropped = FALSE;
+
 	if (!di) return;
 
 	/* handle things that may be in progress… */
+	if (dw->compare_engine)
+		{
+		/* The comparison threads may hold di, the engine frees it */
+		dropped = dupe_compare_engine_drop(dw, di);
+		}
+	if (dw->prepare_job)
+		{
+		for (auto *items : {&dw->prepare_job->items, &dw->prepare_job->collisions})
+			{
+			for (DupePrepareItem &item : *items)
+				{
+				if (item.di == di) item.di = nullptr;
+				}
+			}
+		}
 	if (dw->working && dw->working->data == di)
 		{
 		dw->working = dw->working->prev;
@@ -2493,7 +3193,7 @@ static void dupe_item_remove(DupeWindow *dw, DupeItem *di)
 		{
 		dw->list = g_list_remove(dw->list, di);
 		}
-	dupe_item_free(di);
+	if (!dropped) dupe_item_free(di);
 
 	dupe_window_update_count(dw, FALSE);
 }
@@ -3621,6 +4321,7 @@ static void dupe_menu_type_cb(GtkWidget *combo, gpointer data)
 	options->duplicates_match = dw->match_mask;
 
 	dupe_listview_show_rank(dw->listview, dw->match_mask & DUPE_MATCH_SIM);
+	dupe_window_update_fast_checksum(dw);
 	dupe_window_recompare(dw);
 }
 
@@ -3802,7 +4503,7 @@ static void dupe_window_show_thumb_cb(GtkWidget *widget, gpointer data)
 
 	if (dw->show_thumbs)
 		{
-		if (!dw->working) dupe_thumb_step(dw);
+		if (!dw->working && !dw->compare_engine) dupe_thumb_step(dw);
 		}
 	else
 		{
@@ -3835,6 +4536,47 @@ static void dupe_window_rotation_invariant_cb(GtkWidget *widget, gpointer data)
 	dupe_window_recompare(dw);
 }
 
+static gboolean dupe_match_uses_checksum(DupeMatchType mask)
+{
+	return (mask & (DUPE_MATCH_SUM | DUPE_MATCH_NAME_CONTENT | DUPE_MATCH_NAME_CI_CONTENT)) != 0;
+}
+
+/**
+ * @brief Show whether the current match mode uses the fast hash
+ * @param dw
+ *
+ * The setting is kept per match mode.
+ */
+static void dupe_window_update_fast_checksum(DupeWindow *dw)
+{
+	gtk_widget_set_sensitive(dw->button_fast_checksum, dupe_match_uses_checksum(dw->match_mask));
+	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(dw->button_fast_checksum),
+	                             (options->duplicates_fast_checksum & dw->match_mask) != 0);
+}
+
+static void dupe_window_fast_checksum_cb(GtkWidget *widget, gpointer data)
+{
+	auto dw = static_cast<DupeWindow *>(data);
+	guint fast_checksum = options->duplicates_fast_checksum;
+
+	if (!dupe_match_uses_checksum(dw->match_mask)) return;
+
+	if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(widget)))
+		{
+		fast_checksum |= dw->match_mask;
+		}
+	else
+		{
+		fast_checksum &= ~dw->match_mask;
+		}
+
+	/* Also called when the match mode changes */
+	if (fast_checksum == options->duplicates_fast_checksum) return;
+
+	options->duplicates_fast_checksum = fast_checksum;
+	dupe_window_recompare(dw);
+}
+
 static void dupe_window_custom_threshold_cb(GtkSpinButton *custom_threshold, gpointer data)
 {
 	auto dw = static_cast<DupeWindow *>(data);
@@ -4106,6 +4848,9 @@ void dupe_window_close(DupeWindow *dw)
 	file_data_unregister_notify_func(dupe_notify_cb, dw);
 
 	g_thread_pool_free(dw->dupe_comparison_thread_pool, TRUE, TRUE);
+	g_cond_clear(&dw->thread_count_cond);
+	g_mutex_clear(&dw->thread_count_mutex);
+	g_mutex_clear(&dw->search_matches_mutex);
 
 	g_free(dw);
 }
@@ -4459,6 +5204,14 @@ DupeWindow *dupe_window_new()
 	gq_gtk_box_pack_start(GTK_BOX(controls_box), dw->button_rotation_invariant, FALSE, FALSE, PREF_PAD_SPACE);
 	gtk_widget_show(dw->button_rotation_invariant);
 
+	dw->button_fast_checksum = gtk_check_button_new_with_label(_("Fast checksum"));
+	gtk_widget_set_tooltip_text(dw->button_fast_checksum, _("Compare content with a fast non-cryptographic hash instead of MD5.\nThe setting applies to the current match type only."));
+	dupe_window_update_fast_checksum(dw);
+	g_signal_connect(G_OBJECT(dw->button_fast_checksum), "toggled",
+			 G_CALLBACK(dupe_window_fast_checksum_cb), dw);
+	gq_gtk_box_pack_start(GTK_BOX(controls_box), dw->button_fast_checksum, FALSE, FALSE, PREF_PAD_SPACE);
+	gtk_widget_show(dw->button_fast_checksum);
+
 	button = gtk_check_button_new_with_label(_("Compare two file sets"));
 	gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(button), dw->second_set);
 	g_signal_connect(G_OBJECT(button), "toggled",
@@ -4520,6 +5273,7 @@ DupeWindow *dupe_window_new()
 	file_data_register_notify_func(dupe_notify_cb, dw, NOTIFY_PRIORITY_MEDIUM);
 
 	g_mutex_init(&dw->thread_count_mutex);
+	g_cond_init(&dw->thread_count_cond);
 	g_mutex_init(&dw->search_matches_mutex);
 	dw->dupe_comparison_thread_pool = g_thread_pool_new(dupe_comparison_func, dw, options->threads.duplicates, FALSE, nullptr);
 
@@ -26,8 +26,12 @@
 #include <glib.h>
 #include <gtk/gtk.h>
 
+#include "fast-hash.h"
+
 struct CollectInfo;
 struct CollectionData;
+struct DupeCompareEngine;
+struct DupePrepareJob;
 class FileData;
 struct ImageLoader;
 struct ImageSimilarityData;
@@ -70,7 +74,10 @@ struct DupeItem
 
 	FileData *fd;
 
-	gchar *md5sum;
+	gchar *md5sum; /**< MD5 as text, or a fast hash key, see dupe_prepare_job_start() */
+	FastHashDigest partial_hash;
+	gboolean partial_hash_done;
+	gboolean partial_hash_complete; /**< The file was small enough for \a partial_hash to cover all of it */
 	gint width;
 	gint height;
 	gint dimensions; /**< Computed as (#DupeItem->width << 16) + #DupeItem->height */
@@ -105,6 +112,7 @@ struct DupeWindow
 	GtkWidget *extra_label; /**< Progress bar widget */
 	GtkWidget *button_thumbs;
 	GtkWidget *button_rotation_invariant;
+	GtkWidget *button_fast_checksum;
 	GtkWidget *custom_threshold;
 	GList *add_files_queue;
 	guint add_files_queue_id;
@@ -148,12 +156,13 @@ struct DupeWindow
 
 	/* required for similarity threads */
 	GThreadPool *dupe_comparison_thread_pool;
-	GList *search_matches; /**< List of similarity matches (#DupeSearchMatch) */
-	GMutex search_matches_mutex;
-	GList *search_matches_sorted; /**< \a search_matches sorted by order of entry into thread pool */
-	gint queue_count; /**< Incremented each time an item is pushed onto the similarity thread pool */
-	gint thread_count; /**< Incremented each time a similarity check thread item is completed */
+	DupeCompareEngine *compare_engine; /**< Tiled similarity comparison in progress, or NULL */
+	DupePrepareJob *prepare_job; /**< Checksums and dimensions being computed, or NULL */
+	GMutex search_matches_mutex; /**< Protects the band results of \a compare_engine */
+	gint queue_count; /**< Incremented each time a worker job is pushed onto the similarity thread pool */
+	gint thread_count; /**< Incremented each time a similarity check worker job is completed */
 	GMutex thread_count_mutex;
+	GCond thread_count_cond; /**< Signalled each time \a thread_count is incremented */
 	gboolean abort; /**< Stop the similarity check thread queue */
 };
 
@@ -27,31 +27,36 @@
 #endif
 #endif
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <list>
 #include <numeric>
+#include <string>
+#include <unordered_map>
+#include <utility>
 
 #include <glib.h>
 
 #include "cache.h"
 #include "color-man-heif.h"
 #include "color-man.h"
+#include "debug.h"
 #include "filecache.h"
 #include "filedata.h"
 #include "intl.h"
 #include "jpeg-parser.h"
 #include "main-defines.h"
 #include "misc.h"
+#include "options.h"
 #include "third-party/zonedetect.h"
 #include "ui-fileops.h"
 
 namespace
 {
 
-G_DEFINE_AUTOPTR_CLEANUP_FUNC(ZoneDetect, ZDCloseDatabase)
-
 struct ExifFormattedText
 {
 	const gchar *key;
@@ -159,48 +164,8 @@ gchar *exif_build_formatted_Camera(ExifData *exif)
 	g_autofree gchar *make = exif_get_data_as_text(exif, "Exif.Image.Make");
 	g_autofree gchar *model = exif_get_data_as_text(exif, "Exif.Image.Model");
 	g_autofree gchar *software = exif_get_data_as_text(exif, "Exif.Image.Software");
-	gchar *model2;
-	gchar *software2;
-
-	if (make)
-		{
-		g_strstrip(make);
-
-		if (remove_suffix(make, " CORPORATION", 12)) { /* Nikon */ }
-		else if (remove_suffix(make, " Corporation", 12)) { /* Pentax */ }
-		else if (remove_suffix(make, " OPTICAL CO.,LTD", 16)) { /* OLYMPUS */ };
-		}
-
-	if (model)
-		g_strstrip(model);
-
-	if (software)
-		{
-		gint i;
-		gint j;
-
-		g_strstrip(software);
-
-		/* remove superfluous spaces (pentax K100D) */
-		for (i = 0, j = 0; software[i]; i++, j++)
-			{
-			if (software[i] == ' ' && software[i + 1] == ' ')
-				i++;
-			if (i != j) software[j] = software[i];
-			}
-		software[j] = '\0';
-		}
-
-	model2 = remove_common_prefix(make, model);
-	software2 = remove_common_prefix(model2, software);
 
-	return g_strdup_printf("%s%s%s%s%s%s",
-	                       make ? make : "",
-	                       (make && model2) ? " " : "",
-	                       model2 ? model2 : "",
-	                       (software2 && (make || model2)) ? " (" : "",
-	                       software2 ? software2 : "",
-	                       (software2 && (make || model2)) ? ")" : "");
+	return exif_format_camera(make, model, software);
 }
 
 gchar *exif_build_formatted_DateTime(ExifData *exif, const gchar *text_key, const gchar *subsec_key)
@@ -568,6 +533,123 @@ void ZoneDetect_onError(int errZD, int errNative)
 	log_printf("Error: ZoneDetect %s (0x%08X)\n", ZDGetErrorString(errZD), (unsigned)errNative);
 }
 
+/* Lookups are cached per cell of 1/TIMEZONE_CELLS_PER_DEGREE degrees */
+constexpr gint TIMEZONE_CELLS_PER_DEGREE = 10;
+constexpr gsize TIMEZONE_CACHE_MAX_ENTRIES = 1024;
+
+/**
+ * @brief The result of a timezone database lookup
+ *
+ * The result is valid for any position within \a safezone degrees of
+ * the looked up one.
+ */
+struct TimezoneCacheEntry
+{
+	guint32 cell;
+	gfloat latitude;
+	gfloat longitude;
+	gfloat safezone;
+	std::optional<std::string> timezone;
+	std::optional<std::string> countryname;
+	std::optional<std::string> countryalpha2;
+};
+
+GMutex timezone_mutex;
+ZoneDetect *timezone_database = nullptr;
+gboolean timezone_database_checked = FALSE; /**< the database is not opened again after a failure */
+std::list<TimezoneCacheEntry> timezone_cache; /**< most recently used first */
+std::unordered_map<guint32, std::list<TimezoneCacheEntry>::iterator> timezone_cache_cells;
+
+/**
+ * @brief Gets the timezone database, which is kept open for the lifetime of the process
+ * @returns nullptr if the database is not installed or can not be read
+ *
+ * Must be called with timezone_mutex held.
+ */
+ZoneDetect *timezone_database_get()
+{
+	if (timezone_database || timezone_database_checked) return timezone_database;
+
+	timezone_database_checked = TRUE;
+
+	g_autofree gchar *timezone_path = g_build_filename(get_rc_dir(), TIMEZONE_DATABASE_FILE, NULL);
+	if (!g_file_test(timezone_path, G_FILE_TEST_EXISTS)) return nullptr;
+
+	ZDSetErrorHandler(ZoneDetect_onError);
+
+	timezone_database = ZDOpenDatabase(timezone_path);
+	if (!timezone_database)
+		{
+		log_printf("Error: Init of timezone database %s failed\n", timezone_path);
+		}
+
+	return timezone_database;
+}
+
+/**
+ * @brief Looks up the timezone of a position, in the cache first
+ * @returns nullptr if the timezone database is not available
+ *
+ * Must be called with timezone_mutex held. The entry is valid until the next call.
+ */
+const TimezoneCacheEntry *timezone_cache_lookup(gfloat latitude, gfloat longitude)
+{
+	const auto cell_of = [](gfloat value, gint range)
+	{
+		return static_cast<guint32>(std::clamp(static_cast<gint>(std::floor(value * TIMEZONE_CELLS_PER_DEGREE)), -range, range) + range);
+	};
+	const guint32 cell = (cell_of(latitude, 90 * TIMEZONE_CELLS_PER_DEGREE) * (360 * TIMEZONE_CELLS_PER_DEGREE + 1)) +
+	                     cell_of(longitude, 180 * TIMEZONE_CELLS_PER_DEGREE);
+
+	const auto it = timezone_cache_cells.find(cell);
+	if (it != timezone_cache_cells.end())
+		{
+		const TimezoneCacheEntry &entry = *it->second;
+
+		/* The safezone is in degrees of latitude, a degree of longitude is half as long in the database */
+		if (std::fabs(latitude - entry.latitude) + (std::fabs(longitude - entry.longitude) / 2) < entry.safezone)
+			{
+			timezone_cache.splice(timezone_cache.begin(), timezone_cache, it->second);
+			return &timezone_cache.front();
+			}
+
+		timezone_cache.erase(it->second);
+		timezone_cache_cells.erase(it);
+		}
+
+	ZoneDetect *database = timezone_database_get();
+	if (!database) return nullptr;
+
+	TimezoneCacheEntry entry{cell, latitude, longitude, 0.0F, {}, {}, {}};
+
+	ZoneDetectResult *results = ZDLookup(database, latitude, longitude, &entry.safezone);
+	if (!results) return nullptr;
+
+	/* Without any zone there is no border to measure the safezone from */
+	if (results[0].lookupResult == ZD_LOOKUP_END) entry.safezone = 0.0F;
+
+	g_autofree gchar *timezone = nullptr;
+	g_autofree gchar *countryname = nullptr;
+	g_autofree gchar *countryalpha2 = nullptr;
+	zd_tz(results, &timezone, &countryname, &countryalpha2);
+	ZDFreeResults(results);
+
+	if (timezone) entry.timezone = timezone;
+	if (countryname) entry.countryname = countryname;
+	if (countryalpha2) entry.countryalpha2 = countryalpha2;
+
+	if (timezone_cache.size() >= TIMEZONE_CACHE_MAX_ENTRIES)
+		{
+		timezone_cache_cells.erase(timezone_cache.back().cell);
+		timezone_cache.pop_back();
+		}
+
+	timezone_cache.push_front(std::move(entry));
+	timezone_cache_cells[cell] = timezone_cache.begin();
+
+	return &timezone_cache.front();
+}
+
 /**
  * @brief Gets timezone data from an exif structure
  * @param[in] exif
@@ -601,23 +683,19 @@ bool exif_build_tz_data(ExifData *exif, gchar **timezone, gchar **countryname, g
 	auto longitude = get_latlon("Exif.GPSInfo.GPSLongitude", "Exif.GPSInfo.GPSLongitudeRef", "West");
 	if (!longitude) return false;
 
-	g_autofree gchar *timezone_path = g_build_filename(get_rc_dir(), TIMEZONE_DATABASE_FILE, NULL);
-	if (!g_file_test(timezone_path, G_FILE_TEST_EXISTS)) return false;
+	g_mutex_lock(&timezone_mutex);
 
-	ZDSetErrorHandler(ZoneDetect_onError);
-
-	g_autoptr(ZoneDetect) cd = ZDOpenDatabase(timezone_path);
-	if (!cd)
+	const TimezoneCacheEntry *entry = timezone_cache_lookup(latitude.value(), longitude.value());
+	if (entry)
 		{
-		log_printf("Error: Init of timezone database %s failed\n", timezone_path);
-		return false;
+		if (timezone) *timezone = entry->timezone ? g_strdup(entry->timezone->c_str()) : nullptr;
+		if (countryname && entry->countryname) *countryname = g_strdup(entry->countryname->c_str());
+		if (countryalpha2 && entry->countryalpha2) *countryalpha2 = g_strdup(entry->countryalpha2->c_str());
 		}
 
-	ZoneDetectResult *results = ZDLookup(cd, latitude.value(), longitude.value(), nullptr);
-	if (!results) return false;
+	g_mutex_unlock(&timezone_mutex);
 
-	zd_tz(results, timezone, countryname, countryalpha2);
-	return true;
+	return entry != nullptr;
 }
 
 /**
@@ -786,13 +864,120 @@ const ExifFormattedText ExifFormattedList[] = {
 	{"lua.lensID",				N_("Lens"), 		nullptr},
 };
 
+/* The Exif data of that many recently read files are kept even when over the budget,
+ * callers use fd->exif after reading other files */
+constexpr guint EXIF_CACHE_MIN_ENTRIES = 4;
+
+GList *exif_prefetch_queue = nullptr; /**< list of (FileData *) */
+guint exif_prefetch_id = 0; /**< event source id */
+
 void exif_release_cb(FileData *fd)
 {
 	g_clear_pointer(&fd->exif, exif_free);
 }
 
+FileCacheData *exif_get_cache()
+{
+	static FileCacheData *cache = nullptr;
+
+	if (!cache)
+		{
+		cache = file_cache_new(exif_release_cb, 0);
+		file_cache_set_min_entries(cache, EXIF_CACHE_MIN_ENTRIES);
+		}
+	file_cache_set_max_size(cache, static_cast<gulong>(options->image.exif_cache_max) * 1048576); /* update from options */
+	return cache;
+}
+
+gboolean exif_prefetch_cb(gpointer)
+{
+	if (!exif_prefetch_queue)
+		{
+		exif_prefetch_id = 0;
+		return G_SOURCE_REMOVE;
+		}
+
+	auto fd = static_cast<FileData *>(exif_prefetch_queue->data);
+	exif_prefetch_queue = g_list_delete_link(exif_prefetch_queue, exif_prefetch_queue);
+
+	DEBUG_2("exif prefetch: %s", fd->path);
+	exif_free_fd(fd, exif_read_fd(fd));
+	file_data_unref(fd);
+
+	return G_SOURCE_CONTINUE;
+}
+
 } // namespace
 
+/**
+ * @brief Closes the timezone database and clears the lookup cache
+ *
+ * To be called when the database file is replaced.
+ */
+void exif_timezone_database_reset()
+{
+	g_mutex_lock(&timezone_mutex);
+
+	g_clear_pointer(&timezone_database, ZDCloseDatabase);
+	timezone_database_checked = FALSE;
+	timezone_cache.clear();
+	timezone_cache_cells.clear();
+
+	g_mutex_unlock(&timezone_mutex);
+}
+
+/**
+ * @brief Builds the text of the formatted.Camera tag
+ * @param make, model, software the Exif tags, or NULL; they are modified
+ *
+ * Shortens the names, as in "Canon EOS 80D (Firmware 1.0.2)".
+ */
+gchar *exif_format_camera(gchar *make, gchar *model, gchar *software)
+{
+	gchar *model2;
+	gchar *software2;
+
+	if (make)
+		{
+		g_strstrip(make);
+
+		if (remove_suffix(make, " CORPORATION", 12)) { /* Nikon */ }
+		else if (remove_suffix(make, " Corporation", 12)) { /* Pentax */ }
+		else if (remove_suffix(make, " OPTICAL CO.,LTD", 16)) { /* OLYMPUS */ };
+		}
+
+	if (model)
+		g_strstrip(model);
+
+	if (software)
+		{
+		gint i;
+		gint j;
+
+		g_strstrip(software);
+
+		/* remove superfluous spaces (pentax K100D) */
+		for (i = 0, j = 0; software[i]; i++, j++)
+			{
+			if (software[i] == ' ' && software[i + 1] == ' ')
+				i++;
+			if (i != j) software[j] = software[i];
+			}
+		software[j] = '\0';
+		}
+
+	model2 = remove_common_prefix(make, model);
+	software2 = remove_common_prefix(model2, software);
+
+	return g_strdup_printf("%s%s%s%s%s%s",
+	                       make ? make : "",
+	                       (make && model2) ? " " : "",
+	                       model2 ? model2 : "",
+	                       (software2 && (make || model2)) ? " (" : "",
+	                       software2 ? software2 : "",
+	                       (software2 && (make || model2)) ? ")" : "");
+}
+
 GHashTable *exif_get_formatted(ExifData *exif)
 {
 	GHashTable *formatted = g_hash_table_new_full(g_str_hash, g_str_equal, nullptr, g_free);
@@ -849,18 +1034,15 @@ gchar *exif_get_data_as_text(ExifData *exif, const gchar *key)
 }
 
 
-ExifData *exif_read_fd(FileData *fd)
+/**
+ * @brief Gets the XMP sidecar which exif_read_fd() reads with the image of \a fd
+ * @returns the path, or nullptr if there is none
+ */
+gchar *exif_get_sidecar_path(FileData *fd)
 {
-	if (!fd) return nullptr;
-
-	static FileCacheData *exif_cache = file_cache_new(exif_release_cb, 4);
-
-	if (file_cache_get(exif_cache, fd)) return fd->exif;
-	g_assert(fd->exif == nullptr);
-
 	/* CacheType::XMP_METADATA file should exist only if the metadata are
 	 * not writable directly, thus it should contain the most up-to-date version */
-	g_autofree gchar *sidecar_path = nullptr;
+	gchar *sidecar_path = nullptr;
 
 #if HAVE_EXIV2
 	/* we are not able to handle XMP sidecars without exiv2 */
@@ -869,12 +1051,97 @@ ExifData *exif_read_fd(FileData *fd)
 	if (!sidecar_path) sidecar_path = file_data_get_sidecar_path(fd, TRUE);
 #endif
 
+	return sidecar_path;
+}
+
+ExifData *exif_read_fd(FileData *fd)
+{
+	if (!fd) return nullptr;
+
+	FileCacheData *exif_cache = exif_get_cache();
+
+	if (file_cache_get(exif_cache, fd)) return fd->exif;
+	g_assert(fd->exif == nullptr);
+
+	g_autofree gchar *sidecar_path = exif_get_sidecar_path(fd);
+
+	const gint64 start = g_get_monotonic_time();
 	fd->exif = exif_read(fd->path, sidecar_path, fd->modified_xmp);
+	const auto read_time = static_cast<guint64>(g_get_monotonic_time() - start);
 
-	file_cache_put(exif_cache, fd, 1);
+	/* Files that were slow to read are kept longer */
+	file_cache_put(exif_cache, fd, exif_get_memory_size(fd->exif), read_time);
 	return fd->exif;
 }
 
+/**
+ * @brief Adds Exif data which were read in another thread to the cache
+ * @param exif read by exif_read() from fd->path and exif_get_sidecar_path(), without modified XMP
+ * @param read_time how long the read took, in microseconds
+ *
+ * \a exif is owned by the cache, or freed if the cache has data for \a fd
+ * already or if \a fd has unsaved changes.
+ */
+void exif_cache_put_fd(FileData *fd, ExifData *exif, guint64 read_time)
+{
+	FileCacheData *exif_cache = exif_get_cache();
+
+	if (fd->modified_xmp || file_cache_get(exif_cache, fd))
+		{
+		exif_free(exif);
+		return;
+		}
+	g_assert(fd->exif == nullptr);
+
+	fd->exif = exif;
+	file_cache_put(exif_cache, fd, exif_get_memory_size(fd->exif), read_time);
+}
+
+/**
+ * @brief Reads the Exif data of the files of \a list into the cache, when idle
+ * @param list list of (FileData *), the files are referenced, the list is not modified
+ *
+ * Replaces the files queued by a previous call. Files are read in order,
+ * until the cache is full.
+ */
+void exif_prefetch_list(GList *list)
+{
+	g_list_free_full(exif_prefetch_queue, reinterpret_cast<GDestroyNotify>(file_data_unref));
+	exif_prefetch_queue = nullptr;
+
+	if (options->image.exif_cache_max > 0)
+		{
+		/* Each file is assumed to need as much as the average cached file */
+		const FileCacheStats stats = exif_cache_get_stats();
+		gulong size = stats.size;
+		const gulong file_size = stats.entries ? stats.size / stats.entries : 0;
+
+		for (GList *work = list; work && size + file_size <= stats.max_size; work = work->next)
+			{
+			auto fd = static_cast<FileData *>(work->data);
+
+			exif_prefetch_queue = g_list_prepend(exif_prefetch_queue, file_data_ref(fd));
+			size += file_size;
+			}
+		exif_prefetch_queue = g_list_reverse(exif_prefetch_queue);
+		}
+
+	if (exif_prefetch_queue && !exif_prefetch_id)
+		{
+		exif_prefetch_id = g_idle_add_full(G_PRIORITY_LOW, exif_prefetch_cb, nullptr, nullptr);
+		}
+	else if (!exif_prefetch_queue && exif_prefetch_id)
+		{
+		g_source_remove(exif_prefetch_id);
+		exif_prefetch_id = 0;
+		}
+}
+
+FileCacheStats exif_cache_get_stats()
+{
+	return file_cache_get_stats(exif_get_cache());
+}
+
 
 void exif_free_fd(FileData *fd, ExifData *exif)
 {
@@ -1217,6 +1217,23 @@ void exif_free(ExifData *exif)
 	g_free(exif);
 }
 
+/**
+ * @brief Estimates the memory used by \a exif, for the Exif cache accounting
+ */
+gulong exif_get_memory_size(ExifData *exif)
+{
+	if (!exif) return 0;
+
+	gulong size = sizeof(ExifData);
+	for (GList *work = exif->items; work; work = work->next)
+		{
+		auto item = static_cast<ExifItem *>(work->data);
+		size += sizeof(GList) + sizeof(ExifItem) + item->data_len;
+		}
+
+	return size;
+}
+
 ExifData *exif_read(gchar *path, gchar *, GHashTable *)
 {
 	ExifData *exif;
@@ -32,6 +32,7 @@ enum MetadataFormat : gint;
 struct ColorManMemData;
 struct ExifData;
 struct ExifItem;
+struct FileCacheStats;
 class FileData;
 
 
@@ -78,6 +79,7 @@ gboolean exif_write(ExifData *exif);
 gboolean exif_write_sidecar(ExifData *exif, gchar *path);
 
 void exif_free(ExifData *exif);
+gulong exif_get_memory_size(ExifData *exif);
 
 ExifItem *exif_get_item(ExifData *exif, const gchar *key);
 ExifItem *exif_get_first_item(ExifData *exif);
@@ -124,12 +126,19 @@ std::optional<gchar *> exif_get_formatted_by_key(ExifData *exif, const gchar *ke
 gchar *exif_get_description_by_key(const gchar *key);
 
 gchar *exif_get_data_as_text(ExifData *exif, const gchar *key);
+gchar *exif_format_camera(gchar *make, gchar *model, gchar *software);
 
+gchar *exif_get_sidecar_path(FileData *fd);
 ExifData *exif_read_fd(FileData *fd);
 void exif_free_fd(FileData *fd, ExifData *exif);
+void exif_cache_put_fd(FileData *fd, ExifData *exif, guint64 read_time);
+void exif_prefetch_list(GList *list);
+FileCacheStats exif_cache_get_stats();
 
 ColorManMemData exif_get_color_profile(FileData *fd, ColorManProfileType &color_profile_from_image);
 
+void exif_timezone_database_reset();
+
 /* jpeg embedded icc support */
 bool exif_jpeg_parse_color(ExifData *exif, const guchar *data, guint size);
 
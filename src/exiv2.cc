@@ -393,12 +393,31 @@ public:
 
 
 
+static GMutex xmp_toolkit_mutex;
+
+static void xmp_toolkit_lock(void *data, bool lock)
+{
+	auto mutex = static_cast<GMutex *>(data);
+
+	if (lock)
+		{
+		g_mutex_lock(mutex);
+		}
+	else
+		{
+		g_mutex_unlock(mutex);
+		}
+}
+
 void exif_init()
 {
 #ifdef EXV_ENABLE_NLS
 	bind_textdomain_codeset (EXV_PACKAGE, "UTF-8");
 #endif
 
+	/* exif_read() is called from the search threads too */
+	Exiv2::XmpParser::initialize(xmp_toolkit_lock, &xmp_toolkit_mutex);
+
 #if !EXIV2_TEST_VERSION(0,28,3)
 #ifdef EXV_ENABLE_BMFF
 	Exiv2::enableBMFF(true);
@@ -454,6 +473,39 @@ void exif_free(ExifData *exif)
 	delete exif;
 }
 
+/**
+ * @brief Estimates the memory used by \a exif, for the Exif cache accounting
+ *
+ * Counts the values and a fixed overhead per item, for the processed
+ * data and the original data of the image they were read from.
+ */
+gulong exif_get_memory_size(ExifData *exif)
+{
+	if (!exif) return 0;
+
+	static constexpr gulong item_overhead = 128; /* key, type info, container node */
+
+	const auto metadata_size = [](auto &metadata)
+	{
+		gulong size = 0;
+		for (const auto &md : metadata)
+			{
+			size += item_overhead + md.size();
+			}
+		return size;
+	};
+
+	gulong size = sizeof(ExifDataProcessed);
+	for (ExifData *data : {exif, exif->original()})
+		{
+		if (!data) continue;
+
+		size += metadata_size(data->exifData()) + metadata_size(data->iptcData()) + metadata_size(data->xmpData());
+		}
+
+	return size;
+}
+
 ExifData *exif_get_original(ExifData *exif)
 {
 	return exif->original();
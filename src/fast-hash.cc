@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "fast-hash.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "ui-fileops.h"
+
+namespace
+{
+
+constexpr guint64 PRIME32_1 = 0x9E3779B1U;
+constexpr guint64 PRIME32_2 = 0x85EBCA77U;
+constexpr guint64 PRIME32_3 = 0xC2B2AE3DU;
+constexpr guint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr guint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr guint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr guint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr guint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+constexpr gsize SECRET_WORDS = 24; /**< Stripe keys slide over the first 16 + 8 words */
+constexpr gsize PARTIAL_SIZE = 64 * 1024; /**< Bytes hashed at each end of a file by the partial hash */
+constexpr gsize READ_SIZE = 64 * 1024;
+
+constexpr std::array<guint64, SECRET_WORDS> make_secret()
+{
+	std::array<guint64, SECRET_WORDS> secret{};
+	guint64 x = PRIME64_5;
+
+	/* splitmix64 */
+	for (guint64 &s : secret)
+		{
+		x += 0x9E3779B97F4A7C15ULL;
+		guint64 z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		s = z ^ (z >> 31);
+		}
+
+	return secret;
+}
+
+constexpr std::array<guint64, SECRET_WORDS> secret = make_secret();
+
+inline guint64 read64(const guchar *p)
+{
+	guint64 v;
+	memcpy(&v, p, sizeof(v));
+	return GUINT64_FROM_LE(v);
+}
+
+inline void write64(guchar *p, guint64 v)
+{
+	v = GUINT64_TO_LE(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+inline guint64 mul128_fold64(guint64 a, guint64 b)
+{
+#ifdef __SIZEOF_INT128__
+	const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	return static_cast<guint64>(product) ^ static_cast<guint64>(product >> 64);
+#else
+	const guint64 a_lo = a & 0xFFFFFFFFU;
+	const guint64 a_hi = a >> 32;
+	const guint64 b_lo = b & 0xFFFFFFFFU;
+	const guint64 b_hi = b >> 32;
+
+	const guint64 lo_lo = a_lo * b_lo;
+	const guint64 hi_lo = a_hi * b_lo;
+	const guint64 lo_hi = a_lo * b_hi;
+	const guint64 hi_hi = a_hi * b_hi;
+
+	const guint64 cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFU) + lo_hi;
+	const guint64 upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	const guint64 lower = (cross << 32) | (lo_lo & 0xFFFFFFFFU);
+
+	return lower ^ upper;
+#endif
+}
+
+inline guint64 avalanche(guint64 h)
+{
+	h ^= h >> 37;
+	h *= 0x165667919E3779F9ULL;
+	h ^= h >> 32;
+	return h;
+}
+
+guint64 merge_accs(const std::array<guint64, 8> &acc, gsize secret_offset, guint64 start)
+{
+	guint64 result = start;
+
+	for (gsize i = 0; i < 4; i++)
+		{
+		result += mul128_fold64(acc[2 * i] ^ secret[secret_offset + (2 * i)],
+		                        acc[(2 * i) + 1] ^ secret[secret_offset + (2 * i) + 1]);
+		}
+
+	return avalanche(result);
+}
+
+gboolean hash_stream(FILE *fp, FastHash &hash, gsize limit)
+{
+	guchar buf[READ_SIZE];
+	gsize left = limit;
+
+	while (left > 0)
+		{
+		const gsize n = fread(buf, 1, std::min(left, sizeof(buf)), fp);
+		if (n == 0) break;
+
+		hash.update(buf, n);
+		left -= n;
+		}
+
+	return ferror(fp) == 0;
+}
+
+} // namespace
+
+FastHash::FastHash()
+	: acc{PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1}
+{
+}
+
+void FastHash::stripe(const guchar *data)
+{
+	for (gsize i = 0; i < 8; i++)
+		{
+		const guint64 data_val = read64(data + (8 * i));
+		const guint64 data_key = data_val ^ secret[stripes + i];
+
+		acc[i ^ 1] += data_val;
+		acc[i] += (data_key & 0xFFFFFFFFU) * (data_key >> 32);
+		}
+
+	stripes++;
+	if (stripes < STRIPES_PER_BLOCK) return;
+
+	/* Scramble at the end of each block, so that the accumulators do not saturate */
+	for (gsize i = 0; i < 8; i++)
+		{
+		acc[i] ^= acc[i] >> 47;
+		acc[i] ^= secret[STRIPES_PER_BLOCK + i];
+		acc[i] *= PRIME32_1;
+		}
+
+	stripes = 0;
+}
+
+void FastHash::update(const guchar *data, gsize length)
+{
+	total_length += length;
+
+	if (buffered > 0)
+		{
+		const gsize n = std::min(length, STRIPE_SIZE - buffered);
+
+		memcpy(buffer.data() + buffered, data, n);
+		buffered += n;
+		data += n;
+		length -= n;
+
+		if (buffered < STRIPE_SIZE) return;
+
+		stripe(buffer.data());
+		buffered = 0;
+		}
+
+	while (length >= STRIPE_SIZE)
+		{
+		stripe(data);
+		data += STRIPE_SIZE;
+		length -= STRIPE_SIZE;
+		}
+
+	memcpy(buffer.data(), data, length);
+	buffered = length;
+}
+
+FastHashDigest FastHash::digest() const
+{
+	FastHash last = *this;
+
+	if (last.buffered > 0)
+		{
+		/* The padding is ambiguous, the total length below resolves it */
+		memset(last.buffer.data() + last.buffered, 0, STRIPE_SIZE - last.buffered);
+		last.stripe(last.buffer.data());
+		}
+
+	const guint64 low = merge_accs(last.acc, 0, total_length * PRIME64_1);
+	const guint64 high = merge_accs(last.acc, 11, ~(total_length * PRIME64_2));
+
+	FastHashDigest digest;
+	write64(digest.data(), low);
+	write64(digest.data() + 8, high);
+
+	return digest;
+}
+
+/**
+ * @brief Get the fast hash of a file
+ * @param path file name
+ * @param digest receives the hash
+ * @returns TRUE on success
+ */
+gboolean fast_hash_get_digest_from_file(const gchar *path, FastHashDigest &digest)
+{
+	g_autoptr(FILE) fp = fopen(path, "r");
+	if (!fp) return FALSE;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	FastHash hash;
+	if (!hash_stream(fp, hash, G_MAXSIZE)) return FALSE;
+
+	digest = hash.digest();
+
+	return TRUE;
+}
+
+/**
+ * @brief Get a hash of the size and both ends of a file
+ * @param path file name
+ * @param digest receives the hash
+ * @param complete set to TRUE if the whole file was read
+ * @returns TRUE on success
+ *
+ * Files which differ in this hash differ in content, which avoids
+ * reading large files completely. If \a complete is set, the file was
+ * small enough to be read completely and \a digest is the same as that
+ * of fast_hash_get_digest_from_file().
+ */
+gboolean fast_hash_get_partial_digest_from_file(const gchar *path, FastHashDigest &digest, gboolean &complete)
+{
+	g_autoptr(FILE) fp = fopen(path, "r");
+	if (!fp) return FALSE;
+
+	struct stat st;
+	if (fstat(fileno(fp), &st) != 0) return FALSE;
+
+	const auto size = static_cast<guint64>(st.st_size);
+	FastHash hash;
+
+	complete = (size <= 2 * PARTIAL_SIZE);
+	if (complete)
+		{
+		if (!hash_stream(fp, hash, G_MAXSIZE)) return FALSE;
+		}
+	else
+		{
+		guchar size_le[8];
+		write64(size_le, size);
+		hash.update(size_le, sizeof(size_le));
+
+		if (!hash_stream(fp, hash, PARTIAL_SIZE)) return FALSE;
+		if (fseeko(fp, -static_cast<off_t>(PARTIAL_SIZE), SEEK_END) != 0) return FALSE;
+		if (!hash_stream(fp, hash, PARTIAL_SIZE)) return FALSE;
+		}
+
+	digest = hash.digest();
+
+	return TRUE;
+}
+
+gchar *fast_hash_digest_to_text(const FastHashDigest &digest)
+{
+	static const gchar hex_digits[] = "0123456789abcdef";
+	auto result = static_cast<gchar *>(g_malloc((2 * FAST_HASH_SIZE) + 1));
+
+	for (gsize i = 0; i < FAST_HASH_SIZE; i++)
+		{
+		result[2 * i] = hex_digits[digest[i] >> 4];
+		result[(2 * i) + 1] = hex_digits[digest[i] & 0xf];
+		}
+	result[2 * FAST_HASH_SIZE] = '\0';
+
+	return result;
+}
+
+gboolean fast_hash_digest_from_text(const gchar *text, FastHashDigest &digest)
+{
+	for (gsize i = 0; i < FAST_HASH_SIZE; i++)
+		{
+		const gint hi = g_ascii_xdigit_value(text[2 * i]);
+		if (hi < 0) return FALSE;
+		const gint lo = g_ascii_xdigit_value(text[(2 * i) + 1]);
+		if (lo < 0) return FALSE;
+
+		digest[i] = (hi << 4) | lo;
+		}
+
+	return TRUE;
+}
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef FAST_HASH_H
+#define FAST_HASH_H
+
+#include <array>
+
+#include <glib.h>
+
+inline constexpr gsize FAST_HASH_SIZE = 16;
+
+/**
+ * @brief Identifies the hash function, stored with cached digests.
+ * Must be changed whenever the output of #FastHash changes.
+ */
+inline constexpr guint32 FAST_HASH_ALGORITHM = 1;
+
+using FastHashDigest = std::array<guchar, FAST_HASH_SIZE>;
+
+/**
+ * @brief A fast 128 bit non-cryptographic hash, in the style of XXH3
+ *
+ * Input is consumed in 64 byte stripes by eight 64 bit accumulators,
+ * which are scrambled after every 1 KiB block. This is only meant to
+ * detect identical content, it gives no protection against deliberate
+ * collisions. The result is not compatible with the XXH3 reference.
+ */
+class FastHash
+{
+public:
+	FastHash();
+
+	void update(const guchar *data, gsize length);
+	FastHashDigest digest() const;
+
+	static constexpr gsize STRIPE_SIZE = 64;
+	static constexpr gsize STRIPES_PER_BLOCK = 16;
+
+private:
+	void stripe(const guchar *data);
+
+	std::array<guint64, 8> acc;
+	std::array<guchar, STRIPE_SIZE> buffer;
+	gsize buffered = 0;
+	gsize stripes = 0; /**< In the current block */
+	guint64 total_length = 0;
+};
+
+gboolean fast_hash_get_digest_from_file(const gchar *path, FastHashDigest &digest);
+
+gboolean fast_hash_get_partial_digest_from_file(const gchar *path, FastHashDigest &digest, gboolean &complete);
+
+gchar *fast_hash_digest_to_text(const FastHashDigest &digest);
+
+gboolean fast_hash_digest_from_text(const gchar *text, FastHashDigest &digest);
+
+#endif /* FAST_HASH_H */
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -20,28 +20,54 @@
 
 #include "filecache.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include <config.h>
 
 #include "filedata.h"
 
-/* this implements a simple LRU algorithm */
-
-struct FileCacheData {
-	FileCacheReleaseFunc release;
-	GList *list;
-	gulong max_size;
-	gulong size;
-};
+/* this implements a simple LRU algorithm, weighted by the cost of recreating an entry */
 
 namespace
 {
 
+/**
+ * @brief Number of least recently used entries considered for each eviction.
+ * The one with the lowest cost is evicted, so with equal costs this is plain LRU.
+ */
+constexpr gint FILE_CACHE_EVICTION_WINDOW = 4;
+
 struct FileCacheEntry {
 	FileData *fd;
 	gulong size;
+	guint64 cost;
 	gboolean checking_if_changed;
+
+	/* Intrusive LRU list, most recently used first */
+	FileCacheEntry *prev;
+	FileCacheEntry *next;
 };
 
+} // namespace
+
+struct FileCacheData {
+	FileCacheReleaseFunc release;
+	std::unordered_map<const FileData *, FileCacheEntry *> entries;
+	FileCacheEntry *head = nullptr; /**< Most recently used */
+	FileCacheEntry *tail = nullptr; /**< Least recently used, evicted first */
+	gulong max_size;
+	gulong size; /**< Sum of the sizes of all entries */
+	guint min_entries = 0; /**< Kept regardless of their size */
+
+	guint64 hits = 0;
+	guint64 misses = 0;
+	guint64 evictions = 0;
+};
+
+namespace
+{
+
 #ifdef DEBUG
 constexpr bool debug_file_cache = false; /* Set to true to add file cache dumps to the debug output */
 
@@ -52,9 +78,8 @@ void file_cache_dump(FileCacheData *fc)
 	DEBUG_1("cache dump: fc=%p max size:%lu size:%lu", (void *)fc, fc->max_size, fc->size);
 
 	gulong n = 0;
-	for (GList *work = fc->list; work; work = work->next)
+	for (FileCacheEntry *fe = fc->head; fe; fe = fe->next)
 		{
-		auto fe = static_cast<FileCacheEntry *>(work->data);
 		DEBUG_1("cache entry: fc=%p [%lu] %s %lu", (void *)fc, ++n, fe->fd->path, fe->size);
 		}
 }
@@ -62,15 +87,38 @@ void file_cache_dump(FileCacheData *fc)
 #  define file_cache_dump(fc)
 #endif
 
-gint file_cache_entry_compare_fd(const FileCacheEntry *fe, const FileData *fd)
+FileCacheEntry *file_cache_find(FileCacheData *fc, const FileData *fd)
 {
-	return (fe->fd == fd) ? 0 : 1;
+	const auto it = fc->entries.find(fd);
+
+	return (it != fc->entries.end()) ? it->second : nullptr;
 }
 
-gboolean file_cache_remove_entry(FileCacheData *fc, GList *link)
+void file_cache_unlink(FileCacheData *fc, FileCacheEntry *fe)
 {
-	auto *fe = static_cast<FileCacheEntry *>(link->data);
+	if (fe->prev) fe->prev->next = fe->next;
+	else fc->head = fe->next;
+
+	if (fe->next) fe->next->prev = fe->prev;
+	else fc->tail = fe->prev;
 
+	fe->prev = nullptr;
+	fe->next = nullptr;
+}
+
+void file_cache_link_front(FileCacheData *fc, FileCacheEntry *fe)
+{
+	fe->prev = nullptr;
+	fe->next = fc->head;
+
+	if (fc->head) fc->head->prev = fe;
+	else fc->tail = fe;
+
+	fc->head = fe;
+}
+
+gboolean file_cache_remove_entry(FileCacheData *fc, FileCacheEntry *fe)
+{
 	// Avoid evicting a FileCacheEntry that implicitly triggered this removal attempt.
 	if (fe->checking_if_changed)
 		{
@@ -80,11 +128,12 @@ gboolean file_cache_remove_entry(FileCacheData *fc, GList *link)
 
 	DEBUG_1("cache remove: fc=%p %s", (void *)fc, fe->fd->path);
 
-	fc->list = g_list_delete_link(fc->list, link);
+	file_cache_unlink(fc, fe);
+	fc->entries.erase(fe->fd);
 	fc->size -= fe->size;
 	fc->release(fe->fd);
 	file_data_unref(fe->fd);
-	g_free(fe);
+	delete fe;
 
 	return TRUE;
 }
@@ -99,45 +148,58 @@ void file_cache_notify_cb(FileData *fd, NotifyType type, gpointer data)
 	auto *fc = static_cast<FileCacheData *>(data);
 	file_cache_dump(fc);
 
-	GList *work = g_list_find_custom(fc->list, fd, reinterpret_cast<GCompareFunc>(file_cache_entry_compare_fd));
-	if (!work) return;
+	FileCacheEntry *fe = file_cache_find(fc, fd);
+	if (!fe) return;
 
-	file_cache_remove_entry(fc, work);
+	file_cache_remove_entry(fc, fe);
 }
 
-void file_cache_shrink_to_max_size(FileCacheData *fc)
+void file_cache_shrink_to(FileCacheData *fc, gulong size)
 {
 	file_cache_dump(fc);
 
-	GList *work = g_list_last(fc->list);
-	while (fc->size > fc->max_size && work)
+	// The most recently used min_entries entries are never candidates.
+	// Evictions only happen behind them, so the boundary does not move.
+	FileCacheEntry *last_kept = nullptr;
+	FileCacheEntry *kept = fc->head;
+	for (guint i = 0; kept && i < fc->min_entries; i++, kept = kept->next)
 		{
-		GList *prev = work->prev;
-		// This may fail to remove the specified entry if this resize was implicitly
-		// triggered during a file_cache_get call.  Any file_cache_put after the
-		// file_cache_get will re-trigger the shrink and correct the cache size, if needed.
-		file_cache_remove_entry(fc, work);
-		work = prev;
+		last_kept = kept;
 		}
-}
 
-} // namespace
+	FileCacheEntry *fe = fc->tail;
+	while (fc->size > size && fe && fe != last_kept)
+		{
+		// Entries that are being checked in a file_cache_get call can not be removed now.
+		// Any file_cache_put after the file_cache_get will re-trigger the shrink and
+		// correct the cache size, if needed.
+		FileCacheEntry *victim = nullptr;
+		FileCacheEntry *candidate = fe;
+		for (gint i = 0; candidate && candidate != last_kept && i < FILE_CACHE_EVICTION_WINDOW; i++, candidate = candidate->prev)
+			{
+			if (candidate->checking_if_changed) continue;
+			if (!victim || candidate->cost < victim->cost) victim = candidate;
+			}
+
+		if (!victim)
+			{
+			fe = candidate;
+			continue;
+			}
+
+		if (victim == fe) fe = fe->prev;
+
+		file_cache_remove_entry(fc, victim);
+		fc->evictions++;
+		}
+}
 
-FileCacheData *file_cache_new(FileCacheReleaseFunc release, gulong max_size)
+void file_cache_shrink_to_max_size(FileCacheData *fc)
 {
-	auto fc = g_new(FileCacheData, 1);
-
-	fc->release = release;
-	fc->list = nullptr;
-	fc->max_size = max_size;
-	fc->size = 0;
-
-	file_data_register_notify_func(file_cache_notify_cb, fc, NOTIFY_PRIORITY_HIGH);
-
-	return fc;
+	file_cache_shrink_to(fc, fc->max_size);
 }
 
-gboolean file_cache_get(FileCacheData *fc, FileData *fd)
+gboolean file_cache_lookup(FileCacheData *fc, FileData *fd)
 {
 	/* Operating theory of this function:
 	 * This function must be re-entrant, which means it must specifically be implemented in a
@@ -157,10 +219,8 @@ gboolean file_cache_get(FileCacheData *fc, FileData *fd)
 	 * file_cache_get(fc, fd_A) again.
 	 */
 
-	g_assert(fc && fd);
-
-	GList *work = g_list_find_custom(fc->list, fd, reinterpret_cast<GCompareFunc>(file_cache_entry_compare_fd));
-	if (!work)
+	FileCacheEntry *entry = file_cache_find(fc, fd);
+	if (!entry)
 		{
 		DEBUG_2("cache miss: fc=%p %s", (void *)fc, fd->path);
 		return FALSE;
@@ -170,41 +230,35 @@ gboolean file_cache_get(FileCacheData *fc, FileData *fd)
 	DEBUG_2("cache hit: fc=%p %s", (void *)fc, fd->path);
 
 	// Move it to the beginning, if needed.
-	if (work != fc->list)
+	if (entry != fc->head)
 		{
 		DEBUG_2("cache move to front: fc=%p %s", (void *)fc, fd->path);
-		fc->list = g_list_remove_link(fc->list, work);
-		fc->list = g_list_concat(work, fc->list);
+		file_cache_unlink(fc, entry);
+		file_cache_link_front(fc, entry);
 		}
 
 	// Most of the following code is defending against the case where
 	// file_data_check_changed_files triggers a re-entrant call back into this file_cache_get.
-	{
-		auto *entry = static_cast<FileCacheEntry *>(work->data);
-		if (entry->checking_if_changed) return TRUE;  // Avoid infinite recursion.
+	if (entry->checking_if_changed) return TRUE;  // Avoid infinite recursion.
 
-		entry->checking_if_changed = TRUE;
-	}
+	entry->checking_if_changed = TRUE;
 
-	// We assume that file_data_check_changed_files may invalidate work.
-	work = nullptr;
+	// We assume that file_data_check_changed_files may invalidate entry.
+	entry = nullptr;
 	const gboolean fd_changed = file_data_check_changed_files(fd);
 
-	// Now we re-acquire work to take the appropriate action, if it still exists.
-	work = g_list_find_custom(fc->list, fd, reinterpret_cast<GCompareFunc>(file_cache_entry_compare_fd));
-	if (!work) return FALSE;
+	// Now we re-acquire entry to take the appropriate action, if it still exists.
+	entry = file_cache_find(fc, fd);
+	if (!entry) return FALSE;
 
 	// Doing this here for correctness, even though we might immediately evict the entry.
-	{
-		auto *entry = static_cast<FileCacheEntry *>(work->data);
-		entry->checking_if_changed = FALSE;
-	}
+	entry->checking_if_changed = FALSE;
 
 	if (fd_changed)
 		{
 		// Underlying file has been changed.  Evict the cache entry.
 		file_cache_dump(fc);
-		file_cache_remove_entry(fc, work);
+		file_cache_remove_entry(fc, entry);
 		return FALSE;
 		}
 
@@ -212,19 +266,48 @@ gboolean file_cache_get(FileCacheData *fc, FileData *fd)
 	return TRUE;
 }
 
-void file_cache_put(FileCacheData *fc, FileData *fd, gulong size)
+} // namespace
+
+FileCacheData *file_cache_new(FileCacheReleaseFunc release, gulong max_size)
+{
+	auto fc = new FileCacheData();
+
+	fc->release = release;
+	fc->max_size = max_size;
+	fc->size = 0;
+
+	file_data_register_notify_func(file_cache_notify_cb, fc, NOTIFY_PRIORITY_HIGH);
+
+	return fc;
+}
+
+gboolean file_cache_get(FileCacheData *fc, FileData *fd)
 {
-	FileCacheEntry *fe;
+	g_assert(fc && fd);
+
+	const gboolean hit = file_cache_lookup(fc, fd);
 
-	if (file_cache_get(fc, fd)) return;
+	if (hit) fc->hits++;
+	else fc->misses++;
+
+	return hit;
+}
+
+/**
+ * @brief Adds an entry to the cache
+ * @param size size of the entry, in the unit of the maximum size
+ * @param cost cost of recreating the entry, in any unit used consistently within \a fc
+ *
+ * Of the least recently used entries, those with a lower cost are evicted first.
+ */
+void file_cache_put(FileCacheData *fc, FileData *fd, gulong size, guint64 cost)
+{
+	if (file_cache_lookup(fc, fd)) return;
 
 	DEBUG_2("cache add: fc=%p %s", (void *)fc, fd->path);
-	// TODO[xsdg]: Switch to an stl container and do this initialization in a constructor.
-	fe = g_new(FileCacheEntry, 1);
-	fe->fd = file_data_ref(fd);
-	fe->size = size;
-	fe->checking_if_changed = FALSE;
-	fc->list = g_list_prepend(fc->list, fe);
+	auto *fe = new FileCacheEntry{file_data_ref(fd), size, cost, FALSE, nullptr, nullptr};
+	fc->entries.emplace(fd, fe);
+	file_cache_link_front(fc, fe);
 	fc->size += size;
 
 	file_cache_shrink_to_max_size(fc);
@@ -235,4 +318,41 @@ void file_cache_set_max_size(FileCacheData *fc, gulong size)
 	fc->max_size = size;
 	file_cache_shrink_to_max_size(fc);
 }
+
+/**
+ * @brief Sets the number of most recently used entries that are kept even when over the maximum size
+ *
+ * This is for callers which use an entry after adding it, and which may
+ * add a few other entries meanwhile.
+ */
+void file_cache_set_min_entries(FileCacheData *fc, guint count)
+{
+	fc->min_entries = count;
+	file_cache_shrink_to_max_size(fc);
+}
+
+/**
+ * @brief Evicts entries until the cache is no larger than \a size
+ *
+ * Unlike file_cache_set_max_size() the maximum size is kept, so the cache
+ * can grow again. This is used to release memory under memory pressure.
+ */
+void file_cache_trim(FileCacheData *fc, gulong size)
+{
+	file_cache_shrink_to(fc, size);
+}
+
+FileCacheStats file_cache_get_stats(const FileCacheData *fc)
+{
+	FileCacheStats stats;
+
+	stats.hits = fc->hits;
+	stats.misses = fc->misses;
+	stats.evictions = fc->evictions;
+	stats.entries = fc->entries.size();
+	stats.size = fc->size;
+	stats.max_size = fc->max_size;
+
+	return stats;
+}
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
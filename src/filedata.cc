@@ -174,6 +174,21 @@ gboolean filelist_read_lstat(FileData *dir_fd, GList **files, GList **dirs)
 	return FileData::FileList::read_list_lstat(dir_fd, files, dirs);
 }
 
+FileData::FileList::Scan *filelist_read_async(FileData *dir_fd, FileData::FileList::ReadListFunc func, gpointer data)
+{
+	return FileData::FileList::read_list_async(dir_fd, func, data);
+}
+
+void filelist_read_async_cancel(FileData::FileList::Scan *scan)
+{
+	FileData::FileList::read_list_async_cancel(scan);
+}
+
+gboolean filelist_is_listed(FileData *fd)
+{
+	return FileData::FileList::is_listed(fd);
+}
+
 void file_data_list_free(FileDataList *list)
 {
 	FileData::FileList::free_list(list);
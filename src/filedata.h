@@ -459,6 +459,18 @@ class FileData::FileList
 
 	static gboolean read_list(FileData *dir_fd, GList **files, GList **dirs);
 	static gboolean read_list_lstat(FileData *dir_fd, GList **files, GList **dirs);
+
+	/**
+	 * @brief Receives the files found by read_list_async(), in batches of whole sidecar groups
+	 *
+	 * The list belongs to the callee. The last call has @a done set.
+	 */
+	using ReadListFunc = void (*)(GList *files, gboolean done, gpointer data);
+	struct Scan;
+	static Scan *read_list_async(FileData *dir_fd, ReadListFunc func, gpointer data);
+	static void read_list_async_cancel(Scan *scan);
+	static gboolean is_listed(FileData *fd);
+
 	static void free_list(GList *list);
 	static GList *copy(GList *list);
 	static GList *from_path_list(GList *list);
@@ -540,6 +552,9 @@ GList *filelist_sort(GList *list, FileData::FileList::SortSettings settings);
 
 gboolean filelist_read(FileData *dir_fd, GList **files, GList **dirs);
 gboolean filelist_read_lstat(FileData *dir_fd, GList **files, GList **dirs);
+FileData::FileList::Scan *filelist_read_async(FileData *dir_fd, FileData::FileList::ReadListFunc func, gpointer data);
+void filelist_read_async_cancel(FileData::FileList::Scan *scan);
+gboolean filelist_is_listed(FileData *fd);
 
 void file_data_list_free(FileDataList *list);
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(FileDataList, file_data_list_free)
@@ -44,6 +44,7 @@
 #include "histogram.h"
 #include "intl.h"
 #include "main-defines.h"
+#include "metadata-index.h"
 #include "metadata.h"
 #include "options.h"
 #include "trash.h"
@@ -471,24 +472,10 @@ void FileData::read_exif_time_data(FileData *file)
 		return;
 		}
 
-	if (!file->exif)
-		{
-		exif_read_fd(file);
-		}
-
-	if (file->exif)
-		{
-		g_autofree gchar *tmp = exif_get_data_as_text(file->exif, "Exif.Photo.DateTimeOriginal");
-		DEBUG_2("%s read_exif_time_data: reading %p %s", get_exec_time(), (void *)file, file->path);
-
-		if (tmp)
-			{
-			std::tm time_str{};
-			strptime(tmp, "%Y:%m:%d %H:%M:%S", &time_str);
+	MetadataIndexData data;
+	metadata_index_get(file, data, TRUE);
 
-			file->exifdate = mktime(&time_str);
-			}
-		}
+	file->exifdate = data.date;
 }
 
 void FileData::read_exif_time_digitized_data(FileData *file)
@@ -499,38 +486,18 @@ void FileData::read_exif_time_digitized_data(FileData *file)
 		return;
 		}
 
-	if (!file->exif)
-		{
-		exif_read_fd(file);
-		}
+	MetadataIndexData data;
+	metadata_index_get(file, data, TRUE);
 
-	if (file->exif)
-		{
-		g_autofree gchar *tmp = exif_get_data_as_text(file->exif, "Exif.Photo.DateTimeDigitized");
-		DEBUG_2("%s read_exif_time_digitized_data: reading %p %s", get_exec_time(), (void *)file, file->path);
-
-		if (tmp)
-			{
-			std::tm time_str{};
-			strptime(tmp, "%Y:%m:%d %H:%M:%S", &time_str);
-
-			file->exifdate_digitized = mktime(&time_str);
-			}
-		}
+	file->exifdate_digitized = data.date_digitized;
 }
 
 void FileData::read_rating_data(FileData *file)
 {
-	g_autofree gchar *rating_str = metadata_read_string(file, RATING_KEY, METADATA_PLAIN);
+	MetadataIndexData data;
+	metadata_index_get(file, data);
 
-	if (rating_str)
-		{
-		file->rating = atoi(rating_str);
-		}
-	else
-		{
-		file->rating = 0;
-		}
+	file->rating = data.rating;
 }
 
 FileData *FileData::file_data_new_no_grouping(const gchar *path_utf8, FileDataContext *context)
@@ -26,12 +26,22 @@
 #include "filedata.h"
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <glib.h>
 
@@ -130,89 +140,345 @@ gboolean FileData::FileList::is_hidden_file(const gchar *filepath)
 	return res;
 }
 
-gboolean FileData::FileList::read_list_real(const gchar *dir_path, GList **files, GList **dirs, gboolean follow_symlinks)
+namespace {
+
+constexpr gsize SCAN_DENTS_BUFFER_SIZE = 256 * 1024;
+constexpr gsize SCAN_FIRST_BATCH_SIZE = 256; /**< about a screenful, sent as soon as it is read */
+constexpr gsize SCAN_BATCH_SIZE = 4096;
+
+#if defined(__linux__) && defined(SYS_getdents64)
+#define FILELIST_USE_GETDENTS 1
+
+/**
+ * @brief Record returned by the getdents64 system call
+ */
+struct LinuxDirent64
 {
-	DIR *dp;
-	struct dirent *dir;
-	GList *dlist = nullptr;
-	GList *flist = nullptr;
-	GList *xmp_files = nullptr;
-	gint (*stat_func)(const gchar *path, struct stat *buf);
-	GHashTable *basename_hash = nullptr;
+	guint64 d_ino;
+	gint64 d_off;
+	gushort d_reclen;
+	guchar d_type;
+	gchar d_name[];
+};
+#endif
+
+struct DirName
+{
+	std::string name;
+	guchar type; /**< DT_* value, DT_UNKNOWN if the file system does not tell */
+};
 
-	g_assert(files || dirs);
+/**
+ * @brief Length of the part of @a name before the first dot
+ *
+ * All members of a sidecar group share it, see file_data_basename_hash_insert().
+ */
+gsize name_stem_length(const std::string &name)
+{
+	return std::min(name.find('.', 1), name.size());
+}
 
-	if (files) *files = nullptr;
-	if (dirs) *dirs = nullptr;
+gboolean same_stem(const std::string &a, const std::string &b)
+{
+	const gsize length = name_stem_length(a);
 
-	g_autofree gchar *pathl = path_from_utf8(dir_path);
-	if (!pathl) return FALSE;
+	return length == name_stem_length(b) && a.compare(0, length, b, 0, length) == 0;
+}
+
+gboolean is_dot_name(const gchar *name)
+{
+	return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
 
-	dp = opendir(pathl);
-	if (dp == nullptr)
+/**
+ * @brief Reads the entries of one folder with as few system calls as the platform allows
+ *
+ * On Linux, names are read with getdents64 into a large buffer and the entries
+ * are examined with statx, asking only for what FileData uses. Elsewhere
+ * readdir and fstatat are used. Both stat relative to the open folder.
+ */
+class DirReader
+{
+public:
+	explicit DirReader(const gchar *pathl)
+	{
+#ifdef FILELIST_USE_GETDENTS
+		fd = open(pathl, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#else
+		dp = opendir(pathl);
+		if (dp) fd = dirfd(dp);
+#endif
+	}
+
+	~DirReader()
+	{
+#ifdef FILELIST_USE_GETDENTS
+		if (fd >= 0) close(fd);
+#else
+		if (dp) closedir(dp);
+#endif
+	}
+
+	DirReader(const DirReader &) = delete;
+	DirReader &operator=(const DirReader &) = delete;
+
+	gboolean is_open() const
+	{
+		return fd >= 0;
+	}
+
+	void read_names(std::vector<DirName> &names)
+	{
+#ifdef FILELIST_USE_GETDENTS
+		g_autofree auto *buf = static_cast<gchar *>(g_malloc(SCAN_DENTS_BUFFER_SIZE));
+		glong n;
+
+		while ((n = syscall(SYS_getdents64, fd, buf, SCAN_DENTS_BUFFER_SIZE)) > 0)
+			{
+			for (glong pos = 0; pos < n; )
+				{
+				const auto *dent = reinterpret_cast<const LinuxDirent64 *>(buf + pos);
+				pos += dent->d_reclen;
+
+				if (!is_dot_name(dent->d_name)) names.push_back({dent->d_name, dent->d_type});
+				}
+			}
+#else
+		struct dirent *dir;
+
+		while ((dir = readdir(dp)) != nullptr)
+			{
+			if (is_dot_name(dir->d_name)) continue;
+#ifdef _DIRENT_HAVE_D_TYPE
+			names.push_back({dir->d_name, dir->d_type});
+#else
+			names.push_back({dir->d_name, DT_UNKNOWN});
+#endif
+			}
+#endif
+	}
+
+	gboolean stat(const gchar *name, gboolean follow_symlinks, struct stat *st) const
+	{
+		const gint flags = follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW;
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+		static gint statx_unavailable = FALSE;
+
+		if (!g_atomic_int_get(&statx_unavailable))
+			{
+			struct statx stx;
+
+			if (statx(fd, name, flags, STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME | STATX_CTIME, &stx) == 0)
+				{
+				*st = {};
+				st->st_mode = stx.stx_mode;
+				st->st_size = stx.stx_size;
+				st->st_mtime = stx.stx_mtime.tv_sec;
+				st->st_ctime = stx.stx_ctime.tv_sec;
+				return TRUE;
+				}
+
+			if (errno != ENOSYS) return FALSE;
+
+			g_atomic_int_set(&statx_unavailable, TRUE);
+			}
+#endif
+
+		return fstatat(fd, name, st, flags) == 0;
+	}
+
+private:
+	gint fd = -1;
+#ifndef FILELIST_USE_GETDENTS
+	DIR *dp = nullptr;
+#endif
+};
+
+} // namespace
+
+/**
+ * @brief State of one read_list_async() call, shared by its thread and the main loop
+ */
+struct FileData::FileList::Scan
+{
+	struct Entry
+	{
+		std::string name;
+		struct stat st;
+	};
+
+	using BatchFunc = std::function<gboolean(std::vector<Entry> &)>;
+
+	static gboolean read_entries(const gchar *pathl, gboolean follow_symlinks, gboolean with_files, gboolean with_dirs,
+	                             gsize first_batch_size, gsize batch_size, const BatchFunc &batch_func);
+	static void add_entries(const gchar *pathl, const std::vector<Entry> &entries, GList **files, GList **dirs);
+
+	static gpointer thread_func(gpointer data);
+	static gboolean dispatch_cb(gpointer data);
+	static void unref(Scan *scan);
+
+	void push(std::vector<Entry> &batch, gboolean last);
+
+	Scan(const gchar *dir_pathl, ReadListFunc read_func, gpointer read_data)
+		: pathl(dir_pathl)
+		, func(read_func)
+		, func_data(read_data)
+	{
+		g_mutex_init(&mutex);
+	}
+
+	~Scan()
+	{
+		g_mutex_clear(&mutex);
+	}
+
+	gint ref = 2; /**< the caller and the thread */
+	gint cancelled = FALSE;
+
+	const std::string pathl;
+	const ReadListFunc func;
+	const gpointer func_data;
+
+	GMutex mutex; /**< protects the members below */
+	std::vector<Entry> ready;
+	gboolean finished = FALSE;
+	gboolean dispatch_pending = FALSE;
+};
+
+/**
+ * @brief Lists and stats the entries of a folder, without creating FileData
+ * @param pathl Folder path in locale encoding
+ * @param follow_symlinks Whether to stat the targets of symbolic links
+ * @param with_files Whether files are wanted
+ * @param with_dirs Whether folders are wanted
+ * @param first_batch_size Entries collected before the first call of @a batch_func
+ * @param batch_size Entries collected before each later call of @a batch_func
+ * @param batch_func Receives the entries; it may take them, returns FALSE to stop
+ * @returns FALSE if the folder could not be opened
+ *
+ * Thread safe. When the folder needs more than one batch, the entries are sorted so
+ * that files which may form a sidecar group always arrive in the same batch.
+ */
+gboolean FileData::FileList::Scan::read_entries(const gchar *pathl, gboolean follow_symlinks, gboolean with_files, gboolean with_dirs,
+                                                gsize first_batch_size, gsize batch_size, const BatchFunc &batch_func)
+{
+	DirReader reader(pathl);
+	if (!reader.is_open()) return FALSE;
+
+	std::vector<DirName> names;
+	reader.read_names(names);
+
+	if (names.size() > first_batch_size)
 		{
-		return FALSE;
+		std::sort(names.begin(), names.end(), [](const DirName &a, const DirName &b)
+			{
+			const gint ret = a.name.compare(0, name_stem_length(a.name), b.name, 0, name_stem_length(b.name));
+			return ret != 0 ? ret < 0 : a.name < b.name;
+			});
 		}
 
-	if (files) basename_hash = file_data_basename_hash_new();
-
-	if (follow_symlinks)
-		stat_func = stat;
-	else
-		stat_func = lstat;
+	const gboolean show_hidden = options->file_filter.show_hidden_files;
+	std::vector<Entry> batch;
+	gsize limit = first_batch_size;
 
-	while ((dir = readdir(dp)) != nullptr)
+	for (gsize i = 0; i < names.size(); i++)
 		{
-		const gchar *name = dir->d_name;
-		g_autofree gchar *filepath = g_build_filename(pathl, name, NULL);
+		const DirName &dir_name = names[i];
+		const gchar *name = dir_name.name.c_str();
+
+		/* only folders are wanted, do not stat what is known not to be one */
+		if (!with_files && dir_name.type != DT_UNKNOWN && dir_name.type != DT_DIR &&
+		    (dir_name.type != DT_LNK || !follow_symlinks)) continue;
 
-		if (!options->file_filter.show_hidden_files && is_hidden_file(filepath))
+		if (!show_hidden)
 			{
-			continue;
+			g_autofree gchar *filepath = g_build_filename(pathl, name, NULL);
+			if (is_hidden_file(filepath)) continue;
 			}
 
-		struct stat ent_sbuf;
-		if (stat_func(filepath, &ent_sbuf) >= 0)
+		Entry entry{dir_name.name, {}};
+		if (!reader.stat(name, follow_symlinks, &entry.st))
 			{
-			if (S_ISDIR(ent_sbuf.st_mode))
+			if (errno == EOVERFLOW)
 				{
-				/* we ignore the .thumbnails dir for cleanliness */
-				if (dirs &&
-				    (name[0] != '.' || (name[1] != '\0' && (name[1] != '.' || name[2] != '\0'))) &&
-				    strcmp(name, GQ_CACHE_LOCAL_THUMB) != 0 &&
-				    strcmp(name, GQ_CACHE_LOCAL_METADATA) != 0 &&
-				    strcmp(name, THUMB_FOLDER_LOCAL) != 0)
-					{
-					dlist = g_list_prepend(dlist, file_data_new_local(filepath, &ent_sbuf, TRUE));
-					}
+				log_printf("stat(): EOVERFLOW, skip '%s/%s'", pathl, name);
 				}
-			else
+			continue;
+			}
+
+		if (S_ISDIR(entry.st.st_mode))
+			{
+			/* we ignore the .thumbnails dir for cleanliness */
+			if (!with_dirs ||
+			    strcmp(name, GQ_CACHE_LOCAL_THUMB) == 0 ||
+			    strcmp(name, GQ_CACHE_LOCAL_METADATA) == 0 ||
+			    strcmp(name, THUMB_FOLDER_LOCAL) == 0) continue;
+			}
+		else if (!with_files)
+			{
+			continue;
+			}
+
+		batch.push_back(std::move(entry));
+
+		if (batch.size() >= limit && i + 1 < names.size() && !same_stem(names[i + 1].name, dir_name.name))
+			{
+			if (!batch_func(batch)) return TRUE;
+			batch.clear();
+			limit = batch_size;
+			}
+		}
+
+	if (!batch.empty()) batch_func(batch);
+
+	return TRUE;
+}
+
+/**
+ * @brief Creates the FileData of @a entries and groups the sidecars among them
+ *
+ * Main thread only.
+ */
+void FileData::FileList::Scan::add_entries(const gchar *pathl, const std::vector<Entry> &entries, GList **files, GList **dirs)
+{
+	GList *dlist = nullptr;
+	GList *flist = nullptr;
+	GList *xmp_files = nullptr;
+	GHashTable *basename_hash = nullptr;
+
+	if (files) basename_hash = file_data_basename_hash_new();
+
+	for (const Entry &entry : entries)
+		{
+		const gchar *name = entry.name.c_str();
+		g_autofree gchar *filepath = g_build_filename(pathl, name, NULL);
+		auto st = entry.st;
+
+		if (S_ISDIR(st.st_mode))
+			{
+			if (dirs)
 				{
-				if (files && filter_name_exists(name))
-					{
-					FileData *fd = file_data_new_local(filepath, &ent_sbuf, FALSE);
-					flist = g_list_prepend(flist, fd);
-					if (fd->sidecar_priority && !fd->disable_grouping)
-						{
-						if (strcmp(fd->extension, ".xmp") != 0)
-							file_data_basename_hash_insert(basename_hash, fd);
-						else
-							xmp_files = g_list_append(xmp_files, fd);
-						}
-					}
+				dlist = g_list_prepend(dlist, file_data_new_local(filepath, &st, TRUE));
 				}
 			}
 		else
 			{
-			if (errno == EOVERFLOW)
+			if (files && filter_name_exists(name))
 				{
-				log_printf("stat(): EOVERFLOW, skip '%s'", filepath);
+				FileData *fd = file_data_new_local(filepath, &st, FALSE);
+				flist = g_list_prepend(flist, fd);
+				if (fd->sidecar_priority && !fd->disable_grouping)
+					{
+					if (strcmp(fd->extension, ".xmp") != 0)
+						file_data_basename_hash_insert(basename_hash, fd);
+					else
+						xmp_files = g_list_append(xmp_files, fd);
+					}
 				}
 			}
 		}
 
-	closedir(dp);
-
 	if (xmp_files)
 		{
 		g_list_foreach(xmp_files,file_data_basename_hash_insert_cb,basename_hash);
@@ -228,10 +494,146 @@ gboolean FileData::FileList::read_list_real(const gchar *dir_path, GList **files
 		*files = filter_out_sidecars(flist);
 		}
 	if (basename_hash) file_data_basename_hash_free(basename_hash);
+}
+
+void FileData::FileList::Scan::push(std::vector<Entry> &batch, gboolean last)
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&mutex);
+
+	std::move(batch.begin(), batch.end(), std::back_inserter(ready));
+	batch.clear();
+	if (last) finished = TRUE;
+
+	if (!dispatch_pending)
+		{
+		dispatch_pending = TRUE;
+		g_atomic_int_inc(&ref);
+		g_idle_add(dispatch_cb, this);
+		}
+}
+
+gpointer FileData::FileList::Scan::thread_func(gpointer data)
+{
+	auto scan = static_cast<Scan *>(data);
+
+	read_entries(scan->pathl.c_str(), TRUE, TRUE, FALSE, SCAN_FIRST_BATCH_SIZE, SCAN_BATCH_SIZE,
+	             [scan](std::vector<Entry> &batch)
+	             {
+	             scan->push(batch, FALSE);
+	             return !g_atomic_int_get(&scan->cancelled);
+	             });
+
+	std::vector<Entry> none;
+	scan->push(none, TRUE);
+
+	unref(scan);
+	return nullptr;
+}
+
+gboolean FileData::FileList::Scan::dispatch_cb(gpointer data)
+{
+	auto scan = static_cast<Scan *>(data);
+	std::vector<Entry> entries;
+	gboolean done;
+
+	g_mutex_lock(&scan->mutex);
+	entries.swap(scan->ready);
+	done = scan->finished;
+	scan->dispatch_pending = FALSE;
+	g_mutex_unlock(&scan->mutex);
+
+	if (!g_atomic_int_get(&scan->cancelled))
+		{
+		GList *files = nullptr;
+
+		add_entries(scan->pathl.c_str(), entries, &files, nullptr);
+		scan->func(files, done, scan->func_data);
+
+		if (done) unref(scan); /* the reference of the caller */
+		}
+
+	unref(scan);
+	return G_SOURCE_REMOVE;
+}
+
+void FileData::FileList::Scan::unref(Scan *scan)
+{
+	if (g_atomic_int_dec_and_test(&scan->ref)) delete scan;
+}
+
+gboolean FileData::FileList::read_list_real(const gchar *dir_path, GList **files, GList **dirs, gboolean follow_symlinks)
+{
+	std::vector<Scan::Entry> entries;
+
+	g_assert(files || dirs);
+
+	if (files) *files = nullptr;
+	if (dirs) *dirs = nullptr;
+
+	g_autofree gchar *pathl = path_from_utf8(dir_path);
+	if (!pathl) return FALSE;
+
+	if (!Scan::read_entries(pathl, follow_symlinks, files != nullptr, dirs != nullptr, G_MAXSIZE, G_MAXSIZE,
+	                        [&entries](std::vector<Scan::Entry> &batch) { entries.swap(batch); return TRUE; }))
+		{
+		return FALSE;
+		}
+
+	Scan::add_entries(pathl, entries, files, dirs);
 
 	return TRUE;
 }
 
+/**
+ * @brief Whether read_list() of its folder would return @a fd, checking only this file
+ *
+ * This lets a view follow the change of a single file without reading the folder.
+ */
+gboolean FileData::FileList::is_listed(FileData *fd)
+{
+	if (fd->parent) return FALSE;
+
+	g_autofree gchar *pathl = path_from_utf8(fd->path);
+	if (!pathl) return FALSE;
+
+	struct stat st;
+	if (stat(pathl, &st) < 0 || S_ISDIR(st.st_mode)) return FALSE;
+
+	if (!options->file_filter.show_hidden_files && is_hidden_file(pathl)) return FALSE;
+
+	return filter_name_exists(fd->name);
+}
+
+/**
+ * @brief Reads the files of @a dir_fd in a separate thread
+ * @returns The scan, valid until the call of @a func with done set, or nullptr on failure
+ *
+ * The FileData are created in the main loop, in batches, so that a view can show
+ * the first files of a large folder without waiting for the rest.
+ * Folders and hidden files are left out, as by read_list().
+ */
+FileData::FileList::Scan *FileData::FileList::read_list_async(FileData *dir_fd, ReadListFunc func, gpointer data)
+{
+	g_autofree gchar *pathl = path_from_utf8(dir_fd->path);
+	if (!pathl) return nullptr;
+
+	auto scan = new Scan(pathl, func, data);
+	g_thread_unref(g_thread_new("filelist-scan", Scan::thread_func, scan));
+
+	return scan;
+}
+
+/**
+ * @brief Stops a scan of read_list_async(); its callback is not called again
+ */
+void FileData::FileList::read_list_async_cancel(Scan *scan)
+{
+	if (!scan) return;
+
+	g_atomic_int_set(&scan->cancelled, TRUE);
+	Scan::unref(scan);
+}
+
 /*
  *-----------------------------------------------------------------------------
  * filelist sorting
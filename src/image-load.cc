@@ -23,12 +23,18 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <deque>
+#include <iterator>
+#include <vector>
 
 #include <config.h>
 
 #include "exif.h"
 #include "filedata.h"
+#include "filefilter.h"
 #include "geometry.h"
 #include "image-load-collection.h"
 #include "image-load-dds.h"
@@ -108,6 +114,7 @@ static void image_loader_class_init_wrapper(void *data, void *user_data);
 static void image_loader_class_init(ImageLoaderClass *loader_class);
 static void image_loader_finalize(GObject *object);
 static void image_loader_stop(ImageLoader *il);
+static gboolean image_loader_unqueue(ImageLoader *il);
 
 GType image_loader_get_type()
 {
@@ -146,6 +153,8 @@ static void image_loader_init(GTypeInstance *instance, gpointer)
 	il->idle_read_loop_count = IMAGE_LOADER_IDLE_READ_LOOP_COUNT_DEFAULT;
 	il->read_buffer_size = IMAGE_LOADER_READ_BUFFER_SIZE_DEFAULT;
 	il->mapped_file = nullptr;
+	il->preview_map = nullptr;
+	il->preview_map_size = 0;
 	il->preview = IMAGE_LOADER_PREVIEW_NONE;
 
 	il->requested_width = 0;
@@ -153,6 +162,7 @@ static void image_loader_init(GTypeInstance *instance, gpointer)
 	il->actual_width = 0;
 	il->actual_height = 0;
 	il->shrunk = FALSE;
+	il->decode_time = 0;
 
 	il->can_destroy = TRUE;
 
@@ -908,6 +918,56 @@ static gboolean image_loader_begin(ImageLoader *il)
 /* the following functions are always executed in the main thread */
 
 
+/**
+ * @brief Finds an embedded JPEG preview without reading the file through Exiv2
+ * @param requested_width 0 for the largest preview
+ * @returns TRUE if a preview was found, it is then mapped in place from the file
+ *
+ * The preview is selected as exif_get_preview() selects it.
+ */
+static gboolean image_loader_map_embedded_preview(ImageLoader *il, gint requested_width, gint requested_height)
+{
+	const gboolean is_raw = filter_file_class(il->fd->path, FORMAT_CLASS_RAWIMAGE);
+
+	if (!is_raw && requested_width == 0) return FALSE;
+
+	g_autofree gchar *pathl = path_from_utf8(il->fd->path);
+	gsize map_size = 0;
+	guchar *map = map_file(pathl, map_size);
+	if (!map) return FALSE;
+
+	ExifFastData fast;
+	if (!exif_fast_parse(map, std::min<gsize>(map_size, G_MAXUINT), fast) || fast.previews.empty())
+		{
+		munmap(map, map_size);
+		return FALSE;
+		}
+
+	auto pos = std::prev(fast.previews.cend()); // the largest
+	if (requested_width != 0)
+		{
+		pos = std::find_if(fast.previews.cbegin(), pos, [requested_width, requested_height](const ExifFastPreview &preview)
+			{
+			return preview.width >= static_cast<guint>(requested_width) && preview.height >= static_cast<guint>(requested_height);
+			});
+
+		// we are not interested in smaller thumbnails in normal image formats - we can use full image instead
+		if (!is_raw && (pos->width < static_cast<guint>(requested_width) || pos->height < static_cast<guint>(requested_height)))
+			{
+			munmap(map, map_size);
+			return FALSE;
+			}
+		}
+
+	il->preview_map = map;
+	il->preview_map_size = map_size;
+	il->mapped_file = map + pos->offset;
+	il->bytes_total = pos->length;
+	il->preview = IMAGE_LOADER_PREVIEW_EMBEDDED;
+
+	return TRUE;
+}
+
 static gboolean image_loader_setup_source(ImageLoader *il)
 {
 	if (!il || il->backend || il->mapped_file) return FALSE;
@@ -916,15 +976,26 @@ static gboolean image_loader_setup_source(ImageLoader *il)
 
 	if (il->fd)
 		{
-		ExifData *exif = exif_read_fd(il->fd);
+		/* Exiv2 is used only when the fast reader finds no preview */
+		ExifData *exif = nullptr;
+		gboolean exif_read = FALSE;
+		const auto exif_get = [il, &exif, &exif_read]()
+			{
+			if (!exif_read) exif = exif_read_fd(il->fd);
+			exif_read = TRUE;
+			return exif;
+			};
 
 		if (options->thumbnails.use_exif)
 			{
-			il->mapped_file = exif_get_preview(exif, reinterpret_cast<guint *>(&il->bytes_total), il->requested_width, il->requested_height);
-
-			if (il->mapped_file)
+			if (!image_loader_map_embedded_preview(il, il->requested_width, il->requested_height))
 				{
-				il->preview = IMAGE_LOADER_PREVIEW_EXIF;
+				il->mapped_file = exif_get_preview(exif_get(), reinterpret_cast<guint *>(&il->bytes_total), il->requested_width, il->requested_height);
+
+				if (il->mapped_file)
+					{
+					il->preview = IMAGE_LOADER_PREVIEW_EXIF;
+					}
 				}
 			}
 		else
@@ -938,9 +1009,9 @@ static gboolean image_loader_setup_source(ImageLoader *il)
 			}
 
 		/* If libraw does not find a thumbnail, try exiv2 */
-		if (!il->mapped_file)
+		if (!il->mapped_file && !image_loader_map_embedded_preview(il, 0, 0))
 			{
-			il->mapped_file = exif_get_preview(exif, reinterpret_cast<guint *>(&il->bytes_total), 0, 0); /* get the largest available preview image or NULL for normal images*/
+			il->mapped_file = exif_get_preview(exif_get(), reinterpret_cast<guint *>(&il->bytes_total), 0, 0); /* get the largest available preview image or NULL for normal images*/
 
 			if (il->mapped_file)
 				{
@@ -961,7 +1032,7 @@ static gboolean image_loader_setup_source(ImageLoader *il)
 			{
 			DEBUG_1("Usable reduced size (preview) image loaded from file %s", il->fd->path);
 			}
-		exif_free_fd(il->fd, exif);
+		if (exif_read) exif_free_fd(il->fd, exif);
 		}
 
 	if (!il->mapped_file)
@@ -994,6 +1065,12 @@ static void image_loader_stop_source(ImageLoader *il)
 			{
 			libraw_free_preview(il->mapped_file);
 			}
+		else if (il->preview == IMAGE_LOADER_PREVIEW_EMBEDDED)
+			{
+			munmap(il->preview_map, il->preview_map_size);
+			il->preview_map = nullptr;
+			il->preview_map_size = 0;
+			}
 		else
 			{
 			munmap(il->mapped_file, il->bytes_total);
@@ -1013,6 +1090,13 @@ static void image_loader_stop(ImageLoader *il)
 		/* stop loader in the other thread */
 		g_mutex_lock(il->data_mutex);
 		il->stopping = TRUE;
+		g_mutex_unlock(il->data_mutex);
+
+		/* a queued loader is not run again, the rest of the cleanup is done below */
+		const gboolean removed = image_loader_unqueue(il);
+
+		g_mutex_lock(il->data_mutex);
+		if (removed) il->can_destroy = TRUE;
 		while (!il->can_destroy) g_cond_wait(il->can_destroy_cond, il->data_mutex);
 		g_mutex_unlock(il->data_mutex);
 		}
@@ -1097,95 +1181,330 @@ static gboolean image_loader_start_idle(ImageLoader *il)
 /**************************************************************************************/
 /* execution via thread */
 
-static GThreadPool *image_loader_thread_pool = nullptr;
+static void image_loader_add_decode_time(ImageLoader *il, gint64 start)
+{
+	const gint64 elapsed = g_get_monotonic_time() - start;
 
-static GCond *image_loader_prio_cond = nullptr;
-static GMutex *image_loader_prio_mutex = nullptr;
-static gint image_loader_prio_num = 0;
+	g_mutex_lock(il->data_mutex);
+	il->decode_time += elapsed;
+	g_mutex_unlock(il->data_mutex);
+}
 
+namespace
+{
+
+enum ImageLoaderQueuePriority {
+	IMAGE_LOADER_QUEUE_HIGH, /**< Images being displayed or about to be */
+	IMAGE_LOADER_QUEUE_LOW,  /**< Thumbnails and read ahead beyond the next image */
+	IMAGE_LOADER_QUEUE_COUNT
+};
 
-static void image_loader_thread_enter_high()
+constexpr guint IMAGE_LOADER_MAX_THREADS = 16;
+
+struct ImageLoaderTask
 {
-	g_mutex_lock(image_loader_prio_mutex);
-	image_loader_prio_num++;
-	g_mutex_unlock(image_loader_prio_mutex);
-}
+	ImageLoader *il;
+	ImageLoaderQueuePriority priority;
+	gint64 queued_time;
+	gboolean begun; /**< image_loader_begin() was called, the task yielded to higher priority ones */
+};
 
-static void image_loader_thread_leave_high()
+/**
+ * @brief Runs image loaders on a fixed number of threads
+ *
+ * Each thread has a queue per priority. Loaders are pushed round robin
+ * and an idle thread steals from the other queues, high priority loaders
+ * first. A low priority loader which is running yields its thread
+ * between chunks whenever high priority loaders are queued, and is
+ * resumed from the front of the queue later.
+ */
+class ImageLoaderScheduler
 {
-	g_mutex_lock(image_loader_prio_mutex);
-	image_loader_prio_num--;
-	if (image_loader_prio_num == 0) g_cond_broadcast(image_loader_prio_cond); /* wake up all low prio threads */
-	g_mutex_unlock(image_loader_prio_mutex);
-}
+public:
+	explicit ImageLoaderScheduler(guint num_threads);
+
+	void push(const ImageLoaderTask &task, guint worker);
+	void push(ImageLoader *il);
+	gboolean remove(ImageLoader *il);
+	gboolean high_priority_queued() const;
+	ImageLoaderStats get_stats();
+
+private:
+	struct Worker
+	{
+		ImageLoaderScheduler *scheduler;
+		guint index;
+		GMutex mutex;
+		std::array<std::deque<ImageLoaderTask>, IMAGE_LOADER_QUEUE_COUNT> queues;
+	};
+
+	static gpointer worker_thread(gpointer data);
+	gboolean pop(guint worker, ImageLoaderTask &task);
+	void run(guint worker, ImageLoaderTask &task);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	guint next_worker = 0;
+
+	GMutex sleep_mutex;
+	GCond sleep_cond;
+	gint queued = 0; /**< atomic, may be briefly negative */
+	std::array<gint, IMAGE_LOADER_QUEUE_COUNT> queued_by_priority{}; /**< atomic */
 
-static void image_loader_thread_wait_high()
+	GMutex stats_mutex;
+	ImageLoaderStats stats{};
+};
+
+ImageLoaderScheduler *image_loader_scheduler = nullptr;
+
+ImageLoaderScheduler::ImageLoaderScheduler(guint num_threads)
 {
-	g_mutex_lock(image_loader_prio_mutex);
-	while (image_loader_prio_num)
+	g_mutex_init(&sleep_mutex);
+	g_cond_init(&sleep_cond);
+	g_mutex_init(&stats_mutex);
+
+	stats.threads = num_threads;
+
+	for (guint i = 0; i < num_threads; i++)
 		{
-		g_cond_wait(image_loader_prio_cond, image_loader_prio_mutex);
+		auto worker = std::make_unique<Worker>();
+		worker->scheduler = this;
+		worker->index = i;
+		g_mutex_init(&worker->mutex);
+		workers.push_back(std::move(worker));
 		}
 
-	g_mutex_unlock(image_loader_prio_mutex);
+	for (const auto &worker : workers)
+		{
+		g_thread_unref(g_thread_new("image-loader", worker_thread, worker.get()));
+		}
 }
 
-
-static void image_loader_thread_run(gpointer data, gpointer)
+/**
+ * @brief Queues a task on the queue of \a worker
+ *
+ * Tasks which were already begun are resumed before new ones, to
+ * release their resources as early as possible.
+ */
+void ImageLoaderScheduler::push(const ImageLoaderTask &task, guint worker)
 {
-	auto il = static_cast<ImageLoader *>(data);
-	gboolean cont;
-	gboolean err;
+	Worker *w = workers[worker].get();
 
-	if (il->idle_priority > G_PRIORITY_DEFAULT_IDLE)
+	g_mutex_lock(&w->mutex);
+	if (task.begun)
 		{
-		/* low prio, wait until high prio tasks finishes */
-		image_loader_thread_wait_high();
+		w->queues[task.priority].push_front(task);
 		}
 	else
 		{
-		/* high prio */
-		image_loader_thread_enter_high();
+		w->queues[task.priority].push_back(task);
+		}
+	g_atomic_int_inc(&queued_by_priority[task.priority]);
+	g_atomic_int_inc(&queued);
+	g_mutex_unlock(&w->mutex);
+
+	g_mutex_lock(&sleep_mutex);
+	g_cond_signal(&sleep_cond);
+	g_mutex_unlock(&sleep_mutex);
+}
+
+void ImageLoaderScheduler::push(ImageLoader *il)
+{
+	ImageLoaderTask task;
+
+	task.il = il;
+	task.priority = (il->idle_priority > G_PRIORITY_DEFAULT_IDLE) ? IMAGE_LOADER_QUEUE_LOW : IMAGE_LOADER_QUEUE_HIGH;
+	task.queued_time = g_get_monotonic_time();
+	task.begun = FALSE;
+
+	push(task, next_worker);
+	next_worker = (next_worker + 1) % workers.size();
+}
+
+/**
+ * @brief Removes a loader which has not started or which yielded
+ * @returns TRUE if the loader was queued, it will not be run again
+ */
+gboolean ImageLoaderScheduler::remove(ImageLoader *il)
+{
+	for (const auto &w : workers)
+		{
+		g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&w->mutex);
+
+		for (gint priority = 0; priority < IMAGE_LOADER_QUEUE_COUNT; priority++)
+			{
+			auto &queue = w->queues[priority];
+			const auto it = std::find_if(queue.begin(), queue.end(), [il](const ImageLoaderTask &task){ return task.il == il; });
+			if (it == queue.end()) continue;
+
+			queue.erase(it);
+			g_atomic_int_add(&queued_by_priority[priority], -1);
+			g_atomic_int_add(&queued, -1);
+			return TRUE;
+			}
 		}
 
-	err = !image_loader_begin(il);
+	return FALSE;
+}
 
-	if (err)
+gboolean ImageLoaderScheduler::high_priority_queued() const
+{
+	return g_atomic_int_get(&queued_by_priority[IMAGE_LOADER_QUEUE_HIGH]) > 0;
+}
+
+/**
+ * @brief Takes the next task for \a worker
+ *
+ * High priority tasks of all queues come first. Within a priority the
+ * worker takes the oldest task of its own queue, or steals the newest
+ * task of another queue.
+ */
+gboolean ImageLoaderScheduler::pop(guint worker, ImageLoaderTask &task)
+{
+	for (gint priority = 0; priority < IMAGE_LOADER_QUEUE_COUNT; priority++)
 		{
-		/*
-		loader failed, we have to send signal
-		(idle mode returns the image_loader_begin return value directly)
-		(success is always reported indirectly from image_loader_begin)
-		*/
-		image_loader_emit_error(il);
+		for (guint i = 0; i < workers.size(); i++)
+			{
+			const guint victim = (worker + i) % workers.size();
+			Worker *w = workers[victim].get();
+			g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&w->mutex);
+
+			auto &queue = w->queues[priority];
+			if (queue.empty()) continue;
+
+			if (victim == worker)
+				{
+				task = queue.front();
+				queue.pop_front();
+				}
+			else
+				{
+				task = queue.back();
+				queue.pop_back();
+				}
+			g_atomic_int_add(&queued_by_priority[priority], -1);
+			g_atomic_int_add(&queued, -1);
+
+			if (victim != worker)
+				{
+				g_autoptr(GMutexLocker) stats_locker = g_mutex_locker_new(&stats_mutex);
+				stats.steals++;
+				}
+
+			return TRUE;
+			}
 		}
 
-	cont = !err;
+	return FALSE;
+}
 
-	while (cont && !image_loader_get_is_done(il) && !image_loader_get_stopping(il))
+gpointer ImageLoaderScheduler::worker_thread(gpointer data)
+{
+	auto worker = static_cast<Worker *>(data);
+	ImageLoaderScheduler *scheduler = worker->scheduler;
+	ImageLoaderTask task;
+
+	while (TRUE)
 		{
-		if (il->idle_priority > G_PRIORITY_DEFAULT_IDLE)
+		if (scheduler->pop(worker->index, task))
 			{
-			/* low prio, wait until high prio tasks finishes */
-			image_loader_thread_wait_high();
+			scheduler->run(worker->index, task);
+			continue;
 			}
-		cont = image_loader_continue(il);
+
+		g_mutex_lock(&scheduler->sleep_mutex);
+		while (g_atomic_int_get(&scheduler->queued) <= 0)
+			{
+			g_cond_wait(&scheduler->sleep_cond, &scheduler->sleep_mutex);
+			}
+		g_mutex_unlock(&scheduler->sleep_mutex);
 		}
-	image_loader_stop_loader(il);
 
-	if (il->idle_priority <= G_PRIORITY_DEFAULT_IDLE)
+	return nullptr;
+}
+
+void ImageLoaderScheduler::run(guint worker, ImageLoaderTask &task)
+{
+	ImageLoader *il = task.il;
+	gboolean cont = TRUE;
+	gint64 start;
+
+	if (!task.begun)
 		{
-		/* high prio */
-		image_loader_thread_leave_high();
+		const gint64 latency = g_get_monotonic_time() - task.queued_time;
+		g_mutex_lock(&stats_mutex);
+		ImageLoaderQueueStats &queue_stats = (task.priority == IMAGE_LOADER_QUEUE_HIGH) ? stats.high : stats.low;
+		queue_stats.started++;
+		queue_stats.latency_total += latency;
+		queue_stats.latency_max = std::max(queue_stats.latency_max, latency);
+		g_mutex_unlock(&stats_mutex);
+
+		task.begun = TRUE;
+
+		start = g_get_monotonic_time();
+		const gboolean err = !image_loader_begin(il);
+		image_loader_add_decode_time(il, start);
+
+		if (err)
+			{
+			/*
+			loader failed, we have to send signal
+			(idle mode returns the image_loader_begin return value directly)
+			(success is always reported indirectly from image_loader_begin)
+			*/
+			image_loader_emit_error(il);
+			cont = FALSE;
+			}
 		}
 
+	while (cont && !image_loader_get_is_done(il) && !image_loader_get_stopping(il))
+		{
+		if (task.priority == IMAGE_LOADER_QUEUE_LOW && high_priority_queued())
+			{
+			/* low prio, give the thread to the high prio tasks and continue later */
+			g_mutex_lock(&stats_mutex);
+			stats.yields++;
+			g_mutex_unlock(&stats_mutex);
+
+			push(task, worker);
+			return;
+			}
+
+		start = g_get_monotonic_time();
+		cont = image_loader_continue(il);
+		image_loader_add_decode_time(il, start);
+		}
+
+	start = g_get_monotonic_time();
+	image_loader_stop_loader(il);
+	image_loader_add_decode_time(il, start);
+
 	g_mutex_lock(il->data_mutex);
 	il->can_destroy = TRUE;
 	g_cond_signal(il->can_destroy_cond);
 	g_mutex_unlock(il->data_mutex);
+}
+
+ImageLoaderStats ImageLoaderScheduler::get_stats()
+{
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&stats_mutex);
+	ImageLoaderStats ret = stats;
+
+	ret.high.queued = MAX(g_atomic_int_get(&queued_by_priority[IMAGE_LOADER_QUEUE_HIGH]), 0);
+	ret.low.queued = MAX(g_atomic_int_get(&queued_by_priority[IMAGE_LOADER_QUEUE_LOW]), 0);
 
+	return ret;
 }
 
+} // namespace
+
+/**
+ * @brief Removes \a il from the queues of the loader threads
+ * @returns TRUE if it was queued and will not be run
+ */
+static gboolean image_loader_unqueue(ImageLoader *il)
+{
+	return image_loader_scheduler && image_loader_scheduler->remove(il);
+}
 
 static gboolean image_loader_start_thread(ImageLoader *il)
 {
@@ -1197,19 +1516,14 @@ static gboolean image_loader_start_thread(ImageLoader *il)
 
 	if (!image_loader_setup_source(il)) return FALSE;
 
-        if (!image_loader_thread_pool)
+	if (!image_loader_scheduler)
 		{
-		image_loader_thread_pool = g_thread_pool_new(image_loader_thread_run, nullptr, -1, FALSE, nullptr);
-		if (!image_loader_prio_cond) image_loader_prio_cond = g_new(GCond, 1);
-		g_cond_init(image_loader_prio_cond);
-		if (!image_loader_prio_mutex) image_loader_prio_mutex = g_new(GMutex, 1);
-		g_mutex_init(image_loader_prio_mutex);
+		image_loader_scheduler = new ImageLoaderScheduler(CLAMP(g_get_num_processors(), 2, IMAGE_LOADER_MAX_THREADS));
 		}
 
-	il->can_destroy = FALSE; /* ImageLoader can't be freed until image_loader_thread_run finishes */
+	il->can_destroy = FALSE; /* ImageLoader can't be freed until ImageLoaderScheduler::run finishes */
 
-	g_thread_pool_push(image_loader_thread_pool, il, nullptr);
-	DEBUG_1("Thread pool num threads: %u", g_thread_pool_get_num_threads(image_loader_thread_pool));
+	image_loader_scheduler->push(il);
 
 	return TRUE;
 }
@@ -1331,6 +1645,37 @@ gboolean image_loader_get_shrunk(ImageLoader *il)
 	return ret;
 }
 
+ImageLoaderPreview image_loader_get_preview(ImageLoader *il)
+{
+	if (!il) return IMAGE_LOADER_PREVIEW_NONE;
+
+	return il->preview;
+}
+
+/**
+ * @brief Queue depth and latency of the loader threads
+ */
+ImageLoaderStats image_loader_get_stats()
+{
+	if (!image_loader_scheduler) return {};
+
+	return image_loader_scheduler->get_stats();
+}
+
+/**
+ * @brief Time spent decoding so far, in microseconds
+ */
+gint64 image_loader_get_decode_time(ImageLoader *il)
+{
+	gint64 ret;
+	if (!il) return 0;
+
+	g_mutex_lock(il->data_mutex);
+	ret = il->decode_time;
+	g_mutex_unlock(il->data_mutex);
+	return ret;
+}
+
 
 /**
  *  @FIXME this can be rather slow and blocks until the size is known
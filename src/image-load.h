@@ -57,7 +57,8 @@ public:
 enum ImageLoaderPreview {
 	IMAGE_LOADER_PREVIEW_NONE = 0,
 	IMAGE_LOADER_PREVIEW_EXIF = 1,
-	IMAGE_LOADER_PREVIEW_LIBRAW = 2
+	IMAGE_LOADER_PREVIEW_LIBRAW = 2,
+	IMAGE_LOADER_PREVIEW_EMBEDDED = 3 /**< JPEG preview read in place from the mapped file */
 };
 
 
@@ -103,8 +104,12 @@ struct ImageLoader
 	gboolean thread;
 
 	guchar *mapped_file;
+	guchar *preview_map; /**< Mapping of the whole file, for #IMAGE_LOADER_PREVIEW_EMBEDDED */
+	gsize preview_map_size;
 	gsize read_buffer_size;
 	guint idle_read_loop_count;
+
+	gint64 decode_time; /**< Microseconds spent decoding, excluding time waiting for other loaders */
 };
 
 struct ImageLoaderClass {
@@ -118,6 +123,23 @@ struct ImageLoaderClass {
 	void (*size_prepared)(ImageLoader *, const GqSize *size, gpointer);
 };
 
+struct ImageLoaderQueueStats
+{
+	guint queued;         /**< Waiting to start or to resume */
+	guint64 started;
+	gint64 latency_total; /**< Microseconds between queueing and starting, summed over started loaders */
+	gint64 latency_max;
+};
+
+struct ImageLoaderStats
+{
+	guint threads;
+	ImageLoaderQueueStats high;
+	ImageLoaderQueueStats low;
+	guint64 yields;       /**< Low priority loaders suspended for high priority ones */
+	guint64 steals;       /**< Loaders taken from the queue of another thread */
+};
+
 GType image_loader_get_type();
 
 ImageLoader *image_loader_new(FileData *fd);
@@ -140,6 +162,10 @@ gdouble image_loader_get_percent(ImageLoader *il);
 gboolean image_loader_get_is_done(ImageLoader *il);
 FileData *image_loader_get_fd(ImageLoader *il);
 gboolean image_loader_get_shrunk(ImageLoader *il);
+ImageLoaderPreview image_loader_get_preview(ImageLoader *il);
+gint64 image_loader_get_decode_time(ImageLoader *il);
+
+ImageLoaderStats image_loader_get_stats();
 
 gboolean image_load_dimensions(FileData *fd, gint *width, gint *height);
 
@@ -25,6 +25,7 @@
 #include <cstring>
 
 #include <cairo.h>
+#include <gio/gio.h>
 #include <glib-object.h>
 
 #include "collect-table.h"
@@ -35,6 +36,7 @@
 #include "exif.h"
 #include "filecache.h"
 #include "filedata.h"
+#include "filefilter.h"
 #include "geometry.h"
 #include "history-list.h"
 #include "image-load.h"
@@ -57,6 +59,9 @@ namespace
 
 constexpr gdouble aspect_ratios[5] {0.0, gdouble(1.0), gdouble(4.0) / 3, gdouble(3) / 2, gdouble(16) / 9};
 
+constexpr gint64 PREVIEW_MIN_FILE_SIZE = 2 * 1024 * 1024; /**< smaller files are decoded fast enough without a preview */
+constexpr gdouble PREVIEW_MAX_ASPECT_ERROR = 0.02; /**< embedded previews may be cropped */
+
 /*
  * SelectionRectangle
  */
@@ -120,7 +125,8 @@ SelectionRectangle selection_rectangle;
 static GList *image_list = nullptr;
 
 static void image_read_ahead_start(ImageWindow *imd);
-static void image_cache_set(ImageWindow *imd, FileData *fd);
+static void image_cache_set(ImageWindow *imd, FileData *fd, ImageLoader *il);
+static void image_orientation_update(ImageWindow *imd);
 
 /*
  *-------------------------------------------------------------------
@@ -691,6 +697,16 @@ static void image_read_ahead_cancel(ImageWindow *imd)
 	imd->read_ahead_fd = nullptr;
 }
 
+static void image_read_ahead_clear(ImageWindow *imd)
+{
+	image_read_ahead_cancel(imd);
+
+	file_data_list_free(imd->read_ahead_list);
+	imd->read_ahead_list = nullptr;
+	imd->read_ahead_bytes = 0;
+	imd->read_ahead_count = 0;
+}
+
 static void image_read_ahead_done_cb(ImageLoader *, gpointer data)
 {
 	auto imd = static_cast<ImageWindow *>(data);
@@ -705,13 +721,19 @@ static void image_read_ahead_done_cb(ImageLoader *, gpointer data)
 		if (imd->read_ahead_fd->pixbuf)
 			{
 			g_object_ref(imd->read_ahead_fd->pixbuf);
-			image_cache_set(imd, imd->read_ahead_fd);
+			image_cache_set(imd, imd->read_ahead_fd, imd->read_ahead_il);
+
+			imd->read_ahead_bytes += static_cast<gulong>(gdk_pixbuf_get_rowstride(imd->read_ahead_fd->pixbuf)) * static_cast<gulong>(gdk_pixbuf_get_height(imd->read_ahead_fd->pixbuf));
 			}
 		}
+	imd->read_ahead_count++;
 	image_loader_free(imd->read_ahead_il);
 	imd->read_ahead_il = nullptr;
 
 	image_complete_util(imd, TRUE);
+
+	/* the decoded image is in the cache now, continue with the next one */
+	image_read_ahead_start(imd);
 }
 
 static void image_read_ahead_error_cb(ImageLoader *il, gpointer data)
@@ -720,18 +742,72 @@ static void image_read_ahead_error_cb(ImageLoader *il, gpointer data)
 	image_read_ahead_done_cb(il, data);
 }
 
+/**
+ * @brief Checks that decoding another image keeps the images read ahead in the cache
+ *
+ * The next image is assumed to be as large as the average of those
+ * decoded so far. The displayed image is in the cache too.
+ */
+static gboolean image_read_ahead_within_budget(ImageWindow *imd)
+{
+	if (imd->read_ahead_count == 0) return TRUE;
+
+	auto budget = static_cast<gulong>(options->image.image_cache_max) * 1048576;
+	if (imd->image_fd && imd->image_fd->pixbuf)
+		{
+		const gulong size = static_cast<gulong>(gdk_pixbuf_get_rowstride(imd->image_fd->pixbuf)) * static_cast<gulong>(gdk_pixbuf_get_height(imd->image_fd->pixbuf));
+		budget = (size < budget) ? budget - size : 0;
+		}
+
+	return imd->read_ahead_bytes + (imd->read_ahead_bytes / imd->read_ahead_count) <= budget;
+}
+
 static void image_read_ahead_start(ImageWindow *imd)
 {
 	/* already started ? */
-	if (!imd->read_ahead_fd || imd->read_ahead_il || imd->read_ahead_fd->pixbuf) return;
+	if (imd->read_ahead_il) return;
 
 	/* still loading ?, do later */
 	if (imd->il /*|| imd->cm*/) return;
 
+	if (imd->read_ahead_fd && imd->read_ahead_fd->pixbuf)
+		{
+		file_data_unref(imd->read_ahead_fd);
+		imd->read_ahead_fd = nullptr;
+		}
+
+	/* take the next image which is not decoded yet */
+	while (!imd->read_ahead_fd && imd->read_ahead_list)
+		{
+		auto fd = static_cast<FileData *>(imd->read_ahead_list->data);
+		imd->read_ahead_list = g_list_delete_link(imd->read_ahead_list, imd->read_ahead_list);
+
+		if (fd->pixbuf || fd == imd->image_fd)
+			{
+			file_data_unref(fd);
+			continue;
+			}
+
+		imd->read_ahead_fd = fd;
+		}
+
+	if (!imd->read_ahead_fd) return;
+
+	if (!image_read_ahead_within_budget(imd))
+		{
+		DEBUG_1("%s read ahead stopped, cache budget reached after %d images", get_exec_time(), imd->read_ahead_count);
+		image_read_ahead_clear(imd);
+		return;
+		}
+
 	DEBUG_1("%s read ahead started for :%s", get_exec_time(), imd->read_ahead_fd->path);
 
 	imd->read_ahead_il = image_loader_new(imd->read_ahead_fd);
 
+	/* the nearest image is likely to be displayed next, the others must not
+	 * delay loaders which are needed now */
+	if (imd->read_ahead_count > 0) image_loader_set_priority(imd->read_ahead_il, G_PRIORITY_LOW);
+
 	image_loader_delay_area_ready(imd->read_ahead_il, TRUE); /* we will need the area_ready signals later */
 
 	g_signal_connect(G_OBJECT(imd->read_ahead_il), "error", (GCallback)image_read_ahead_error_cb, imd);
@@ -744,19 +820,6 @@ static void image_read_ahead_start(ImageWindow *imd)
 		}
 }
 
-static void image_read_ahead_set(ImageWindow *imd, FileData *fd)
-{
-	if (imd->read_ahead_fd && fd && imd->read_ahead_fd == fd) return;
-
-	image_read_ahead_cancel(imd);
-
-	imd->read_ahead_fd = file_data_ref(fd);
-
-	DEBUG_1("read ahead set to :%s", imd->read_ahead_fd->path);
-
-	image_read_ahead_start(imd);
-}
-
 /*
  *-------------------------------------------------------------------
  * post buffering
@@ -769,18 +832,66 @@ static void image_cache_release_cb(FileData *fd)
 	fd->pixbuf = nullptr;
 }
 
+/**
+ * @brief Releases cached images when the system runs low on memory
+ *
+ * The cache keeps its maximum size and refills as images are viewed.
+ * On Linux GLib derives the warning level from the kernel pressure
+ * stall information.
+ */
+static void image_cache_low_memory_cb(GMemoryMonitor *, GMemoryMonitorWarningLevel level, gpointer data)
+{
+	auto cache = static_cast<FileCacheData *>(data);
+	const FileCacheStats stats = file_cache_get_stats(cache);
+	gulong size;
+
+	if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+		{
+		size = 0;
+		}
+	else if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+		{
+		size = stats.size / 4;
+		}
+	else
+		{
+		size = stats.size / 2;
+		}
+
+	DEBUG_1("image cache: low memory warning %d, trimming from %lu to %lu bytes", level, stats.size, size);
+	file_cache_trim(cache, size);
+}
+
 static FileCacheData *image_get_cache()
 {
-	static FileCacheData *cache = file_cache_new(image_cache_release_cb, 1);
+	static FileCacheData *cache = nullptr;
+
+	if (!cache)
+		{
+		cache = file_cache_new(image_cache_release_cb, 1);
+
+		/* The monitor is kept for the lifetime of the cache, which is never freed */
+		GMemoryMonitor *monitor = g_memory_monitor_dup_default();
+		g_signal_connect(monitor, "low-memory-warning", G_CALLBACK(image_cache_low_memory_cb), cache);
+		}
 	file_cache_set_max_size(cache, static_cast<gulong>(options->image.image_cache_max) * 1048576); /* update from options */
 	return cache;
 }
 
-static void image_cache_set(ImageWindow *, FileData *fd)
+/**
+ * @brief Adds the pixbuf of \a fd, decoded by \a il, to the cache
+ *
+ * The cost of an entry is its decode time times its size, so that
+ * images which are slow to decode are kept in preference to cheap ones.
+ */
+static void image_cache_set(ImageWindow *, FileData *fd, ImageLoader *il)
 {
 	g_assert(fd->pixbuf);
 
-	file_cache_put(image_get_cache(), fd, static_cast<gulong>(gdk_pixbuf_get_rowstride(fd->pixbuf)) * static_cast<gulong>(gdk_pixbuf_get_height(fd->pixbuf)));
+	const gulong size = static_cast<gulong>(gdk_pixbuf_get_rowstride(fd->pixbuf)) * static_cast<gulong>(gdk_pixbuf_get_height(fd->pixbuf));
+	const auto decode_time = static_cast<guint64>(image_loader_get_decode_time(il));
+
+	file_cache_put(image_get_cache(), fd, size, decode_time * size);
 	file_data_send_notification(fd, NOTIFY_PIXBUF); /* to update histogram */
 }
 
@@ -798,12 +909,113 @@ static gint image_cache_get(ImageWindow *imd)
 	return success;
 }
 
+FileCacheStats image_cache_get_stats()
+{
+	return file_cache_get_stats(image_get_cache());
+}
+
 /*
  *-------------------------------------------------------------------
  * loading
  *-------------------------------------------------------------------
  */
 
+/*
+ * A reduced preview of large JPEG and RAW files is decoded alongside the
+ * full image and shown until that is complete. JPEG files are decoded at a
+ * fraction of their size, RAW files use the smallest embedded preview that
+ * fills the window.
+ */
+
+static void image_load_preview_cancel(ImageWindow *imd)
+{
+	image_loader_free(imd->preview_il);
+	imd->preview_il = nullptr;
+}
+
+static void image_load_preview_show(ImageWindow *imd)
+{
+	if (!imd->preview_il || !image_loader_get_is_done(imd->preview_il)) return;
+
+	/* the preview is placed by the size of the full image */
+	if (imd->load_width < 1 || imd->load_height < 1) return;
+
+	GdkPixbuf *pixbuf = image_loader_get_pixbuf(imd->preview_il);
+
+	/* the full image may already be displayed progressively */
+	if (pixbuf && imd->il && !image_get_pixbuf(imd) &&
+	    gdk_pixbuf_get_width(pixbuf) < imd->load_width)
+		{
+		const gdouble aspect = static_cast<gdouble>(imd->load_width) / imd->load_height;
+		const gdouble preview_aspect = static_cast<gdouble>(gdk_pixbuf_get_width(pixbuf)) / gdk_pixbuf_get_height(pixbuf);
+
+		if (fabs((preview_aspect / aspect) - 1.0) < PREVIEW_MAX_ASPECT_ERROR)
+			{
+			DEBUG_1("%s image preview %dx%d", get_exec_time(), gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+
+			image_orientation_update(imd);
+
+			pixbuf_renderer_set_post_process_func(PIXBUF_RENDERER(imd->pr), nullptr, FALSE);
+			pixbuf_renderer_set_pixbuf_preview(PIXBUF_RENDERER(imd->pr), pixbuf,
+			                                   imd->load_width, imd->load_height,
+			                                   image_zoom_get(imd), imd->orientation);
+			image_set_pixbuf_renderer_post_process_func(imd);
+			}
+		}
+
+	image_load_preview_cancel(imd);
+}
+
+static void image_load_preview_done_cb(ImageLoader *, gpointer data)
+{
+	auto imd = static_cast<ImageWindow *>(data);
+
+	image_load_preview_show(imd);
+}
+
+static void image_load_preview_error_cb(ImageLoader *, gpointer data)
+{
+	auto imd = static_cast<ImageWindow *>(data);
+
+	image_load_preview_cancel(imd);
+}
+
+static void image_load_preview_size_prepared_cb(ImageLoader *il, const GqSize *, gpointer data)
+{
+	auto imd = static_cast<ImageWindow *>(data);
+
+	/* not reduced, this would only decode the full image twice */
+	if (!image_loader_get_shrunk(il) && image_loader_get_preview(il) == IMAGE_LOADER_PREVIEW_NONE)
+		{
+		image_load_preview_cancel(imd);
+		}
+}
+
+static void image_load_preview_start(ImageWindow *imd, FileData *fd)
+{
+	if (!options->image.zoom_2pass || !options->image.zoom_2pass_preview) return;
+	if (imd->delay_flip || imd->preview_il) return;
+	if (fd->format_class != FORMAT_CLASS_IMAGE && fd->format_class != FORMAT_CLASS_RAWIMAGE) return;
+	if (fd->size < PREVIEW_MIN_FILE_SIZE) return;
+
+	PixbufRenderer *pr = PIXBUF_RENDERER(imd->pr);
+	if (pr->window_width < 1 || pr->window_height < 1) return;
+
+	const gint scale = gtk_widget_get_scale_factor(imd->pr);
+
+	imd->preview_il = image_loader_new(fd);
+	image_loader_set_requested_size(imd->preview_il, pr->window_width * scale, pr->window_height * scale);
+
+	g_signal_connect(G_OBJECT(imd->preview_il), "error", G_CALLBACK(image_load_preview_error_cb), imd);
+	g_signal_connect(G_OBJECT(imd->preview_il), "done", G_CALLBACK(image_load_preview_done_cb), imd);
+	g_signal_connect(G_OBJECT(imd->preview_il), "size-prepared", G_CALLBACK(image_load_preview_size_prepared_cb), imd);
+
+	if (!image_loader_start(imd->preview_il))
+		{
+		image_load_preview_cancel(imd);
+		}
+}
+
 static void image_load_pixbuf_ready(ImageWindow *imd)
 {
 	if (image_get_pixbuf(imd) || !imd->il) return;
@@ -816,7 +1028,8 @@ static void image_load_area_ready_cb(ImageLoader *il, const GdkRectangle *area,
 	auto imd = static_cast<ImageWindow *>(data);
 	PixbufRenderer *pr = PIXBUF_RENDERER(imd->pr);
 
-	if (imd->delay_flip &&
+	/* keep the old image or the preview until the new one is complete */
+	if ((imd->delay_flip || pr->full_width > 0) &&
 	    pr->pixbuf != image_loader_get_pixbuf(il))
 		{
 		return;
@@ -833,10 +1046,12 @@ static void image_load_done_cb(ImageLoader *, gpointer data)
 
 	DEBUG_1("%s image done", get_exec_time());
 
+	image_load_preview_cancel(imd);
+
 	if (options->image.enable_read_ahead && imd->image_fd && !imd->image_fd->pixbuf && image_loader_get_pixbuf(imd->il))
 		{
 		imd->image_fd->pixbuf = g_object_ref(image_loader_get_pixbuf(imd->il));
-		image_cache_set(imd, imd->image_fd);
+		image_cache_set(imd, imd->image_fd, imd->il);
 		}
 	/* call the callback triggered by image_state after fd->pixbuf is set */
 	g_object_set(imd->pr, "loading", FALSE, NULL);
@@ -851,7 +1066,7 @@ static void image_load_done_cb(ImageLoader *, gpointer data)
 
 		imd->unknown = TRUE;
 		}
-	else if (imd->delay_flip &&
+	else if ((imd->delay_flip || PIXBUF_RENDERER(imd->pr)->full_width > 0) &&
 	    image_get_pixbuf(imd) != image_loader_get_pixbuf(imd->il))
 		{
 		g_object_set(imd->pr, "complete", FALSE, NULL);
@@ -870,6 +1085,10 @@ static void image_load_size_prepared_cb(ImageLoader *, const GqSize *size, gpoin
 
 	DEBUG_1("image_load_size_cb: %dx%d", size->width, size->height);
 	pixbuf_renderer_set_size_early(PIXBUF_RENDERER(imd->pr), size->width, size->height);
+
+	imd->load_width = size->width;
+	imd->load_height = size->height;
+	image_load_preview_show(imd);
 }
 
 static void image_load_error_cb(ImageLoader *il, gpointer data)
@@ -904,11 +1123,8 @@ static gboolean image_read_ahead_check(ImageWindow *imd)
 	if (!imd->read_ahead_fd) return FALSE;
 	if (imd->il) return FALSE;
 
-	if (!imd->image_fd || imd->read_ahead_fd != imd->image_fd)
-		{
-		image_read_ahead_cancel(imd);
-		return FALSE;
-		}
+	/* keep reading ahead, the next image may be wanted later */
+	if (!imd->image_fd || imd->read_ahead_fd != imd->image_fd) return FALSE;
 
 	if (imd->read_ahead_il)
 		{
@@ -973,10 +1189,17 @@ static gboolean image_load_begin(ImageWindow *imd, FileData *fd)
 		pr = PIXBUF_RENDERER(imd->pr);
 		if (pr->pixbuf) g_object_unref(pr->pixbuf);
 		pr->pixbuf = nullptr;
+		pr->full_width = 0;
+		pr->full_height = 0;
 		}
 
 	g_object_set(imd->pr, "loading", TRUE, NULL);
 
+	/* queued first, so that it is decoded first */
+	imd->load_width = 0;
+	imd->load_height = 0;
+	image_load_preview_start(imd, fd);
+
 	imd->il = image_loader_new(fd);
 
 	image_load_set_signals(imd, FALSE);
@@ -987,6 +1210,7 @@ static gboolean image_load_begin(ImageWindow *imd, FileData *fd)
 
 		g_object_set(imd->pr, "loading", FALSE, NULL);
 
+		image_load_preview_cancel(imd);
 		image_loader_free(imd->il);
 		imd->il = nullptr;
 
@@ -1014,6 +1238,7 @@ static void image_reset(ImageWindow *imd)
 
 	g_object_set(imd->pr, "loading", FALSE, NULL);
 
+	image_load_preview_cancel(imd);
 	image_loader_free(imd->il);
 	imd->il = nullptr;
 
@@ -1315,15 +1540,8 @@ GdkPixbuf *image_get_pixbuf(ImageWindow *imd)
 	return pixbuf_renderer_get_pixbuf(PIXBUF_RENDERER(imd->pr));
 }
 
-void image_change_pixbuf(ImageWindow *imd, GdkPixbuf *pixbuf, gdouble zoom, gboolean lazy)
+static void image_orientation_update(ImageWindow *imd)
 {
-	LayoutWindow *lw;
-	StereoPixbufData stereo_data = STEREO_PIXBUF_DEFAULT;
-	/* read_exif and similar functions can actually notice that the file has changed and trigger
-	   a notification that removes the pixbuf from cache and unrefs it. Therefore we must ref it
-	   here before it is taken over by the renderer. */
-	if (pixbuf) g_object_ref(pixbuf);
-
 	imd->orientation = EXIF_ORIENTATION_TOP_LEFT;
 	if (imd->image_fd)
 		{
@@ -1345,6 +1563,18 @@ void image_change_pixbuf(ImageWindow *imd, GdkPixbuf *pixbuf, gdouble zoom, gboo
 			imd->image_fd->exif_orientation = imd->orientation;
 			}
 		}
+}
+
+void image_change_pixbuf(ImageWindow *imd, GdkPixbuf *pixbuf, gdouble zoom, gboolean lazy)
+{
+	LayoutWindow *lw;
+	StereoPixbufData stereo_data = STEREO_PIXBUF_DEFAULT;
+	/* read_exif and similar functions can actually notice that the file has changed and trigger
+	   a notification that removes the pixbuf from cache and unrefs it. Therefore we must ref it
+	   here before it is taken over by the renderer. */
+	if (pixbuf) g_object_ref(pixbuf);
+
+	image_orientation_update(imd);
 
 	if (pixbuf)
 		{
@@ -1454,6 +1684,8 @@ void image_move_from_image(ImageWindow *imd, ImageWindow *source)
 	imd->collection = source->collection;
 	imd->collection_info = source->collection_info;
 
+	image_load_preview_cancel(imd);
+	image_load_preview_cancel(source);
 	image_loader_free(imd->il);
 	imd->il = nullptr;
 
@@ -1464,6 +1696,8 @@ void image_move_from_image(ImageWindow *imd, ImageWindow *source)
 		{
 		imd->il = source->il;
 		source->il = nullptr;
+		imd->load_width = source->load_width;
+		imd->load_height = source->load_height;
 
 		image_loader_sync_data(imd->il, source, imd);
 		}
@@ -1478,8 +1712,8 @@ void image_move_from_image(ImageWindow *imd, ImageWindow *source)
 		std::swap(imd->cm, source->cm);
 		}
 
-	file_data_unref(imd->read_ahead_fd);
-	source->read_ahead_fd = nullptr;
+	image_read_ahead_clear(imd);
+	image_read_ahead_clear(source);
 
 	imd->orientation = source->orientation;
 	imd->desaturate = source->desaturate;
@@ -1503,6 +1737,7 @@ void image_copy_from_image(ImageWindow *imd, ImageWindow *source)
 	imd->collection = source->collection;
 	imd->collection_info = source->collection_info;
 
+	image_load_preview_cancel(imd);
 	image_loader_free(imd->il);
 	imd->il = nullptr;
 
@@ -1528,6 +1763,12 @@ void image_copy_from_image(ImageWindow *imd, ImageWindow *source)
 	imd->read_ahead_fd = source->read_ahead_fd;
 	source->read_ahead_fd = nullptr;
 
+	file_data_list_free(imd->read_ahead_list);
+	imd->read_ahead_list = source->read_ahead_list;
+	source->read_ahead_list = nullptr;
+	imd->read_ahead_bytes = source->read_ahead_bytes;
+	imd->read_ahead_count = source->read_ahead_count;
+
 	imd->completed = source->completed;
 	imd->state = source->state;
 	source->state = IMAGE_STATE_NONE;
@@ -1740,20 +1981,49 @@ void image_stereo_pixbuf_set(ImageWindow *imd, StereoPixbufData stereo_mode)
  * @brief Read ahead, pass NULL to cancel
  */
 void image_prebuffer_set(ImageWindow *imd, FileData *fd)
+{
+	g_autoptr(GList) list = fd ? g_list_prepend(nullptr, fd) : nullptr;
+
+	image_prebuffer_set_list(imd, list);
+}
+
+/**
+ * @brief Read ahead the images of \a list in order, pass NULL to cancel
+ * @param list FileData, nearest first, the list is not modified
+ *
+ * Replaces the previous list. An image which is being read ahead is
+ * only cancelled when it is not in the new list, so that stale work is
+ * dropped when the direction of travel changes. Reading ahead stops when
+ * more images would not fit in the decoded image cache.
+ */
+void image_prebuffer_set_list(ImageWindow *imd, GList *list)
 {
 	if (pixbuf_renderer_get_tiles(PIXBUF_RENDERER(imd->pr))) return;
 
-	if (fd)
+	if (imd->read_ahead_fd && !g_list_find(list, imd->read_ahead_fd))
 		{
-		if (!file_cache_get(image_get_cache(), fd))
-			{
-			image_read_ahead_set(imd, fd);
-			}
+		image_read_ahead_cancel(imd);
 		}
-	else
+
+	file_data_list_free(imd->read_ahead_list);
+	imd->read_ahead_list = nullptr;
+	imd->read_ahead_bytes = 0;
+	imd->read_ahead_count = 0;
+
+	for (GList *work = list; work; work = work->next)
 		{
-		image_read_ahead_cancel(imd);
+		auto fd = static_cast<FileData *>(work->data);
+
+		/* this also marks cached images as recently used, so they are kept */
+		if (!fd || fd == imd->read_ahead_fd || file_cache_get(image_get_cache(), fd)) continue;
+
+		imd->read_ahead_list = g_list_prepend(imd->read_ahead_list, file_data_ref(fd));
 		}
+	imd->read_ahead_list = g_list_reverse(imd->read_ahead_list);
+
+	DEBUG_1("read ahead set to %u images", g_list_length(imd->read_ahead_list) + (imd->read_ahead_fd ? 1 : 0));
+
+	image_read_ahead_start(imd);
 }
 
 static void image_notify_cb(FileData *fd, NotifyType type, gpointer data)
@@ -2001,7 +2271,7 @@ static void image_free(ImageWindow *imd)
 
 	image_reset(imd);
 
-	image_read_ahead_cancel(imd);
+	image_read_ahead_clear(imd);
 
 	file_data_unref(imd->image_fd);
 	g_free(imd->title);
@@ -37,6 +37,7 @@ struct CollectionData;
 struct ColorMan;
 struct ColorManStatus;
 class FileData;
+struct FileCacheStats;
 struct ImageLoader;
 
 enum AlterType : gint {
@@ -122,6 +123,13 @@ struct ImageWindow
 
 	FileData *read_ahead_fd;
 	ImageLoader *read_ahead_il;
+	GList *read_ahead_list;        /**< FileData to read ahead after read_ahead_fd, nearest first */
+	gulong read_ahead_bytes;       /**< decoded by the current read ahead request */
+	gint read_ahead_count;         /**< images decoded by the current read ahead request */
+
+	ImageLoader *preview_il;       /**< decodes a reduced preview of the image while il decodes all of it */
+	gint load_width;               /**< unrotated size of the image il is decoding, 0 until known */
+	gint load_height;
 
 	gint prev_color_row;
 
@@ -219,6 +227,8 @@ StereoPixbufData image_stereo_pixbuf_get(const ImageWindow *imd);
 void image_stereo_pixbuf_set(ImageWindow *imd, StereoPixbufData stereo_mode);
 
 void image_prebuffer_set(ImageWindow *imd, FileData *fd);
+void image_prebuffer_set_list(ImageWindow *imd, GList *list);
+FileCacheStats image_cache_get_stats();
 
 void image_auto_refresh_enable(ImageWindow *imd, gboolean enable);
 
@@ -24,6 +24,7 @@
 #include <algorithm>
 #include <cstring>
 #include <functional>
+#include <utility>
 
 namespace
 {
@@ -230,6 +231,607 @@ gint mpo_parse_Attributes_IFD_entry(const guchar *tiff, guint offset, TiffByteOr
 	return 0;
 }
 
+/*
+ *-------------------------------------------------------------------
+ * fast reader of the commonly used tags
+ *-------------------------------------------------------------------
+ */
+
+constexpr guint TIFF_FORMAT_BYTE = 1;
+constexpr guint TIFF_FORMAT_ASCII = 2;
+constexpr guint TIFF_FORMAT_SHORT = 3;
+constexpr guint TIFF_FORMAT_LONG = 4;
+constexpr guint TIFF_FORMAT_RATIONAL = 5;
+constexpr guint TIFF_FORMAT_UNDEFINED = 7;
+
+constexpr guint TIFF_TAG_COMPRESSION = 0x0103;
+constexpr guint TIFF_TAG_MAKE = 0x010f;
+constexpr guint TIFF_TAG_MODEL = 0x0110;
+constexpr guint TIFF_TAG_STRIP_OFFSETS = 0x0111;
+constexpr guint TIFF_TAG_ORIENTATION = 0x0112;
+constexpr guint TIFF_TAG_STRIP_BYTE_COUNTS = 0x0117;
+constexpr guint TIFF_TAG_SOFTWARE = 0x0131;
+constexpr guint TIFF_TAG_SUB_IFDS = 0x014a;
+constexpr guint TIFF_TAG_JPEG_OFFSET = 0x0201;
+constexpr guint TIFF_TAG_JPEG_LENGTH = 0x0202;
+constexpr guint TIFF_TAG_XMP = 0x02bc;
+constexpr guint TIFF_TAG_RATING = 0x4746;
+constexpr guint TIFF_TAG_RATING_PERCENT = 0x4749;
+constexpr guint TIFF_TAG_IPTC = 0x83bb;
+constexpr guint TIFF_TAG_PHOTOSHOP = 0x8649;
+constexpr guint TIFF_TAG_EXIF_IFD = 0x8769;
+constexpr guint TIFF_TAG_GPS_IFD = 0x8825;
+
+constexpr guint EXIF_TAG_DATE_TIME_ORIGINAL = 0x9003;
+constexpr guint EXIF_TAG_DATE_TIME_DIGITIZED = 0x9004;
+constexpr guint EXIF_TAG_PIXEL_X_DIMENSION = 0xa002;
+constexpr guint EXIF_TAG_PIXEL_Y_DIMENSION = 0xa003;
+constexpr guint EXIF_TAG_LENS_MODEL = 0xa434;
+
+constexpr guint GPS_TAG_LATITUDE_REF = 0x0001;
+constexpr guint GPS_TAG_LATITUDE = 0x0002;
+constexpr guint GPS_TAG_LONGITUDE_REF = 0x0003;
+constexpr guint GPS_TAG_LONGITUDE = 0x0004;
+
+constexpr guint TIFF_COMPRESSION_OJPEG = 6;
+constexpr guint TIFF_COMPRESSION_JPEG = 7;
+
+constexpr guint EXIF_FAST_MAX_IFDS = 32; /**< Guards against loops in broken files */
+
+constexpr std::string_view EXIF_MAGIC{"Exif\x00\x00", 6};
+constexpr std::string_view XMP_MAGIC{"http://ns.adobe.com/xap/1.0/\x00", 29};
+constexpr std::string_view XMP_EXTENSION_MAGIC{"http://ns.adobe.com/xmp/extension/\x00", 35};
+constexpr std::string_view PHOTOSHOP_MAGIC{"Photoshop 3.0\x00", 14};
+
+struct XmpNamespace
+{
+	std::string_view prefix;
+	std::string_view uri;
+};
+
+/** Namespaces of the properties read by exif_fast_parse_xmp(), with the prefixes it looks for */
+constexpr XmpNamespace XMP_READ_NAMESPACES[] = {
+	{"rdf", "http://www.w3.org/1999/02/22-rdf-syntax-ns#"},
+	{"xmp", "http://ns.adobe.com/xap/1.0/"},
+	{"dc", "http://purl.org/dc/elements/1.1/"}
+};
+
+/** Namespaces whose properties Exiv2 merges with the Exif data */
+constexpr std::string_view XMP_MERGED_NAMESPACES[] = {
+	"http://ns.adobe.com/exif/1.0/",
+	"http://ns.adobe.com/tiff/1.0/",
+	"http://cipa.jp/exif/1.0/"
+};
+
+/**
+ * @brief Reads the values of TIFF tags in place
+ *
+ * The offsets of the previews are relative to the start of the file, which
+ * is base bytes before the TIFF header.
+ */
+struct TiffReader
+{
+	const guchar *tiff;
+	guint size;
+	TiffByteOrder bo;
+	guint base;
+
+	/* Offset of the values of a tag, if they are in the data */
+	bool value_offset(guint entry, const TiffTag &tt, guint &offset) const
+	{
+		guint element_size;
+
+		switch (tt.format)
+			{
+			case TIFF_FORMAT_BYTE:
+			case TIFF_FORMAT_ASCII:
+			case TIFF_FORMAT_UNDEFINED:
+				element_size = 1;
+				break;
+			case TIFF_FORMAT_SHORT:
+				element_size = 2;
+				break;
+			case TIFF_FORMAT_LONG:
+				element_size = 4;
+				break;
+			case TIFF_FORMAT_RATIONAL:
+				element_size = 8;
+				break;
+			default:
+				return false;
+			}
+
+		const guint64 length = static_cast<guint64>(tt.count) * element_size;
+		offset = (length <= 4) ? entry + TIFF_TIFD_OFFSET_DATA : tt.data_val;
+
+		return offset + length <= size;
+	}
+
+	std::string text(guint entry, const TiffTag &tt) const
+	{
+		guint offset;
+		if (tt.format != TIFF_FORMAT_ASCII || !value_offset(entry, tt, offset)) return {};
+
+		const auto *str = reinterpret_cast<const gchar *>(tiff + offset);
+
+		return {str, strnlen(str, tt.count)};
+	}
+
+	std::optional<guint> number(guint entry, const TiffTag &tt, guint index = 0) const
+	{
+		guint offset;
+		if (index >= tt.count || !value_offset(entry, tt, offset)) return {};
+
+		if (tt.format == TIFF_FORMAT_SHORT) return tiff_byte_get_int16(tiff + offset + (index * 2), bo);
+		if (tt.format == TIFF_FORMAT_LONG) return tiff_byte_get_int32(tiff + offset + (index * 4), bo);
+
+		return {};
+	}
+
+	std::optional<gdouble> rational(guint entry, const TiffTag &tt, guint index) const
+	{
+		guint offset;
+		if (tt.format != TIFF_FORMAT_RATIONAL || index >= tt.count || !value_offset(entry, tt, offset)) return {};
+
+		const guint32 numerator = tiff_byte_get_int32(tiff + offset + (index * 8), bo);
+		const guint32 denominator = tiff_byte_get_int32(tiff + offset + (index * 8) + 4, bo);
+		if (denominator == 0) return {};
+
+		return static_cast<gdouble>(numerator) / denominator;
+	}
+};
+
+/**
+ * @brief Finds the frame header of a JPEG stream
+ * @returns the SOF marker, 0 if not found
+ */
+guchar jpeg_find_frame(const guchar *data, guint size, guint &width, guint &height)
+{
+	if (!is_jpeg_container(data, size)) return 0;
+
+	guint offset = 2;
+
+	while (offset + 4 <= size)
+		{
+		if (data[offset] != JPEG_MARKER) return 0;
+
+		const guchar marker = data[offset + 1];
+		if (marker == JPEG_MARKER)
+			{
+			/* fill byte */
+			offset++;
+			continue;
+			}
+
+		/* markers without data */
+		if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7))
+			{
+			offset += 2;
+			continue;
+			}
+
+		if (marker == JPEG_MARKER_EOI || marker == 0xda) return 0; /* EOI, SOS */
+
+		const guint length = (static_cast<guint>(data[offset + 2]) << 8) + data[offset + 3];
+
+		if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc)
+			{
+			if (length < 7 || offset + 9 > size) return 0;
+
+			height = (static_cast<guint>(data[offset + 5]) << 8) + data[offset + 6];
+			width = (static_cast<guint>(data[offset + 7]) << 8) + data[offset + 8];
+			return marker;
+			}
+
+		offset += 2 + length;
+		}
+
+	return 0;
+}
+
+void exif_fast_add_preview(const guchar *data, guint size, guint offset, guint length, ExifFastData &fast)
+{
+	if (length == 0 || offset >= size || length > size - offset) return;
+
+	for (const ExifFastPreview &preview : fast.previews)
+		{
+		if (preview.offset == offset) return;
+		}
+
+	/* Only baseline and progressive JPEG, other streams are raw image data */
+	guint width = 0;
+	guint height = 0;
+	const guchar frame = jpeg_find_frame(data + offset, length, width, height);
+	if (frame != 0xc0 && frame != 0xc1 && frame != 0xc2) return;
+	if (width == 0 || height == 0) return;
+
+	fast.previews.push_back({offset, length, width, height});
+}
+
+bool xml_unescape(std::string_view text, std::string &out)
+{
+	out.clear();
+
+	while (!text.empty())
+		{
+		const size_t amp = text.find('&');
+		out.append(text.substr(0, amp));
+		if (amp == std::string_view::npos) break;
+
+		text.remove_prefix(amp);
+		const size_t semicolon = text.find(';');
+		if (semicolon == std::string_view::npos) return false;
+
+		const std::string_view entity = text.substr(1, semicolon - 1);
+		text.remove_prefix(semicolon + 1);
+
+		if (entity == "amp") out.push_back('&');
+		else if (entity == "lt") out.push_back('<');
+		else if (entity == "gt") out.push_back('>');
+		else if (entity == "quot") out.push_back('"');
+		else if (entity == "apos") out.push_back('\'');
+		else if (entity.size() > 1 && entity[0] == '#')
+			{
+			const std::string number{entity.substr(1)};
+			gchar *end;
+			const auto c = static_cast<gunichar>((number[0] == 'x') ? g_ascii_strtoull(number.c_str() + 1, &end, 16) : g_ascii_strtoull(number.c_str(), &end, 10));
+			if (*end != '\0' || !g_unichar_validate(c)) return false;
+
+			gchar utf8[6];
+			out.append(utf8, g_unichar_to_utf8(c, utf8));
+			}
+		else
+			{
+			return false;
+			}
+		}
+
+	return true;
+}
+
+/**
+ * @brief Checks the namespace declarations of an XMP packet
+ * @returns false if the properties cannot be found by their usual prefixes,
+ * or if the packet has properties Exiv2 merges with the Exif data
+ *
+ * Exiv2 identifies properties by namespace URI, so a packet which binds
+ * for instance the XMP namespace to the older xap: prefix has a rating
+ * that a search for xmp:Rating misses.
+ */
+bool xmp_namespaces_supported(std::string_view xmp)
+{
+	constexpr std::string_view xmlns{"xmlns"};
+
+	for (size_t pos = xmp.find(xmlns); pos != std::string_view::npos; pos = xmp.find(xmlns, pos + xmlns.size()))
+		{
+		std::string_view decl = xmp.substr(pos + xmlns.size());
+
+		/* The default namespace, or xmlns in some text */
+		if (decl.empty() || decl[0] != ':') return false;
+		decl.remove_prefix(1);
+
+		const size_t eq = decl.find('=');
+		if (eq == std::string_view::npos) return false;
+
+		std::string_view prefix = decl.substr(0, eq);
+		while (!prefix.empty() && g_ascii_isspace(prefix.back())) prefix.remove_suffix(1);
+
+		decl.remove_prefix(eq + 1);
+		while (!decl.empty() && g_ascii_isspace(decl[0])) decl.remove_prefix(1);
+		if (decl.empty() || (decl[0] != '"' && decl[0] != '\'')) return false;
+
+		const size_t uri_end = decl.find(decl[0], 1);
+		if (uri_end == std::string_view::npos) return false;
+		const std::string_view uri = decl.substr(1, uri_end - 1);
+
+		for (const XmpNamespace &ns : XMP_READ_NAMESPACES)
+			{
+			if ((uri == ns.uri) != (prefix == ns.prefix)) return false;
+			}
+
+		for (const std::string_view &merged : XMP_MERGED_NAMESPACES)
+			{
+			if (uri == merged) return false;
+			}
+		}
+
+	return true;
+}
+
+/**
+ * @brief Reads rating and keywords from an XMP packet
+ *
+ * Exiv2 merges the Exif and TIFF properties of XMP with the Exif data,
+ * so packets with such properties are left to Exiv2. So are forms this
+ * simple scan does not understand, and namespaces bound to other prefixes.
+ */
+void exif_fast_parse_xmp(std::string_view xmp, ExifFastData &fast)
+{
+	if (!xmp_namespaces_supported(xmp) ||
+	    xmp.find("exif:") != std::string_view::npos ||
+	    xmp.find("tiff:") != std::string_view::npos ||
+	    xmp.find("<![CDATA[") != std::string_view::npos ||
+	    xmp.find("dc:subject=") != std::string_view::npos)
+		{
+		fast.complete = false;
+		return;
+		}
+
+	if (size_t pos = xmp.find("xmp:Rating"); pos != std::string_view::npos)
+		{
+		std::string_view value = xmp.substr(pos + strlen("xmp:Rating"));
+		size_t end = std::string_view::npos;
+
+		if (!value.empty() && value[0] == '=' && value.size() > 2 && (value[1] == '"' || value[1] == '\''))
+			{
+			end = value.find(value[1], 2);
+			value.remove_prefix(2);
+			end = (end == std::string_view::npos) ? end : end - 2;
+			}
+		else if (!value.empty() && value[0] == '>')
+			{
+			value.remove_prefix(1);
+			end = value.find('<');
+			}
+
+		if (end == std::string_view::npos)
+			{
+			fast.complete = false;
+			return;
+			}
+
+		const std::string number{value.substr(0, end)};
+		gchar *number_end;
+		fast.rating = g_ascii_strtoll(number.c_str(), &number_end, 10);
+		if (*number_end != '\0' && !g_ascii_isspace(*number_end)) fast.complete = false;
+		}
+
+	const size_t subject = xmp.find("<dc:subject");
+	if (subject == std::string_view::npos) return;
+
+	const size_t subject_end = xmp.find("</dc:subject>", subject);
+	if (subject_end == std::string_view::npos)
+		{
+		fast.complete = false;
+		return;
+		}
+
+	std::string_view items = xmp.substr(subject, subject_end - subject);
+	constexpr std::string_view item_start{"<rdf:li"};
+	constexpr std::string_view item_end{"</rdf:li>"};
+
+	for (size_t pos = items.find(item_start); pos != std::string_view::npos; pos = items.find(item_start))
+		{
+		items.remove_prefix(pos + item_start.size());
+
+		const size_t tag_end = items.find('>');
+		if (tag_end == std::string_view::npos || (items[0] != '>' && items[0] != '/' && !g_ascii_isspace(items[0])))
+			{
+			fast.complete = false;
+			return;
+			}
+
+		if (tag_end > 0 && items[tag_end - 1] == '/')
+			{
+			items.remove_prefix(tag_end + 1);
+			continue;
+			}
+
+		items.remove_prefix(tag_end + 1);
+		const size_t text_end = items.find(item_end);
+		std::string keyword;
+		if (text_end == std::string_view::npos || !xml_unescape(items.substr(0, text_end), keyword))
+			{
+			fast.complete = false;
+			return;
+			}
+
+		fast.keywords.push_back(std::move(keyword));
+		items.remove_prefix(text_end + item_end.size());
+		}
+}
+
+/**
+ * @brief Parses an IFD and the IFDs it links to
+ * @param kind 0 for the main IFD chain, TIFF_TAG_EXIF_IFD, TIFF_TAG_GPS_IFD or TIFF_TAG_SUB_IFDS
+ * @param ifd_count number of IFDs parsed, to stop at loops
+ */
+void exif_fast_parse_ifd(const guchar *data, guint size, const TiffReader &reader,
+                         guint offset, guint kind, guint ifd_index, guint &ifd_count, ExifFastData &fast)
+{
+	while (offset != 0 && offset < reader.size && ifd_count < EXIF_FAST_MAX_IFDS)
+		{
+		ifd_count++;
+
+		guint compression = 0;
+		std::optional<guint> strip_offset;
+		std::optional<guint> strip_length;
+		std::optional<guint> jpeg_offset;
+		std::optional<guint> jpeg_length;
+		std::optional<gdouble> latitude;
+		std::optional<gdouble> longitude;
+		gchar latitude_ref = 0;
+		gchar longitude_ref = 0;
+		std::vector<std::pair<guint, guint>> links; /**< kind, offset */
+
+		const auto parse_entry = [&](const guchar *tiff, guint entry, TiffByteOrder bo)
+		{
+			const TiffTag tt{tiff + entry, bo};
+
+			if (kind == TIFF_TAG_EXIF_IFD)
+				{
+				switch (tt.tag)
+					{
+					case EXIF_TAG_DATE_TIME_ORIGINAL:
+						fast.date_time_original = reader.text(entry, tt);
+						break;
+					case EXIF_TAG_DATE_TIME_DIGITIZED:
+						fast.date_time_digitized = reader.text(entry, tt);
+						break;
+					case EXIF_TAG_PIXEL_X_DIMENSION:
+						fast.width = reader.number(entry, tt).value_or(0);
+						break;
+					case EXIF_TAG_PIXEL_Y_DIMENSION:
+						fast.height = reader.number(entry, tt).value_or(0);
+						break;
+					case EXIF_TAG_LENS_MODEL:
+						fast.lens = reader.text(entry, tt);
+						break;
+					default:
+						break;
+					}
+				return 0;
+				}
+
+			if (kind == TIFF_TAG_GPS_IFD)
+				{
+				const auto coordinate = [&reader, entry, &tt]() -> std::optional<gdouble>
+					{
+					auto deg = reader.rational(entry, tt, 0);
+					auto min = reader.rational(entry, tt, 1);
+					auto sec = reader.rational(entry, tt, 2);
+					if (!deg || !min) return {};
+
+					return deg.value() + (min.value() / 60.0) + (sec.value_or(0.0) / 3600.0);
+					};
+
+				switch (tt.tag)
+					{
+					case GPS_TAG_LATITUDE_REF:
+						latitude_ref = reader.text(entry, tt)[0];
+						break;
+					case GPS_TAG_LATITUDE:
+						latitude = coordinate();
+						break;
+					case GPS_TAG_LONGITUDE_REF:
+						longitude_ref = reader.text(entry, tt)[0];
+						break;
+					case GPS_TAG_LONGITUDE:
+						longitude = coordinate();
+						break;
+					default:
+						break;
+					}
+				return 0;
+				}
+
+			switch (tt.tag)
+				{
+				case TIFF_TAG_COMPRESSION:
+					compression = reader.number(entry, tt).value_or(0);
+					break;
+				case TIFF_TAG_STRIP_OFFSETS:
+					if (tt.count == 1) strip_offset = reader.number(entry, tt);
+					break;
+				case TIFF_TAG_STRIP_BYTE_COUNTS:
+					if (tt.count == 1) strip_length = reader.number(entry, tt);
+					break;
+				case TIFF_TAG_JPEG_OFFSET:
+					jpeg_offset = reader.number(entry, tt);
+					break;
+				case TIFF_TAG_JPEG_LENGTH:
+					jpeg_length = reader.number(entry, tt);
+					break;
+				case TIFF_TAG_SUB_IFDS:
+					for (guint i = 0; i < tt.count && i < EXIF_FAST_MAX_IFDS; i++)
+						{
+						if (auto sub_ifd = reader.number(entry, tt, i)) links.emplace_back(TIFF_TAG_SUB_IFDS, sub_ifd.value());
+						}
+					break;
+				default:
+					break;
+				}
+
+			if (kind != 0 || ifd_index != 0) return 0;
+
+			/* IFD0 */
+			switch (tt.tag)
+				{
+				case TIFF_TAG_MAKE:
+					fast.make = reader.text(entry, tt);
+					break;
+				case TIFF_TAG_MODEL:
+					fast.model = reader.text(entry, tt);
+					break;
+				case TIFF_TAG_SOFTWARE:
+					fast.software = reader.text(entry, tt);
+					break;
+				case TIFF_TAG_ORIENTATION:
+					fast.orientation = reader.number(entry, tt).value_or(0);
+					break;
+				case TIFF_TAG_RATING:
+				case TIFF_TAG_RATING_PERCENT:
+					/* Exiv2 may merge it into the XMP rating */
+					fast.complete = false;
+					break;
+				case TIFF_TAG_IPTC:
+				case TIFF_TAG_PHOTOSHOP:
+					/* Exiv2 reads the IPTC keywords if the XMP has none */
+					fast.complete = false;
+					break;
+				case TIFF_TAG_XMP:
+					{
+					guint xmp_offset;
+					if ((tt.format == TIFF_FORMAT_BYTE || tt.format == TIFF_FORMAT_UNDEFINED) && reader.value_offset(entry, tt, xmp_offset))
+						{
+						exif_fast_parse_xmp({reinterpret_cast<const gchar *>(reader.tiff + xmp_offset), tt.count}, fast);
+						}
+					}
+					break;
+				case TIFF_TAG_EXIF_IFD:
+				case TIFF_TAG_GPS_IFD:
+					if (auto link = reader.number(entry, tt)) links.emplace_back(tt.tag, link.value());
+					break;
+				default:
+					break;
+				}
+
+			return 0;
+		};
+
+		guint next_offset = 0;
+		if (tiff_parse_IFD_table(reader.tiff, offset, reader.size, reader.bo, parse_entry, &next_offset) != 0) return;
+
+		if (jpeg_offset && jpeg_length)
+			{
+			exif_fast_add_preview(data, size, reader.base + jpeg_offset.value(), jpeg_length.value(), fast);
+			}
+		if ((compression == TIFF_COMPRESSION_OJPEG || compression == TIFF_COMPRESSION_JPEG) && strip_offset && strip_length)
+			{
+			exif_fast_add_preview(data, size, reader.base + strip_offset.value(), strip_length.value(), fast);
+			}
+		if (latitude && longitude && latitude_ref && longitude_ref)
+			{
+			fast.has_gps = true;
+			fast.latitude = (latitude_ref == 'S') ? -latitude.value() : latitude.value();
+			fast.longitude = (longitude_ref == 'W') ? -longitude.value() : longitude.value();
+			}
+
+		for (const auto &[link_kind, link_offset] : links)
+			{
+			exif_fast_parse_ifd(data, size, reader, link_offset, link_kind, 0, ifd_count, fast);
+			}
+
+		/* Only the main chain and SubIFD chains continue */
+		if (kind == TIFF_TAG_EXIF_IFD || kind == TIFF_TAG_GPS_IFD) return;
+
+		offset = next_offset;
+		ifd_index++;
+		}
+}
+
+void exif_fast_parse_tiff(const guchar *data, guint size, guint tiff_offset, guint tiff_size, ExifFastData &fast)
+{
+	guint offset;
+	TiffByteOrder bo;
+	if (!tiff_directory_offset(data + tiff_offset, tiff_size, offset, bo)) return;
+
+	const TiffReader reader{data + tiff_offset, tiff_size, bo, tiff_offset};
+	guint ifd_count = 0;
+
+	exif_fast_parse_ifd(data, size, reader, offset, 0, 0, ifd_count, fast);
+}
+
 } // namespace
 
 gboolean is_jpeg_container(const guchar *data, guint size)
@@ -346,4 +948,67 @@ MPOData jpeg_get_mpo_data(const guchar *data, guint size)
 	return mpo;
 }
 
+/**
+ * @brief Gets the size of a JPEG image from its frame header
+ */
+bool jpeg_get_dimensions(const guchar *data, guint size, guint &width, guint &height)
+{
+	return jpeg_find_frame(data, size, width, height) != 0;
+}
+
+/**
+ * @brief Reads the commonly used tags of a JPEG or TIFF based file in place
+ * @param data the file contents, usually mapped
+ * @param size size of data
+ * @param fast filled with the tags found
+ * @returns false if data is neither JPEG nor TIFF based
+ *
+ * The Exif data, the XMP packet and the embedded JPEG previews are found
+ * without copying or decoding anything else. This covers JPEG, TIFF and
+ * the TIFF based raw formats such as CR2, NEF, ARW and DNG. Tags are read
+ * as Exiv2 reads them for the Geeqie metadata keys only as long as
+ * ExifFastData::complete is true.
+ */
+bool exif_fast_parse(const guchar *data, guint size, ExifFastData &fast)
+{
+	fast = ExifFastData();
+
+	if (is_jpeg_container(data, size))
+		{
+		JpegSegment seg;
+
+		if (jpeg_segment_find(data, size, JPEG_MARKER_APP1, EXIF_MAGIC, seg))
+			{
+			exif_fast_parse_tiff(data, size, seg.offset + EXIF_MAGIC.size(), seg.length - EXIF_MAGIC.size(), fast);
+			}
+
+		if (jpeg_segment_find(data, size, JPEG_MARKER_APP1, XMP_MAGIC, seg))
+			{
+			exif_fast_parse_xmp({reinterpret_cast<const gchar *>(data + seg.offset + XMP_MAGIC.size()), seg.length - XMP_MAGIC.size()}, fast);
+			}
+
+		/* Exiv2 also reads the IPTC keywords of the Photoshop segment */
+		if (jpeg_segment_find(data, size, JPEG_MARKER_APP1, XMP_EXTENSION_MAGIC, seg) ||
+		    jpeg_segment_find(data, size, JPEG_MARKER_APP13, PHOTOSHOP_MAGIC, seg))
+			{
+			fast.complete = false;
+			}
+		}
+	else
+		{
+		guint offset;
+		TiffByteOrder bo;
+		if (!tiff_directory_offset(data, size, offset, bo)) return false;
+
+		exif_fast_parse_tiff(data, size, 0, size, fast);
+		}
+
+	std::sort(fast.previews.begin(), fast.previews.end(), [](const ExifFastPreview &a, const ExifFastPreview &b)
+	{
+		return static_cast<guint64>(a.width) * a.height < static_cast<guint64>(b.width) * b.height;
+	});
+
+	return true;
+}
+
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
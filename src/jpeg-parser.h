@@ -22,6 +22,8 @@
 #ifndef JPEG_PARSER_H
 #define JPEG_PARSER_H
 
+#include <optional>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -32,6 +34,7 @@
 #define JPEG_MARKER_EOI		0xD9
 #define JPEG_MARKER_APP1	0xE1
 #define JPEG_MARKER_APP2	0xE2
+#define JPEG_MARKER_APP13	0xED
 
 /* jpeg container format:
      all data markers start with 0XFF
@@ -96,6 +99,50 @@ struct MPOData {
 
 MPOData jpeg_get_mpo_data(const guchar *data, guint size);
 
+bool jpeg_get_dimensions(const guchar *data, guint size, guint &width, guint &height);
+
+
+/**
+ * @brief An embedded JPEG preview, found by exif_fast_parse()
+ */
+struct ExifFastPreview
+{
+	guint offset; /**< From the start of the file */
+	guint length;
+	guint width;
+	guint height;
+};
+
+/**
+ * @brief The commonly used tags of a file, as read by exif_fast_parse()
+ *
+ * Empty strings and zero values are tags that are not set.
+ */
+struct ExifFastData
+{
+	bool complete = true; /**< false if the file has metadata that may change these tags when read by Exiv2 */
+
+	std::string date_time_original; /**< As in the file: "YYYY:MM:DD HH:MM:SS" */
+	std::string date_time_digitized;
+	std::string make;
+	std::string model;
+	std::string software;
+	std::string lens;
+	guint orientation = 0;
+	std::optional<gint> rating;
+	guint width = 0;
+	guint height = 0;
+
+	bool has_gps = false;
+	gdouble latitude = 0.0;
+	gdouble longitude = 0.0;
+
+	std::vector<std::string> keywords;
+	std::vector<ExifFastPreview> previews; /**< Sorted by size, the smallest first */
+};
+
+bool exif_fast_parse(const guchar *data, guint size, ExifFastData &fast);
+
 #endif
 
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
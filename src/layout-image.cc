@@ -1348,7 +1348,13 @@ void layout_image_set_fd(LayoutWindow *lw, FileData *fd)
 		}
 }
 
-void layout_image_set_with_ahead(LayoutWindow *lw, FileData *fd, FileData *read_ahead_fd)
+/**
+ * @brief Displays \a fd and reads ahead the FileData of \a read_ahead_list, nearest first
+ *
+ * The Exif data of \a read_ahead_list are read ahead even when the
+ * images are not.
+ */
+void layout_image_set_with_ahead(LayoutWindow *lw, FileData *fd, GList *read_ahead_list)
 {
 	if (!layout_valid(&lw)) return;
 
@@ -1362,13 +1368,14 @@ void layout_image_set_with_ahead(LayoutWindow *lw, FileData *fd, FileData *read_
 		}
 */
 	layout_image_set_fd(lw, fd);
-	if (options->image.enable_read_ahead) image_prebuffer_set(lw->image, read_ahead_fd);
+	if (options->image.enable_read_ahead) image_prebuffer_set_list(lw->image, read_ahead_list);
+	exif_prefetch_list(read_ahead_list);
 }
 
 void layout_image_set_index(LayoutWindow *lw, gint index)
 {
 	FileData *fd;
-	FileData *read_ahead_fd;
+	g_autoptr(GList) read_ahead_list = nullptr;
 	gint old;
 
 	if (!layout_valid(&lw)) return;
@@ -1376,14 +1383,7 @@ void layout_image_set_index(LayoutWindow *lw, gint index)
 	old = layout_list_get_index(lw, layout_image_get_fd(lw));
 	fd = layout_list_get_fd(lw, index);
 
-	if (old > index)
-		{
-		read_ahead_fd = layout_list_get_fd(lw, index - 1);
-		}
-	else
-		{
-		read_ahead_fd = layout_list_get_fd(lw, index + 1);
-		}
+	read_ahead_list = layout_list_get_read_ahead(lw, index, old <= index);
 
 	if (layout_selection_count(lw) > 1)
 		{
@@ -1410,11 +1410,12 @@ void layout_image_set_index(LayoutWindow *lw, gint index)
 					newindex = x.back();
 				}
 
-			read_ahead_fd = layout_list_get_fd(lw, newindex);
+			g_list_free(read_ahead_list);
+			read_ahead_list = g_list_prepend(nullptr, layout_list_get_fd(lw, newindex));
 			}
 		}
 
-	layout_image_set_with_ahead(lw, fd, read_ahead_fd);
+	layout_image_set_with_ahead(lw, fd, read_ahead_list);
 }
 
 static void layout_image_set_collection_real(LayoutWindow *lw, CollectionData *cd, CollectInfo *info, gboolean forward)
@@ -50,7 +50,7 @@ void layout_image_activate(LayoutWindow *lw, gint i, gboolean force);
 GtkWidget *layout_image_setup_split(LayoutWindow *lw, ImageSplitMode mode);
 
 void layout_image_set_fd(LayoutWindow *lw, FileData *fd);
-void layout_image_set_with_ahead(LayoutWindow *lw, FileData *fd, FileData *read_ahead_fd);
+void layout_image_set_with_ahead(LayoutWindow *lw, FileData *fd, GList *read_ahead_list);
 
 void layout_image_set_index(LayoutWindow *lw, gint index);
 void layout_image_set_collection(LayoutWindow *lw, CollectionData *cd, CollectInfo *info);
@@ -1143,6 +1143,15 @@ FileData *layout_list_get_fd(LayoutWindow *lw, gint index)
 	return nullptr;
 }
 
+GList *layout_list_get_read_ahead(LayoutWindow *lw, gint index, gboolean forward)
+{
+	if (!layout_valid(&lw)) return nullptr;
+
+	if (lw->vf) return vf_read_ahead_list(lw->vf, index, forward);
+
+	return nullptr;
+}
+
 gint layout_list_get_index(LayoutWindow *lw, FileData *fd)
 {
 	if (!layout_valid(&lw) || !fd) return -1;
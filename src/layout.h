@@ -275,6 +275,7 @@ GList *layout_list(LayoutWindow *lw);
 guint layout_list_count(LayoutWindow *lw, gint64 *bytes = nullptr);
 FileData *layout_list_get_fd(LayoutWindow *lw, gint index);
 gint layout_list_get_index(LayoutWindow *lw, FileData *fd);
+GList *layout_list_get_read_ahead(LayoutWindow *lw, gint index, gboolean forward);
 void layout_list_sync_fd(LayoutWindow *lw, FileData *fd);
 gchar *layout_get_window_list();
 
@@ -75,10 +75,13 @@
 #include "layout.h"
 #include "logwindow.h"
 #include "main-defines.h"
+#include "metadata-index.h"
 #include "metadata.h"
 #include "options.h"
 #include "pixbuf-util.h"
 #include "third-party/whereami.h"
+#include "thumb-index.h"
+#include "thumb-pack.h"
 #include "thumb.h"
 #include "ui-bookmark.h"
 #include "ui-fileops.h"
@@ -128,7 +131,8 @@ const gchar *option_context_description_cache_maintenance = _(" \
 This is a command line program that will recursively remove orphaned thumbnails and\n \
 .sim files, and create thumbnails and similarity data for all images found under FOLDER.\n\n \
 It may also be called from cron or anacron thus enabling automatic updating of the cached\n \
-data for all your images.\n\n \
+data for all your images. Images which already have an up to date thumbnail are skipped,\n \
+and the throughput is printed when done.\n\n \
 Note that bash command line completion does not work in this mode.\n\n \
 User manual: https://www.geeqie.org/help/GuideIndex.html\n \
            : https://www.geeqie.org/help-pdf/help.pdf");
@@ -163,12 +167,14 @@ GOptionEntry command_line_options[] =
 	{ "first"                     ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("first image")                                                                 , nullptr },
 	{ "fullscreen"                , 'f', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("start / toggle in full screen mode")                                          , nullptr },
 	{ "geometry"                  ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, nullptr, _("set main window location and geometry")                                       , "<W>x<H>[+<XOFF>+<YOFF>]" },
+	{ "get-cache-stats"           ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("get hit, miss and eviction counts of the caches")                              , nullptr },
 	{ "get-collection"            ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, nullptr, _("get collection content")                                                      , "<COLLECTION>" },
 	{ "get-collection-list"       ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("get collection list")                                                         , nullptr },
 	{ "get-destination"           ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, nullptr, _("get destination path of FILE (https://www.geeqie.org/help/GuidePluginsConfig.html)"), "<FILE>" },
 	{ "get-file-info"             ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("get file info")                                                               , nullptr},
 	{ "get-filelist"              ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, nullptr, _("get list of files and class")                                                 , "[<FOLDER>]" },
 	{ "get-filelist-recurse"      ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, nullptr, _("get list of files and class recursive")                                       , "[<FOLDER>]" },
+	{ "get-loader-stats"          ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("get queue depth and latency of the image loader threads")                     , nullptr },
 	{ "get-rectangle"             ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("get rectangle coordinates")                                                   , nullptr },
 	{ "get-render-intent"         ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("get render intent")                                                           , nullptr },
 	{ "get-selection"             ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("get list of selected files")                                                  , nullptr },
@@ -203,6 +209,7 @@ GOptionEntry command_line_options[] =
 GOptionEntry command_line_options_cache_maintenance[] =
 {
 	{ "cache-maintenance", 'c', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, nullptr, _("execute cache maintenance recursively on FOLDER"), "<FOLDER>" },
+	{ "jobs"             , 'j', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT   , nullptr, _("number of thumbnails created in parallel, default: number of processors"), "<N>" },
 	{ "quit"             , 'q', G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, _("stop cache maintenance")                         , nullptr },
 	{ nullptr            ,   0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE  , nullptr, nullptr                                             , nullptr },
 };
@@ -482,6 +489,10 @@ void exit_program_final()
 	layout_editors_reload_finish();
 
 	collect_manager_flush();
+	cache_sim_pack_flush();
+	thumb_pack_flush();
+	thumb_index_flush();
+	metadata_index_flush();
 
 	/* Save the named windows */
 	if (layout_window_count() > 1)
@@ -32,6 +32,8 @@
 
 #include "md5-util.h"
 
+#include <fcntl.h>
+
 #include <cstdio>
 
 #include "ui-fileops.h"
@@ -49,12 +51,17 @@ namespace
  **/
 gboolean md5_update_from_file(GChecksum *md5, const gchar *path)
 {
-	guchar tmp_buf[1024];
+	guchar tmp_buf[64 * 1024];
 	gint nb_bytes_read;
 
 	g_autoptr(FILE) fp = fopen(path, "r");
 	if (!fp) return FALSE;
 
+#ifdef POSIX_FADV_SEQUENTIAL
+	/* The whole file is read once, let the kernel read ahead */
+	posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
 	while ((nb_bytes_read = fread(tmp_buf, sizeof (guchar), sizeof(tmp_buf), fp)) > 0)
 		{
 		g_checksum_update(md5, tmp_buf, nb_bytes_read);
@@ -0,0 +1,553 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "metadata-index.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <optional>
+
+#include <config.h>
+
+#include "cache.h"
+#include "cache-store.h"
+#include "debug.h"
+#include "exif.h"
+#include "filedata.h"
+#include "jpeg-parser.h"
+#include "metadata.h"
+#include "options.h"
+#include "ui-fileops.h"
+
+/**
+ * @file
+ *
+ * Sorting a folder by date or rating, and filtering it by rating, needs
+ * the metadata of every file, and reading it means opening and parsing
+ * each file with Exiv2. The metadata index keeps the commonly used tags of
+ * each file of a folder, so that a folder is parsed once and later visits
+ * read one file. An entry applies only while the modification time and
+ * size of the file, and of its sidecars, are unchanged. Metadata written
+ * by Geeqie drops the entry, and unwritten changes bypass the index.
+ *
+ * Entries are added whenever the metadata has to be read from the file,
+ * which for a folder that is shown is done by the idle pass of the file
+ * views. The index is rebuilt file by file as the folder is browsed.
+ * JPEG and TIFF based files without sidecars are read in place by the fast
+ * reader of jpeg-parser.cc, other files through Exiv2.
+ *
+ *-------------------------------------------------------------------
+ * Metadata index file format (GQ_CACHE_METADATA_INDEX):
+ *-------------------------------------------------------------------
+ *
+ * A table file as described by CacheTableFormat, with one
+ * MetadataIndexRecord per file. Its strings hold the file names, camera
+ * and lens names, and the keywords of a file joined by newlines. It is
+ * kept and written out as described in cache-store.cc. An index written
+ * by another version of Geeqie is ignored.
+ */
+
+namespace
+{
+
+constexpr guint METADATA_INDEX_FLUSH_DELAY = 5; /**< seconds after the last change */
+constexpr gdouble METADATA_INDEX_NO_GPS = 1000.0;
+
+enum MetadataIndexFlags : guint32 {
+	METADATA_INDEX_GPS = 1 << 0
+};
+
+struct MetadataIndexRecord
+{
+	guint32 name_offset; /**< Relative to the start of the strings, as all offsets */
+	guint32 flags; /**< #MetadataIndexFlags */
+	gint64 source_mtime;
+	gint64 source_size;
+	guint64 sidecar_stamp;
+	gint64 date;
+	gint64 date_digitized;
+	gint32 rating;
+	gint32 orientation;
+	gint32 width;
+	gint32 height;
+	guint64 latitude; /**< gdouble bits */
+	guint64 longitude; /**< gdouble bits */
+	guint32 camera_offset;
+	guint32 lens_offset;
+	guint32 keywords_offset;
+	guint32 reserved;
+};
+
+static_assert(sizeof(MetadataIndexRecord) == 96, "metadata index record must not be padded");
+
+/* The tags are read differently by other versions */
+const CacheTableFormat metadata_index_format{{'G', 'Q', 'M', 'E', 'T', 'A', 'I', '\n'}, 1, g_str_hash(VERSION), sizeof(MetadataIndexRecord), "metadata index"};
+
+struct MetadataIndexEntry
+{
+	gint64 source_mtime = 0;
+	gint64 source_size = 0;
+	guint64 sidecar_stamp = 0;
+	MetadataIndexData data;
+	gboolean removed = FALSE; /**< Dropped, but not yet flushed */
+};
+
+guint64 double_to_le(gdouble value)
+{
+	guint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	return GUINT64_TO_LE(bits);
+}
+
+gdouble double_from_le(guint64 le)
+{
+	const guint64 bits = GUINT64_FROM_LE(le);
+	gdouble value;
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+time_t exif_time_from_text(const gchar *text)
+{
+	if (!text) return 0;
+
+	std::tm time_str{};
+	strptime(text, "%Y:%m:%d %H:%M:%S", &time_str);
+
+	return mktime(&time_str);
+}
+
+/**
+ * @brief Folds the modification times and sizes of the other files of the group of fd
+ *
+ * The metadata of a file is merged from its sidecars, so a changed
+ * sidecar invalidates the entry as well.
+ */
+guint64 sidecar_stamp(const FileData *fd)
+{
+	const FileData *parent = fd->parent ? fd->parent : fd;
+	guint64 stamp = 0;
+
+	const auto add = [&stamp](const FileData *sfd)
+		{
+		stamp = (stamp * 1000003) ^ static_cast<guint64>(sfd->date);
+		stamp = (stamp * 1000003) ^ static_cast<guint64>(sfd->size);
+		};
+
+	if (parent != fd) add(parent);
+
+	for (GList *work = parent->sidecar_files; work; work = work->next)
+		{
+		auto sfd = static_cast<const FileData *>(work->data);
+		if (sfd != fd) add(sfd);
+		}
+
+	return stamp;
+}
+
+class MetadataIndex : public CacheStoreFile
+{
+public:
+	MetadataIndex(const gchar *index_path, const gchar *source_dir);
+
+	bool find(const gchar *name, MetadataIndexEntry &entry) const;
+	void write(const gchar *name, const MetadataIndexEntry &entry);
+
+protected:
+	bool changed() const override;
+	void write_out(bool prune) override;
+
+private:
+	MetadataIndexEntry entry_from_record(const MetadataIndexRecord &r) const;
+
+	CacheTable table;
+
+	std::map<std::string, MetadataIndexEntry> pending; /**< Written, but not yet flushed */
+};
+
+MetadataIndex::MetadataIndex(const gchar *index_path, const gchar *source_dir)
+	: CacheStoreFile(index_path, source_dir)
+	, table(metadata_index_format, index_path)
+{
+}
+
+MetadataIndexEntry MetadataIndex::entry_from_record(const MetadataIndexRecord &r) const
+{
+	MetadataIndexEntry entry;
+	MetadataIndexData &data = entry.data;
+
+	entry.source_mtime = GINT64_FROM_LE(r.source_mtime);
+	entry.source_size = GINT64_FROM_LE(r.source_size);
+	entry.sidecar_stamp = GUINT64_FROM_LE(r.sidecar_stamp);
+
+	data.date = GINT64_FROM_LE(r.date);
+	data.date_digitized = GINT64_FROM_LE(r.date_digitized);
+	data.rating = GINT32_FROM_LE(r.rating);
+	data.orientation = GINT32_FROM_LE(r.orientation);
+	data.width = GINT32_FROM_LE(r.width);
+	data.height = GINT32_FROM_LE(r.height);
+	data.has_gps = (GUINT32_FROM_LE(r.flags) & METADATA_INDEX_GPS) != 0;
+	data.latitude = double_from_le(r.latitude);
+	data.longitude = double_from_le(r.longitude);
+	data.camera = table.string_at(GUINT32_FROM_LE(r.camera_offset));
+	data.lens = table.string_at(GUINT32_FROM_LE(r.lens_offset));
+
+	g_auto(GStrv) keywords = g_strsplit(table.string_at(GUINT32_FROM_LE(r.keywords_offset)), "\n", -1);
+	for (gint i = 0; keywords[i]; i++)
+		{
+		if (keywords[i][0]) data.keywords.emplace_back(keywords[i]);
+		}
+
+	return entry;
+}
+
+bool MetadataIndex::find(const gchar *name, MetadataIndexEntry &entry) const
+{
+	if (const auto it = pending.find(name); it != pending.end())
+		{
+		if (it->second.removed) return false;
+
+		entry = it->second;
+		return true;
+		}
+
+	const gint i = table.find(name);
+	if (i < 0) return false;
+
+	entry = entry_from_record(table.record<MetadataIndexRecord>(i));
+
+	return true;
+}
+
+void MetadataIndex::write(const gchar *name, const MetadataIndexEntry &entry)
+{
+	pending[name] = entry;
+}
+
+bool MetadataIndex::changed() const
+{
+	return !pending.empty();
+}
+
+void MetadataIndex::write_out(bool prune)
+{
+	std::map<std::string, MetadataIndexEntry> merged;
+
+	for (guint32 i = 0; i < table.count(); i++)
+		{
+		const gchar *name = table.name(i);
+		if (pending.count(name) > 0) continue;
+		if (prune && !source_exists(name)) continue;
+
+		merged.emplace(name, entry_from_record(table.record<MetadataIndexRecord>(i)));
+		}
+
+	for (auto &[name, entry] : pending)
+		{
+		if (!entry.removed) merged.emplace(name, std::move(entry));
+		}
+	pending.clear();
+
+	CacheTableWriter writer(metadata_index_format);
+
+	for (const auto &[name, entry] : merged)
+		{
+		const MetadataIndexData &data = entry.data;
+		MetadataIndexRecord r{};
+
+		std::string keywords;
+		for (const std::string &keyword : data.keywords)
+			{
+			if (!keywords.empty()) keywords.push_back('\n');
+			keywords.append(keyword);
+			}
+
+		r.name_offset = GUINT32_TO_LE(writer.add_string(name));
+		r.flags = GUINT32_TO_LE(data.has_gps ? static_cast<guint32>(METADATA_INDEX_GPS) : 0);
+		r.source_mtime = GINT64_TO_LE(entry.source_mtime);
+		r.source_size = GINT64_TO_LE(entry.source_size);
+		r.sidecar_stamp = GUINT64_TO_LE(entry.sidecar_stamp);
+		r.date = GINT64_TO_LE(data.date);
+		r.date_digitized = GINT64_TO_LE(data.date_digitized);
+		r.rating = GINT32_TO_LE(data.rating);
+		r.orientation = GINT32_TO_LE(data.orientation);
+		r.width = GINT32_TO_LE(data.width);
+		r.height = GINT32_TO_LE(data.height);
+		r.latitude = double_to_le(data.latitude);
+		r.longitude = double_to_le(data.longitude);
+		r.camera_offset = GUINT32_TO_LE(writer.add_string(data.camera));
+		r.lens_offset = GUINT32_TO_LE(writer.add_string(data.lens));
+		r.keywords_offset = GUINT32_TO_LE(writer.add_string(keywords));
+
+		writer.add_record(&r);
+		}
+
+	writer.write(table);
+}
+
+/* Metadata is read in the main thread only, so there is no locking */
+CacheStore metadata_indexes([](const gchar *path, const gchar *source_dir) -> CacheStoreFile *
+	{
+	return new MetadataIndex(path, source_dir);
+	}, METADATA_INDEX_FLUSH_DELAY);
+
+MetadataIndex *metadata_index_open(const gchar *source, gboolean create)
+{
+	return static_cast<MetadataIndex *>(metadata_indexes.get(source, GQ_CACHE_METADATA_INDEX, create));
+}
+
+/**
+ * @brief Reads the indexed tags of fd in place from the mapped file, without Exiv2
+ * @returns FALSE if the tags may come from elsewhere: sidecars, metadata
+ * written by Geeqie, or metadata the fast reader does not interpret
+ */
+gboolean metadata_index_read_fast(FileData *fd, MetadataIndexData &data)
+{
+	if (fd->exif || fd->parent || fd->sidecar_files || fd->modified_xmp) return FALSE;
+
+	g_autofree gchar *xmp_path = cache_find_location(CacheType::XMP_METADATA, fd->path);
+	g_autofree gchar *legacy_path = cache_find_location(CacheType::METADATA, fd->path);
+	if (xmp_path || legacy_path) return FALSE;
+
+	g_autofree gchar *pathl = path_from_utf8(fd->path);
+	g_autoptr(GMappedFile) mapped = g_mapped_file_new(pathl, FALSE, nullptr);
+	if (!mapped) return FALSE;
+
+	const auto *contents = reinterpret_cast<const guchar *>(g_mapped_file_get_contents(mapped));
+	const gsize length = std::min<gsize>(g_mapped_file_get_length(mapped), G_MAXUINT);
+	ExifFastData fast;
+
+	if (!exif_fast_parse(contents, length, fast) || !fast.complete) return FALSE;
+
+	const auto text_or_null = [](std::string &text) { return text.empty() ? nullptr : text.data(); };
+
+	data = MetadataIndexData();
+	data.date = exif_time_from_text(text_or_null(fast.date_time_original));
+	data.date_digitized = exif_time_from_text(text_or_null(fast.date_time_digitized));
+	data.rating = fast.rating.value_or(0);
+	data.orientation = fast.orientation ? static_cast<gint>(fast.orientation) : static_cast<gint>(EXIF_ORIENTATION_TOP_LEFT);
+	data.width = fast.width;
+	data.height = fast.height;
+	data.has_gps = fast.has_gps;
+	data.latitude = fast.latitude;
+	data.longitude = fast.longitude;
+	data.lens = g_strstrip(fast.lens.data());
+	data.keywords = std::move(fast.keywords);
+
+	g_autofree gchar *camera = exif_format_camera(text_or_null(fast.make), text_or_null(fast.model), text_or_null(fast.software));
+	data.camera = camera;
+
+	return TRUE;
+}
+
+} // namespace
+
+/**
+ * @brief Reads the dates of the index from Exif data already read
+ *
+ * It only uses @a exif, so it can run in any thread.
+ */
+void metadata_index_read_exif_dates(ExifData *exif, MetadataIndexData &data)
+{
+	g_autofree gchar *date = exif_get_data_as_text(exif, "Exif.Photo.DateTimeOriginal");
+	g_autofree gchar *date_digitized = exif_get_data_as_text(exif, "Exif.Photo.DateTimeDigitized");
+
+	data.date = exif_time_from_text(date);
+	data.date_digitized = exif_time_from_text(date_digitized);
+}
+
+namespace
+{
+
+/**
+ * @brief Reads only the dates of fd through Exiv2
+ *
+ * The tags that may also come from the other metadata sources of Geeqie,
+ * like the keywords, are not read.
+ */
+void metadata_index_read_dates(FileData *fd, MetadataIndexData &data)
+{
+	ExifData *exif = exif_read_fd(fd);
+
+	data = MetadataIndexData();
+
+	if (!exif) return;
+
+	metadata_index_read_exif_dates(exif, data);
+
+	exif_free_fd(fd, exif);
+}
+
+/**
+ * @brief Reads the indexed tags of fd through Exiv2 and the metadata sources of Geeqie
+ */
+void metadata_index_read_file(FileData *fd, MetadataIndexData &data)
+{
+	ExifData *exif = exif_read_fd(fd);
+
+	data = MetadataIndexData();
+
+	if (exif)
+		{
+		g_autofree gchar *camera = exif_get_data_as_text(exif, "formatted.Camera");
+		g_autofree gchar *lens = exif_get_data_as_text(exif, "Exif.Photo.LensModel");
+
+		metadata_index_read_exif_dates(exif, data);
+		data.width = exif_item_get_integer(exif_get_item(exif, "Exif.Photo.PixelXDimension")).value_or(0);
+		data.height = exif_item_get_integer(exif_get_item(exif, "Exif.Photo.PixelYDimension")).value_or(0);
+		if (camera) data.camera = g_strstrip(camera);
+		if (lens) data.lens = g_strstrip(lens);
+		}
+
+	g_autofree gchar *rating = metadata_read_string(fd, RATING_KEY, METADATA_PLAIN);
+	if (rating) data.rating = atoi(rating);
+
+	data.orientation = metadata_read_int(fd, ORIENTATION_KEY, EXIF_ORIENTATION_TOP_LEFT);
+
+	const gdouble latitude = metadata_read_GPS_coord(fd, "Xmp.exif.GPSLatitude", METADATA_INDEX_NO_GPS);
+	const gdouble longitude = metadata_read_GPS_coord(fd, "Xmp.exif.GPSLongitude", METADATA_INDEX_NO_GPS);
+	if (latitude != METADATA_INDEX_NO_GPS && longitude != METADATA_INDEX_NO_GPS)
+		{
+		data.has_gps = TRUE;
+		data.latitude = latitude;
+		data.longitude = longitude;
+		}
+
+	GList *keywords = metadata_read_list(fd, KEYWORD_KEY, METADATA_PLAIN);
+	for (GList *work = keywords; work; work = work->next)
+		{
+		data.keywords.emplace_back(static_cast<const gchar *>(work->data));
+		}
+	g_list_free_full(keywords, g_free);
+
+	if (exif) exif_free_fd(fd, exif);
+}
+
+} // namespace
+
+/**
+ * @brief Get the indexed tags of a file, without reading the file
+ * @param fd the file
+ * @param data filled with the tags
+ * @returns TRUE if the index has an entry for this version of the file and its sidecars
+ *
+ * Unwritten metadata changes are not in the index, so files with such
+ * changes are never found.
+ */
+gboolean metadata_index_lookup(FileData *fd, MetadataIndexData &data)
+{
+	if (!fd || fd->modified_xmp) return FALSE;
+
+	MetadataIndex *index = metadata_index_open(fd->path, FALSE);
+	if (!index) return FALSE;
+
+	MetadataIndexEntry entry;
+	if (!index->find(fd->name, entry)) return FALSE;
+	if (entry.source_mtime != fd->date || entry.source_size != fd->size ||
+	    entry.sidecar_stamp != sidecar_stamp(fd)) return FALSE;
+
+	data = std::move(entry.data);
+
+	return TRUE;
+}
+
+/**
+ * @brief Get the indexed tags of a file
+ * @param fd the file
+ * @param data filled with the tags
+ * @param dates_only TRUE if only the dates are needed
+ *
+ * The tags are taken from the index if it is up to date, otherwise they
+ * are read from the file and stored in the index. If only the dates are
+ * needed and the file cannot be read by the fast reader, only the dates
+ * are read, and nothing is stored.
+ */
+void metadata_index_get(FileData *fd, MetadataIndexData &data, gboolean dates_only)
+{
+	if (metadata_index_lookup(fd, data)) return;
+
+	DEBUG_2("%s metadata_index_get: reading %s", get_exec_time(), fd->path);
+	if (!metadata_index_read_fast(fd, data))
+		{
+		if (dates_only)
+			{
+			metadata_index_read_dates(fd, data);
+			return;
+			}
+
+		metadata_index_read_file(fd, data);
+		}
+
+	if (fd->modified_xmp || !options->thumbnails.enable_caching) return;
+
+	MetadataIndex *index = metadata_index_open(fd->path, TRUE);
+	if (!index) return;
+
+	MetadataIndexEntry entry;
+	entry.source_mtime = fd->date;
+	entry.source_size = fd->size;
+	entry.sidecar_stamp = sidecar_stamp(fd);
+	entry.data = data;
+	index->write(fd->name, entry);
+
+	metadata_indexes.changed();
+}
+
+/**
+ * @brief Drop the entries of a file and its sidecars, as its metadata is changed
+ */
+void metadata_index_forget(FileData *fd)
+{
+	if (!fd) return;
+
+	FileData *parent = fd->parent ? fd->parent : fd;
+	GList *group = g_list_prepend(g_list_copy(parent->sidecar_files), parent);
+
+	for (GList *work = group; work; work = work->next)
+		{
+		auto gfd = static_cast<FileData *>(work->data);
+
+		MetadataIndex *index = metadata_index_open(gfd->path, FALSE);
+		if (!index) continue;
+
+		MetadataIndexEntry entry;
+		if (!index->find(gfd->name, entry)) continue;
+
+		entry.removed = TRUE;
+		index->write(gfd->name, entry);
+
+		metadata_indexes.changed();
+		}
+
+	g_list_free(group);
+}
+
+/**
+ * @brief Write all changed indexes, and close all indexes
+ */
+void metadata_index_flush()
+{
+	metadata_indexes.close();
+}
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef METADATA_INDEX_H
+#define METADATA_INDEX_H
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+class FileData;
+struct ExifData;
+
+/**
+ * @brief The commonly used metadata of a file, as stored in the metadata index
+ */
+struct MetadataIndexData
+{
+	time_t date = 0;           /**< Exif.Photo.DateTimeOriginal, 0 if not set */
+	time_t date_digitized = 0; /**< Exif.Photo.DateTimeDigitized, 0 if not set */
+	gint rating = 0;
+	gint orientation = 0;      /**< #EXIF_ORIENTATION_TOP_LEFT etc. */
+	gint width = 0;            /**< Exif.Photo.PixelXDimension, 0 if not set */
+	gint height = 0;           /**< Exif.Photo.PixelYDimension, 0 if not set */
+	gboolean has_gps = FALSE;
+	gdouble latitude = 0.0;
+	gdouble longitude = 0.0;
+	std::string camera;
+	std::string lens;
+	std::vector<std::string> keywords;
+};
+
+gboolean metadata_index_lookup(FileData *fd, MetadataIndexData &data);
+void metadata_index_get(FileData *fd, MetadataIndexData &data, gboolean dates_only = FALSE);
+void metadata_index_read_exif_dates(ExifData *exif, MetadataIndexData &data);
+void metadata_index_forget(FileData *fd);
+void metadata_index_flush();
+
+#endif /* METADATA_INDEX_H */
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
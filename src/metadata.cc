@@ -47,6 +47,7 @@
 #include "intl.h"
 #include "layout-util.h"
 #include "main-defines.h"
+#include "metadata-index.h"
 #include "misc.h"
 #include "options.h"
 #include "rcfile.h"
@@ -369,6 +370,7 @@ gboolean metadata_write_queue_remove(FileData *fd)
 	fd->modified_xmp = nullptr;
 
 	metadata_write_queue = g_list_remove(metadata_write_queue, fd);
+	metadata_index_forget(fd);
 
 	file_data_increment_version(fd);
 	file_data_send_notification(fd, NOTIFY_REREAD);
@@ -509,6 +511,7 @@ gboolean metadata_write_list(FileData *fd, const gchar *key, const GList *values
 	g_hash_table_insert(fd->modified_xmp, g_strdup(key), string_list_copy(const_cast<GList *>(values)));
 
 	metadata_cache_remove(fd, key);
+	metadata_index_forget(fd);
 
 	if (fd->exif)
 		{
@@ -72,6 +72,7 @@ ConfOptions *init_options(ConfOptions *options)
 	options->dnd_icon_size = 48;
 	options->dnd_default_action = DND_ACTION_ASK;
 	options->duplicates_similarity_threshold = 99;
+	options->duplicates_fast_checksum = 0;
 	options->rot_invariant_sim = TRUE;
 	options->sort_totals = FALSE;
 	options->rectangle_draw_aspect_ratio = RECTANGLE_DRAW_ASPECT_RATIO_NONE;
@@ -129,6 +130,8 @@ ConfOptions *init_options(ConfOptions *options)
 	options->image.alpha_color_2.green = static_cast<gdouble>(0x006666) / 65535;
 	options->image.alpha_color_2.blue = static_cast<gdouble>(0x006666) / 65535;
 	options->image.enable_read_ahead = TRUE;
+	options->image.read_ahead_next = 2;
+	options->image.read_ahead_previous = 1;
 	options->image.exif_rotate_enable = TRUE;
 	options->image.fit_window_to_image = FALSE;
 	options->image.limit_autofit_size = FALSE;
@@ -139,9 +142,11 @@ ConfOptions *init_options(ConfOptions *options)
 	options->image.scroll_reset_method = ScrollReset::NOCHANGE;
 	options->image.tile_cache_max = 10;
 	options->image.image_cache_max = 128; /* 4 x 10MPix */
+	options->image.exif_cache_max = 16;
 	options->image.use_custom_border_color = FALSE;
 	options->image.use_custom_border_color_in_fullscreen = TRUE;
 	options->image.zoom_2pass = TRUE;
+	options->image.zoom_2pass_preview = TRUE;
 	options->image.zoom_increment = 5;
 	options->image.zoom_mode = ZOOM_RESET_NONE;
 	options->image.zoom_quality = GDK_INTERP_BILINEAR;
@@ -202,6 +207,8 @@ ConfOptions *init_options(ConfOptions *options)
 	options->thumbnails.max_height = DEFAULT_THUMB_HEIGHT;
 	options->thumbnails.quality = GDK_INTERP_TILES;
 	options->thumbnails.spec_standard = TRUE;
+	options->thumbnails.pack_store = FALSE;
+	options->thumbnails.pack_export_standard = FALSE;
 	options->thumbnails.use_xvpics = TRUE;
 	options->thumbnails.use_exif = FALSE;
 	options->thumbnails.use_color_management = FALSE;
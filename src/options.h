@@ -113,6 +113,7 @@ struct ConfOptions
 	guint duplicates_similarity_threshold;
 	guint duplicates_match;
 	gboolean duplicates_thumbnails;
+	guint duplicates_fast_checksum; /**< DupeMatchType modes which compare content with a fast hash instead of MD5 */
 	DupeSelectType duplicates_select_type;
 	gboolean rot_invariant_sim;
 	gboolean sort_totals;
@@ -214,10 +215,14 @@ struct ConfOptions
 
 		gint tile_cache_max;	/**< in megabytes */
 		gint image_cache_max;   /**< in megabytes */
+		gint exif_cache_max;    /**< in megabytes */
 		gboolean enable_read_ahead;
+		gint read_ahead_next;     /**< number of images to read ahead in the direction of travel */
+		gint read_ahead_previous; /**< number of images to read ahead in the opposite direction */
 
 		ZoomMode zoom_mode;
 		gboolean zoom_2pass;
+		gboolean zoom_2pass_preview; /**< first pass from a reduced preview decoded with the image */
 		gboolean zoom_to_fit_allow_expand;
 		GdkInterpType zoom_quality;
 		gint zoom_increment;	/**< 100 is 1.0, 5 is 0.05, 200 is 2.0, etc. */
@@ -240,6 +245,8 @@ struct ConfOptions
 		gboolean cache_into_dirs;
 		gboolean use_xvpics;
 		gboolean spec_standard;
+		gboolean pack_store; /**< With spec_standard, keep thumbnails in per-folder pack files */
+		gboolean pack_export_standard; /**< With pack_store, also write freedesktop.org thumbnails */
 		GdkInterpType quality;
 		gboolean use_exif;
 		gboolean use_color_management;
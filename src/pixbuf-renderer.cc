@@ -135,6 +135,8 @@ static void pr_scroller_timer_set(PixbufRenderer *pr, gboolean start);
 
 static void pr_source_tile_free_all(PixbufRenderer *pr);
 
+static void pr_mipmap_clear(PixbufRenderer *pr);
+
 static void pr_zoom_sync(PixbufRenderer *pr, gdouble zoom,
 			 PrZoomFlags flags, gint px, gint py);
 
@@ -216,7 +218,7 @@ static void pixbuf_renderer_class_init(PixbufRendererClass *renderer_class)
 							  "Zoom quality",
 							  nullptr,
 							  GDK_INTERP_NEAREST,
-							  GDK_INTERP_BILINEAR,
+							  GDK_INTERP_HYPER,
 							  GDK_INTERP_BILINEAR,
 							  static_cast<GParamFlags>(G_PARAM_READABLE | G_PARAM_WRITABLE)));
 
@@ -466,6 +468,7 @@ static void pixbuf_renderer_finalize(GObject *object)
 	if (pr->renderer2) pr->renderer2->free(pr->renderer2);
 
 
+	pr_mipmap_clear(pr);
 	if (pr->pixbuf) g_object_unref(pr->pixbuf);
 
 	pr_scroller_timer_set(pr, FALSE);
@@ -1122,8 +1125,11 @@ void pixbuf_renderer_set_tiles(PixbufRenderer *pr, gint width, gint height,
 	g_return_if_fail(width >= 32 && height > 32);
 	g_return_if_fail(func_request != nullptr);
 
+	pr_mipmap_clear(pr);
 	if (pr->pixbuf) g_object_unref(pr->pixbuf);
 	pr->pixbuf = nullptr;
+	pr->full_width = 0;
+	pr->full_height = 0;
 
 	pr_source_tile_unset(pr);
 
@@ -1248,6 +1254,205 @@ static gdouble pr_zoom_adjust(const PixbufRenderer *pr, gdouble increment)
 }
 
 
+/*
+ *-------------------------------------------------------------------
+ * mipmaps
+ *-------------------------------------------------------------------
+ */
+
+namespace
+{
+
+/* smaller images are scaled quickly enough from the full resolution pixbuf */
+constexpr gint64 PR_MIPMAP_MIN_PIXELS = 2048 * 2048;
+
+/* smallest width or height of a mipmap level */
+constexpr gint PR_MIPMAP_MIN_SIZE = 64;
+
+inline gint pr_mipmap_size(gint size, gint level)
+{
+	return std::max(size >> level, 1);
+}
+
+/**
+ * @brief Reduce a pixbuf to half its size with a 2x2 box filter
+ *
+ * Colors are weighted by alpha, so that fully transparent pixels
+ * do not darken the edges of opaque areas.
+ */
+GdkPixbuf *pr_mipmap_halve(GdkPixbuf *src)
+{
+	const gint src_w = gdk_pixbuf_get_width(src);
+	const gint src_h = gdk_pixbuf_get_height(src);
+	const gint src_rs = gdk_pixbuf_get_rowstride(src);
+	const guchar *src_pixels = gdk_pixbuf_get_pixels(src);
+	const gboolean has_alpha = gdk_pixbuf_get_has_alpha(src);
+	const gint channels = gdk_pixbuf_get_n_channels(src);
+
+	const gint w = pr_mipmap_size(src_w, 1);
+	const gint h = pr_mipmap_size(src_h, 1);
+
+	GdkPixbuf *dest = gdk_pixbuf_new(GDK_COLORSPACE_RGB, has_alpha, 8, w, h);
+	if (!dest) return nullptr;
+
+	const gint rs = gdk_pixbuf_get_rowstride(dest);
+	guchar *pixels = gdk_pixbuf_get_pixels(dest);
+
+	for (gint y = 0; y < h; y++)
+		{
+		const guchar *s1 = src_pixels + (static_cast<gsize>(2 * y) * src_rs);
+		const guchar *s2 = src_pixels + (static_cast<gsize>(std::min((2 * y) + 1, src_h - 1)) * src_rs);
+		guchar *d = pixels + (static_cast<gsize>(y) * rs);
+
+		for (gint x = 0; x < w; x++)
+			{
+			const gint x1 = 2 * x * channels;
+			const gint x2 = std::min((2 * x) + 1, src_w - 1) * channels;
+			const guchar *p[4] = { s1 + x1, s1 + x2, s2 + x1, s2 + x2 };
+
+			if (has_alpha)
+				{
+				const guint alpha = p[0][3] + p[1][3] + p[2][3] + p[3][3];
+
+				for (gint c = 0; c < 3; c++)
+					{
+					const guint sum = (p[0][c] * p[0][3]) + (p[1][c] * p[1][3]) + (p[2][c] * p[2][3]) + (p[3][c] * p[3][3]);
+					d[c] = alpha ? (sum + (alpha / 2)) / alpha : 0;
+					}
+				d[3] = (alpha + 2) / 4;
+				}
+			else
+				{
+				for (gint c = 0; c < 3; c++)
+					{
+					d[c] = (p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4;
+					}
+				}
+
+			d += channels;
+			}
+		}
+
+	return dest;
+}
+
+void pr_mipmap_build_thread(GTask *task, gpointer, gpointer task_data, GCancellable *)
+{
+	auto *level = static_cast<GdkPixbuf *>(task_data);
+	GPtrArray *levels = g_ptr_array_new_with_free_func(g_object_unref);
+
+	while (levels->len < PR_MIPMAP_LEVELS &&
+	       gdk_pixbuf_get_width(level) / 2 >= PR_MIPMAP_MIN_SIZE &&
+	       gdk_pixbuf_get_height(level) / 2 >= PR_MIPMAP_MIN_SIZE)
+		{
+		if (g_task_return_error_if_cancelled(task))
+			{
+			g_ptr_array_unref(levels);
+			return;
+			}
+
+		level = pr_mipmap_halve(level);
+		if (!level) break;
+
+		g_ptr_array_add(levels, level);
+		}
+
+	g_task_return_pointer(task, levels, reinterpret_cast<GDestroyNotify>(g_ptr_array_unref));
+}
+
+void pr_mipmap_build_done_cb(GObject *source_object, GAsyncResult *res, gpointer)
+{
+	auto *pr = PIXBUF_RENDERER(source_object);
+	GTask *task = G_TASK(res);
+
+	/* a cancelled build is replaced by nothing or by a newer build */
+	g_autoptr(GPtrArray) levels = static_cast<GPtrArray *>(g_task_propagate_pointer(task, nullptr));
+	if (!levels || g_task_get_cancellable(task) != pr->mipmap_cancellable) return;
+
+	g_clear_object(&pr->mipmap_cancellable);
+
+	for (guint i = 0; i < levels->len; i++)
+		{
+		pr->mipmaps[i] = static_cast<GdkPixbuf *>(g_object_ref(g_ptr_array_index(levels, i)));
+		}
+
+	DEBUG_1("%s pixbuf renderer built %u mipmap levels %p", get_exec_time(), levels->len, (void *)pr);
+}
+
+void pr_mipmap_build(PixbufRenderer *pr)
+{
+	pr->mipmap_cancellable = g_cancellable_new();
+
+	g_autoptr(GTask) task = g_task_new(pr, pr->mipmap_cancellable, pr_mipmap_build_done_cb, nullptr);
+	g_task_set_task_data(task, g_object_ref(pr->pixbuf), g_object_unref);
+	g_task_set_priority(task, G_PRIORITY_LOW);
+	g_task_run_in_thread(task, pr_mipmap_build_thread);
+}
+
+} // namespace
+
+/**
+ * @brief Drop the mipmaps, they no longer match the pixbuf
+ */
+static void pr_mipmap_clear(PixbufRenderer *pr)
+{
+	if (pr->mipmap_cancellable)
+		{
+		g_cancellable_cancel(pr->mipmap_cancellable);
+		g_clear_object(&pr->mipmap_cancellable);
+		}
+
+	for (GdkPixbuf *&mipmap : pr->mipmaps)
+		{
+		g_clear_object(&mipmap);
+		}
+}
+
+/**
+ * @brief Get the pixbuf to render from at the given scale
+ * @param pr
+ * @param scale_x horizontal scale of pr->pixbuf
+ * @param scale_y vertical scale of pr->pixbuf
+ * @returns the smallest mipmap level that is not smaller than the scaled
+ * image, or pr->pixbuf
+ *
+ * The mipmaps of a large image are built in the background when first
+ * needed, pr->pixbuf is returned until they are ready. The caller must
+ * adjust the scale to the size of the returned pixbuf.
+ */
+GdkPixbuf *pixbuf_renderer_get_mipmap(PixbufRenderer *pr, gdouble scale_x, gdouble scale_y)
+{
+	if (!pr->pixbuf || pr->loading) return pr->pixbuf;
+
+	const gint width = gdk_pixbuf_get_width(pr->pixbuf);
+	const gint height = gdk_pixbuf_get_height(pr->pixbuf);
+	if (static_cast<gint64>(width) * height < PR_MIPMAP_MIN_PIXELS) return pr->pixbuf;
+
+	gint level = 0;
+	while (level < PR_MIPMAP_LEVELS &&
+	       pr_mipmap_size(width, level + 1) >= PR_MIPMAP_MIN_SIZE &&
+	       pr_mipmap_size(height, level + 1) >= PR_MIPMAP_MIN_SIZE &&
+	       pr_mipmap_size(width, level + 1) >= width * scale_x &&
+	       pr_mipmap_size(height, level + 1) >= height * scale_y)
+		{
+		level++;
+		}
+
+	if (level == 0) return pr->pixbuf;
+
+	if (!pr->mipmaps[0])
+		{
+		if (!pr->mipmap_cancellable) pr_mipmap_build(pr);
+		return pr->pixbuf;
+		}
+
+	/* a level may be missing if memory ran out while building */
+	while (level > 0 && !pr->mipmaps[level - 1]) level--;
+
+	return (level > 0) ? pr->mipmaps[level - 1] : pr->pixbuf;
+}
+
+
 /*
  *-------------------------------------------------------------------
  * signal emission
@@ -2384,8 +2589,16 @@ static void pr_pixbuf_size_sync(PixbufRenderer *pr)
 
 	if (!pr->pixbuf) return;
 
-	pr->image_width = gdk_pixbuf_get_width(pr->pixbuf);
-	pr->image_height = gdk_pixbuf_get_height(pr->pixbuf);
+	if (pr->full_width > 0)
+		{
+		pr->image_width = pr->full_width;
+		pr->image_height = pr->full_height;
+		}
+	else
+		{
+		pr->image_width = gdk_pixbuf_get_width(pr->pixbuf);
+		pr->image_height = gdk_pixbuf_get_height(pr->pixbuf);
+		}
 
 	if (pr->stereo_data == STEREO_PIXBUF_SBS)
 		{
@@ -2411,11 +2624,15 @@ static void pr_pixbuf_size_sync(PixbufRenderer *pr)
 		}
 }
 
-static void pr_set_pixbuf(PixbufRenderer *pr, GdkPixbuf *pixbuf, gdouble zoom, PrZoomFlags flags)
+static void pr_set_pixbuf(PixbufRenderer *pr, GdkPixbuf *pixbuf, gint full_width, gint full_height, gdouble zoom, PrZoomFlags flags)
 {
+	pr_mipmap_clear(pr);
+
 	if (pixbuf) g_object_ref(pixbuf);
 	if (pr->pixbuf) g_object_unref(pr->pixbuf);
 	pr->pixbuf = pixbuf;
+	pr->full_width = pixbuf ? full_width : 0;
+	pr->full_height = pixbuf ? full_height : 0;
 
 	if (!pr->pixbuf)
 		{
@@ -2453,7 +2670,7 @@ void pixbuf_renderer_set_pixbuf(PixbufRenderer *pr, GdkPixbuf *pixbuf, gdouble z
 
 	pr_source_tile_unset(pr);
 
-	pr_set_pixbuf(pr, pixbuf, zoom, PR_ZOOM_NONE);
+	pr_set_pixbuf(pr, pixbuf, 0, 0, zoom, PR_ZOOM_NONE);
 
 	pr_update_signal(pr);
 }
@@ -2469,7 +2686,29 @@ void pixbuf_renderer_set_pixbuf_lazy(PixbufRenderer *pr, GdkPixbuf *pixbuf, gdou
 
 	pr->orientation = orientation;
 	pr->stereo_data = stereo_data;
-	pr_set_pixbuf(pr, pixbuf, zoom, PR_ZOOM_LAZY);
+	pr_set_pixbuf(pr, pixbuf, 0, 0, zoom, PR_ZOOM_LAZY);
+
+	pr_update_signal(pr);
+}
+
+/**
+ * @brief Display a reduced preview in place of an image that is still loading
+ * @param full_width,full_height unrotated size of the full image
+ *
+ * The preview is scaled up to the size of the full image, so zoom and
+ * scroll positions stay valid when the full image replaces it with
+ * pixbuf_renderer_set_pixbuf().
+ */
+void pixbuf_renderer_set_pixbuf_preview(PixbufRenderer *pr, GdkPixbuf *pixbuf, gint full_width, gint full_height, gdouble zoom, gint orientation)
+{
+	g_return_if_fail(IS_PIXBUF_RENDERER(pr));
+	g_return_if_fail(full_width > 0 && full_height > 0);
+
+	pr_source_tile_unset(pr);
+
+	pr->orientation = orientation;
+	pr->stereo_data = STEREO_PIXBUF_DEFAULT;
+	pr_set_pixbuf(pr, pixbuf, full_width, full_height, zoom, PR_ZOOM_NONE);
 
 	pr_update_signal(pr);
 }
@@ -2569,6 +2808,10 @@ void pixbuf_renderer_move(PixbufRenderer *pr, PixbufRenderer *source)
 
 		pr_zoom_sync(pr, source->zoom, static_cast<PrZoomFlags>(PR_ZOOM_FORCE | PR_ZOOM_NEW), 0, 0);
 		}
+	else if (source->full_width > 0)
+		{
+		pixbuf_renderer_set_pixbuf_preview(pr, source->pixbuf, source->full_width, source->full_height, source->zoom, source->orientation);
+		}
 	else
 		{
 		pixbuf_renderer_set_pixbuf(pr, source->pixbuf, source->zoom);
@@ -2621,6 +2864,10 @@ void pixbuf_renderer_copy(PixbufRenderer *pr, PixbufRenderer *source)
 
 		pr_zoom_sync(pr, source->zoom, static_cast<PrZoomFlags>(PR_ZOOM_FORCE | PR_ZOOM_NEW), 0, 0);
 		}
+	else if (source->full_width > 0)
+		{
+		pixbuf_renderer_set_pixbuf_preview(pr, source->pixbuf, source->full_width, source->full_height, source->zoom, source->orientation);
+		}
 	else
 		{
 		pixbuf_renderer_set_pixbuf(pr, source->pixbuf, source->zoom);
@@ -2640,6 +2887,10 @@ void pixbuf_renderer_area_changed(PixbufRenderer *pr, GdkRectangle area)
 		{
 		pr_source_tile_changed(pr, area);
 		}
+	else
+		{
+		pr_mipmap_clear(pr);
+		}
 
 	pr->renderer->area_changed(pr->renderer, area);
 	if (pr->renderer2) pr->renderer2->area_changed(pr->renderer2, area);
@@ -2779,6 +3030,7 @@ std::optional<GqColor> pixbuf_renderer_get_pixel_colors(PixbufRenderer *pr, GqPo
 	g_return_val_if_fail(IS_PIXBUF_RENDERER(pr), std::nullopt);
 
 	if (!pr->pixbuf && !pr->source_tiles_enabled) return {};
+	if (pr->full_width > 0) return {};
 
 	GdkRectangle map_rect = pr_tile_region_map_orientation(pr->orientation,
 	                                                       {pixel.x, pixel.y, 1, 1}, /*single pixel */
@@ -62,6 +62,13 @@ struct PixbufRenderer;
  */
 #define PR_CACHE_SIZE_DEFAULT 8
 
+/**
+ * @def PR_MIPMAP_LEVELS
+ * maximum number of reduced copies of the pixbuf kept for zoomed out rendering,
+ * each is half the size of the previous one
+ */
+#define PR_MIPMAP_LEVELS 8
+
 /**
  * @def ROUND_UP
  * round A up to integer count of B
@@ -162,6 +169,8 @@ struct PixbufRenderer
 	gint stereo_pixbuf_offset_left; /**< offset of the left part of the stereo image in pixbuf */
 
 	GdkPixbuf *pixbuf;
+	gint full_width;	/**< unrotated size of the full image while pixbuf is a reduced preview of it, 0 otherwise */
+	gint full_height;
 
 	gint window_width;	/**< allocated size of window (drawing area) */
 	gint window_height;
@@ -229,6 +238,9 @@ struct PixbufRenderer
 	gint source_tile_width;
 	gint source_tile_height;
 
+	GdkPixbuf *mipmaps[PR_MIPMAP_LEVELS]; /**< pixbuf reduced by 2, 4, 8... built on demand, nullptr if not built */
+	GCancellable *mipmap_cancellable; /**< set while the mipmaps are being built */
+
 	using TileRequestFunc = std::function<gboolean(PixbufRenderer *, gint, gint, gint, gint, GdkPixbuf *)>;
 	TileRequestFunc func_tile_request;
 	using TileDisposeFunc = std::function<void(PixbufRenderer *, gint, gint, gint, gint, GdkPixbuf *)>;
@@ -294,6 +306,8 @@ void pixbuf_renderer_set_pixbuf(PixbufRenderer *pr, GdkPixbuf *pixbuf, gdouble z
 
 void pixbuf_renderer_set_pixbuf_lazy(PixbufRenderer *pr, GdkPixbuf *pixbuf, gdouble zoom, gint orientation, StereoPixbufData stereo_data);
 
+void pixbuf_renderer_set_pixbuf_preview(PixbufRenderer *pr, GdkPixbuf *pixbuf, gint full_width, gint full_height, gdouble zoom, gint orientation);
+
 
 GdkPixbuf *pixbuf_renderer_get_pixbuf(PixbufRenderer *pr);
 
@@ -316,6 +330,8 @@ void pixbuf_renderer_copy(PixbufRenderer *pr, PixbufRenderer *source);
 
 void pixbuf_renderer_area_changed(PixbufRenderer *pr, GdkRectangle area);
 
+GdkPixbuf *pixbuf_renderer_get_mipmap(PixbufRenderer *pr, gdouble scale_x, gdouble scale_y);
+
 /* scrolling */
 
 void pixbuf_renderer_scroll(PixbufRenderer *pr, gint x, gint y);
@@ -0,0 +1,624 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * @file
+ * Separable resampling of 8 bit RGB pixbufs.
+ *
+ * Each destination row is made in two passes: a vertical pass blends the
+ * source rows under the filter into one row, and a horizontal pass blends
+ * the pixels of that row. Weights are 14 bit fixed point, so the SIMD
+ * variants of both passes produce exactly the same output as the plain C
+ * ones. The variant is chosen at run time from what the CPU supports.
+ */
+
+#include "pixbuf-resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXBUF_RESAMPLE_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define PIXBUF_RESAMPLE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+constexpr gint WEIGHT_BITS = 14;
+constexpr gint32 WEIGHT_ONE = 1 << WEIGHT_BITS;
+constexpr gint32 WEIGHT_ROUND = 1 << (WEIGHT_BITS - 1);
+
+/* bytes after the end of the vertical pass row, read by the horizontal pass */
+constexpr gint ROW_PADDING = 16;
+
+/**
+ * @brief The source pixels blended into each destination pixel along one axis
+ */
+struct ResampleAxis
+{
+	std::vector<gint> start;	/**< first source pixel, per destination pixel */
+	std::vector<gint16> weights;	/**< #taps weights per destination pixel */
+	gint taps;
+	gint min;			/**< first source pixel used */
+	gint max;			/**< last source pixel used + 1, may include zero weight padding */
+};
+
+gdouble filter_support(PixbufResampleFilter filter)
+{
+	switch (filter)
+		{
+		case PixbufResampleFilter::BOX:
+			return 0.5;
+		case PixbufResampleFilter::BILINEAR:
+			return 1.0;
+		case PixbufResampleFilter::LANCZOS3:
+		default:
+			return 3.0;
+		}
+}
+
+gdouble sinc(gdouble x)
+{
+	if (x == 0.0) return 1.0;
+
+	x *= G_PI;
+	return sin(x) / x;
+}
+
+gdouble filter_value(PixbufResampleFilter filter, gdouble x)
+{
+	switch (filter)
+		{
+		case PixbufResampleFilter::BOX:
+			return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+		case PixbufResampleFilter::BILINEAR:
+			x = fabs(x);
+			return (x < 1.0) ? 1.0 - x : 0.0;
+		case PixbufResampleFilter::LANCZOS3:
+		default:
+			return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+		}
+}
+
+/**
+ * @brief Compute the weights of one axis
+ * @param dest_start first destination pixel, in destination pixbuf coordinates
+ * @param dest_length number of destination pixels
+ * @param offset,scale as for gdk_pixbuf_scale()
+ * @param src_length size of the source along the axis
+ * @param filter
+ * @param even_taps round the number of taps up to an even number, the added taps have zero weight
+ *
+ * Source pixels outside of the image are replaced by the edge pixels, by
+ * folding their weight into the edge. The window of each destination pixel
+ * stays inside the image.
+ */
+ResampleAxis resample_axis_new(gint dest_start, gint dest_length, gdouble offset, gdouble scale,
+                               gint src_length, PixbufResampleFilter filter, gboolean even_taps)
+{
+	ResampleAxis axis;
+
+	const gdouble filter_scale = std::max(1.0 / scale, 1.0);
+	const gdouble radius = filter_support(filter) * filter_scale;
+
+	axis.taps = std::min((static_cast<gint>(ceil(radius)) * 2) + 1, src_length);
+	const gint stored_taps = (even_taps && axis.taps % 2) ? axis.taps + 1 : axis.taps;
+
+	axis.start.resize(dest_length);
+	axis.weights.assign(static_cast<gsize>(dest_length) * stored_taps, 0);
+	axis.min = src_length;
+	axis.max = 0;
+
+	std::vector<gdouble> weights(axis.taps);
+
+	for (gint d = 0; d < dest_length; d++)
+		{
+		const gdouble center = (dest_start + d + 0.5 - offset) / scale;
+		const gint lo = static_cast<gint>(floor(center - radius));
+		const gint hi = static_cast<gint>(ceil(center + radius));
+
+		const gint start = std::min(std::clamp(lo, 0, src_length - 1), src_length - axis.taps);
+
+		std::fill(weights.begin(), weights.end(), 0.0);
+		gdouble sum = 0.0;
+
+		for (gint i = lo; i < hi; i++)
+			{
+			const gdouble w = filter_value(filter, (i + 0.5 - center) / filter_scale);
+			if (w == 0.0) continue;
+
+			const gint k = std::clamp(i, 0, src_length - 1) - start;
+			if (k < 0 || k >= axis.taps) continue;
+
+			weights[k] += w;
+			sum += w;
+			}
+
+		if (sum == 0.0)
+			{
+			/* can only happen with rounding at the edges, use the nearest pixel */
+			weights[std::clamp(static_cast<gint>(center) - start, 0, axis.taps - 1)] = 1.0;
+			sum = 1.0;
+			}
+
+		gint16 *w = axis.weights.data() + (static_cast<gsize>(d) * stored_taps);
+		gint32 total = 0;
+		gint largest = 0;
+
+		for (gint k = 0; k < axis.taps; k++)
+			{
+			w[k] = static_cast<gint16>(lround(weights[k] / sum * WEIGHT_ONE));
+			total += w[k];
+			if (abs(w[k]) > abs(w[largest])) largest = k;
+			}
+
+		/* rounding must not change the brightness */
+		w[largest] = static_cast<gint16>(w[largest] + WEIGHT_ONE - total);
+
+		axis.start[d] = start;
+		axis.min = std::min(axis.min, start);
+		axis.max = std::max(axis.max, start + stored_taps);
+		}
+
+	axis.taps = stored_taps;
+
+	return axis;
+}
+
+inline guchar clamp_pixel(gint32 value)
+{
+	return static_cast<guchar>(std::clamp(value >> WEIGHT_BITS, 0, 255));
+}
+
+/*
+ *-------------------------------------------------------------------
+ * plain C
+ *-------------------------------------------------------------------
+ */
+
+void resample_vertical_c(guchar *out, const guchar *const *rows, const gint16 *weights, gint taps, gint start, gint length)
+{
+	for (gint i = start; i < length; i++)
+		{
+		gint32 acc = WEIGHT_ROUND;
+
+		for (gint k = 0; k < taps; k++)
+			{
+			acc += weights[k] * rows[k][i];
+			}
+
+		out[i] = clamp_pixel(acc);
+		}
+}
+
+void resample_horizontal_c(guchar *out, const guchar *in, const ResampleAxis &axis, gint min, gint channels, gint length)
+{
+	for (gint d = 0; d < length; d++)
+		{
+		const guchar *p = in + (static_cast<gsize>(axis.start[d] - min) * channels);
+		const gint16 *w = axis.weights.data() + (static_cast<gsize>(d) * axis.taps);
+
+		for (gint c = 0; c < channels; c++)
+			{
+			gint32 acc = WEIGHT_ROUND;
+
+			for (gint k = 0; k < axis.taps; k++)
+				{
+				acc += w[k] * p[(k * channels) + c];
+				}
+
+			out[c] = clamp_pixel(acc);
+			}
+
+		out += channels;
+		}
+}
+
+/*
+ *-------------------------------------------------------------------
+ * x86
+ *-------------------------------------------------------------------
+ */
+
+#ifdef PIXBUF_RESAMPLE_X86
+
+/* weights of two taps, for _mm_madd_epi16() on interleaved pixels */
+inline gint32 weight_pair(const gint16 *weights, gint k, gint taps)
+{
+	const guint16 w0 = weights[k];
+	const guint16 w1 = (k + 1 < taps) ? weights[k + 1] : 0;
+
+	return static_cast<gint32>(w0 | (static_cast<guint32>(w1) << 16));
+}
+
+__attribute__((target("sse4.1")))
+void resample_vertical_sse4(guchar *out, const guchar *const *rows, const gint16 *weights, gint taps, gint start, gint length)
+{
+	gint i = start;
+
+	for (; i + 8 <= length; i += 8)
+		{
+		__m128i acc_lo = _mm_set1_epi32(WEIGHT_ROUND);
+		__m128i acc_hi = acc_lo;
+
+		for (gint k = 0; k < taps; k += 2)
+			{
+			const __m128i w = _mm_set1_epi32(weight_pair(weights, k, taps));
+			const __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(rows[k] + i)));
+			const __m128i b = (k + 1 < taps) ?
+			                  _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(rows[k + 1] + i))) :
+			                  _mm_setzero_si128();
+
+			acc_lo = _mm_add_epi32(acc_lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+			acc_hi = _mm_add_epi32(acc_hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+			}
+
+		acc_lo = _mm_srai_epi32(acc_lo, WEIGHT_BITS);
+		acc_hi = _mm_srai_epi32(acc_hi, WEIGHT_BITS);
+
+		const __m128i packed = _mm_packs_epi32(acc_lo, acc_hi);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(packed, packed));
+		}
+
+	resample_vertical_c(out, rows, weights, taps, i, length);
+}
+
+__attribute__((target("avx2")))
+void resample_vertical_avx2(guchar *out, const guchar *const *rows, const gint16 *weights, gint taps, gint length)
+{
+	gint i = 0;
+
+	for (; i + 16 <= length; i += 16)
+		{
+		__m256i acc_lo = _mm256_set1_epi32(WEIGHT_ROUND);
+		__m256i acc_hi = acc_lo;
+
+		for (gint k = 0; k < taps; k += 2)
+			{
+			const __m256i w = _mm256_set1_epi32(weight_pair(weights, k, taps));
+			const __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + i)));
+			const __m256i b = (k + 1 < taps) ?
+			                  _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k + 1] + i))) :
+			                  _mm256_setzero_si256();
+
+			/* pixels 0-3 and 8-11 in acc_lo, 4-7 and 12-15 in acc_hi */
+			acc_lo = _mm256_add_epi32(acc_lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+			acc_hi = _mm256_add_epi32(acc_hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+			}
+
+		acc_lo = _mm256_srai_epi32(acc_lo, WEIGHT_BITS);
+		acc_hi = _mm256_srai_epi32(acc_hi, WEIGHT_BITS);
+
+		/* the in-lane packing puts the pixels back in order, in the low 8 bytes of each lane */
+		const __m256i packed = _mm256_packs_epi32(acc_lo, acc_hi);
+		const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(packed, packed), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm256_castsi256_si128(bytes));
+		}
+
+	resample_vertical_sse4(out, rows, weights, taps, i, length);
+}
+
+/* pixels are loaded 4 bytes at a time, the 4th byte of RGB is ignored */
+__attribute__((target("sse4.1")))
+void resample_horizontal_sse4(guchar *out, const guchar *in, const ResampleAxis &axis, gint min, gint channels, gint length)
+{
+	for (gint d = 0; d < length; d++)
+		{
+		const guchar *p = in + (static_cast<gsize>(axis.start[d] - min) * channels);
+		const gint16 *w = axis.weights.data() + (static_cast<gsize>(d) * axis.taps);
+		__m128i acc = _mm_set1_epi32(WEIGHT_ROUND);
+
+		/* axis.taps is even, see resample_axis_new() */
+		for (gint k = 0; k < axis.taps; k += 2)
+			{
+			gint32 p0;
+			gint32 p1;
+			memcpy(&p0, p + (k * channels), sizeof(p0));
+			memcpy(&p1, p + ((k + 1) * channels), sizeof(p1));
+
+			const __m128i pair = _mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p0), _mm_cvtsi32_si128(p1)));
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(pair, _mm_set1_epi32(weight_pair(w, k, axis.taps))));
+			}
+
+		acc = _mm_srai_epi32(acc, WEIGHT_BITS);
+		acc = _mm_packs_epi32(acc, acc);
+
+		const gint32 pixel = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+		memcpy(out, &pixel, channels);
+		out += channels;
+		}
+}
+
+#endif /* PIXBUF_RESAMPLE_X86 */
+
+/*
+ *-------------------------------------------------------------------
+ * ARM
+ *-------------------------------------------------------------------
+ */
+
+#ifdef PIXBUF_RESAMPLE_NEON
+
+void resample_vertical_neon(guchar *out, const guchar *const *rows, const gint16 *weights, gint taps, gint length)
+{
+	gint i = 0;
+
+	for (; i + 8 <= length; i += 8)
+		{
+		int32x4_t acc_lo = vdupq_n_s32(WEIGHT_ROUND);
+		int32x4_t acc_hi = acc_lo;
+
+		for (gint k = 0; k < taps; k++)
+			{
+			const int16x8_t a = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(rows[k] + i)));
+
+			acc_lo = vmlal_n_s16(acc_lo, vget_low_s16(a), weights[k]);
+			acc_hi = vmlal_n_s16(acc_hi, vget_high_s16(a), weights[k]);
+			}
+
+		const int16x8_t packed = vcombine_s16(vqmovn_s32(vshrq_n_s32(acc_lo, WEIGHT_BITS)),
+		                                      vqmovn_s32(vshrq_n_s32(acc_hi, WEIGHT_BITS)));
+		vst1_u8(out + i, vqmovun_s16(packed));
+		}
+
+	resample_vertical_c(out, rows, weights, taps, i, length);
+}
+
+/* pixels are loaded 4 bytes at a time, the 4th byte of RGB is ignored */
+void resample_horizontal_neon(guchar *out, const guchar *in, const ResampleAxis &axis, gint min, gint channels, gint length)
+{
+	for (gint d = 0; d < length; d++)
+		{
+		const guchar *p = in + (static_cast<gsize>(axis.start[d] - min) * channels);
+		const gint16 *w = axis.weights.data() + (static_cast<gsize>(d) * axis.taps);
+		int32x4_t acc = vdupq_n_s32(WEIGHT_ROUND);
+
+		for (gint k = 0; k < axis.taps; k++)
+			{
+			guint32 p0;
+			memcpy(&p0, p + (k * channels), sizeof(p0));
+
+			const uint8x8_t bytes = vreinterpret_u8_u32(vdup_n_u32(p0));
+			acc = vmlal_n_s16(acc, vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(bytes))), w[k]);
+			}
+
+		const int16x4_t narrow = vqmovn_s32(vshrq_n_s32(acc, WEIGHT_BITS));
+		const uint8x8_t pixel = vqmovun_s16(vcombine_s16(narrow, narrow));
+
+		guint32 value = vget_lane_u32(vreinterpret_u32_u8(pixel), 0);
+		memcpy(out, &value, channels);
+		out += channels;
+		}
+}
+
+#endif /* PIXBUF_RESAMPLE_NEON */
+
+/*
+ *-------------------------------------------------------------------
+ * dispatch
+ *-------------------------------------------------------------------
+ */
+
+PixbufResampleSimd resample_simd_detect()
+{
+#ifdef PIXBUF_RESAMPLE_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return PixbufResampleSimd::AVX2;
+	if (__builtin_cpu_supports("sse4.1")) return PixbufResampleSimd::SSE4_1;
+#elif defined(PIXBUF_RESAMPLE_NEON)
+	return PixbufResampleSimd::NEON;
+#endif
+	return PixbufResampleSimd::NONE;
+}
+
+PixbufResampleSimd resample_simd_best()
+{
+	static const PixbufResampleSimd best = resample_simd_detect();
+
+	return best;
+}
+
+gint resample_simd = -1; /**< PixbufResampleSimd in use, -1 until detected */
+
+void resample_vertical(PixbufResampleSimd simd, guchar *out, const guchar *const *rows, const gint16 *weights, gint taps, gint length)
+{
+	switch (simd)
+		{
+#ifdef PIXBUF_RESAMPLE_X86
+		case PixbufResampleSimd::AVX2:
+			resample_vertical_avx2(out, rows, weights, taps, length);
+			return;
+		case PixbufResampleSimd::SSE4_1:
+			resample_vertical_sse4(out, rows, weights, taps, 0, length);
+			return;
+#endif
+#ifdef PIXBUF_RESAMPLE_NEON
+		case PixbufResampleSimd::NEON:
+			resample_vertical_neon(out, rows, weights, taps, length);
+			return;
+#endif
+		default:
+			resample_vertical_c(out, rows, weights, taps, 0, length);
+			return;
+		}
+}
+
+void resample_horizontal(PixbufResampleSimd simd, guchar *out, const guchar *in, const ResampleAxis &axis, gint min, gint channels, gint length)
+{
+	switch (simd)
+		{
+#ifdef PIXBUF_RESAMPLE_X86
+		/* 4 bytes per pixel fit in SSE, AVX2 would only add overhead */
+		case PixbufResampleSimd::AVX2:
+		case PixbufResampleSimd::SSE4_1:
+			resample_horizontal_sse4(out, in, axis, min, channels, length);
+			return;
+#endif
+#ifdef PIXBUF_RESAMPLE_NEON
+		case PixbufResampleSimd::NEON:
+			resample_horizontal_neon(out, in, axis, min, channels, length);
+			return;
+#endif
+		default:
+			resample_horizontal_c(out, in, axis, min, channels, length);
+			return;
+		}
+}
+
+} // namespace
+
+/**
+ * @brief Get the resampler filter to use for a zoom quality
+ * @param interp_type
+ * @param filter receives the filter
+ * @returns FALSE for GDK_INTERP_NEAREST, which is left to gdk_pixbuf_scale()
+ */
+gboolean pixbuf_resample_filter_from_interp(GdkInterpType interp_type, PixbufResampleFilter &filter)
+{
+	switch (interp_type)
+		{
+		case GDK_INTERP_TILES:
+			filter = PixbufResampleFilter::BOX;
+			return TRUE;
+		case GDK_INTERP_BILINEAR:
+			filter = PixbufResampleFilter::BILINEAR;
+			return TRUE;
+		case GDK_INTERP_HYPER:
+			filter = PixbufResampleFilter::LANCZOS3;
+			return TRUE;
+		case GDK_INTERP_NEAREST:
+		default:
+			return FALSE;
+		}
+}
+
+/**
+ * @brief Drop in replacement for gdk_pixbuf_scale()
+ *
+ * Only 8 bit RGB pixbufs without alpha are resampled here, as filtering
+ * straight alpha needs premultiplication. Anything else is passed on to
+ * gdk_pixbuf_scale() with the nearest equivalent interpolation.
+ */
+void pixbuf_resample(const GdkPixbuf *src, GdkPixbuf *dest,
+                     gint dest_x, gint dest_y, gint dest_width, gint dest_height,
+                     gdouble offset_x, gdouble offset_y, gdouble scale_x, gdouble scale_y,
+                     PixbufResampleFilter filter)
+{
+	if (dest_width < 1 || dest_height < 1) return;
+
+	if (gdk_pixbuf_get_has_alpha(src) || gdk_pixbuf_get_has_alpha(dest) ||
+	    gdk_pixbuf_get_n_channels(src) != 3 || gdk_pixbuf_get_n_channels(dest) != 3 ||
+	    gdk_pixbuf_get_bits_per_sample(src) != 8 || gdk_pixbuf_get_bits_per_sample(dest) != 8)
+		{
+		static const GdkInterpType interp[] = { GDK_INTERP_TILES, GDK_INTERP_BILINEAR, GDK_INTERP_HYPER };
+
+		gdk_pixbuf_scale(src, dest, dest_x, dest_y, dest_width, dest_height,
+		                 offset_x, offset_y, scale_x, scale_y, interp[static_cast<gint>(filter)]);
+		return;
+		}
+
+	const gint channels = 3;
+	const gint src_width = gdk_pixbuf_get_width(src);
+	const gint src_height = gdk_pixbuf_get_height(src);
+	const gint src_rowstride = gdk_pixbuf_get_rowstride(src);
+	const guchar *src_pixels = gdk_pixbuf_get_pixels(src);
+	const gint dest_rowstride = gdk_pixbuf_get_rowstride(dest);
+	guchar *dest_pixels = gdk_pixbuf_get_pixels(dest);
+
+	const PixbufResampleSimd simd = pixbuf_resample_get_simd();
+
+	const ResampleAxis horizontal = resample_axis_new(dest_x, dest_width, offset_x, scale_x, src_width, filter, TRUE);
+	const ResampleAxis vertical = resample_axis_new(dest_y, dest_height, offset_y, scale_y, src_height, filter, FALSE);
+
+	/* the zero weight padding tap may be one pixel beyond the image, it is not read from the source */
+	const gint span_max = std::min(horizontal.max, src_width);
+	const gint span_length = (span_max - horizontal.min) * channels;
+
+	std::vector<guchar> row((static_cast<gsize>(horizontal.max - horizontal.min) * channels) + ROW_PADDING, 0);
+	std::vector<const guchar *> rows(vertical.taps);
+
+	for (gint y = 0; y < dest_height; y++)
+		{
+		const gint16 *weights = vertical.weights.data() + (static_cast<gsize>(y) * vertical.taps);
+
+		for (gint k = 0; k < vertical.taps; k++)
+			{
+			rows[k] = src_pixels + (static_cast<gsize>(vertical.start[y] + k) * src_rowstride) + (static_cast<gsize>(horizontal.min) * channels);
+			}
+
+		resample_vertical(simd, row.data(), rows.data(), weights, vertical.taps, span_length);
+
+		guchar *out = dest_pixels + (static_cast<gsize>(dest_y + y) * dest_rowstride) + (static_cast<gsize>(dest_x) * channels);
+		resample_horizontal(simd, out, row.data(), horizontal, horizontal.min, channels, dest_width);
+		}
+}
+
+/**
+ * @brief Get the instruction set used by pixbuf_resample()
+ */
+PixbufResampleSimd pixbuf_resample_get_simd()
+{
+	gint simd = g_atomic_int_get(&resample_simd);
+
+	if (simd < 0)
+		{
+		simd = static_cast<gint>(resample_simd_best());
+		g_atomic_int_set(&resample_simd, simd);
+		}
+
+	return static_cast<PixbufResampleSimd>(simd);
+}
+
+/**
+ * @brief Check if the CPU supports an instruction set of the resampler
+ */
+gboolean pixbuf_resample_simd_supported(PixbufResampleSimd simd)
+{
+	const PixbufResampleSimd best = resample_simd_best();
+
+	switch (simd)
+		{
+		case PixbufResampleSimd::NONE:
+			return TRUE;
+		case PixbufResampleSimd::SSE4_1:
+			return best == PixbufResampleSimd::SSE4_1 || best == PixbufResampleSimd::AVX2;
+		default:
+			return best == simd;
+		}
+}
+
+/**
+ * @brief Select the instruction set used by pixbuf_resample(), for tests and benchmarks
+ * @returns the instruction set now in use, which falls back to plain C if \a simd is not supported
+ */
+PixbufResampleSimd pixbuf_resample_set_simd(PixbufResampleSimd simd)
+{
+	if (!pixbuf_resample_simd_supported(simd)) simd = PixbufResampleSimd::NONE;
+
+	g_atomic_int_set(&resample_simd, static_cast<gint>(simd));
+
+	return simd;
+}
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef PIXBUF_RESAMPLE_H
+#define PIXBUF_RESAMPLE_H
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib.h>
+
+enum class PixbufResampleFilter {
+	BOX,		/**< area average, sharp pixels when enlarging */
+	BILINEAR,	/**< triangle filter */
+	LANCZOS3	/**< windowed sinc with 3 lobes */
+};
+
+/**
+ * @brief Instruction sets the resampler has code paths for
+ */
+enum class PixbufResampleSimd {
+	NONE,
+	SSE4_1,
+	AVX2,
+	NEON
+};
+
+gboolean pixbuf_resample_filter_from_interp(GdkInterpType interp_type, PixbufResampleFilter &filter);
+
+void pixbuf_resample(const GdkPixbuf *src, GdkPixbuf *dest,
+                     gint dest_x, gint dest_y, gint dest_width, gint dest_height,
+                     gdouble offset_x, gdouble offset_y, gdouble scale_x, gdouble scale_y,
+                     PixbufResampleFilter filter);
+
+PixbufResampleSimd pixbuf_resample_get_simd();
+PixbufResampleSimd pixbuf_resample_set_simd(PixbufResampleSimd simd);
+gboolean pixbuf_resample_simd_supported(PixbufResampleSimd simd);
+
+#endif /* PIXBUF_RESAMPLE_H */
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -51,6 +51,7 @@
 #include "compat-deprecated.h"
 #include "compat.h"
 #include "editors.h"
+#include "exif.h"
 #include "filedata.h"
 #include "filefilter.h"
 #include "fullscreen.h"
@@ -331,6 +332,7 @@ static void config_window_apply()
 	options->show_window_ids = c_options->show_window_ids;
 	options->image.scroll_reset_method = c_options->image.scroll_reset_method;
 	options->image.zoom_2pass = c_options->image.zoom_2pass;
+	options->image.zoom_2pass_preview = c_options->image.zoom_2pass_preview;
 	options->image.fit_window_to_image = c_options->image.fit_window_to_image;
 	options->image.limit_window_size = c_options->image.limit_window_size;
 	options->image.zoom_to_fit_allow_expand = c_options->image.zoom_to_fit_allow_expand;
@@ -359,6 +361,8 @@ static void config_window_apply()
 	options->thumbnails.collection_preview = c_options->thumbnails.collection_preview;
 	options->thumbnails.use_ft_metadata = c_options->thumbnails.use_ft_metadata;
 	options->thumbnails.spec_standard = c_options->thumbnails.spec_standard;
+	options->thumbnails.pack_store = c_options->thumbnails.pack_store;
+	options->thumbnails.pack_export_standard = c_options->thumbnails.pack_export_standard;
 
 	options->file_filter = c_options->file_filter;
 
@@ -379,6 +383,7 @@ static void config_window_apply()
 
 	options->image.tile_cache_max = c_options->image.tile_cache_max;
 	options->image.image_cache_max = c_options->image.image_cache_max;
+	options->image.exif_cache_max = c_options->image.exif_cache_max;
 
 	options->image.zoom_quality = c_options->image.zoom_quality;
 
@@ -387,6 +392,8 @@ static void config_window_apply()
 	options->image.zoom_style = c_options->image.zoom_style;
 
 	options->image.enable_read_ahead = c_options->image.enable_read_ahead;
+	options->image.read_ahead_next = c_options->image.read_ahead_next;
+	options->image.read_ahead_previous = c_options->image.read_ahead_previous;
 
 	options->appimage_notifications = c_options->appimage_notifications;
 
@@ -617,6 +624,9 @@ static void quality_menu_cb(GtkWidget *combo, gpointer data)
 		case 2:
 			*option = GDK_INTERP_BILINEAR;
 			break;
+		case 3:
+			*option = GDK_INTERP_HYPER;
+			break;
 		}
 }
 
@@ -674,8 +684,10 @@ static void add_quality_menu(GtkWidget *table, gint column, gint row, const gcha
 	if (option == GDK_INTERP_NEAREST) current = 0;
 	gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), _("Tiles"));
 	if (option == GDK_INTERP_TILES) current = 1;
-	gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), _("Bilinear (best, but slowest)"));
+	gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), _("Bilinear"));
 	if (option == GDK_INTERP_BILINEAR) current = 2;
+	gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(combo), _("Best (slowest)"));
+	if (option == GDK_INTERP_HYPER) current = 3;
 
 	gtk_combo_box_set_active(GTK_COMBO_BOX(combo), current);
 
@@ -1846,6 +1858,7 @@ static void config_tab_general(GtkWidget *notebook)
 	GtkWidget *subgroup;
 	GtkWidget *button;
 	GtkWidget *ct_button;
+	GtkWidget *pack_button;
 	GtkWidget *table;
 	GtkWidget *spin;
 	gint hours;
@@ -1896,6 +1909,12 @@ static void config_tab_general(GtkWidget *notebook)
 	pref_radiobutton_new(group_frame, button, get_thumbnails_standard_cache_dir(),
 							options->thumbnails.spec_standard && !options->thumbnails.cache_into_dirs,
 							G_CALLBACK(cache_standard_cb), nullptr);
+	pack_button = pref_checkbox_new_int(group_frame, _("Keep thumbnails in one pack file per folder, in the Geeqie cache"),
+					    options->thumbnails.pack_store, &c_options->thumbnails.pack_store);
+	gtk_widget_set_tooltip_text(pack_button, _("Faster for large folders than one file per thumbnail. Thumbnails already in the standard cache are still used."));
+	button = pref_checkbox_new_int(group_frame, _("Also write standard thumbnails for other applications"),
+				       options->thumbnails.pack_export_standard, &c_options->thumbnails.pack_export_standard);
+	pref_checkbox_link_sensitivity(pack_button, button);
 
 	pref_checkbox_new_int(group, _("Use EXIF thumbnails when available (EXIF thumbnails may be outdated)"),
 			      options->thumbnails.use_exif, &c_options->thumbnails.use_exif);
@@ -1962,8 +1981,14 @@ static void config_tab_general(GtkWidget *notebook)
 
 	pref_spin_new_int(group, _("Decoded image cache size (MiB):"), nullptr,
 			  0, 99999, 1, options->image.image_cache_max, &c_options->image.image_cache_max);
+	pref_spin_new_int(group, _("Exif data cache size (MiB):"), nullptr,
+			  0, 9999, 1, options->image.exif_cache_max, &c_options->image.exif_cache_max);
 	pref_checkbox_new_int(group, _("Preload next image"),
 			      options->image.enable_read_ahead, &c_options->image.enable_read_ahead);
+	pref_spin_new_int(group, _("Images to preload ahead:"), nullptr,
+			  1, 16, 1, options->image.read_ahead_next, &c_options->image.read_ahead_next);
+	pref_spin_new_int(group, _("Images to preload behind:"), nullptr,
+			  0, 16, 1, options->image.read_ahead_previous, &c_options->image.read_ahead_previous);
 
 	pref_checkbox_new_int(group, _("Refresh on file change"),
 			      options->update_on_time_change, &c_options->update_on_time_change);
@@ -2076,6 +2101,8 @@ static void config_tab_image(GtkWidget *notebook)
 	GtkWidget *group;
 	GtkWidget *ct_button;
 	GtkWidget *enlargement_button;
+	GtkWidget *two_pass_button;
+	GtkWidget *button;
 	GtkWidget *table;
 	GtkWidget *spin;
 
@@ -2086,8 +2113,12 @@ static void config_tab_image(GtkWidget *notebook)
 	table = pref_table_new(group, 2, 1, FALSE, FALSE);
 	add_quality_menu(table, 0, 0, _("Quality:"), options->image.zoom_quality, &c_options->image.zoom_quality);
 
-	pref_checkbox_new_int(group, _("Two pass rendering (apply HQ zoom and color correction in second pass)"),
-			      options->image.zoom_2pass, &c_options->image.zoom_2pass);
+	two_pass_button = pref_checkbox_new_int(group, _("Two pass rendering (apply HQ zoom and color correction in second pass)"),
+						options->image.zoom_2pass, &c_options->image.zoom_2pass);
+	button = pref_checkbox_new_int(group, _("Start from a reduced preview of large JPEG and RAW images"),
+				       options->image.zoom_2pass_preview, &c_options->image.zoom_2pass_preview);
+	pref_checkbox_link_sensitivity(two_pass_button, button);
+	gtk_widget_set_tooltip_text(button, _("While the image is loading, show a reduced copy decoded at the size of the window, or an embedded preview image"));
 
 	c_options->image.zoom_increment = options->image.zoom_increment;
 	spin = pref_spin_new(group, _("Zoom increment:"), nullptr,
@@ -3987,6 +4018,7 @@ static void timezone_async_ready_cb(GObject *source_object, GAsyncResult *res, g
 			if (isfile(timezone_bin))
 				{
 				move_file(timezone_bin, tz->timezone_database_user);
+				exif_timezone_database_reset();
 				}
 			else
 				{
@@ -415,6 +415,7 @@ static void write_global_attributes(GString *outstr, gint indent)
 	WRITE_NL(); WRITE_UINT(*options, duplicates_match);
 	WRITE_NL(); WRITE_UINT(*options, duplicates_select_type);
 	WRITE_NL(); WRITE_BOOL(*options, duplicates_thumbnails);
+	WRITE_NL(); WRITE_UINT(*options, duplicates_fast_checksum);
 	WRITE_NL(); WRITE_BOOL(*options, rot_invariant_sim);
 	WRITE_NL(); WRITE_BOOL(*options, sort_totals);
 	WRITE_SEPARATOR();
@@ -480,6 +481,7 @@ static void write_global_attributes(GString *outstr, gint indent)
 
 	WRITE_SEPARATOR();
 	WRITE_NL(); WRITE_BOOL(*options, image.zoom_2pass);
+	WRITE_NL(); WRITE_BOOL(*options, image.zoom_2pass_preview);
 	WRITE_NL(); WRITE_BOOL(*options, image.zoom_to_fit_allow_expand);
 	WRITE_NL(); WRITE_UINT(*options, image.zoom_quality);
 	WRITE_NL(); WRITE_INT(*options, image.zoom_increment);
@@ -493,7 +495,10 @@ static void write_global_attributes(GString *outstr, gint indent)
 	WRITE_NL(); WRITE_UINT(*options, image.scroll_reset_method);
 	WRITE_NL(); WRITE_INT(*options, image.tile_cache_max);
 	WRITE_NL(); WRITE_INT(*options, image.image_cache_max);
+	WRITE_NL(); WRITE_INT(*options, image.exif_cache_max);
 	WRITE_NL(); WRITE_BOOL(*options, image.enable_read_ahead);
+	WRITE_NL(); WRITE_INT(*options, image.read_ahead_next);
+	WRITE_NL(); WRITE_INT(*options, image.read_ahead_previous);
 	WRITE_NL(); WRITE_BOOL(*options, image.exif_rotate_enable);
 	WRITE_NL(); WRITE_BOOL(*options, image.use_custom_border_color);
 	WRITE_NL(); WRITE_BOOL(*options, image.use_custom_border_color_in_fullscreen);
@@ -509,6 +514,8 @@ static void write_global_attributes(GString *outstr, gint indent)
 	WRITE_NL(); WRITE_BOOL(*options, thumbnails.cache_into_dirs);
 	WRITE_NL(); WRITE_BOOL(*options, thumbnails.use_xvpics);
 	WRITE_NL(); WRITE_BOOL(*options, thumbnails.spec_standard);
+	WRITE_NL(); WRITE_BOOL(*options, thumbnails.pack_store);
+	WRITE_NL(); WRITE_BOOL(*options, thumbnails.pack_export_standard);
 	WRITE_NL(); WRITE_UINT(*options, thumbnails.quality);
 	WRITE_NL(); WRITE_BOOL(*options, thumbnails.use_exif);
 	WRITE_NL(); WRITE_BOOL(*options, thumbnails.use_color_management);
@@ -907,6 +914,7 @@ static gboolean load_global_params(const gchar **attribute_names, const gchar **
 		if (READ_UINT_CLAMP(*options, duplicates_match, 0, DUPE_MATCH_ALL)) continue;
 		if (READ_UINT_ENUM_CLAMP(*options, duplicates_select_type, DUPE_SELECT_NONE, DUPE_SELECT_GROUP2)) continue;
 		if (READ_BOOL(*options, duplicates_thumbnails)) continue;
+		if (READ_UINT(*options, duplicates_fast_checksum)) continue;
 		if (READ_BOOL(*options, rot_invariant_sim)) continue;
 		if (READ_BOOL(*options, sort_totals)) continue;
 
@@ -964,6 +972,7 @@ static gboolean load_global_params(const gchar **attribute_names, const gchar **
 		if (READ_UINT_ENUM_CLAMP(*options, image.zoom_mode, 0, ZOOM_RESET_NONE)) continue;
 		if (READ_UINT_ENUM_CLAMP(*options, image.zoom_style, 0, ZOOM_ARITHMETIC)) continue;
 		if (READ_BOOL(*options, image.zoom_2pass)) continue;
+		if (READ_BOOL(*options, image.zoom_2pass_preview)) continue;
 		if (READ_BOOL(*options, image.zoom_to_fit_allow_expand)) continue;
 		if (READ_BOOL(*options, image.fit_window_to_image)) continue;
 		if (READ_BOOL(*options, image.limit_window_size)) continue;
@@ -974,9 +983,12 @@ static gboolean load_global_params(const gchar **attribute_names, const gchar **
 		if (READ_UINT_ENUM_CLAMP(*options, image.scroll_reset_method, 0, ScrollReset::COUNT - 1)) continue;
 		if (READ_INT(*options, image.tile_cache_max)) continue;
 		if (READ_INT(*options, image.image_cache_max)) continue;
-		if (READ_UINT_ENUM_CLAMP(*options, image.zoom_quality, GDK_INTERP_NEAREST, GDK_INTERP_BILINEAR)) continue;
+		if (READ_INT(*options, image.exif_cache_max)) continue;
+		if (READ_UINT_ENUM_CLAMP(*options, image.zoom_quality, GDK_INTERP_NEAREST, GDK_INTERP_HYPER)) continue;
 		if (READ_INT(*options, image.zoom_increment)) continue;
 		if (READ_BOOL(*options, image.enable_read_ahead)) continue;
+		if (READ_INT_CLAMP(*options, image.read_ahead_next, 1, 16)) continue;
+		if (READ_INT_CLAMP(*options, image.read_ahead_previous, 0, 16)) continue;
 		if (READ_BOOL(*options, image.exif_rotate_enable)) continue;
 		if (READ_BOOL(*options, image.use_custom_border_color)) continue;
 		if (READ_BOOL(*options, image.use_custom_border_color_in_fullscreen)) continue;
@@ -993,7 +1005,9 @@ static gboolean load_global_params(const gchar **attribute_names, const gchar **
 		if (READ_BOOL(*options, thumbnails.cache_into_dirs)) continue;
 		if (READ_BOOL(*options, thumbnails.use_xvpics)) continue;
 		if (READ_BOOL(*options, thumbnails.spec_standard)) continue;
-		if (READ_UINT_ENUM_CLAMP(*options, thumbnails.quality, GDK_INTERP_NEAREST, GDK_INTERP_BILINEAR)) continue;
+		if (READ_BOOL(*options, thumbnails.pack_store)) continue;
+		if (READ_BOOL(*options, thumbnails.pack_export_standard)) continue;
+		if (READ_UINT_ENUM_CLAMP(*options, thumbnails.quality, GDK_INTERP_NEAREST, GDK_INTERP_HYPER)) continue;
 		if (READ_BOOL(*options, thumbnails.use_exif)) continue;
 		if (READ_BOOL(*options, thumbnails.use_color_management)) continue;
 		if (READ_INT(*options, thumbnails.collection_preview)) continue;
@@ -27,6 +27,7 @@
 #include <cstring>
 #include <functional>
 #include <utility>
+#include <vector>
 
 #include <cairo.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -35,8 +36,10 @@
 #include <glib.h>
 #include <gtk/gtk.h>
 
+#include "misc.h"
 #include "options.h"
 #include "pixbuf-renderer.h"
+#include "pixbuf-resample.h"
 
 /* comment this out if not using this from within Geeqie
  * defining GQ_BUILD does these things:
@@ -106,6 +109,51 @@ struct QueueData
 	gboolean new_data;
 };
 
+struct TileRenderBatch;
+
+/**
+ * @brief Scaling of image data into a tile, prepared on the main thread
+ */
+struct TileRenderJob
+{
+	ImageTile *it;
+	gint x;			/* region of the tile to render */
+	gint y;
+	gint w;
+	gint h;
+	gboolean fast;
+	gboolean draw;		/* the tile pixbuf has new data */
+
+	const GdkPixbuf *src;	/* image data to scale, nullptr if nothing to scale */
+	GdkRectangle pb_rect;
+	gdouble offset_x;
+	gdouble offset_y;
+	gdouble scale_x;
+	gdouble scale_y;
+	GdkInterpType interp_type;
+	gboolean has_alpha;
+	gboolean ignore_alpha;
+	gint check_x;
+	gint check_y;
+	gboolean wide_image;
+	gint orientation;
+
+	gboolean anaglyph;
+	gdouble anaglyph_offset_x;
+
+	TileRenderBatch *batch;
+};
+
+/**
+ * @brief Tiles scaled in parallel, the main thread waits for all of them
+ */
+struct TileRenderBatch
+{
+	GMutex mutex;
+	GCond cond;
+	gint pending;
+};
+
 struct OverlayData
 {
 	gint id;
@@ -1215,11 +1263,24 @@ void rt_tile_get_region(gboolean has_alpha, gboolean ignore_alpha,
 			}
 		else
 			{
-			gdk_pixbuf_scale(src, dest,
-			                 pb_rect.x, pb_rect.y, pb_rect.width, pb_rect.height,
-			                 offset_x, offset_y,
-			                 scale_x, scale_y,
-			                 (wide_image && interp_type == GDK_INTERP_NEAREST) ? GDK_INTERP_TILES : interp_type);
+			PixbufResampleFilter filter;
+
+			if (pixbuf_resample_filter_from_interp(interp_type, filter))
+				{
+				pixbuf_resample(src, dest,
+				                pb_rect.x, pb_rect.y, pb_rect.width, pb_rect.height,
+				                offset_x, offset_y,
+				                scale_x, scale_y,
+				                filter);
+				}
+			else
+				{
+				gdk_pixbuf_scale(src, dest,
+				                 pb_rect.x, pb_rect.y, pb_rect.width, pb_rect.height,
+				                 offset_x, offset_y,
+				                 scale_x, scale_y,
+				                 (wide_image && interp_type == GDK_INTERP_NEAREST) ? GDK_INTERP_TILES : interp_type);
+				}
 			}
 		}
 	else
@@ -1271,17 +1332,27 @@ gint rt_get_orientation(RendererTiles *rt)
 }
 
 
-void rt_tile_render(RendererTiles *rt, ImageTile *it,
-                    gint x, gint y, gint w, gint h,
-                    gboolean new_data, gboolean fast)
+/**
+ * @brief Prepare rendering a region of a tile
+ * @param rt
+ * @param it
+ * @param x,y,w,h The sub-region of the tile to render
+ * @param new_data
+ * @param fast
+ * @param job Receives the scaling to do, if job.src is set it must be passed
+ *        to rt_tile_render_scale() and then rt_tile_render_finish()
+ * @returns FALSE if there is nothing to render
+ *
+ * Blank and source tiles are rendered completely here.
+ */
+gboolean rt_tile_render_setup(RendererTiles *rt, ImageTile *it,
+                              gint x, gint y, gint w, gint h,
+                              gboolean new_data, gboolean fast, TileRenderJob &job)
 {
 	PixbufRenderer *pr = rt->pr;
-	gboolean has_alpha;
-	gboolean draw = FALSE;
 	gint orientation = rt_get_orientation(rt);
-	gboolean wide_image = FALSE;
 
-	if (it->render_todo == TileRender::NONE && it->surface && !new_data) return;
+	if (it->render_todo == TileRender::NONE && it->surface && !new_data) return FALSE;
 
 	if (it->render_done != TileRender::ALL)
 		{
@@ -1294,7 +1365,7 @@ void rt_tile_render(RendererTiles *rt, ImageTile *it,
 	else if (it->render_todo != TileRender::AREA)
 		{
 		if (!fast) it->render_todo = TileRender::NONE;
-		return;
+		return FALSE;
 		}
 
 	if (!fast) it->render_todo = TileRender::NONE;
@@ -1302,7 +1373,16 @@ void rt_tile_render(RendererTiles *rt, ImageTile *it,
 	if (new_data) it->blank = FALSE;
 
 	rt_tile_prepare(rt, it);
-	has_alpha = (pr->pixbuf && gdk_pixbuf_get_has_alpha(pr->pixbuf));
+
+	job = {};
+	job.it = it;
+	job.x = x;
+	job.y = y;
+	job.w = w;
+	job.h = h;
+	job.fast = fast;
+	job.has_alpha = (pr->pixbuf && gdk_pixbuf_get_has_alpha(pr->pixbuf));
+	job.ignore_alpha = pr->ignore_alpha;
 
 	/** @FIXME checker colors for alpha should be configurable,
 	 * also should be drawn for blank = TRUE
@@ -1320,7 +1400,7 @@ void rt_tile_render(RendererTiles *rt, ImageTile *it,
 		}
 	else if (pr->source_tiles_enabled)
 		{
-		draw = rt_source_tile_render(rt, it, x, y, w, h, new_data, fast);
+		job.draw = rt_source_tile_render(rt, it, x, y, w, h, new_data, fast);
 		}
 	else
 		{
@@ -1329,7 +1409,7 @@ void rt_tile_render(RendererTiles *rt, ImageTile *it,
 		gdouble src_x;
 		gdouble src_y;
 
-		if (pr->image_width == 0 || pr->image_height == 0) return;
+		if (pr->image_width == 0 || pr->image_height == 0) return FALSE;
 
 		scale_x = rt->hidpi_scale * static_cast<gdouble>(pr->width) / pr->image_width;
 		scale_y = rt->hidpi_scale * static_cast<gdouble>(pr->height) / pr->image_height;
@@ -1360,44 +1440,112 @@ void rt_tile_render(RendererTiles *rt, ImageTile *it,
 				break;
 			}
 
+		/* when zoomed out, scale from the nearest mipmap level instead of the full image,
+		 * the stereo offsets are in pr->pixbuf coordinates so stereo images always use that,
+		 * a reduced preview is already small
+		 */
+		GdkPixbuf *src_pixbuf = pr->pixbuf;
+		if (pr->stereo_pixbuf_offset_right == 0 && pr->stereo_pixbuf_offset_left == 0 && pr->full_width == 0)
+			{
+			src_pixbuf = pixbuf_renderer_get_mipmap(pr, scale_x, scale_y);
+			}
+
 		/* HACK: The pixbuf scalers get kinda buggy(crash) with extremely
 		 * small sizes for anything but GDK_INTERP_NEAREST
 		 */
 		if (pr->width < PR_MIN_SCALE_SIZE || pr->height < PR_MIN_SCALE_SIZE) fast = TRUE;
-		if (pr->image_width > 32767) wide_image = TRUE;
-
-		rt_tile_get_region(has_alpha, pr->ignore_alpha,
-		                   pr->pixbuf, it->pixbuf, pb_rect,
-		                   static_cast<gdouble>(0.0) - src_x - (get_right_pixbuf_offset(rt) * scale_x),
-		                   static_cast<gdouble>(0.0) - src_y,
-		                   scale_x, scale_y,
-		                   (fast) ? GDK_INTERP_NEAREST : pr->zoom_quality,
-		                   it->x + pb_rect.x, it->y + pb_rect.y, wide_image);
+		job.fast = fast;
+
+		gboolean wide_image = FALSE;
+		if (pr->full_width > 0)
+			{
+			scale_x *= static_cast<gdouble>(pr->full_width) / gdk_pixbuf_get_width(src_pixbuf);
+			scale_y *= static_cast<gdouble>(pr->full_height) / gdk_pixbuf_get_height(src_pixbuf);
+			}
+		else if (src_pixbuf != pr->pixbuf)
+			{
+			scale_x *= static_cast<gdouble>(gdk_pixbuf_get_width(pr->pixbuf)) / gdk_pixbuf_get_width(src_pixbuf);
+			scale_y *= static_cast<gdouble>(gdk_pixbuf_get_height(pr->pixbuf)) / gdk_pixbuf_get_height(src_pixbuf);
+			if (gdk_pixbuf_get_width(src_pixbuf) > 32767) wide_image = TRUE;
+			}
+		else if (pr->image_width > 32767)
+			{
+			wide_image = TRUE;
+			}
+
+		job.src = src_pixbuf;
+		job.pb_rect = pb_rect;
+		job.offset_x = static_cast<gdouble>(0.0) - src_x - (get_right_pixbuf_offset(rt) * scale_x);
+		job.offset_y = static_cast<gdouble>(0.0) - src_y;
+		job.scale_x = scale_x;
+		job.scale_y = scale_y;
+		job.interp_type = (fast) ? GDK_INTERP_NEAREST : pr->zoom_quality;
+		job.check_x = it->x + pb_rect.x;
+		job.check_y = it->y + pb_rect.y;
+		job.wide_image = wide_image;
+		job.orientation = orientation;
+
 		if (rt->stereo_mode & PR_STEREO_ANAGLYPH &&
 		    (pr->stereo_pixbuf_offset_right > 0 || pr->stereo_pixbuf_offset_left > 0))
+			{
+			job.anaglyph = TRUE;
+			job.anaglyph_offset_x = static_cast<gdouble>(0.0) - src_x - (get_left_pixbuf_offset(rt) * scale_x);
+			}
+
+		job.draw = TRUE;
+		}
+
+	return TRUE;
+}
+
+/**
+ * @brief Scale the image data of a tile
+ *
+ * This only touches the tile pixbuf, so jobs for different tiles can run
+ * in parallel on worker threads.
+ */
+void rt_tile_render_scale(const TileRenderJob &job)
+{
+	rt_tile_get_region(job.has_alpha, job.ignore_alpha,
+	                   job.src, job.it->pixbuf, job.pb_rect,
+	                   job.offset_x, job.offset_y,
+	                   job.scale_x, job.scale_y,
+	                   job.interp_type,
+	                   job.check_x, job.check_y, job.wide_image);
+}
+
+/**
+ * @brief Complete rendering a tile on the main thread, after rt_tile_render_scale()
+ */
+void rt_tile_render_finish(RendererTiles *rt, const TileRenderJob &job)
+{
+	PixbufRenderer *pr = rt->pr;
+	ImageTile *it = job.it;
+
+	if (job.src)
+		{
+		if (job.anaglyph)
 			{
 			GdkPixbuf *right_pb = rt_get_spare_tile(rt);
-			rt_tile_get_region(has_alpha, pr->ignore_alpha,
-			                   pr->pixbuf, right_pb, pb_rect,
-			                   static_cast<gdouble>(0.0) - src_x - (get_left_pixbuf_offset(rt) * scale_x),
-			                   static_cast<gdouble>(0.0) - src_y,
-			                   scale_x, scale_y,
-			                   (fast) ? GDK_INTERP_NEAREST : pr->zoom_quality,
-			                   it->x + pb_rect.x, it->y + pb_rect.y, wide_image);
-			pr_create_anaglyph(rt->stereo_mode, it->pixbuf, right_pb, pb_rect.x, pb_rect.y, pb_rect.width, pb_rect.height);
+			rt_tile_get_region(job.has_alpha, job.ignore_alpha,
+			                   pr->pixbuf, right_pb, job.pb_rect,
+			                   job.anaglyph_offset_x, job.offset_y,
+			                   job.scale_x, job.scale_y,
+			                   job.interp_type,
+			                   job.check_x, job.check_y, job.wide_image);
+			pr_create_anaglyph(rt->stereo_mode, it->pixbuf, right_pb, job.pb_rect.x, job.pb_rect.y, job.pb_rect.width, job.pb_rect.height);
 			/* do not care about freeing spare_tile, it will be reused */
 			}
-		rt_tile_apply_orientation(rt, orientation, &it->pixbuf, pb_rect.x, pb_rect.y, pb_rect.width, pb_rect.height);
-		draw = TRUE;
+		rt_tile_apply_orientation(rt, job.orientation, &it->pixbuf, job.pb_rect.x, job.pb_rect.y, job.pb_rect.width, job.pb_rect.height);
 		}
 
-	if (draw && it->pixbuf && !it->blank)
+	if (job.draw && it->pixbuf && !it->blank)
 		{
-		if (pr->func_post_process && (!pr->post_process_slow || !fast))
-			pr->func_post_process(pr, &it->pixbuf, x, y, w, h);
+		if (pr->func_post_process && (!pr->post_process_slow || !job.fast))
+			pr->func_post_process(pr, &it->pixbuf, job.x, job.y, job.w, job.h);
 
 		cairo_t *cr = cairo_create(it->surface);
-		cairo_rectangle (cr, x, y, w, h);
+		cairo_rectangle (cr, job.x, job.y, job.w, job.h);
 
 		cairo_surface_t *surface = gdk_cairo_surface_create_from_pixbuf(it->pixbuf, rt->hidpi_scale, nullptr);
 		cairo_set_source_surface(cr, surface, 0, 0);
@@ -1408,15 +1556,27 @@ void rt_tile_render(RendererTiles *rt, ImageTile *it,
 		}
 }
 
-
-void rt_tile_expose(RendererTiles *rt, ImageTile *it,
+void rt_tile_render(RendererTiles *rt, ImageTile *it,
                     gint x, gint y, gint w, gint h,
                     gboolean new_data, gboolean fast)
+{
+	TileRenderJob job;
+
+	if (!rt_tile_render_setup(rt, it, x, y, w, h, new_data, fast, job)) return;
+
+	if (job.src) rt_tile_render_scale(job);
+	rt_tile_render_finish(rt, job);
+}
+
+/**
+ * @brief Clamp a region of a tile to the visible area
+ * @returns FALSE if nothing of it is visible
+ */
+gboolean rt_tile_clamp_to_visible(RendererTiles *rt, ImageTile *it,
+                                  gint &x, gint &y, gint &w, gint &h)
 {
 	PixbufRenderer *pr = rt->pr;
-	cairo_t *cr;
 
-	/* clamp to visible */
 	if (it->x + x < rt->x_scroll)
 		{
 		w -= rt->x_scroll - it->x - x;
@@ -1426,7 +1586,7 @@ void rt_tile_expose(RendererTiles *rt, ImageTile *it,
 		{
 		w = rt->x_scroll + pr->vis_width - it->x - x;
 		}
-	if (w < 1) return;
+	if (w < 1) return FALSE;
 	if (it->y + y < rt->y_scroll)
 		{
 		h -= rt->y_scroll - it->y - y;
@@ -1436,9 +1596,19 @@ void rt_tile_expose(RendererTiles *rt, ImageTile *it,
 		{
 		h = rt->y_scroll + pr->vis_height - it->y - y;
 		}
-	if (h < 1) return;
+	if (h < 1) return FALSE;
 
-	rt_tile_render(rt, it, x, y, w, h, new_data, fast);
+	return TRUE;
+}
+
+/**
+ * @brief Copy a rendered region of a tile to the window
+ */
+void rt_tile_expose_region(RendererTiles *rt, ImageTile *it,
+                           gint x, gint y, gint w, gint h)
+{
+	PixbufRenderer *pr = rt->pr;
+	cairo_t *cr;
 
 	cr = cairo_create(rt->surface);
 	cairo_set_source_surface(cr, it->surface, pr->x_offset + (it->x - rt->x_scroll) + rt->stereo_off_x, pr->y_offset + (it->y - rt->y_scroll) + rt->stereo_off_y);
@@ -1459,6 +1629,17 @@ void rt_tile_expose(RendererTiles *rt, ImageTile *it,
 }
 
 
+void rt_tile_expose(RendererTiles *rt, ImageTile *it,
+                    gint x, gint y, gint w, gint h,
+                    gboolean new_data, gboolean fast)
+{
+	if (!rt_tile_clamp_to_visible(rt, it, x, y, w, h)) return;
+
+	rt_tile_render(rt, it, x, y, w, h, new_data, fast);
+	rt_tile_expose_region(rt, it, x, y, w, h);
+}
+
+
 gboolean rt_tile_is_visible(RendererTiles *rt, ImageTile *it)
 {
 	PixbufRenderer *pr = rt->pr;
@@ -1548,6 +1729,175 @@ void queue_data_merge(QueueData *parent, const QueueData *qd)
 	parent->new_data |= qd->new_data;
 }
 
+/*
+ *-------------------------------------------------------------------
+ * parallel rendering
+ *-------------------------------------------------------------------
+ */
+
+/* upper limit of tiles scaled at the same time */
+constexpr gint RT_RENDER_BATCH_MAX = 16;
+
+GThreadPool *rt_render_pool = nullptr;
+
+gint rt_render_batch_size()
+{
+	static const gint batch_size = std::clamp(get_cpu_cores(), 1, RT_RENDER_BATCH_MAX);
+
+	return batch_size;
+}
+
+void rt_render_pool_func(gpointer data, gpointer)
+{
+	auto *job = static_cast<TileRenderJob *>(data);
+	TileRenderBatch *batch = job->batch;
+
+	rt_tile_render_scale(*job);
+
+	g_mutex_lock(&batch->mutex);
+	batch->pending--;
+	if (batch->pending == 0) g_cond_signal(&batch->cond);
+	g_mutex_unlock(&batch->mutex);
+}
+
+/**
+ * @brief Scale several tiles at once, returns when all are done
+ *
+ * The main thread scales the first tile itself, the others go to the
+ * render pool.
+ */
+void rt_tile_render_parallel(const std::vector<TileRenderJob *> &jobs)
+{
+	if (jobs.empty()) return;
+
+	if (!rt_render_pool)
+		{
+		rt_render_pool = g_thread_pool_new(rt_render_pool_func, nullptr,
+		                                   std::max(rt_render_batch_size() - 1, 1), FALSE, nullptr);
+		}
+
+	TileRenderBatch batch;
+	g_mutex_init(&batch.mutex);
+	g_cond_init(&batch.cond);
+	batch.pending = static_cast<gint>(jobs.size()) - 1;
+
+	for (size_t i = 1; i < jobs.size(); i++)
+		{
+		jobs[i]->batch = &batch;
+		g_thread_pool_push(rt_render_pool, jobs[i], nullptr);
+		}
+
+	rt_tile_render_scale(*jobs[0]);
+
+	g_mutex_lock(&batch.mutex);
+	while (batch.pending > 0) g_cond_wait(&batch.cond, &batch.mutex);
+	g_mutex_unlock(&batch.mutex);
+
+	g_cond_clear(&batch.cond);
+	g_mutex_clear(&batch.mutex);
+}
+
+/**
+ * @brief Draw the visible tiles at the head of a draw queue, scaling them in parallel
+ * @returns the queue entries drawn, empty if the head of the queue has to be drawn alone
+ *
+ * Tiles are only prepared and composited on the main thread, the pixel
+ * scaling runs on all cores. Tiles that are visible and queued are never
+ * freed by rt_tile_free_space(), so the batch stays valid throughout.
+ */
+std::vector<QueueData *> rt_queue_draw_batch(RendererTiles *rt, GList *queue, gboolean fast)
+{
+	struct BatchItem
+	{
+		QueueData *qd;
+		GdkRectangle rect;
+		gboolean exposed;
+		gboolean rendered;
+		TileRenderJob job;
+	};
+
+	PixbufRenderer *pr = rt->pr;
+	const gint batch_size = rt_render_batch_size();
+
+	if (pr->source_tiles_enabled || batch_size < 2) return {};
+
+	std::vector<BatchItem> items;
+	for (GList *work = queue; work && static_cast<gint>(items.size()) < batch_size; work = work->next)
+		{
+		auto *qd = static_cast<QueueData *>(work->data);
+		if (!rt_tile_is_visible(rt, qd->it)) break;
+
+		items.push_back({qd, {qd->x, qd->y, qd->w, qd->h}, FALSE, FALSE, {}});
+		}
+
+	if (items.size() < 2) return {};
+
+	std::vector<TileRenderJob *> jobs;
+	for (BatchItem &item : items)
+		{
+		GdkRectangle &rect = item.rect;
+
+		item.exposed = rt_tile_clamp_to_visible(rt, item.qd->it, rect.x, rect.y, rect.width, rect.height);
+		if (!item.exposed) continue;
+
+		item.rendered = rt_tile_render_setup(rt, item.qd->it, rect.x, rect.y, rect.width, rect.height,
+		                                     item.qd->new_data, fast, item.job);
+		if (item.rendered && item.job.src) jobs.push_back(&item.job);
+		}
+
+	rt_tile_render_parallel(jobs);
+
+	std::vector<QueueData *> done;
+	for (BatchItem &item : items)
+		{
+		if (item.rendered) rt_tile_render_finish(rt, item.job);
+		if (item.exposed) rt_tile_expose_region(rt, item.qd->it, item.rect.x, item.rect.y, item.rect.width, item.rect.height);
+
+		done.push_back(item.qd);
+		}
+
+	return done;
+}
+
+/**
+ * @brief Remove a drawn entry from its draw queue
+ * @param rt
+ * @param qd
+ * @param pass2 TRUE if \a qd is from the second pass queue
+ * @param fast TRUE if \a qd was drawn in fast mode, it is then queued for the second pass
+ */
+void rt_queue_draw_done(RendererTiles *rt, QueueData *qd, gboolean pass2, gboolean fast)
+{
+	if (!pass2)
+		{
+		qd->it->qd = nullptr;
+		rt->draw_queue = g_list_remove(rt->draw_queue, qd);
+		if (fast)
+			{
+			if (qd->it->qd2)
+				{
+				queue_data_merge(qd->it->qd2, qd);
+				g_free(qd);
+				}
+			else
+				{
+				qd->it->qd2 = qd;
+				rt->draw_queue_2pass = g_list_append(rt->draw_queue_2pass, qd);
+				}
+			}
+		else
+			{
+			g_free(qd);
+			}
+		}
+	else
+		{
+		qd->it->qd2 = nullptr;
+		rt->draw_queue_2pass = g_list_remove(rt->draw_queue_2pass, qd);
+		g_free(qd);
+		}
+}
+
 gboolean rt_queue_draw_idle_cb(gpointer data)
 {
 	auto rt = static_cast<RendererTiles *>(data);
@@ -1565,7 +1915,9 @@ gboolean rt_queue_draw_idle_cb(gpointer data)
 		return G_SOURCE_REMOVE;
 		}
 
-	if (rt->draw_queue)
+	const gboolean pass2 = (rt->draw_queue == nullptr);
+
+	if (!pass2)
 		{
 		qd = static_cast<QueueData *>(rt->draw_queue->data);
 		fast = (pr->zoom_2pass && ((pr->zoom_quality != GDK_INTERP_NEAREST && pr->scale != 1.0) || pr->post_process_slow));
@@ -1583,50 +1935,38 @@ gboolean rt_queue_draw_idle_cb(gpointer data)
 		fast = FALSE;
 		}
 
+	std::vector<QueueData *> done;
+
 	if (gtk_widget_get_realized(GTK_WIDGET(pr)))
 		{
-		if (rt_tile_is_visible(rt, qd->it))
-			{
-			rt_tile_expose(rt, qd->it, qd->x, qd->y, qd->w, qd->h, qd->new_data, fast);
-			}
-		else if (qd->new_data)
-			{
-			/* if new pixel data, and we already have a pixmap, update the tile */
-			qd->it->blank = FALSE;
-			if (qd->it->surface && qd->it->render_done == TileRender::ALL)
-				{
-				rt_tile_render(rt, qd->it, qd->x, qd->y, qd->w, qd->h, qd->new_data, fast);
-				}
-			}
+		done = rt_queue_draw_batch(rt, pass2 ? rt->draw_queue_2pass : rt->draw_queue, fast);
 		}
 
-	if (rt->draw_queue)
+	if (done.empty())
 		{
-		qd->it->qd = nullptr;
-		rt->draw_queue = g_list_remove(rt->draw_queue, qd);
-		if (fast)
+		if (gtk_widget_get_realized(GTK_WIDGET(pr)))
 			{
-			if (qd->it->qd2)
+			if (rt_tile_is_visible(rt, qd->it))
 				{
-				queue_data_merge(qd->it->qd2, qd);
-				g_free(qd);
+				rt_tile_expose(rt, qd->it, qd->x, qd->y, qd->w, qd->h, qd->new_data, fast);
 				}
-			else
+			else if (qd->new_data)
 				{
-				qd->it->qd2 = qd;
-				rt->draw_queue_2pass = g_list_append(rt->draw_queue_2pass, qd);
+				/* if new pixel data, and we already have a pixmap, update the tile */
+				qd->it->blank = FALSE;
+				if (qd->it->surface && qd->it->render_done == TileRender::ALL)
+					{
+					rt_tile_render(rt, qd->it, qd->x, qd->y, qd->w, qd->h, qd->new_data, fast);
+					}
 				}
 			}
-		else
-			{
-			g_free(qd);
-			}
+
+		done.push_back(qd);
 		}
-	else
+
+	for (QueueData *done_qd : done)
 		{
-		qd->it->qd2 = nullptr;
-		rt->draw_queue_2pass = g_list_remove(rt->draw_queue_2pass, qd);
-		g_free(qd);
+		rt_queue_draw_done(rt, done_qd, pass2, fast);
 		}
 
 	if (!rt->draw_queue && !rt->draw_queue_2pass)
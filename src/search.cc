@@ -27,6 +27,7 @@
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <deque>
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gdk/gdk.h>
@@ -40,6 +41,7 @@
 #include "compat.h"
 #include "dnd.h"
 #include "editors.h"
+#include "exif.h"
 #include "filedata.h"
 #include "history-list.h"
 #include "image-load.h"
@@ -49,6 +51,7 @@
 #include "layout.h"
 #include "main-defines.h"
 #include "menu.h"
+#include "metadata-index.h"
 #include "metadata.h"
 #include "misc.h"
 #include "options.h"
@@ -180,17 +183,20 @@ struct SearchUi
 
 using GetFileDate = std::function<time_t(FileData *)>;
 
+using MetadataDate = time_t MetadataIndexData::*;
+
 struct SearchDateType
 {
 	const gchar *name;
-	GetFileDate get_file_date;
+	GetFileDate get_file_date; /**< For a date of the metadata, the date already read, 0 if it was not */
+	MetadataDate metadata_date; /**< For a date of the metadata, read by the search workers, otherwise nullptr */
 };
 
 const SearchDateType search_date_types[] = {
-    { _("Modified"), [](FileData *fd){ return fd->date; } },
-    { _("Status Changed"), [](FileData *fd){ return fd->cdate; } },
-    { _("Original"), [](FileData *fd){ read_exif_time_data(fd); return fd->exifdate; } },
-    { _("Digitized"), [](FileData *fd){ read_exif_time_digitized_data(fd); return fd->exifdate_digitized; } },
+    { _("Modified"), [](FileData *fd){ return fd->date; }, nullptr },
+    { _("Status Changed"), [](FileData *fd){ return fd->cdate; }, nullptr },
+    { _("Original"), [](FileData *fd){ return fd->exifdate; }, &MetadataIndexData::date },
+    { _("Digitized"), [](FileData *fd){ return fd->exifdate_digitized; }, &MetadataIndexData::date_digitized },
 };
 
 struct SearchDate
@@ -236,6 +242,8 @@ bool SearchDate::is_equal(const std::tm *lt) const
 	       mday == lt->tm_mday;
 }
 
+struct SearchPipeline;
+
 struct SearchData
 {
 	SearchUi ui;
@@ -249,6 +257,7 @@ struct SearchData
 	gint64 search_size;
 	gint64 search_size_end;
 	GetFileDate get_file_date;
+	MetadataDate metadata_date;
 	SearchDate search_date;
 	SearchDate search_date_end;
 	gint   search_width;
@@ -301,7 +310,6 @@ struct SearchData
 	gboolean match_gps_enable;
 	gboolean match_class_enable;
 	gboolean match_marks_enable;
-	gboolean match_broken_enable;
 
 	GList *search_folder_list;
 	GList *search_done_list;
@@ -315,8 +323,8 @@ struct SearchData
 	guint search_idle_id; /* event source id */
 	guint update_idle_id; /* event source id */
 
-	ImageLoader *img_loader;
-	CacheData   *img_cd;
+	SearchPipeline *pipeline; /**< The files being checked, set while searching */
+	ImageLoader *img_loader; /**< Loads the image of the similarity search */
 
 	FileData *click_fd;
 
@@ -333,6 +341,60 @@ struct MatchFileData
 	gint rank;
 };
 
+enum SearchJobState {
+	SEARCH_JOB_PREPARE, /**< The worker reads the metadata, its dates and the similarity cache data */
+	SEARCH_JOB_LOAD,    /**< Waits for a free image loader */
+	SEARCH_JOB_LOADING, /**< The image is being loaded */
+	SEARCH_JOB_DONE
+};
+
+/**
+ * @brief A file which passed the checks of its FileData, and needs its metadata or image
+ */
+struct SearchJob
+{
+	SearchData *sd;
+	FileData *fd;
+	SearchJobState state;
+	gboolean tested;
+	gboolean match;
+	gboolean check_broken; /**< The file is checked for being a broken image */
+	MatchFileData mfd;
+
+	/* Read by the worker */
+	gchar *path;
+	gchar *sidecar_path;
+	gboolean want_exif;
+	gboolean want_date; /**< The date of the metadata searched for is read from the Exif data */
+	gboolean want_cd;
+	ExifData *exif;
+	guint64 exif_read_time;
+	MetadataIndexData dates;
+	CacheData *cd;
+	gint prepared; /**< Set by the worker when done. Atomic */
+
+	ImageLoader *il;
+};
+
+/**
+ * @brief The files of a search which are being checked
+ *
+ * The checks of the FileData run on the main thread. The files which pass
+ * them are queued as a #SearchJob, and workers read their metadata, with
+ * the Exif dates, and similarity cache data. The checks of the Exif date
+ * and of the metadata run on the main thread too, then the images are
+ * loaded by several loaders. Matches are added to the result list in the
+ * order of the file list.
+ */
+struct SearchPipeline
+{
+	std::deque<SearchJob *> jobs; /**< In the order of the file list */
+	GThreadPool *pool;
+	gint loaders; /**< Running image loaders */
+	gint max_loaders;
+	gboolean polling; /**< The search step is called from a timeout, waiting for the jobs */
+};
+
 struct MatchList
 {
 	const gchar *text;
@@ -404,6 +466,11 @@ constexpr gint SEARCH_BUFFER_MATCH_HIT = 5;
 constexpr gint SEARCH_BUFFER_MATCH_MISS = 1;
 constexpr gint SEARCH_BUFFER_FLUSH_SIZE = 99;
 
+constexpr gsize SEARCH_PIPELINE_MAX_JOBS = 256;
+constexpr gint SEARCH_MAX_LOADERS = 8;
+constexpr gint64 SEARCH_STEP_TIME = 20000; /**< us spent checking files per search step */
+constexpr guint SEARCH_POLL_INTERVAL = 20; /**< ms between checks for completed jobs */
+
 constexpr auto FORMAT_CLASS_BROKEN = static_cast<FileFormatClass>(FILE_FORMAT_CLASSES + 1);
 
 constexpr std::array<GtkTargetEntry, 2> result_drag_types{{
@@ -554,7 +621,7 @@ static void search_progress_update(SearchData *sd, gboolean search, gdouble thum
 		{
 		const gchar *message;
 
-		if (search && (sd->search_folder_list || sd->search_file_list))
+		if (search && (sd->search_folder_list || sd->search_file_list || sd->pipeline))
 			message = _("Searching…");
 		else if (thumbs >= 0.0)
 			message = _("Loading thumbs…");
@@ -1034,7 +1101,7 @@ static void search_result_thumb_enable(SearchData *sd, gboolean enable)
 	sd->thumb_enable = enable;
 
 	search_result_thumb_height(sd);
-	if (!sd->search_folder_list && !sd->search_file_list) search_result_thumb_step(sd);
+	if (!sd->pipeline) search_result_thumb_step(sd);
 }
 
 /*
@@ -1684,14 +1751,75 @@ static void search_buffer_flush(SearchData *sd)
 	sd->search_buffer_count = 0;
 }
 
+static void search_job_free(SearchJob *job)
+{
+	image_loader_free(job->il);
+	exif_free(job->exif);
+	cache_sim_data_free(job->cd);
+	file_data_unref(job->fd);
+	g_free(job->path);
+	g_free(job->sidecar_path);
+
+	delete job;
+}
+
+/**
+ * @brief Reads the metadata and the similarity cache data of a job, in a worker thread
+ */
+static void search_job_prepare_func(gpointer data, gpointer)
+{
+	auto job = static_cast<SearchJob *>(data);
+
+	if (job->want_exif || job->want_date)
+		{
+		const gint64 start = g_get_monotonic_time();
+		job->exif = exif_read(job->path, job->sidecar_path, nullptr);
+		job->exif_read_time = static_cast<guint64>(g_get_monotonic_time() - start);
+		}
+
+	if (job->want_date && job->exif) metadata_index_read_exif_dates(job->exif, job->dates);
+
+	if (job->want_cd) job->cd = cache_sim_data_new(job->path);
+
+	g_atomic_int_set(&job->prepared, TRUE);
+}
+
+static SearchPipeline *search_pipeline_new()
+{
+	auto pipeline = new SearchPipeline();
+
+	pipeline->pool = g_thread_pool_new(search_job_prepare_func, nullptr, std::max(1, get_cpu_cores()), FALSE, nullptr);
+	pipeline->max_loaders = std::clamp(get_cpu_cores(), 1, SEARCH_MAX_LOADERS);
+
+	return pipeline;
+}
+
+/**
+ * @brief Stops the workers and the image loaders, and drops the jobs
+ */
+static void search_pipeline_free(SearchPipeline *pipeline)
+{
+	if (!pipeline) return;
+
+	/* Queued jobs are dropped, running ones are waited for */
+	g_thread_pool_free(pipeline->pool, TRUE, TRUE);
+
+	for (SearchJob *job : pipeline->jobs)
+		{
+		search_job_free(job);
+		}
+
+	delete pipeline;
+}
+
 static void search_stop(SearchData *sd)
 {
 	g_clear_handle_id(&sd->search_idle_id, g_source_remove);
 
 	image_loader_free(sd->img_loader);
 	sd->img_loader = nullptr;
-	cache_sim_data_free(sd->img_cd);
-	sd->img_cd = nullptr;
+
+	g_clear_pointer(&sd->pipeline, search_pipeline_free);
 
 	cache_sim_data_free(sd->search_similarity_cd);
 	sd->search_similarity_cd = nullptr;
@@ -1707,8 +1835,6 @@ static void search_stop(SearchData *sd)
 	file_data_list_free(sd->search_file_list);
 	sd->search_file_list = nullptr;
 
-	sd->match_broken_enable = FALSE;
-
 	gtk_widget_set_sensitive(sd->ui.box_search, TRUE);
 	gtk_spinner_stop(GTK_SPINNER(sd->ui.spinner));
 	gtk_widget_set_sensitive(sd->ui.button_start, TRUE);
@@ -1717,11 +1843,11 @@ static void search_stop(SearchData *sd)
 	search_status_update(sd);
 }
 
-static void search_file_load_process(SearchData *sd, CacheData *cd)
+static void search_file_load_process(SearchData *sd, ImageLoader *il, CacheData *cd)
 {
 	GdkPixbuf *pixbuf;
 
-	pixbuf = image_loader_get_pixbuf(sd->img_loader);
+	pixbuf = image_loader_get_pixbuf(il);
 
 	/* Used to determine if image is broken
 	 */
@@ -1748,70 +1874,44 @@ static void search_file_load_process(SearchData *sd, CacheData *cd)
 			cd->set_similarity(sim);
 			}
 
-		if (options->thumbnails.enable_caching &&
-		    sd->img_loader && image_loader_get_fd(sd->img_loader))
+		if (options->thumbnails.enable_caching && image_loader_get_fd(il))
 			{
-			const FileData *fd = image_loader_get_fd(sd->img_loader);
+			const FileData *fd = image_loader_get_fd(il);
 
 			cd->save(fd->path);
 			}
 		}
-
-	image_loader_free(sd->img_loader);
-	sd->img_loader = nullptr;
-
-	sd->search_idle_id = g_idle_add(search_step_cb, sd);
-}
-
-static void search_file_load_done_cb(ImageLoader *, gpointer data)
-{
-	auto sd = static_cast<SearchData *>(data);
-	search_file_load_process(sd, sd->img_cd);
 }
 
-static gboolean search_file_do_extra(SearchData *sd, MatchFileData &mfd, gboolean &match)
+/**
+ * @brief Checks the dimensions and the similarity of a job, sets its result
+ *
+ * The job is done after this.
+ */
+static void search_job_match_extra(SearchData *sd, SearchJob *job)
 {
+	CacheData *cd = job->cd;
+	MatchFileData &mfd = job->mfd;
 	gboolean tmatch = TRUE;
 	gboolean tested = FALSE;
 
-	if (!sd->img_cd)
-		{
-		sd->img_cd = cache_sim_data_new(mfd.fd->path);
-
-		if ((sd->match_dimensions_enable && !sd->img_cd->dimensions) ||
-		    (sd->match_similarity_enable && !sd->img_cd->similarity) ||
-		    sd->match_broken_enable)
-			{
-			sd->img_loader = image_loader_new(mfd.fd);
-			g_signal_connect(G_OBJECT(sd->img_loader), "error", (GCallback)search_file_load_done_cb, sd);
-			g_signal_connect(G_OBJECT(sd->img_loader), "done", (GCallback)search_file_load_done_cb, sd);
-			if (image_loader_start(sd->img_loader))
-				{
-				return TRUE;
-				}
-
-			image_loader_free(sd->img_loader);
-			sd->img_loader = nullptr;
-			}
-		}
-
-	if (sd->match_broken_enable && sd->img_cd->dimensions)
+	if (job->check_broken && cd->dimensions)
 		{
 		tested = TRUE;
 		tmatch = FALSE;
-		if (sd->match_class == SEARCH_MATCH_EQUAL && sd->img_cd->dimensions->width == -1)
+		if (sd->match_class == SEARCH_MATCH_EQUAL && cd->dimensions->width == -1)
 			{
 			tmatch = TRUE;
 			}
-		else if (sd->match_class == SEARCH_MATCH_NONE && sd->img_cd->dimensions->width != -1)
+		else if (sd->match_class == SEARCH_MATCH_NONE && cd->dimensions->width != -1)
 			{
 			tmatch = TRUE;
 			}
 		}
 
-	if (tmatch && sd->match_dimensions_enable && sd->img_cd->dimensions)
+	if (tmatch && sd->match_dimensions_enable && cd->dimensions)
 		{
-		const GqSize &dimensions = sd->img_cd->dimensions.value();
+		const GqSize &dimensions = cd->dimensions.value();
 
 		tmatch = FALSE;
 		tested = TRUE;
@@ -1835,7 +1935,7 @@ static gboolean search_file_do_extra(SearchData *sd, MatchFileData &mfd, gboolea
 			}
 		}
 
-	if (tmatch && sd->match_similarity_enable && sd->img_cd->similarity)
+	if (tmatch && sd->match_similarity_enable && cd->similarity)
 		{
 		tmatch = FALSE;
 		tested = TRUE;
@@ -1845,7 +1945,7 @@ static gboolean search_file_do_extra(SearchData *sd, MatchFileData &mfd, gboolea
 			{
 			gdouble result;
 
-			result = image_sim_compare_fast(sd->search_similarity_cd->similarity.get(), sd->img_cd->similarity.get(),
+			result = image_sim_compare_fast(sd->search_similarity_cd->similarity.get(), cd->similarity.get(),
 			                                static_cast<gdouble>(sd->search_similarity) / 100.0);
 			result *= 100.0;
 			if (result >= static_cast<gdouble>(sd->search_similarity))
@@ -1856,41 +1956,96 @@ static gboolean search_file_do_extra(SearchData *sd, MatchFileData &mfd, gboolea
 			}
 		}
 
-	if (sd->img_cd->dimensions)
+	if (cd->dimensions)
 		{
-		mfd.width = sd->img_cd->dimensions->width;
-		mfd.height = sd->img_cd->dimensions->height;
+		mfd.width = cd->dimensions->width;
+		mfd.height = cd->dimensions->height;
 		}
 
-	cache_sim_data_free(sd->img_cd);
-	sd->img_cd = nullptr;
+	cache_sim_data_free(job->cd);
+	job->cd = nullptr;
 
-	match = (tmatch && tested);
+	job->tested = TRUE;
+	job->match = (tmatch && tested);
+	job->state = SEARCH_JOB_DONE;
+}
 
-	return FALSE;
+static void search_job_load_done_cb(ImageLoader *, gpointer data)
+{
+	auto job = static_cast<SearchJob *>(data);
+	SearchData *sd = job->sd;
+
+	search_file_load_process(sd, job->il, job->cd);
+
+	image_loader_free(job->il);
+	job->il = nullptr;
+	sd->pipeline->loaders--;
+
+	search_job_match_extra(sd, job);
 }
 
-static gboolean search_file_next(SearchData *sd)
+static void search_job_load(SearchData *sd, SearchJob *job)
 {
-	FileData *fd;
-	gboolean match = TRUE;
-	gboolean tested = FALSE;
-	gboolean extra_only = FALSE;
+	job->il = image_loader_new(job->fd);
+	g_signal_connect(G_OBJECT(job->il), "error", (GCallback)search_job_load_done_cb, job);
+	g_signal_connect(G_OBJECT(job->il), "done", (GCallback)search_job_load_done_cb, job);
+	if (image_loader_start(job->il))
+		{
+		job->state = SEARCH_JOB_LOADING;
+		sd->pipeline->loaders++;
+		sd->search_buffer_count += SEARCH_BUFFER_MATCH_LOAD;
+		return;
+		}
+
+	image_loader_free(job->il);
+	job->il = nullptr;
 
-	if (!sd->search_file_list) return FALSE;
+	search_job_match_extra(sd, job);
+}
 
-	if (sd->img_cd)
+static gboolean search_match_date(SearchData *sd, time_t file_date)
+{
+	constexpr time_t seconds_per_day = 60 * 60 * 24;
+
+	if (sd->match_date == SEARCH_MATCH_EQUAL)
 		{
-		/* on end of a CacheData load, skip recomparing non-extra match types */
-		extra_only = TRUE;
-		match = FALSE;
+		struct tm *lt;
+
+		lt = localtime(&file_date);
+		return (lt && sd->search_date.is_equal(lt));
 		}
-	else
+
+	if (sd->match_date == SEARCH_MATCH_UNDER)
+		{
+		return (file_date < sd->search_date.to_time());
+		}
+
+	if (sd->match_date == SEARCH_MATCH_OVER)
+		{
+		return (file_date > sd->search_date.to_time() + seconds_per_day - 1);
+		}
+
+	if (sd->match_date == SEARCH_MATCH_BETWEEN)
 		{
-		sd->search_total++;
+		time_t a = sd->search_date.to_time();
+		time_t b = sd->search_date_end.to_time();
+
+		std::tie(a, b) = std::minmax(a, b); // @TODO Use structured binding in C++17
+		return match_is_between(file_date, a, b + seconds_per_day - 1);
 		}
 
-	fd = static_cast<FileData *>(sd->search_file_list->data);
+	return FALSE;
+}
+
+/**
+ * @brief Checks the FileData of \a fd, which needs no file access
+ * @param[out] tested set if any check was done
+ * @param[out] check_broken set if the image has to be checked for being broken
+ * @returns FALSE if \a fd does not match
+ */
+static gboolean search_file_match_fd(SearchData *sd, FileData *fd, gboolean &tested, gboolean &check_broken)
+{
+	gboolean match = TRUE;
 
 	if (match && sd->match_name_enable && sd->search_name)
 		{
@@ -1958,39 +2113,73 @@ static gboolean search_file_next(SearchData *sd)
 			}
 		}
 
-	if (match && sd->match_date_enable)
+	if (match && sd->match_class_enable)
 		{
 		tested = TRUE;
 		match = FALSE;
 
-		constexpr time_t seconds_per_day = 60 * 60 * 24;
-		const time_t file_date = sd->get_file_date(fd);
-
-		if (sd->match_date == SEARCH_MATCH_EQUAL)
+		if (sd->search_class != FORMAT_CLASS_BROKEN)
 			{
-			struct tm *lt;
-
-			lt = localtime(&file_date);
-			match = (lt && sd->search_date.is_equal(lt));
+			match = (sd->match_class == SEARCH_MATCH_EQUAL && fd->format_class == sd->search_class) ||
+			        (sd->match_class == SEARCH_MATCH_NONE && fd->format_class != sd->search_class);
 			}
-		else if (sd->match_date == SEARCH_MATCH_UNDER)
+		else
 			{
-			match = (file_date < sd->search_date.to_time());
+			match = check_broken = fd->format_class == FORMAT_CLASS_IMAGE || fd->format_class == FORMAT_CLASS_RAWIMAGE ||
+			                       fd->format_class == FORMAT_CLASS_VIDEO || fd->format_class == FORMAT_CLASS_DOCUMENT;
 			}
-		else if (sd->match_date == SEARCH_MATCH_OVER)
+		}
+
+	if (match && sd->match_marks_enable)
+		{
+		tested = TRUE;
+		match = FALSE;
+
+		if (sd->match_marks == SEARCH_MATCH_EQUAL)
 			{
-			match = (file_date > sd->search_date.to_time() + seconds_per_day - 1);
+			match = (fd->marks & sd->search_marks);
 			}
-		else if (sd->match_date == SEARCH_MATCH_BETWEEN)
+		else
 			{
-			time_t a = sd->search_date.to_time();
-			time_t b = sd->search_date_end.to_time();
-
-			std::tie(a, b) = std::minmax(a, b); // @TODO Use structured binding in C++17
-			match = match_is_between(file_date, a, b + seconds_per_day - 1);
+			if (sd->search_marks == -1)
+				{
+				match = fd->marks ? FALSE : TRUE;
+				}
+			else
+				{
+				match = (fd->marks & sd->search_marks) ? FALSE : TRUE;
+				}
 			}
 		}
 
+	/* A date of the metadata is checked with the metadata */
+	if (match && sd->match_date_enable && !sd->metadata_date)
+		{
+		tested = TRUE;
+		match = search_match_date(sd, sd->get_file_date(fd));
+		}
+
+	return match;
+}
+
+static gboolean search_match_metadata_enabled(SearchData *sd)
+{
+	return (sd->match_keywords_enable && sd->search_keyword_list) ||
+	       (sd->match_comment_enable && sd->search_comment && sd->search_comment[0] != '\0') ||
+	       (sd->match_exif_enable && sd->search_exif_tag && sd->search_exif_tag[0] != '\0') ||
+	       sd->match_rating_enable ||
+	       sd->match_gps_enable;
+}
+
+/**
+ * @brief Checks the metadata of \a fd
+ * @param[out] tested set if any check was done
+ * @returns FALSE if \a fd does not match
+ */
+static gboolean search_file_match_metadata(SearchData *sd, FileData *fd, gboolean &tested)
+{
+	gboolean match = TRUE;
+
 	if (match && sd->match_keywords_enable && sd->search_keyword_list)
 		{
 		GList *list;
@@ -2136,45 +2325,6 @@ static gboolean search_file_next(SearchData *sd)
 			}
 		}
 
-	if (match && sd->match_class_enable)
-		{
-		tested = TRUE;
-		match = FALSE;
-
-		if (sd->search_class != FORMAT_CLASS_BROKEN)
-			{
-			match = (sd->match_class == SEARCH_MATCH_EQUAL && fd->format_class == sd->search_class) ||
-			        (sd->match_class == SEARCH_MATCH_NONE && fd->format_class != sd->search_class);
-			}
-		else
-			{
-			match = sd->match_broken_enable = fd->format_class == FORMAT_CLASS_IMAGE || fd->format_class == FORMAT_CLASS_RAWIMAGE ||
-			                                  fd->format_class == FORMAT_CLASS_VIDEO || fd->format_class == FORMAT_CLASS_DOCUMENT;
-			}
-		}
-
-	if (match && sd->match_marks_enable)
-		{
-		tested = TRUE;
-		match = FALSE;
-
-		if (sd->match_marks == SEARCH_MATCH_EQUAL)
-			{
-			match = (fd->marks & sd->search_marks);
-			}
-		else
-			{
-			if (sd->search_marks == -1)
-				{
-				match = fd->marks ? FALSE : TRUE;
-				}
-			else
-				{
-				match = (fd->marks & sd->search_marks) ? FALSE : TRUE;
-				}
-			}
-		}
-
 	if (match && sd->match_gps_enable)
 		{
 		/* Calculate the distance the image is from the specified origin.
@@ -2199,71 +2349,135 @@ static gboolean search_file_next(SearchData *sd)
 			}
 		}
 
-	MatchFileData mfd_extra{fd, 0, 0, 0};
-	if ((match || extra_only) && (sd->match_dimensions_enable || sd->match_similarity_enable || sd->match_broken_enable))
+	return match;
+}
+
+static gboolean search_job_wants_image(SearchData *sd, SearchJob *job)
+{
+	return sd->match_dimensions_enable || sd->match_similarity_enable || job->check_broken;
+}
+
+/**
+ * @brief Continues a job whose metadata and similarity cache data have been read
+ *
+ * Runs the metadata checks, then the dimensions and similarity checks or
+ * queues the image load they need.
+ */
+static void search_job_prepared(SearchData *sd, SearchJob *job)
+{
+	if (job->exif)
 		{
-		tested = TRUE;
+		exif_cache_put_fd(job->fd, job->exif, job->exif_read_time);
+		job->exif = nullptr;
+		}
 
-		if (search_file_do_extra(sd, mfd_extra, match))
+	if (sd->match_date_enable && sd->metadata_date)
+		{
+		job->tested = TRUE;
+		if (!search_match_date(sd, job->dates.*sd->metadata_date))
 			{
-			sd->search_buffer_count += SEARCH_BUFFER_MATCH_LOAD;
-			return TRUE;
+			job->match = FALSE;
+			job->state = SEARCH_JOB_DONE;
+			return;
 			}
 		}
 
-	sd->search_file_list = g_list_remove(sd->search_file_list, fd);
-
-	if (tested && match)
+	if (search_match_metadata_enabled(sd) && !search_file_match_metadata(sd, job->fd, job->tested))
 		{
-		auto mfd = g_new(MatchFileData, 1);
-		*mfd = mfd_extra;
+		job->match = FALSE;
+		job->state = SEARCH_JOB_DONE;
+		return;
+		}
 
-		sd->search_buffer_list = g_list_prepend(sd->search_buffer_list, mfd);
-		sd->search_buffer_count += SEARCH_BUFFER_MATCH_HIT;
-		sd->search_count++;
-		search_progress_update(sd, TRUE, -1.0);
+	if (!search_job_wants_image(sd, job))
+		{
+		job->match = TRUE;
+		job->state = SEARCH_JOB_DONE;
+		return;
 		}
-	else
+
+	if ((sd->match_dimensions_enable && !job->cd->dimensions) ||
+	    (sd->match_similarity_enable && !job->cd->similarity) ||
+	    job->check_broken)
 		{
-		file_data_unref(fd);
-		sd->search_buffer_count += SEARCH_BUFFER_MATCH_MISS;
+		job->state = SEARCH_JOB_LOAD;
+		return;
 		}
 
-	return FALSE;
+	search_job_match_extra(sd, job);
 }
 
-static gboolean search_step_cb(gpointer data)
+/**
+ * @brief Checks the next file of the file list, and queues a job if it needs file access
+ */
+static void search_file_next(SearchData *sd)
 {
-	auto sd = static_cast<SearchData *>(data);
-	FileData *fd;
+	auto fd = static_cast<FileData *>(sd->search_file_list->data);
+	sd->search_file_list = g_list_delete_link(sd->search_file_list, sd->search_file_list);
 
-	if (sd->search_buffer_count > SEARCH_BUFFER_FLUSH_SIZE)
+	sd->search_total++;
+
+	gboolean tested = FALSE;
+	gboolean check_broken = FALSE;
+	if (!search_file_match_fd(sd, fd, tested, check_broken))
 		{
-		search_buffer_flush(sd);
-		search_progress_update(sd, TRUE, -1.0);
+		file_data_unref(fd);
+		sd->search_buffer_count += SEARCH_BUFFER_MATCH_MISS;
+		return;
 		}
 
-	if (sd->search_file_list)
+	auto job = new SearchJob();
+	job->sd = sd;
+	job->fd = fd;
+	job->tested = tested;
+	job->check_broken = check_broken;
+	job->mfd = {fd, 0, 0, 0};
+
+	/* Data modified in this session are not read from the file */
+	job->want_exif = search_match_metadata_enabled(sd) && !fd->exif && !fd->modified_xmp;
+	job->want_cd = search_job_wants_image(sd, job);
+
+	if (sd->match_date_enable && sd->metadata_date)
 		{
-		if (search_file_next(sd))
+		/* A date read before, or in the metadata index, is not read again */
+		const time_t date = sd->get_file_date(fd);
+
+		if (date > 0)
 			{
-			sd->search_idle_id = 0;
-			return G_SOURCE_REMOVE;
+			job->dates.*sd->metadata_date = date;
+			}
+		else if (fd->exif)
+			{
+			metadata_index_read_exif_dates(fd->exif, job->dates);
+			}
+		else if (!metadata_index_lookup(fd, job->dates))
+			{
+			job->want_date = TRUE;
 			}
-		return G_SOURCE_CONTINUE;
 		}
 
-	if (!sd->search_folder_list)
-		{
-		sd->search_idle_id = 0;
+	sd->pipeline->jobs.push_back(job);
 
-		search_stop(sd);
-		search_result_thumb_step(sd);
+	if (job->want_exif || job->want_date || job->want_cd)
+		{
+		job->path = g_strdup(fd->path);
+		if (job->want_exif || job->want_date) job->sidecar_path = exif_get_sidecar_path(fd);
 
-		return G_SOURCE_REMOVE;
+		job->state = SEARCH_JOB_PREPARE;
+		g_thread_pool_push(sd->pipeline->pool, job, nullptr);
 		}
+	else
+		{
+		search_job_prepared(sd, job);
+		}
+}
 
-	fd = static_cast<FileData *>(sd->search_folder_list->data);
+/**
+ * @brief Reads the next folder of the folder list into the file list
+ */
+static void search_folder_next(SearchData *sd)
+{
+	auto fd = static_cast<FileData *>(sd->search_folder_list->data);
 
 	if (g_list_find(sd->search_done_list, fd) == nullptr)
 		{
@@ -2337,6 +2551,128 @@ static gboolean search_step_cb(gpointer data)
 		sd->search_done_list = g_list_remove(sd->search_done_list, fd);
 		file_data_unref(fd);
 		}
+}
+
+/**
+ * @brief Advances the jobs, and moves the completed ones at the head of the pipeline to the results
+ * @returns TRUE if any job changed
+ */
+static gboolean search_pipeline_step(SearchData *sd)
+{
+	SearchPipeline *pipeline = sd->pipeline;
+	gboolean changed = FALSE;
+
+	for (SearchJob *job : pipeline->jobs)
+		{
+		if (job->state == SEARCH_JOB_PREPARE && g_atomic_int_get(&job->prepared))
+			{
+			search_job_prepared(sd, job);
+			changed = TRUE;
+			}
+
+		if (job->state == SEARCH_JOB_LOAD && pipeline->loaders < pipeline->max_loaders)
+			{
+			search_job_load(sd, job);
+			changed = TRUE;
+			}
+		}
+
+	while (!pipeline->jobs.empty() && pipeline->jobs.front()->state == SEARCH_JOB_DONE)
+		{
+		SearchJob *job = pipeline->jobs.front();
+		pipeline->jobs.pop_front();
+		changed = TRUE;
+
+		if (job->tested && job->match)
+			{
+			auto mfd = g_new(MatchFileData, 1);
+			*mfd = job->mfd;
+			job->fd = nullptr; /* the reference is moved to mfd */
+
+			sd->search_buffer_list = g_list_prepend(sd->search_buffer_list, mfd);
+			sd->search_buffer_count += SEARCH_BUFFER_MATCH_HIT;
+			sd->search_count++;
+			search_progress_update(sd, TRUE, -1.0);
+			}
+		else
+			{
+			sd->search_buffer_count += SEARCH_BUFFER_MATCH_MISS;
+			}
+
+		search_job_free(job);
+		}
+
+	return changed;
+}
+
+/**
+ * @brief Checks files and reads folders until the pipeline is full or the step time is used
+ * @returns TRUE if any file or folder was read
+ */
+static gboolean search_pipeline_fill(SearchData *sd)
+{
+	const gint64 end_time = g_get_monotonic_time() + SEARCH_STEP_TIME;
+	gboolean changed = FALSE;
+
+	while (sd->pipeline->jobs.size() < SEARCH_PIPELINE_MAX_JOBS && g_get_monotonic_time() < end_time)
+		{
+		if (sd->search_file_list)
+			{
+			search_file_next(sd);
+			}
+		else if (sd->search_folder_list)
+			{
+			search_folder_next(sd);
+			}
+		else
+			{
+			break;
+			}
+
+		changed = TRUE;
+		}
+
+	return changed;
+}
+
+static gboolean search_step_cb(gpointer data)
+{
+	auto sd = static_cast<SearchData *>(data);
+
+	if (sd->search_buffer_count > SEARCH_BUFFER_FLUSH_SIZE)
+		{
+		search_buffer_flush(sd);
+		search_progress_update(sd, TRUE, -1.0);
+		}
+
+	gboolean changed = search_pipeline_step(sd);
+	changed = search_pipeline_fill(sd) || changed;
+
+	if (sd->pipeline->jobs.empty() && !sd->search_file_list && !sd->search_folder_list)
+		{
+		sd->search_idle_id = 0;
+
+		search_stop(sd);
+		search_result_thumb_step(sd);
+
+		return G_SOURCE_REMOVE;
+		}
+
+	/* Poll while all jobs wait for the workers or the image loaders */
+	if (changed == sd->pipeline->polling)
+		{
+		sd->pipeline->polling = !changed;
+		if (changed)
+			{
+			sd->search_idle_id = g_idle_add(search_step_cb, sd);
+			}
+		else
+			{
+			sd->search_idle_id = g_timeout_add(SEARCH_POLL_INTERVAL, search_step_cb, sd);
+			}
+
+		return G_SOURCE_REMOVE;
+		}
 
 	return G_SOURCE_CONTINUE;
 }
@@ -2344,7 +2680,13 @@ static gboolean search_step_cb(gpointer data)
 static void search_similarity_load_done_cb(ImageLoader *, gpointer data)
 {
 	auto sd = static_cast<SearchData *>(data);
-	search_file_load_process(sd, sd->search_similarity_cd);
+
+	search_file_load_process(sd, sd->img_loader, sd->search_similarity_cd);
+
+	image_loader_free(sd->img_loader);
+	sd->img_loader = nullptr;
+
+	sd->search_idle_id = g_idle_add(search_step_cb, sd);
 }
 
 static GRegex *create_search_regex(const gchar *pattern)
@@ -2415,6 +2757,8 @@ static void search_start(SearchData *sd)
 	sd->search_count = 0;
 	sd->search_total = 0;
 
+	sd->pipeline = search_pipeline_new();
+
 	gtk_widget_set_sensitive(sd->ui.box_search, FALSE);
 	gtk_spinner_start(GTK_SPINNER(sd->ui.spinner));
 	gtk_widget_set_sensitive(sd->ui.button_start, FALSE);
@@ -2550,9 +2894,15 @@ static void search_start_cb(GtkWidget *, gpointer data)
 		const auto it = std::find_if(std::cbegin(search_date_types), std::cend(search_date_types),
 		                             [date_type](const SearchDateType &sdt){ return g_strcmp0(date_type, sdt.name) == 0; });
 		if (it != std::cend(search_date_types))
+			{
 			sd->get_file_date = it->get_file_date;
+			sd->metadata_date = it->metadata_date;
+			}
 		else
+			{
 			sd->get_file_date = [](FileData *fd){ return fd->date; };
+			sd->metadata_date = nullptr;
+			}
 
 		sd->search_date.set_date(sd->ui.date_sel);
 		sd->search_date_end.set_date(sd->ui.date_sel_end);
@@ -27,6 +27,12 @@
 #include <functional>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "options.h"
 
 /**
@@ -60,6 +66,201 @@ namespace
 
 using ImageSimilarityCheckAbort = std::function<bool(gdouble)>;
 
+constexpr gint SIM_ROW_SIZE = 32;
+
+struct SimChannels
+{
+	const guint8 *r;
+	const guint8 *g;
+	const guint8 *b;
+};
+
+/*
+ * Row kernels: each handles SIM_ROW_SIZE bytes of all three channels.
+ * row_sad() returns the summed absolute difference of the row.
+ * row_diff() stores the per-cell summed absolute difference (0..765) in cd.
+ */
+struct SimKernels
+{
+	guint (*row_sad)(SimChannels a, SimChannels b);
+	void (*row_diff)(SimChannels a, SimChannels b, guint16 *cd);
+};
+
+[[maybe_unused]] guint sim_row_sad_scalar(SimChannels a, SimChannels b)
+{
+	guint sim = 0;
+
+	for (gint i = 0; i < SIM_ROW_SIZE; i++)
+		{
+		sim += abs(a.r[i] - b.r[i]);
+		sim += abs(a.g[i] - b.g[i]);
+		sim += abs(a.b[i] - b.b[i]);
+		}
+
+	return sim;
+}
+
+[[maybe_unused]] void sim_row_diff_scalar(SimChannels a, SimChannels b, guint16 *cd)
+{
+	for (gint i = 0; i < SIM_ROW_SIZE; i++)
+		{
+		cd[i] = abs(a.r[i] - b.r[i]) + abs(a.g[i] - b.g[i]) + abs(a.b[i] - b.b[i]);
+		}
+}
+
+#if defined(__SSE2__)
+guint sim_row_sad_sse2(SimChannels a, SimChannels b)
+{
+	__m128i acc = _mm_setzero_si128();
+
+	for (gint i = 0; i < SIM_ROW_SIZE; i += 16)
+		{
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a.r + i)),
+		                                      _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.r + i))));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a.g + i)),
+		                                      _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.g + i))));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a.b + i)),
+		                                      _mm_loadu_si128(reinterpret_cast<const __m128i *>(b.b + i))));
+		}
+
+	return _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(acc, acc));
+}
+
+inline __m128i sim_absdiff_sse2(const guint8 *a, const guint8 *b)
+{
+	const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+	const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+
+	return _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+}
+
+void sim_row_diff_sse2(SimChannels a, SimChannels b, guint16 *cd)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	for (gint i = 0; i < SIM_ROW_SIZE; i += 16)
+		{
+		const __m128i dr = sim_absdiff_sse2(a.r + i, b.r + i);
+		const __m128i dg = sim_absdiff_sse2(a.g + i, b.g + i);
+		const __m128i db = sim_absdiff_sse2(a.b + i, b.b + i);
+
+		__m128i lo = _mm_unpacklo_epi8(dr, zero);
+		lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(dg, zero));
+		lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(db, zero));
+
+		__m128i hi = _mm_unpackhi_epi8(dr, zero);
+		hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(dg, zero));
+		hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(db, zero));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(cd + i), lo);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(cd + i + 8), hi);
+		}
+}
+
+__attribute__((target("avx2")))
+guint sim_row_sad_avx2(SimChannels a, SimChannels b)
+{
+	__m256i acc = _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a.r)),
+	                              _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.r)));
+	acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a.g)),
+	                                            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.g))));
+	acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a.b)),
+	                                            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.b))));
+
+	__m128i sum = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+
+	return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+}
+
+__attribute__((target("avx2")))
+inline __m256i sim_absdiff_avx2(const guint8 *a, const guint8 *b)
+{
+	const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+	const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+
+	return _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+}
+
+__attribute__((target("avx2")))
+void sim_row_diff_avx2(SimChannels a, SimChannels b, guint16 *cd)
+{
+	const __m256i dr = sim_absdiff_avx2(a.r, b.r);
+	const __m256i dg = sim_absdiff_avx2(a.g, b.g);
+	const __m256i db = sim_absdiff_avx2(a.b, b.b);
+
+	__m256i lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(dr));
+	lo = _mm256_add_epi16(lo, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(dg)));
+	lo = _mm256_add_epi16(lo, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(db)));
+
+	__m256i hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(dr, 1));
+	hi = _mm256_add_epi16(hi, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(dg, 1)));
+	hi = _mm256_add_epi16(hi, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(db, 1)));
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(cd), lo);
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(cd + 16), hi);
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+guint sim_row_sad_neon(SimChannels a, SimChannels b)
+{
+	uint16x8_t acc = vdupq_n_u16(0);
+
+	for (gint i = 0; i < SIM_ROW_SIZE; i += 16)
+		{
+		acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a.r + i), vld1q_u8(b.r + i)));
+		acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a.g + i), vld1q_u8(b.g + i)));
+		acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(a.b + i), vld1q_u8(b.b + i)));
+		}
+
+	return vaddlvq_u16(acc);
+}
+
+void sim_row_diff_neon(SimChannels a, SimChannels b, guint16 *cd)
+{
+	for (gint i = 0; i < SIM_ROW_SIZE; i += 16)
+		{
+		const uint8x16_t dr = vabdq_u8(vld1q_u8(a.r + i), vld1q_u8(b.r + i));
+		const uint8x16_t dg = vabdq_u8(vld1q_u8(a.g + i), vld1q_u8(b.g + i));
+		const uint8x16_t db = vabdq_u8(vld1q_u8(a.b + i), vld1q_u8(b.b + i));
+
+		uint16x8_t lo = vaddl_u8(vget_low_u8(dr), vget_low_u8(dg));
+		lo = vaddw_u8(lo, vget_low_u8(db));
+		uint16x8_t hi = vaddl_u8(vget_high_u8(dr), vget_high_u8(dg));
+		hi = vaddw_u8(hi, vget_high_u8(db));
+
+		vst1q_u16(cd + i, lo);
+		vst1q_u16(cd + i + 8, hi);
+		}
+}
+#endif
+
+/**
+ * @brief Selects the row kernels once, based on the running CPU
+ *
+ * All kernels produce identical integer sums, so the choice
+ * never changes a similarity score.
+ */
+const SimKernels &sim_kernels()
+{
+	static const SimKernels kernels = []()
+		{
+#if defined(__SSE2__)
+		if (__builtin_cpu_supports("avx2"))
+			{
+			return SimKernels{sim_row_sad_avx2, sim_row_diff_avx2};
+			}
+		return SimKernels{sim_row_sad_sse2, sim_row_diff_sse2};
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+		return SimKernels{sim_row_sad_neon, sim_row_diff_neon};
+#else
+		return SimKernels{sim_row_sad_scalar, sim_row_diff_scalar};
+#endif
+		}();
+
+	return kernels;
+}
+
 void image_sim_channel_equal(ImageSimilarityData::Avg &pix)
 {
 	struct IndexedPix
@@ -91,30 +292,123 @@ void image_sim_channel_equal(ImageSimilarityData::Avg &pix)
  * generate all possible isometric transformations
  * = 8 tests
  * = change dir of x, change dir of y, exchange x and y = 2^3 = 8
+ *
+ * Each table maps a cell index of a to the matching cell index of b,
+ * so that b can be gathered into a's order and compared row by row.
+ * The transformations map the 4 x 4 blocks of the coarse grid onto each
+ * other in the same way, so the same construction is used for both grids.
+ */
+template<gint N>
+using SimTransfoIndex = std::array<guint16, N * N>;
+
+template<gint N>
+const std::array<SimTransfoIndex<N>, 8> &sim_transfo_tables()
+{
+	static const std::array<SimTransfoIndex<N>, 8> tables = []()
+		{
+		std::array<SimTransfoIndex<N>, 8> t{};
+
+		for (gint transfo = 0; transfo < 8; transfo++)
+			{
+			gint i2;
+			gint *i;
+			gint j2;
+			gint *j;
+
+			if (transfo & 1) { i = &j2; j = &i2; } else { i = &i2; j = &j2; }
+			for (gint j1 = 0; j1 < N; j1++)
+				{
+				if (transfo & 2) *j = N-1-j1; else *j = j1;
+				for (gint i1 = 0; i1 < N; i1++)
+					{
+					if (transfo & 4) *i = N-1-i1; else *i = i1;
+					t[transfo][(i1*N)+j1] = (i2*N)+j2;
+					}
+				}
+			}
+
+		return t;
+		}();
+
+	return tables;
+}
+
+/**
+ * @brief Lower bound of the sum of differences of a and the transformed b
+ *
+ * The difference of two block sums is never more than the sum of the
+ * differences of the cells in the block, so the distance between the
+ * coarse grids can never exceed the full distance.
+ */
+guint image_sim_coarse_distance(const ImageSimilarityData *a, const ImageSimilarityData *b, gchar transfo)
+{
+	const SimTransfoIndex<8> &index = sim_transfo_tables<8>()[transfo];
+	guint dist = 0;
+
+	for (gsize n = 0; n < index.size(); n++)
+		{
+		dist += abs(a->coarse_r[n] - b->coarse_r[index[n]]);
+		dist += abs(a->coarse_g[n] - b->coarse_g[index[n]]);
+		dist += abs(a->coarse_b[n] - b->coarse_b[index[n]]);
+		}
+
+	return dist;
+}
+
+guint image_sim_coarse_distance(const ImageSimilarityData::Coarse *a, const ImageSimilarityData::Coarse *b)
+{
+	guint dist = 0;
+
+	for (gint c = 0; c < 3; c++)
+		{
+		for (gsize n = 0; n < a[c].size(); n++)
+			{
+			dist += abs(a[c][n] - b[c][n]);
+			}
+		}
+
+	return dist;
+}
+
+/*
+ * The sum of differences only grows, so checking the abort condition once
+ * per row gives the same result as checking it after every cell.
+ * For the same reason, an abort on the coarse lower bound is exact.
  */
 gdouble image_sim_data_compare_transfo(const ImageSimilarityData *a, const ImageSimilarityData *b, gchar transfo, const ImageSimilarityCheckAbort &check_abort)
 {
 	if (!a || !b || !a->filled || !b->filled) return 0.0;
 
-	gint sim = 0.0;
-	gint i2;
-	gint *i;
-	gint j2;
-	gint *j;
+	if (a->coarse_filled && b->coarse_filled &&
+	    check_abort(image_sim_coarse_distance(a, b, transfo))) return 0.0;
+
+	ImageSimilarityData::Avg tr;
+	ImageSimilarityData::Avg tg;
+	ImageSimilarityData::Avg tb;
+	SimChannels bc{b->avg_r.data(), b->avg_g.data(), b->avg_b.data()};
 
-	if (transfo & 1) { i = &j2; j = &i2; } else { i = &i2; j = &j2; }
-	for (gint j1 = 0; j1 < 32; j1++)
+	if (transfo != 0)
 		{
-		if (transfo & 2) *j = 31-j1; else *j = j1;
-		for (gint i1 = 0; i1 < 32; i1++)
+		const SimTransfoIndex<32> &index = sim_transfo_tables<32>()[transfo];
+
+		for (gsize n = 0; n < index.size(); n++)
 			{
-			if (transfo & 4) *i = 31-i1; else *i = i1;
-			sim += abs(a->avg_r[(i1*32)+j1] - b->avg_r[(i2*32)+j2]);
-			sim += abs(a->avg_g[(i1*32)+j1] - b->avg_g[(i2*32)+j2]);
-			sim += abs(a->avg_b[(i1*32)+j1] - b->avg_b[(i2*32)+j2]);
-			/* check for abort, if so return 0.0 */
-			if (check_abort(sim)) return 0.0;
+			tr[n] = b->avg_r[index[n]];
+			tg[n] = b->avg_g[index[n]];
+			tb[n] = b->avg_b[index[n]];
 			}
+		bc = {tr.data(), tg.data(), tb.data()};
+		}
+
+	const SimKernels &kernels = sim_kernels();
+	gint sim = 0;
+
+	for (gint n = 0; n < 1024; n += SIM_ROW_SIZE)
+		{
+		sim += kernels.row_sad({a->avg_r.data() + n, a->avg_g.data() + n, a->avg_b.data() + n},
+		                       {bc.r + n, bc.g + n, bc.b + n});
+		/* check for abort, if so return 0.0 */
+		if (check_abort(sim)) return 0.0;
 		}
 
 	return 1.0 - (static_cast<gdouble>(sim) / (255.0 * 1024.0 * 3.0));
@@ -188,6 +482,29 @@ void image_sim_alternate_processing(ImageSimilarityData *sd)
 			sd->avg_r[i] = sd->avg_g[i] = sd->avg_b[i] = n;
 			}
 		}
+
+	sd->fill_coarse();
+}
+
+void ImageSimilarityData::fill_coarse()
+{
+	const auto block_sums = [](const Avg &avg, Coarse &coarse)
+		{
+		coarse.fill(0);
+		for (gint y = 0; y < 32; y++)
+			{
+			for (gint x = 0; x < 32; x++)
+				{
+				coarse[((y / 4) * 8) + (x / 4)] += avg[(y * 32) + x];
+				}
+			}
+		};
+
+	block_sums(avg_r, coarse_r);
+	block_sums(avg_g, coarse_g);
+	block_sums(avg_b, coarse_b);
+
+	coarse_filled = TRUE;
 }
 
 void ImageSimilarityData::fill_data(GdkPixbuf *pixbuf)
@@ -270,42 +587,38 @@ void ImageSimilarityData::fill_data(GdkPixbuf *pixbuf)
 		}
 
 	filled = TRUE;
+
+	fill_coarse();
 }
 
 static gdouble alternate_image_sim_compare_fast(const ImageSimilarityData *a, const ImageSimilarityData *b, gdouble min)
 {
-	gint sim;
-	gint i;
-	gint j;
-	gint ld;
-
 	if (!a || !b || !a->filled || !b->filled) return 0.0;
 
-	sim = 0.0;
-	ld = 0;
+	/* Each cell adds at least its difference, so the coarse bound applies */
+	if (a->coarse_filled && b->coarse_filled &&
+	    static_cast<gdouble>(image_sim_coarse_distance(a, b, 0)) / (255.0 * 1024.0 * 4.0) > min) return 0.0;
 
-	for (j = 0; j < 1024; j += 32)
-		{
-		for (i = j; i < j + 32; i++)
-			{
-			gint cr;
-			gint cg;
-			gint cb;
-			gint cd;
+	const SimKernels &kernels = sim_kernels();
+	std::array<guint16, SIM_ROW_SIZE> row;
+	gint sim = 0;
+	gint ld = 0;
 
-			cr = abs(a->avg_r[i] - b->avg_r[i]);
-			cg = abs(a->avg_g[i] - b->avg_g[i]);
-			cb = abs(a->avg_b[i] - b->avg_b[i]);
+	for (gint j = 0; j < 1024; j += SIM_ROW_SIZE)
+		{
+		kernels.row_diff({a->avg_r.data() + j, a->avg_g.data() + j, a->avg_b.data() + j},
+		                 {b->avg_r.data() + j, b->avg_g.data() + j, b->avg_b.data() + j}, row.data());
 
-			cd = cr + cg + cb;
+		for (const gint cd : row)
+			{
 			sim += cd + abs(cd - ld);
 			ld = cd / 3;
 			}
 		/* check for abort, if so return 0.0 */
-		if ((gdouble)sim / (255.0 * 1024.0 * 4.0) > min) return 0.0;
+		if (static_cast<gdouble>(sim) / (255.0 * 1024.0 * 4.0) > min) return 0.0;
 		}
 
-	return (1.0 - ((gdouble)sim / (255.0 * 1024.0 * 4.0)) );
+	return (1.0 - (static_cast<gdouble>(sim) / (255.0 * 1024.0 * 4.0)) );
 }
 
 gdouble image_sim_compare(ImageSimilarityData *a, ImageSimilarityData *b)
@@ -333,4 +646,114 @@ gboolean image_sim_filled(const ImageSimilarityData *sd)
 	if (!sd) return FALSE;
 	return sd->filled;
 }
+
+/*
+ *-------------------------------------------------------------------
+ * similarity index
+ *-------------------------------------------------------------------
+ */
+
+ImageSimilarityIndex::ImageSimilarityIndex(const std::vector<const ImageSimilarityData *> &items)
+{
+	for (gsize i = 0; i < items.size(); i++)
+		{
+		const ImageSimilarityData *sd = items[i];
+
+		if (!sd || !sd->filled || !sd->coarse_filled) continue;
+
+		nodes.push_back({static_cast<guint>(i), static_cast<guint>(signatures.size()), 0, 0});
+		signatures.push_back({sd->coarse_r, sd->coarse_g, sd->coarse_b});
+		}
+
+	build(0, nodes.size());
+}
+
+/*
+ * The nodes of [lo, hi) are rearranged in place: nodes[lo] is the vantage
+ * point, followed by the nodes at or within its radius, then the nodes
+ * at or beyond it.
+ */
+void ImageSimilarityIndex::build(guint lo, guint hi)
+{
+	if (hi - lo < 2)
+		{
+		if (hi > lo) nodes[lo].outside = hi;
+		return;
+		}
+
+	/* Use the middle node as vantage point, the input order is often sorted */
+	std::swap(nodes[lo], nodes[lo + ((hi - lo) / 2)]);
+
+	const ImageSimilarityData::Coarse *vp = signatures[nodes[lo].signature].data();
+	std::vector<std::pair<guint, Node>> dist;
+
+	dist.reserve(hi - lo - 1);
+	for (guint i = lo + 1; i < hi; i++)
+		{
+		dist.emplace_back(image_sim_coarse_distance(vp, signatures[nodes[i].signature].data()), nodes[i]);
+		}
+
+	/* Split at the median, ties may fall on either side so the tree stays balanced */
+	const gsize mid = dist.size() / 2;
+	std::nth_element(dist.begin(), dist.begin() + mid, dist.end(),
+	                 [](const std::pair<guint, Node> &a, const std::pair<guint, Node> &b){ return a.first < b.first; });
+
+	nodes[lo].radius = dist[mid].first;
+	nodes[lo].outside = lo + 1 + mid + 1;
+
+	for (gsize i = 0; i < dist.size(); i++)
+		{
+		nodes[lo + 1 + i] = dist[i].second;
+		}
+
+	build(lo + 1, nodes[lo].outside);
+	build(nodes[lo].outside, hi);
+}
+
+void ImageSimilarityIndex::search(guint lo, guint hi, const ImageSimilarityData::Coarse *query, guint max_dist, std::vector<guint> &result) const
+{
+	if (lo >= hi) return;
+
+	const Node &vp = nodes[lo];
+	const guint d = image_sim_coarse_distance(query, signatures[vp.signature].data());
+
+	if (d <= max_dist) result.push_back(vp.item);
+
+	/* Triangle inequality: skip a subtree if no node in it can be near enough */
+	if (d <= vp.radius + max_dist) search(lo + 1, vp.outside, query, max_dist, result);
+	if (d + max_dist >= vp.radius) search(vp.outside, hi, query, max_dist, result);
+}
+
+void ImageSimilarityIndex::find_candidates(const ImageSimilarityData *sd, gdouble min, std::vector<guint> &result) const
+{
+	if (!sd || !sd->filled || !sd->coarse_filled) return;
+
+	const gboolean alternate = options->alternate_similarity_algorithm.enabled;
+	const gchar max_t = (options->rot_invariant_sim && !alternate) ? 8 : 1;
+	const gdouble scale = 255.0 * 1024.0 * (alternate ? 4.0 : 3.0);
+	/* Round up, the exact test is done by image_sim_compare_fast() */
+	const guint max_dist = std::ceil((1.0 - min) * scale);
+	const gsize first = result.size();
+
+	for (gchar t = 0; t < max_t; t++)
+		{
+		const SimTransfoIndex<8> &index = sim_transfo_tables<8>()[t];
+		std::array<ImageSimilarityData::Coarse, 3> query;
+
+		for (gsize n = 0; n < index.size(); n++)
+			{
+			query[0][n] = sd->coarse_r[index[n]];
+			query[1][n] = sd->coarse_g[index[n]];
+			query[2][n] = sd->coarse_b[index[n]];
+			}
+
+		search(0, nodes.size(), query.data(), max_dist, result);
+		}
+
+	if (max_t > 1)
+		{
+		std::sort(result.begin() + first, result.end());
+		result.erase(std::unique(result.begin() + first, result.end()), result.end());
+		}
+}
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -23,6 +23,7 @@
 #define SIMILAR_H
 
 #include <array>
+#include <vector>
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <glib.h>
@@ -30,6 +31,7 @@
 struct ImageSimilarityData
 {
 	void fill_data(GdkPixbuf *pixbuf);
+	void fill_coarse();
 
 	using Avg = std::array<guint8, 1024>;
 	Avg avg_r;
@@ -37,6 +39,47 @@ struct ImageSimilarityData
 	Avg avg_b;
 
 	gboolean filled;
+
+	/* Sums of the 4 x 4 blocks of avg_*, an 8 x 8 grid.
+	 * Used as a lower bound of the distance; call fill_coarse() after changing avg_*
+	 */
+	using Coarse = std::array<guint16, 64>;
+	Coarse coarse_r;
+	Coarse coarse_g;
+	Coarse coarse_b;
+
+	gboolean coarse_filled;
+};
+
+/**
+ * @brief Vantage point tree over the coarse grids of a set of images
+ *
+ * Finds the images that may be similar to a given one without comparing
+ * against every image. The result is a superset: each candidate must still
+ * be checked with image_sim_compare_fast().
+ */
+class ImageSimilarityIndex
+{
+public:
+	explicit ImageSimilarityIndex(const std::vector<const ImageSimilarityData *> &items);
+
+	/* Appends the positions in items of the candidates for image_sim_compare_fast(item, sd, min) */
+	void find_candidates(const ImageSimilarityData *sd, gdouble min, std::vector<guint> &result) const;
+
+private:
+	struct Node
+	{
+		guint item;
+		guint signature;
+		guint radius;
+		guint outside; /**< First node of the subtree at or beyond radius */
+	};
+
+	void build(guint lo, guint hi);
+	void search(guint lo, guint hi, const ImageSimilarityData::Coarse *query, guint max_dist, std::vector<guint> &result) const;
+
+	std::vector<std::array<ImageSimilarityData::Coarse, 3>> signatures;
+	std::vector<Node> nodes;
 };
 
 
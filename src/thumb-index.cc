@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "thumb-index.h"
+
+#include <map>
+#include <string>
+
+#include <config.h>
+
+#include "cache.h"
+#include "cache-store.h"
+#include "ui-fileops.h"
+
+/**
+ * @file
+ *
+ * The standard thumbnail cache keeps one PNG per thumbnail, named by the
+ * MD5 of the source URI, and a thumbnail can only be validated by reading
+ * the PNG. The validation index records, for each source file of a folder,
+ * what was last found out about its thumbnails: which sizes were valid, or
+ * that the source could not be loaded. An entry applies only while the
+ * modification time and size of the source are unchanged, so looking up a
+ * whole folder takes one read of the index and the stat of each file that
+ * is done anyway. A thumbnail it lists is loaded without being validated
+ * again and without checking that it exists first, a failure it lists saves
+ * reading the failure marker, and cache maintenance can skip files without
+ * looking for their thumbnails at all.
+ *
+ *-------------------------------------------------------------------
+ * Validation index file format (GQ_CACHE_THUMB_INDEX):
+ *-------------------------------------------------------------------
+ *
+ * A table file as described by CacheTableFormat, with one ThumbIndexRecord
+ * per source file. Its strings are the file names. It is kept and written
+ * out as described in cache-store.cc. An index written by another version
+ * of Geeqie is ignored.
+ */
+
+namespace
+{
+
+constexpr guint THUMB_INDEX_FLUSH_DELAY = 5; /**< seconds after the last change */
+
+struct ThumbIndexRecord
+{
+	guint32 name_offset; /**< Relative to the start of the strings */
+	guint32 status; /**< #ThumbIndexStatus flags */
+	gint64 source_mtime;
+	gint64 source_size;
+};
+
+static_assert(sizeof(ThumbIndexRecord) == 24, "thumbnail index record must not be padded");
+
+/* Failures are version specific */
+const CacheTableFormat thumb_index_format{{'G', 'Q', 'T', 'H', 'V', 'A', 'L', '\n'}, 1, g_str_hash(VERSION), sizeof(ThumbIndexRecord), "thumbnail index"};
+
+class ThumbIndex : public CacheStoreFile
+{
+public:
+	ThumbIndex(const gchar *index_path, const gchar *source_dir);
+
+	bool find(const gchar *name, ThumbIndexRecord &r) const;
+	void write(const gchar *name, const ThumbIndexRecord &r);
+
+protected:
+	bool changed() const override;
+	void write_out(bool prune) override;
+
+private:
+	static ThumbIndexRecord record_from_le(const ThumbIndexRecord &r);
+	static ThumbIndexRecord record_to_le(const ThumbIndexRecord &r);
+
+	CacheTable table;
+
+	std::map<std::string, ThumbIndexRecord> pending; /**< Written, but not yet flushed */
+};
+
+ThumbIndex::ThumbIndex(const gchar *index_path, const gchar *source_dir)
+	: CacheStoreFile(index_path, source_dir)
+	, table(thumb_index_format, index_path)
+{
+}
+
+ThumbIndexRecord ThumbIndex::record_from_le(const ThumbIndexRecord &r)
+{
+	ThumbIndexRecord h;
+
+	h.name_offset = GUINT32_FROM_LE(r.name_offset);
+	h.status = GUINT32_FROM_LE(r.status);
+	h.source_mtime = GINT64_FROM_LE(r.source_mtime);
+	h.source_size = GINT64_FROM_LE(r.source_size);
+
+	return h;
+}
+
+ThumbIndexRecord ThumbIndex::record_to_le(const ThumbIndexRecord &r)
+{
+	/* The conversion is its own inverse */
+	return record_from_le(r);
+}
+
+bool ThumbIndex::find(const gchar *name, ThumbIndexRecord &r) const
+{
+	if (const auto it = pending.find(name); it != pending.end())
+		{
+		r = it->second;
+		return true;
+		}
+
+	const gint i = table.find(name);
+	if (i < 0) return false;
+
+	r = record_from_le(table.record<ThumbIndexRecord>(i));
+
+	return true;
+}
+
+void ThumbIndex::write(const gchar *name, const ThumbIndexRecord &r)
+{
+	pending[name] = r;
+}
+
+bool ThumbIndex::changed() const
+{
+	return !pending.empty();
+}
+
+void ThumbIndex::write_out(bool prune)
+{
+	std::map<std::string, ThumbIndexRecord> merged;
+
+	for (guint32 i = 0; i < table.count(); i++)
+		{
+		const gchar *name = table.name(i);
+		if (pending.count(name) > 0) continue;
+		if (prune && !source_exists(name)) continue;
+
+		merged.emplace(name, record_from_le(table.record<ThumbIndexRecord>(i)));
+		}
+
+	merged.merge(pending);
+	pending.clear();
+
+	CacheTableWriter writer(thumb_index_format);
+
+	for (auto &[name, r] : merged)
+		{
+		r.name_offset = writer.add_string(name);
+
+		const ThumbIndexRecord le = record_to_le(r);
+		writer.add_record(&le);
+		}
+
+	writer.write(table);
+}
+
+/* Thumbnails are validated in the main thread only, so there is no locking */
+CacheStore thumb_indexes([](const gchar *path, const gchar *source_dir) -> CacheStoreFile *
+	{
+	return new ThumbIndex(path, source_dir);
+	}, THUMB_INDEX_FLUSH_DELAY);
+
+ThumbIndex *thumb_index_get(const gchar *source, gboolean create)
+{
+	return static_cast<ThumbIndex *>(thumb_indexes.get(source, GQ_CACHE_THUMB_INDEX, create));
+}
+
+} // namespace
+
+/**
+ * @brief Get what is known about the thumbnails of a source file
+ * @param source file name of the image
+ * @param mtime modification time of the source
+ * @param size size of the source
+ * @returns #ThumbIndexStatus flags, 0 if nothing is known for this version of the source
+ */
+guint32 thumb_index_lookup(const gchar *source, time_t mtime, off_t size)
+{
+	ThumbIndex *index = thumb_index_get(source, FALSE);
+	if (!index) return 0;
+
+	ThumbIndexRecord r;
+	if (!index->find(filename_from_path(source), r)) return 0;
+	if (r.source_mtime != mtime || r.source_size != size) return 0;
+
+	return r.status;
+}
+
+/**
+ * @brief Record what was found out about the thumbnails of a source file
+ * @param set #ThumbIndexStatus flags that now apply
+ * @param clear #ThumbIndexStatus flags that no longer apply
+ *
+ * Flags recorded for an older version of the source are discarded.
+ */
+void thumb_index_update(const gchar *source, time_t mtime, off_t size, guint32 set, guint32 clear)
+{
+	const guint32 old_status = thumb_index_lookup(source, mtime, size);
+	const guint32 status = (old_status | set) & ~clear;
+
+	if (status == old_status) return;
+
+	ThumbIndex *index = thumb_index_get(source, TRUE);
+	if (!index) return;
+
+	ThumbIndexRecord r{};
+	r.status = status;
+	r.source_mtime = mtime;
+	r.source_size = size;
+	index->write(filename_from_path(source), r);
+	thumb_indexes.changed();
+}
+
+/**
+ * @brief Write all changed indexes, and close all indexes
+ */
+void thumb_index_flush()
+{
+	thumb_indexes.close();
+}
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
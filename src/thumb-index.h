@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef THUMB_INDEX_H
+#define THUMB_INDEX_H
+
+#include <sys/types.h>
+
+#include <ctime>
+
+#include <glib.h>
+
+/**
+ * @brief What is known about the standard cache thumbnails of a source file
+ */
+enum ThumbIndexStatus : guint32 {
+	THUMB_INDEX_NORMAL = 1 << 0, /**< valid normal size thumbnail in the shared cache */
+	THUMB_INDEX_LARGE  = 1 << 1, /**< valid large size thumbnail in the shared cache */
+	THUMB_INDEX_FAILED = 1 << 2  /**< the source could not be loaded */
+};
+
+guint32 thumb_index_lookup(const gchar *source, time_t mtime, off_t size);
+void thumb_index_update(const gchar *source, time_t mtime, off_t size, guint32 set, guint32 clear);
+void thumb_index_flush();
+
+#endif /* THUMB_INDEX_H */
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,919 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "thumb-pack.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <map>
+
+#include "cache.h"
+#include "cache-store.h"
+#include "debug.h"
+#include "fast-hash.h"
+#include "ui-fileops.h"
+
+/**
+ * @file
+ *
+ * Thumbnails can be kept in one pack file per source folder and size
+ * class, instead of one PNG file per thumbnail. The packs are placed in
+ * the Geeqie thumbnail cache folder of the source folder.
+ *
+ *-------------------------------------------------------------------
+ * Thumbnail pack file format (GQ_CACHE_THUMB_PACK_NORMAL, _LARGE):
+ *-------------------------------------------------------------------
+ *
+ * All values are little endian. \n
+ * ThumbPackHeader \n
+ * any number of: \n
+ *   ThumbPackRecord, name_length bytes of file name, data_length bytes of pixels \n
+ *   or an index block: \n
+ *   ThumbPackIndexHeader, entry_count x ThumbPackIndexEntry sorted by name,
+ *   names_size bytes of file names, each NUL terminated \n
+ *
+ * The file is only appended to. New thumbnails are written as records at
+ * the end, and when the pack is written out as described in cache-store.cc
+ * a new index block is appended and the header is pointed at it. The index is read in place
+ * from the mapped file. When most of the file is taken by superseded
+ * records and index blocks, it is compacted instead. Every record repeats
+ * its key and carries a checksum, so a stale index entry, for instance
+ * from another Geeqie instance, only causes a miss. \n
+ * Pixels are compressed with the QOI scheme (https://qoiformat.org),
+ * without its header and end marker.
+ */
+
+namespace
+{
+
+constexpr gchar THUMB_PACK_MAGIC[8] = {'G', 'Q', 'T', 'H', 'M', 'P', 'K', '\n'};
+constexpr gchar THUMB_PACK_INDEX_MAGIC[8] = {'G', 'Q', 'T', 'H', 'I', 'D', 'X', '\n'};
+constexpr guint32 THUMB_PACK_VERSION = 1;
+constexpr guint THUMB_PACK_FLUSH_DELAY = 5; /**< seconds after the last change */
+constexpr gsize THUMB_PACK_COMPACT_MIN_SIZE = 1024 * 1024; /**< Smaller files are not compacted */
+
+enum ThumbPackFlags : guint8 {
+	THUMB_PACK_FAILED = 1 << 0 /**< The source could not be loaded, there are no pixels */
+};
+
+struct ThumbPackHeader
+{
+	gchar magic[8];
+	guint32 version;
+	guint32 reserved;
+	guint64 index_offset; /**< Of the current index block, 0 if none */
+};
+
+struct ThumbPackRecord
+{
+	guint32 name_length;
+	guint32 data_length;
+	gint64 source_mtime;
+	gint64 source_size;
+	guint32 width;
+	guint32 height;
+	guint8 channels;
+	guint8 flags;
+	guint16 reserved;
+	guint32 checksum; /**< Of the name and the pixel data */
+};
+
+struct ThumbPackIndexHeader
+{
+	gchar magic[8];
+	guint32 entry_count;
+	guint32 names_size;
+};
+
+struct ThumbPackIndexEntry
+{
+	guint32 name_offset; /**< Relative to the start of the names */
+	guint32 name_length;
+	gint64 source_mtime;
+	gint64 source_size;
+	guint64 record_offset;
+	guint32 record_length; /**< Including the record header and the name */
+	guint32 reserved;
+};
+
+static_assert(sizeof(ThumbPackHeader) == 24, "thumbnail pack header must not be padded");
+static_assert(sizeof(ThumbPackRecord) == 40, "thumbnail pack record must not be padded");
+static_assert(sizeof(ThumbPackIndexHeader) == 16, "thumbnail pack index header must not be padded");
+static_assert(sizeof(ThumbPackIndexEntry) == 40, "thumbnail pack index entry must not be padded");
+
+/*
+ *-------------------------------------------------------------------
+ * pixel compression
+ *-------------------------------------------------------------------
+ */
+
+constexpr guchar QOI_OP_INDEX = 0x00;
+constexpr guchar QOI_OP_DIFF = 0x40;
+constexpr guchar QOI_OP_LUMA = 0x80;
+constexpr guchar QOI_OP_RUN = 0xc0;
+constexpr guchar QOI_OP_RGB = 0xfe;
+constexpr guchar QOI_OP_RGBA = 0xff;
+constexpr guchar QOI_MASK = 0xc0;
+constexpr gint QOI_MAX_RUN = 62;
+
+struct QoiPixel
+{
+	guchar r;
+	guchar g;
+	guchar b;
+	guchar a;
+
+	bool operator==(const QoiPixel &other) const
+	{
+		return r == other.r && g == other.g && b == other.b && a == other.a;
+	}
+
+	gint hash() const
+	{
+		return ((r * 3) + (g * 5) + (b * 7) + (a * 11)) % 64;
+	}
+};
+
+/**
+ * @brief Decode one operation
+ * @returns false if the data ends within the operation
+ */
+bool qoi_decode_op(const guchar *data, gsize length, gsize &pos, QoiPixel &px, std::array<QoiPixel, 64> &index, gint &run)
+{
+	if (pos >= length) return false;
+	const guchar b1 = data[pos++];
+
+	if (b1 == QOI_OP_RGB)
+		{
+		if (length - pos < 3) return false;
+		px.r = data[pos++];
+		px.g = data[pos++];
+		px.b = data[pos++];
+		}
+	else if (b1 == QOI_OP_RGBA)
+		{
+		if (length - pos < 4) return false;
+		px.r = data[pos++];
+		px.g = data[pos++];
+		px.b = data[pos++];
+		px.a = data[pos++];
+		}
+	else if ((b1 & QOI_MASK) == QOI_OP_INDEX)
+		{
+		px = index[b1];
+		}
+	else if ((b1 & QOI_MASK) == QOI_OP_DIFF)
+		{
+		px.r += ((b1 >> 4) & 0x03) - 2;
+		px.g += ((b1 >> 2) & 0x03) - 2;
+		px.b += (b1 & 0x03) - 2;
+		}
+	else if ((b1 & QOI_MASK) == QOI_OP_LUMA)
+		{
+		if (pos >= length) return false;
+		const guchar b2 = data[pos++];
+		const gint dg = (b1 & 0x3f) - 32;
+
+		px.r += dg - 8 + ((b2 >> 4) & 0x0f);
+		px.g += dg;
+		px.b += dg - 8 + (b2 & 0x0f);
+		}
+	else
+		{
+		/* The current pixel is the first of the run, the encoder has not indexed it again */
+		run = b1 & 0x3f;
+		return true;
+		}
+
+	index[px.hash()] = px;
+
+	return true;
+}
+
+guint32 thumb_pack_checksum(const gchar *name, gsize name_length, const guchar *data, gsize data_length)
+{
+	FastHash hash;
+
+	hash.update(reinterpret_cast<const guchar *>(name), name_length);
+	hash.update(data, data_length);
+
+	const FastHashDigest digest = hash.digest();
+	guint32 checksum;
+	memcpy(&checksum, digest.data(), sizeof(checksum));
+
+	return GUINT32_FROM_LE(checksum);
+}
+
+/*
+ *-------------------------------------------------------------------
+ * pack file
+ *-------------------------------------------------------------------
+ */
+
+class ThumbPack : public CacheStoreFile
+{
+public:
+	ThumbPack(const gchar *pack_path, const gchar *source_dir);
+	~ThumbPack() override;
+
+	bool contains(const gchar *name, time_t mtime, off_t size) const;
+	GdkPixbuf *read(const gchar *name, time_t mtime, off_t size, gboolean &failed);
+	void write(const gchar *name, time_t mtime, off_t size, GdkPixbuf *pixbuf);
+
+protected:
+	bool changed() const override;
+	void write_out(bool prune) override;
+
+private:
+	struct Entry
+	{
+		gint64 source_mtime;
+		gint64 source_size;
+		guint64 record_offset;
+		guint32 record_length;
+	};
+
+	void map();
+	bool find(const gchar *name, Entry &entry) const;
+	static Entry entry_from_le(const ThumbPackIndexEntry &e);
+	const guchar *record(const gchar *name, const Entry &entry, ThumbPackRecord &r);
+	static std::string index_block(const std::map<std::string, Entry> &entries);
+	void append_index(const std::map<std::string, Entry> &entries);
+	void compact(std::map<std::string, Entry> &entries);
+
+	GMappedFile *mapped = nullptr;
+	bool valid = false; /**< The mapped file has a valid header */
+	const ThumbPackIndexEntry *entries = nullptr;
+	guint32 entry_count = 0;
+	const gchar *names = nullptr;
+	guint32 names_size = 0;
+
+	std::map<std::string, Entry> pending; /**< Appended, but not yet in the index */
+};
+
+ThumbPack::ThumbPack(const gchar *pack_path, const gchar *source_dir)
+	: CacheStoreFile(pack_path, source_dir)
+{
+	map();
+}
+
+ThumbPack::~ThumbPack()
+{
+	if (mapped) g_mapped_file_unref(mapped);
+}
+
+void ThumbPack::map()
+{
+	if (mapped) g_mapped_file_unref(mapped);
+	mapped = nullptr;
+	valid = false;
+	entries = nullptr;
+	entry_count = 0;
+	names = nullptr;
+	names_size = 0;
+
+	g_autofree gchar *pathl = path_from_utf8(path);
+	mapped = g_mapped_file_new(pathl, FALSE, nullptr);
+	if (!mapped) return;
+
+	const gchar *data = g_mapped_file_get_contents(mapped);
+	const gsize length = g_mapped_file_get_length(mapped);
+	ThumbPackHeader header;
+
+	if (length < sizeof(header)) return;
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, THUMB_PACK_MAGIC, sizeof(header.magic)) != 0 ||
+	    GUINT32_FROM_LE(header.version) != THUMB_PACK_VERSION)
+		{
+		DEBUG_1("%s is not a valid thumbnail pack file", path);
+		return;
+		}
+	valid = true;
+
+	const guint64 index_offset = GUINT64_FROM_LE(header.index_offset);
+	if (index_offset == 0) return;
+
+	ThumbPackIndexHeader index_header;
+	if (index_offset % alignof(ThumbPackIndexEntry) != 0 ||
+	    index_offset > length || length - index_offset < sizeof(index_header))
+		{
+		DEBUG_1("%s has no valid index", path);
+		return;
+		}
+	memcpy(&index_header, data + index_offset, sizeof(index_header));
+
+	const guint64 count = GUINT32_FROM_LE(index_header.entry_count);
+	const guint64 size = GUINT32_FROM_LE(index_header.names_size);
+	const guint64 names_offset = index_offset + sizeof(index_header) + (count * sizeof(ThumbPackIndexEntry));
+
+	if (memcmp(index_header.magic, THUMB_PACK_INDEX_MAGIC, sizeof(index_header.magic)) != 0 ||
+	    names_offset + size > length ||
+	    (size > 0 && data[names_offset + size - 1] != '\0'))
+		{
+		DEBUG_1("%s has no valid index", path);
+		return;
+		}
+
+	entries = reinterpret_cast<const ThumbPackIndexEntry *>(data + index_offset + sizeof(index_header));
+	entry_count = count;
+	names = data + names_offset;
+	names_size = size;
+}
+
+bool ThumbPack::find(const gchar *name, Entry &entry) const
+{
+	if (const auto it = pending.find(name); it != pending.end())
+		{
+		entry = it->second;
+		return true;
+		}
+
+	const auto entry_name = [this](const ThumbPackIndexEntry &e) -> const gchar *
+		{
+		const guint32 name_offset = GUINT32_FROM_LE(e.name_offset);
+		if (name_offset >= names_size) return "";
+		return names + name_offset;
+		};
+
+	const ThumbPackIndexEntry *end = entries + entry_count;
+	const ThumbPackIndexEntry *e = std::lower_bound(entries, end, name, [&entry_name](const ThumbPackIndexEntry &e, const gchar *name)
+		{
+		return strcmp(entry_name(e), name) < 0;
+		});
+
+	if (e == end || strcmp(entry_name(*e), name) != 0) return false;
+
+	entry = entry_from_le(*e);
+
+	return true;
+}
+
+ThumbPack::Entry ThumbPack::entry_from_le(const ThumbPackIndexEntry &e)
+{
+	Entry entry;
+
+	entry.source_mtime = GINT64_FROM_LE(e.source_mtime);
+	entry.source_size = GINT64_FROM_LE(e.source_size);
+	entry.record_offset = GUINT64_FROM_LE(e.record_offset);
+	entry.record_length = GUINT32_FROM_LE(e.record_length);
+
+	return entry;
+}
+
+/**
+ * @brief Get a record from the mapped file
+ * @param name file name the record must belong to
+ * @param entry where to find the record
+ * @param r receives the record header, in host byte order
+ * @returns the pixel data, nullptr if the record is not there or does not match
+ *
+ * The file is mapped again if the record has been appended since it was mapped.
+ */
+const guchar *ThumbPack::record(const gchar *name, const Entry &entry, ThumbPackRecord &r)
+{
+	if (!mapped || entry.record_offset + entry.record_length > g_mapped_file_get_length(mapped)) map();
+	if (!mapped || entry.record_offset + entry.record_length > g_mapped_file_get_length(mapped)) return nullptr;
+	if (entry.record_length < sizeof(r)) return nullptr;
+
+	const auto data = reinterpret_cast<const guchar *>(g_mapped_file_get_contents(mapped)) + entry.record_offset;
+	const gsize name_length = strlen(name);
+
+	memcpy(&r, data, sizeof(r));
+	r.name_length = GUINT32_FROM_LE(r.name_length);
+	r.data_length = GUINT32_FROM_LE(r.data_length);
+	r.source_mtime = GINT64_FROM_LE(r.source_mtime);
+	r.source_size = GINT64_FROM_LE(r.source_size);
+	r.width = GUINT32_FROM_LE(r.width);
+	r.height = GUINT32_FROM_LE(r.height);
+	r.checksum = GUINT32_FROM_LE(r.checksum);
+
+	if (r.name_length != name_length ||
+	    sizeof(r) + r.name_length + static_cast<guint64>(r.data_length) != entry.record_length ||
+	    r.source_mtime != entry.source_mtime || r.source_size != entry.source_size ||
+	    memcmp(data + sizeof(r), name, name_length) != 0)
+		{
+		return nullptr;
+		}
+
+	const guchar *pixels = data + sizeof(r) + name_length;
+	if (thumb_pack_checksum(name, name_length, pixels, r.data_length) != r.checksum)
+		{
+		DEBUG_1("%s: broken thumbnail of %s", path, name);
+		return nullptr;
+		}
+
+	return pixels;
+}
+
+bool ThumbPack::contains(const gchar *name, time_t mtime, off_t size) const
+{
+	Entry entry;
+
+	return find(name, entry) && entry.source_mtime == mtime && entry.source_size == size;
+}
+
+GdkPixbuf *ThumbPack::read(const gchar *name, time_t mtime, off_t size, gboolean &failed)
+{
+	Entry entry;
+
+	failed = FALSE;
+
+	if (!find(name, entry)) return nullptr;
+	if (entry.source_mtime != mtime || entry.source_size != size) return nullptr;
+
+	ThumbPackRecord r;
+	const guchar *pixels = record(name, entry, r);
+	if (!pixels) return nullptr;
+
+	if (r.flags & THUMB_PACK_FAILED)
+		{
+		failed = TRUE;
+		return nullptr;
+		}
+
+	return thumb_pack_decode(pixels, r.data_length, r.width, r.height, r.channels == 4);
+}
+
+void ThumbPack::write(const gchar *name, time_t mtime, off_t size, GdkPixbuf *pixbuf)
+{
+	ThumbPackRecord r{};
+	std::string data;
+
+	if (pixbuf)
+		{
+		data = thumb_pack_encode(pixbuf);
+		r.width = GUINT32_TO_LE(gdk_pixbuf_get_width(pixbuf));
+		r.height = GUINT32_TO_LE(gdk_pixbuf_get_height(pixbuf));
+		r.channels = gdk_pixbuf_get_has_alpha(pixbuf) ? 4 : 3;
+		}
+	else
+		{
+		r.flags = THUMB_PACK_FAILED;
+		}
+
+	const gsize name_length = strlen(name);
+
+	r.name_length = GUINT32_TO_LE(name_length);
+	r.data_length = GUINT32_TO_LE(data.size());
+	r.source_mtime = GINT64_TO_LE(mtime);
+	r.source_size = GINT64_TO_LE(size);
+	r.checksum = GUINT32_TO_LE(thumb_pack_checksum(name, name_length, reinterpret_cast<const guchar *>(data.data()), data.size()));
+
+	std::string buf;
+	buf.reserve(sizeof(r) + name_length + data.size());
+	buf.append(reinterpret_cast<const gchar *>(&r), sizeof(r));
+	buf.append(name, name_length);
+	buf.append(data);
+
+	g_autofree gchar *pathl = path_from_utf8(path);
+	gint fd = open(pathl, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	if (fd < 0) return;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size == 0)
+		{
+		ThumbPackHeader header{};
+		memcpy(header.magic, THUMB_PACK_MAGIC, sizeof(header.magic));
+		header.version = GUINT32_TO_LE(THUMB_PACK_VERSION);
+
+		buf.insert(0, reinterpret_cast<const gchar *>(&header), sizeof(header));
+		}
+
+	/* With O_APPEND the file position is the end of the file after the write */
+	const bool success = ::write(fd, buf.data(), buf.size()) == static_cast<ssize_t>(buf.size());
+	const off_t end = lseek(fd, 0, SEEK_CUR);
+	close(fd);
+
+	if (!success || end < 0)
+		{
+		DEBUG_1("%s: failed to write thumbnail of %s", path, name);
+		return;
+		}
+
+	const gsize record_length = sizeof(r) + name_length + data.size();
+	pending[name] = {mtime, size, static_cast<guint64>(end) - record_length, static_cast<guint32>(record_length)};
+}
+
+std::string ThumbPack::index_block(const std::map<std::string, Entry> &entries)
+{
+	ThumbPackIndexHeader header{};
+	std::string names_buf;
+	std::string block;
+
+	memcpy(header.magic, THUMB_PACK_INDEX_MAGIC, sizeof(header.magic));
+	header.entry_count = GUINT32_TO_LE(entries.size());
+
+	block.reserve(sizeof(header) + (entries.size() * sizeof(ThumbPackIndexEntry)));
+	block.append(reinterpret_cast<const gchar *>(&header), sizeof(header));
+
+	for (const auto &[name, entry] : entries)
+		{
+		ThumbPackIndexEntry e{};
+
+		e.name_offset = GUINT32_TO_LE(names_buf.size());
+		e.name_length = GUINT32_TO_LE(name.size());
+		e.source_mtime = GINT64_TO_LE(entry.source_mtime);
+		e.source_size = GINT64_TO_LE(entry.source_size);
+		e.record_offset = GUINT64_TO_LE(entry.record_offset);
+		e.record_length = GUINT32_TO_LE(entry.record_length);
+
+		names_buf.append(name);
+		names_buf.push_back('\0');
+
+		block.append(reinterpret_cast<const gchar *>(&e), sizeof(e));
+		}
+
+	block.append(names_buf);
+
+	header.names_size = GUINT32_TO_LE(names_buf.size());
+	memcpy(block.data(), &header, sizeof(header));
+
+	return block;
+}
+
+void ThumbPack::append_index(const std::map<std::string, Entry> &entries)
+{
+	g_autofree gchar *pathl = path_from_utf8(path);
+	gint fd = open(pathl, O_WRONLY | O_CLOEXEC);
+	if (fd < 0) return;
+
+	const off_t end = lseek(fd, 0, SEEK_END);
+	const gsize padding = (end < 0) ? 0 : (alignof(ThumbPackIndexEntry) - (end % alignof(ThumbPackIndexEntry))) % alignof(ThumbPackIndexEntry);
+
+	std::string block(padding, '\0');
+	block.append(index_block(entries));
+
+	const guint64 index_offset = GUINT64_TO_LE(end + padding);
+
+	/* The header is only changed after the index is complete */
+	if (end < 0 ||
+	    ::write(fd, block.data(), block.size()) != static_cast<ssize_t>(block.size()) ||
+	    pwrite(fd, &index_offset, sizeof(index_offset), offsetof(ThumbPackHeader, index_offset)) != sizeof(index_offset))
+		{
+		DEBUG_1("%s: failed to write index", path);
+		}
+
+	close(fd);
+}
+
+void ThumbPack::compact(std::map<std::string, Entry> &entries)
+{
+	ThumbPackHeader header{};
+
+	memcpy(header.magic, THUMB_PACK_MAGIC, sizeof(header.magic));
+	header.version = GUINT32_TO_LE(THUMB_PACK_VERSION);
+
+	std::string buf(reinterpret_cast<const gchar *>(&header), sizeof(header));
+
+	for (auto it = entries.begin(); it != entries.end(); )
+		{
+		ThumbPackRecord r;
+		if (!record(it->first.c_str(), it->second, r))
+			{
+			it = entries.erase(it);
+			continue;
+			}
+
+		const gchar *data = g_mapped_file_get_contents(mapped) + it->second.record_offset;
+		it->second.record_offset = buf.size();
+		buf.append(data, it->second.record_length);
+		++it;
+		}
+
+	buf.resize(buf.size() + ((alignof(ThumbPackIndexEntry) - (buf.size() % alignof(ThumbPackIndexEntry))) % alignof(ThumbPackIndexEntry)), '\0');
+
+	header.index_offset = GUINT64_TO_LE(buf.size());
+	memcpy(buf.data(), &header, sizeof(header));
+
+	buf.append(index_block(entries));
+
+	/* Unmap first, the file is replaced */
+	if (mapped) g_mapped_file_unref(mapped);
+	mapped = nullptr;
+
+	g_autofree gchar *pathl = path_from_utf8(path);
+	secure_save(pathl, buf.data(), buf.size());
+}
+
+bool ThumbPack::changed() const
+{
+	return !pending.empty();
+}
+
+void ThumbPack::write_out(bool prune)
+{
+	/* Include what has been appended since the file was mapped */
+	map();
+
+	std::map<std::string, Entry> merged;
+
+	for (guint32 i = 0; i < entry_count; i++)
+		{
+		const guint32 name_offset = GUINT32_FROM_LE(entries[i].name_offset);
+		if (name_offset >= names_size) continue;
+
+		const gchar *name = names + name_offset;
+		if (pending.count(name) > 0) continue;
+		if (prune && !source_exists(name)) continue;
+
+		merged.emplace(name, entry_from_le(entries[i]));
+		}
+
+	merged.merge(pending);
+	pending.clear();
+
+	gsize live_size = sizeof(ThumbPackHeader);
+	for (const auto &[name, entry] : merged)
+		{
+		live_size += entry.record_length;
+		}
+
+	const gsize length = mapped ? g_mapped_file_get_length(mapped) : 0;
+
+	if (!valid || (length > THUMB_PACK_COMPACT_MIN_SIZE && length - live_size > live_size))
+		{
+		DEBUG_1("%s: compacting, %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes in use", path, live_size, length);
+		compact(merged);
+		}
+	else
+		{
+		append_index(merged);
+		}
+
+	map();
+}
+
+/* Guarded by the mutex of the store for the threads that load thumbnails */
+CacheStore thumb_packs([](const gchar *path, const gchar *source_dir) -> CacheStoreFile *
+	{
+	return new ThumbPack(path, source_dir);
+	}, THUMB_PACK_FLUSH_DELAY);
+
+const gchar *thumb_pack_name(ThumbPackSize pack_size)
+{
+	return (pack_size == ThumbPackSize::LARGE) ? GQ_CACHE_THUMB_PACK_LARGE : GQ_CACHE_THUMB_PACK_NORMAL;
+}
+
+ThumbPack *thumb_pack_get(const gchar *source, ThumbPackSize pack_size, gboolean create)
+{
+	return static_cast<ThumbPack *>(thumb_packs.get(source, thumb_pack_name(pack_size), create));
+}
+
+} // namespace
+
+/**
+ * @brief Get a thumbnail from the pack of the source folder
+ * @param source file name of the image
+ * @param mtime modification time of the source
+ * @param size size of the source
+ * @param pack_size size class of the thumbnail
+ * @param failed set to TRUE if a failure to load the source is recorded
+ * @returns a new pixbuf, nullptr if there is no valid thumbnail
+ */
+GdkPixbuf *thumb_pack_read(const gchar *source, time_t mtime, off_t size, ThumbPackSize pack_size, gboolean &failed)
+{
+	GdkPixbuf *pixbuf = nullptr;
+
+	failed = FALSE;
+
+	g_mutex_lock(&thumb_packs.mutex);
+	ThumbPack *pack = thumb_pack_get(source, pack_size, FALSE);
+	if (pack) pixbuf = pack->read(filename_from_path(source), mtime, size, failed);
+	g_mutex_unlock(&thumb_packs.mutex);
+
+	return pixbuf;
+}
+
+/**
+ * @brief Check the index of the pack of the source folder for a thumbnail
+ * @returns TRUE if the pack has a thumbnail or a failure for this version of the source
+ *
+ * The thumbnail itself is not read, so it may still turn out to be broken.
+ */
+gboolean thumb_pack_contains(const gchar *source, time_t mtime, off_t size, ThumbPackSize pack_size)
+{
+	gboolean found = FALSE;
+
+	g_mutex_lock(&thumb_packs.mutex);
+	ThumbPack *pack = thumb_pack_get(source, pack_size, FALSE);
+	if (pack) found = pack->contains(filename_from_path(source), mtime, size);
+	g_mutex_unlock(&thumb_packs.mutex);
+
+	return found;
+}
+
+/**
+ * @brief Add a thumbnail to the pack of the source folder
+ * @param pixbuf the thumbnail, nullptr to record that the source could not be loaded
+ */
+void thumb_pack_write(const gchar *source, time_t mtime, off_t size, ThumbPackSize pack_size, GdkPixbuf *pixbuf)
+{
+	g_mutex_lock(&thumb_packs.mutex);
+	ThumbPack *pack = thumb_pack_get(source, pack_size, TRUE);
+	if (pack)
+		{
+		DEBUG_1("thumb pack saving: %s", source);
+		pack->write(filename_from_path(source), mtime, size, pixbuf);
+		thumb_packs.changed();
+		}
+	g_mutex_unlock(&thumb_packs.mutex);
+}
+
+/**
+ * @brief Copy the thumbnails of a moved file to the pack of its new folder
+ *
+ * The entries in the old pack are dropped when that pack is next pruned.
+ */
+void thumb_pack_moved(const gchar *source, const gchar *dest)
+{
+	struct stat st;
+	if (!stat_utf8(dest, &st)) return;
+
+	for (const ThumbPackSize pack_size : {ThumbPackSize::NORMAL, ThumbPackSize::LARGE})
+		{
+		gboolean failed;
+		g_autoptr(GdkPixbuf) pixbuf = thumb_pack_read(source, st.st_mtime, st.st_size, pack_size, failed);
+
+		if (pixbuf || failed) thumb_pack_write(dest, st.st_mtime, st.st_size, pack_size, pixbuf);
+		}
+}
+
+/**
+ * @brief Write the indexes of all changed packs, and close all packs
+ */
+void thumb_pack_flush()
+{
+	thumb_packs.close();
+}
+
+/**
+ * @brief Compress the pixels of a thumbnail
+ * @param pixbuf 8 bit RGB or RGBA
+ * @returns the compressed pixels
+ */
+std::string thumb_pack_encode(const GdkPixbuf *pixbuf)
+{
+	const gint width = gdk_pixbuf_get_width(pixbuf);
+	const gint height = gdk_pixbuf_get_height(pixbuf);
+	const gint rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+	const gint channels = gdk_pixbuf_get_n_channels(pixbuf);
+	const gboolean has_alpha = gdk_pixbuf_get_has_alpha(pixbuf);
+	const guchar *pixels = gdk_pixbuf_read_pixels(pixbuf);
+
+	std::string out;
+	std::array<QoiPixel, 64> index{};
+	QoiPixel prev{0, 0, 0, 255};
+	gint run = 0;
+
+	out.reserve(static_cast<gsize>(width) * height * 2);
+
+	for (gint y = 0; y < height; y++)
+		{
+		const guchar *p = pixels + (static_cast<gsize>(y) * rowstride);
+
+		for (gint x = 0; x < width; x++, p += channels)
+			{
+			const QoiPixel px{p[0], p[1], p[2], has_alpha ? p[3] : static_cast<guchar>(255)};
+
+			if (px == prev)
+				{
+				run++;
+				if (run == QOI_MAX_RUN)
+					{
+					out.push_back(QOI_OP_RUN | (run - 1));
+					run = 0;
+					}
+				continue;
+				}
+
+			if (run > 0)
+				{
+				out.push_back(QOI_OP_RUN | (run - 1));
+				run = 0;
+				}
+
+			const gint pos = px.hash();
+			if (index[pos] == px)
+				{
+				out.push_back(QOI_OP_INDEX | pos);
+				}
+			else
+				{
+				index[pos] = px;
+
+				if (px.a == prev.a)
+					{
+					const gint dr = static_cast<gint8>(px.r - prev.r);
+					const gint dg = static_cast<gint8>(px.g - prev.g);
+					const gint db = static_cast<gint8>(px.b - prev.b);
+					const gint dr_dg = dr - dg;
+					const gint db_dg = db - dg;
+
+					if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+						{
+						out.push_back(QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+						}
+					else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+						{
+						out.push_back(QOI_OP_LUMA | (dg + 32));
+						out.push_back(((dr_dg + 8) << 4) | (db_dg + 8));
+						}
+					else
+						{
+						out.push_back(QOI_OP_RGB);
+						out.append({static_cast<gchar>(px.r), static_cast<gchar>(px.g), static_cast<gchar>(px.b)});
+						}
+					}
+				else
+					{
+					out.push_back(QOI_OP_RGBA);
+					out.append({static_cast<gchar>(px.r), static_cast<gchar>(px.g), static_cast<gchar>(px.b), static_cast<gchar>(px.a)});
+					}
+				}
+
+			prev = px;
+			}
+		}
+
+	if (run > 0) out.push_back(QOI_OP_RUN | (run - 1));
+
+	return out;
+}
+
+/**
+ * @brief Decompress the pixels of a thumbnail
+ * @returns a new pixbuf, nullptr if the data is broken
+ */
+GdkPixbuf *thumb_pack_decode(const guchar *data, gsize length, gint width, gint height, gboolean has_alpha)
+{
+	if (width <= 0 || height <= 0) return nullptr;
+
+	GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, has_alpha, 8, width, height);
+	if (!pixbuf) return nullptr;
+
+	const gint rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+	const gint channels = gdk_pixbuf_get_n_channels(pixbuf);
+	guchar *pixels = gdk_pixbuf_get_pixels(pixbuf);
+
+	std::array<QoiPixel, 64> index{};
+	QoiPixel px{0, 0, 0, 255};
+	gint run = 0;
+	gsize pos = 0;
+
+	for (gint y = 0; y < height; y++)
+		{
+		guchar *p = pixels + (static_cast<gsize>(y) * rowstride);
+
+		for (gint x = 0; x < width; x++, p += channels)
+			{
+			if (run > 0)
+				{
+				run--;
+				}
+			else if (!qoi_decode_op(data, length, pos, px, index, run))
+				{
+				DEBUG_1("thumbnail pack: truncated pixel data");
+				g_object_unref(pixbuf);
+				return nullptr;
+				}
+
+			p[0] = px.r;
+			p[1] = px.g;
+			p[2] = px.b;
+			if (has_alpha) p[3] = px.a;
+			}
+		}
+
+	if (run > 0 || pos != length)
+		{
+		DEBUG_1("thumbnail pack: pixel data does not match the size");
+		g_object_unref(pixbuf);
+		return nullptr;
+		}
+
+	return pixbuf;
+}
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
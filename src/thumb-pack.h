@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef THUMB_PACK_H
+#define THUMB_PACK_H
+
+#include <sys/types.h>
+
+#include <ctime>
+#include <string>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib.h>
+
+/**
+ * @brief Thumbnail size classes of the pack store, as in the freedesktop.org standard
+ */
+enum class ThumbPackSize {
+	NORMAL,	/**< up to 128 x 128 */
+	LARGE	/**< up to 256 x 256 */
+};
+
+gboolean thumb_pack_contains(const gchar *source, time_t mtime, off_t size, ThumbPackSize pack_size);
+GdkPixbuf *thumb_pack_read(const gchar *source, time_t mtime, off_t size, ThumbPackSize pack_size, gboolean &failed);
+void thumb_pack_write(const gchar *source, time_t mtime, off_t size, ThumbPackSize pack_size, GdkPixbuf *pixbuf);
+void thumb_pack_moved(const gchar *source, const gchar *dest);
+void thumb_pack_flush();
+
+std::string thumb_pack_encode(const GdkPixbuf *pixbuf);
+GdkPixbuf *thumb_pack_decode(const guchar *data, gsize length, gint width, gint height, gboolean has_alpha);
+
+#endif /* THUMB_PACK_H */
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -23,6 +23,7 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
@@ -39,8 +40,11 @@
 #include "image-load.h"
 #include "md5-util.h"
 #include "metadata.h"
+#include "misc.h"
 #include "options.h"
 #include "pixbuf-util.h"
+#include "thumb-index.h"
+#include "thumb-pack.h"
 #include "ui-fileops.h"
 
 struct ExifData;
@@ -118,6 +122,12 @@ void thumb_loader_std_set_callbacks(ThumbLoaderStd *tl,
 
 static void thumb_loader_std_reset(ThumbLoaderStd *tl)
 {
+	g_clear_handle_id(&tl->idle_done_id, g_source_remove);
+
+	/* a running store completes without the loader */
+	if (tl->store_job) tl->store_job->tl = nullptr;
+	tl->store_job = nullptr;
+
 	image_loader_free(tl->il);
 	tl->il = nullptr;
 
@@ -132,6 +142,7 @@ static void thumb_loader_std_reset(ThumbLoaderStd *tl)
 	tl->local_uri = nullptr;
 
 	tl->thumb_path_local = FALSE;
+	tl->thumb_path_indexed = FALSE;
 
 	tl->cache_hit = FALSE;
 
@@ -162,9 +173,17 @@ static gchar *thumb_std_cache_path(const gchar *path, const gchar *uri, gboolean
 	return g_build_filename(get_thumbnails_standard_cache_dir(), cache_subfolder, name, NULL);
 }
 
+static const gchar *thumb_std_cache_folder(gint w, gint h, gboolean fail)
+{
+	if (fail) return THUMB_FOLDER_FAIL;
+
+	if (w > THUMB_SIZE_NORMAL || h > THUMB_SIZE_NORMAL) return THUMB_FOLDER_LARGE;
+
+	return THUMB_FOLDER_NORMAL;
+}
+
 static gchar *thumb_loader_std_cache_path(ThumbLoaderStd *tl, gboolean local, GdkPixbuf *pixbuf, gboolean fail)
 {
-	const gchar *folder;
 	gint w;
 	gint h;
 
@@ -181,22 +200,24 @@ static gchar *thumb_loader_std_cache_path(ThumbLoaderStd *tl, gboolean local, Gd
 		h = tl->requested_height;
 		}
 
-	if (fail)
-		{
-		folder = THUMB_FOLDER_FAIL;
-		}
-	else if (w > THUMB_SIZE_NORMAL || h > THUMB_SIZE_NORMAL)
-		{
-		folder = THUMB_FOLDER_LARGE;
-		}
-	else
+	return thumb_std_cache_path(tl->fd->path,
+				    (local) ?  tl->local_uri : tl->thumb_uri,
+				    local, thumb_std_cache_folder(w, h, fail));
+}
+
+static ThumbPackSize thumb_loader_std_pack_size(ThumbLoaderStd *tl)
+{
+	if (tl->requested_width > THUMB_SIZE_NORMAL || tl->requested_height > THUMB_SIZE_NORMAL)
 		{
-		folder = THUMB_FOLDER_NORMAL;
+		return ThumbPackSize::LARGE;
 		}
 
-	return thumb_std_cache_path(tl->fd->path,
-				    (local) ?  tl->local_uri : tl->thumb_uri,
-				    local, folder);
+	return ThumbPackSize::NORMAL;
+}
+
+static guint32 thumb_std_index_status(gint width, gint height)
+{
+	return (width > THUMB_SIZE_NORMAL || height > THUMB_SIZE_NORMAL) ? THUMB_INDEX_LARGE : THUMB_INDEX_NORMAL;
 }
 
 static gboolean thumb_loader_std_fail_check(ThumbLoaderStd *tl)
@@ -228,7 +249,15 @@ static gboolean thumb_loader_std_fail_check(ThumbLoaderStd *tl)
 		g_object_unref(G_OBJECT(pixbuf));
 		}
 
-	if (!result) unlink_file(fail_path);
+	if (result)
+		{
+		thumb_index_update(tl->fd->path, tl->source_mtime, tl->source_size, THUMB_INDEX_FAILED, 0);
+		}
+	else
+		{
+		unlink_file(fail_path);
+		thumb_index_update(tl->fd->path, tl->source_mtime, tl->source_size, 0, THUMB_INDEX_FAILED);
+		}
 
 	return result;
 }
@@ -264,6 +293,64 @@ static gboolean thumb_loader_std_validate(ThumbLoaderStd *tl, GdkPixbuf *pixbuf)
 	return TRUE;
 }
 
+/**
+ * @brief Writes a thumbnail file, using a temp file then renaming into place
+ * @param source path of the source file, for the folder of a local thumbnail
+ *
+ * It only uses its arguments, so it can run in any thread.
+ */
+static gboolean thumb_std_save_file(const gchar *thumb_path, GdkPixbuf *pixbuf, const gchar *source, const gchar *mark_uri,
+                                    time_t source_mtime, mode_t source_mode, gboolean local)
+{
+	/* create thumbnail dir if needed */
+	g_autofree gchar *base_path = remove_level_from_path(thumb_path);
+	if (local)
+		{
+		if (!isdir(base_path))
+			{
+			g_autofree gchar *source_base = remove_level_from_path(source);
+			struct stat st;
+
+			if (stat_utf8(source_base, &st))
+				{
+				recursive_mkdir_if_not_exists(base_path, st.st_mode);
+				}
+			}
+		}
+	else
+		{
+		recursive_mkdir_if_not_exists(base_path, S_IRWXU);
+		}
+
+	DEBUG_1("thumb saving: %s", source);
+	DEBUG_1("       saved: %s", thumb_path);
+
+	g_autofree gchar *tmp_path = unique_filename(thumb_path, ".tmp", "_", 2);
+	if (!tmp_path) return FALSE;
+
+	g_autofree gchar *mark_app = g_strdup_printf("%s %s", GQ_APPNAME, VERSION);
+	const std::string mark_mtime = std::to_string(static_cast<unsigned long long>(source_mtime));
+	g_autofree gchar *pathl = path_from_utf8(tmp_path);
+	gboolean success = gdk_pixbuf_save(pixbuf, pathl, "png", nullptr,
+	                                   THUMB_MARKER_URI, mark_uri,
+	                                   THUMB_MARKER_MTIME, mark_mtime.c_str(),
+	                                   THUMB_MARKER_APP, mark_app,
+	                                   NULL);
+	if (success)
+		{
+		chmod(pathl, local ? source_mode : S_IRUSR | S_IWUSR);
+		success = rename_file(tmp_path, thumb_path);
+		}
+
+	if (!success)
+		{
+		DEBUG_1("thumb save failed: %s", source);
+		DEBUG_1("            thumb: %s", thumb_path);
+		}
+
+	return success;
+}
+
 static void thumb_loader_std_save(ThumbLoaderStd *tl, GdkPixbuf *pixbuf)
 {
 	gboolean fail;
@@ -293,62 +380,38 @@ static void thumb_loader_std_save(ThumbLoaderStd *tl, GdkPixbuf *pixbuf)
 		}
 	tl->thumb_path_local = tl->cache_local;
 
-	/* create thumbnail dir if needed */
-	g_autofree gchar *base_path = remove_level_from_path(tl->thumb_path);
-	if (tl->cache_local)
-		{
-		if (!isdir(base_path))
-			{
-			g_autofree gchar *source_base = remove_level_from_path(tl->fd->path);
-			struct stat st;
-
-			if (stat_utf8(source_base, &st))
-				{
-				recursive_mkdir_if_not_exists(base_path, st.st_mode);
-				}
-			}
-		}
-	else
-		{
-		recursive_mkdir_if_not_exists(base_path, S_IRWXU);
-		}
-
-	DEBUG_1("thumb saving: %s", tl->fd->path);
-	DEBUG_1("       saved: %s", tl->thumb_path);
+	const gchar *mark_uri = (tl->cache_local) ? tl->local_uri :tl->thumb_uri;
 
-	/* save thumb, using a temp file then renaming into place */
-	g_autofree gchar *tmp_path = unique_filename(tl->thumb_path, ".tmp", "_", 2);
-	if (tmp_path)
+	if (thumb_std_save_file(tl->thumb_path, pixbuf, tl->fd->path, mark_uri, tl->source_mtime, tl->source_mode, tl->cache_local) &&
+	    !tl->cache_local)
 		{
-		const gchar *mark_uri;
-		gboolean success;
-
-		mark_uri = (tl->cache_local) ? tl->local_uri :tl->thumb_uri;
-
-		g_autofree gchar *mark_app = g_strdup_printf("%s %s", GQ_APPNAME, VERSION);
-		const std::string mark_mtime = std::to_string(static_cast<unsigned long long>(tl->source_mtime));
-		g_autofree gchar *pathl = path_from_utf8(tmp_path);
-		success = gdk_pixbuf_save(pixbuf, pathl, "png", nullptr,
-		                          THUMB_MARKER_URI, mark_uri,
-		                          THUMB_MARKER_MTIME, mark_mtime.c_str(),
-		                          THUMB_MARKER_APP, mark_app,
-		                          NULL);
-		if (success)
+		if (fail)
 			{
-			chmod(pathl, (tl->cache_local) ? tl->source_mode : S_IRUSR | S_IWUSR);
-			success = rename_file(tmp_path, tl->thumb_path);
+			thumb_index_update(tl->fd->path, tl->source_mtime, tl->source_size, THUMB_INDEX_FAILED, 0);
 			}
-
-		if (!success)
+		else
 			{
-			DEBUG_1("thumb save failed: %s", tl->fd->path);
-			DEBUG_1("            thumb: %s", tl->thumb_path);
+			thumb_index_update(tl->fd->path, tl->source_mtime, tl->source_size,
+			                   thumb_std_index_status(gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf)),
+			                   THUMB_INDEX_FAILED);
 			}
 		}
 
 	g_object_unref(G_OBJECT(pixbuf));
 }
 
+/* The pack store replaces the thumbnail files, unless these are wanted as well */
+static void thumb_loader_std_store(ThumbLoaderStd *tl, GdkPixbuf *pixbuf)
+{
+	if (options->thumbnails.pack_store && tl->cache_enable && !tl->cache_hit)
+		{
+		thumb_pack_write(tl->fd->path, tl->source_mtime, tl->source_size, thumb_loader_std_pack_size(tl), pixbuf);
+		if (!options->thumbnails.pack_export_standard) return;
+		}
+
+	thumb_loader_std_save(tl, pixbuf);
+}
+
 static void thumb_loader_std_set_fallback(ThumbLoaderStd *tl)
 {
 	if (tl->fd->thumb_pixbuf) g_object_unref(tl->fd->thumb_pixbuf);
@@ -389,6 +452,41 @@ void thumb_loader_std_calibrate_pixbuf(FileData *fd, GdkPixbuf *pixbuf)
 		}
 }
 
+/**
+ * @brief The orientation to apply to a new thumbnail
+ */
+static gint thumb_loader_std_orientation(ThumbLoaderStd *tl)
+{
+	if (!options->image.exif_rotate_enable) return EXIF_ORIENTATION_TOP_LEFT;
+
+	if (!tl->fd->exif_orientation)
+		{
+		if (tl->fd->supports_exif_orientation())
+			{
+			tl->fd->exif_orientation = metadata_read_int(tl->fd, ORIENTATION_KEY, EXIF_ORIENTATION_TOP_LEFT);
+			}
+		else
+			{
+			tl->fd->exif_orientation = EXIF_ORIENTATION_TOP_LEFT;
+			}
+		}
+
+	return tl->fd->exif_orientation;
+}
+
+/**
+ * @brief The width and height of the thumbnails stored in the cache
+ */
+static gint thumb_loader_std_cache_size(ThumbLoaderStd *tl)
+{
+	if (tl->requested_width > THUMB_SIZE_NORMAL || tl->requested_height > THUMB_SIZE_NORMAL)
+		{
+		return THUMB_SIZE_LARGE;
+		}
+
+	return THUMB_SIZE_NORMAL;
+}
+
 static GdkPixbuf *thumb_loader_std_finish(ThumbLoaderStd *tl, GdkPixbuf *pixbuf, gboolean shrunk)
 {
 	GdkPixbuf *pixbuf_thumb = nullptr;
@@ -398,23 +496,13 @@ static GdkPixbuf *thumb_loader_std_finish(ThumbLoaderStd *tl, GdkPixbuf *pixbuf,
 	gint sh;
 
 
-	if (!tl->cache_hit && options->image.exif_rotate_enable)
+	if (!tl->cache_hit)
 		{
-		if (!tl->fd->exif_orientation)
-			{
-			if (tl->fd->supports_exif_orientation())
-				{
-				tl->fd->exif_orientation = metadata_read_int(tl->fd, ORIENTATION_KEY, EXIF_ORIENTATION_TOP_LEFT);
-				}
-			else
-				{
-				tl->fd->exif_orientation = EXIF_ORIENTATION_TOP_LEFT;
-				}
-			}
+		const gint orientation = thumb_loader_std_orientation(tl);
 
-		if (tl->fd->exif_orientation != EXIF_ORIENTATION_TOP_LEFT)
+		if (orientation != EXIF_ORIENTATION_TOP_LEFT)
 			{
-			rotated = pixbuf_apply_orientation(pixbuf, tl->fd->exif_orientation);
+			rotated = pixbuf_apply_orientation(pixbuf, orientation);
 			pixbuf = rotated;
 			}
 		}
@@ -426,17 +514,8 @@ static GdkPixbuf *thumb_loader_std_finish(ThumbLoaderStd *tl, GdkPixbuf *pixbuf,
 		{
 		if (!tl->cache_hit)
 			{
-			gint cache_w;
-			gint cache_h;
-
-			if (tl->requested_width > THUMB_SIZE_NORMAL || tl->requested_height > THUMB_SIZE_NORMAL)
-				{
-				cache_w = cache_h = THUMB_SIZE_LARGE;
-				}
-			else
-				{
-				cache_w = cache_h = THUMB_SIZE_NORMAL;
-				}
+			const gint cache_w = thumb_loader_std_cache_size(tl);
+			const gint cache_h = cache_w;
 
 			if (sw > cache_w || sh > cache_h || shrunk)
 				{
@@ -461,11 +540,11 @@ static GdkPixbuf *thumb_loader_std_finish(ThumbLoaderStd *tl, GdkPixbuf *pixbuf,
 				    tl->source_mtime == st.st_mtime &&
 				    tl->source_size == st.st_size)
 					{
-					thumb_loader_std_save(tl, pixbuf_thumb);
+					thumb_loader_std_store(tl, pixbuf_thumb);
 					}
 				}
 			}
-		else if (tl->cache_local && !tl->thumb_path_local)
+		else if (tl->cache_local && tl->thumb_path && !tl->thumb_path_local)
 			{
 			/* A local cache save was requested, but a valid thumb is in $HOME,
 			 * so specifically save as a local thumbnail.
@@ -479,6 +558,11 @@ static GdkPixbuf *thumb_loader_std_finish(ThumbLoaderStd *tl, GdkPixbuf *pixbuf,
 
 			thumb_loader_std_save(tl, pixbuf);
 			}
+		else if (options->thumbnails.pack_store && tl->thumb_path)
+			{
+			/* Add thumbnails found as files to the pack, it is searched first next time */
+			thumb_pack_write(tl->fd->path, tl->source_mtime, tl->source_size, thumb_loader_std_pack_size(tl), pixbuf);
+			}
 		}
 
 	if (sw <= tl->requested_width && sh <= tl->requested_height)
@@ -518,6 +602,144 @@ static GdkPixbuf *thumb_loader_std_finish(ThumbLoaderStd *tl, GdkPixbuf *pixbuf,
 	return result;
 }
 
+/**
+ * @brief A new thumbnail, rotated, scaled and stored by a worker thread
+ */
+struct ThumbStoreJob
+{
+	ThumbLoaderStd *tl; /**< nullptr once the loader has been reset */
+	GdkPixbuf *pixbuf;  /**< as decoded */
+	gboolean shrunk;
+	gint orientation;
+	gint cache_size;
+	ThumbPackSize pack_size;
+	gchar *source;
+	gchar *mark_uri; /**< nullptr if no thumbnail file is written for the source */
+	time_t source_mtime;
+	off_t source_size;
+	mode_t source_mode;
+	gboolean local;
+	guint32 index_status; /**< Set by the worker when a thumbnail file was written */
+};
+
+static void thumb_std_store_job_free(ThumbStoreJob *job)
+{
+	g_object_unref(job->pixbuf);
+	g_free(job->source);
+	g_free(job->mark_uri);
+	g_free(job);
+}
+
+static gboolean thumb_std_store_done_cb(gpointer data)
+{
+	auto *job = static_cast<ThumbStoreJob *>(data);
+	ThumbLoaderStd *tl = job->tl;
+
+	/* the validation index is not thread safe */
+	if (job->index_status && !job->local)
+		{
+		thumb_index_update(job->source, job->source_mtime, job->source_size, job->index_status, THUMB_INDEX_FAILED);
+		}
+
+	thumb_std_store_job_free(job);
+
+	if (tl)
+		{
+		tl->store_job = nullptr;
+		if (tl->func_done) tl->func_done(tl, tl->data);
+		}
+
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief Does the work of thumb_loader_std_finish() and thumb_loader_std_store() for a new thumbnail
+ */
+static void thumb_std_store_func(gpointer data, gpointer)
+{
+	auto *job = static_cast<ThumbStoreJob *>(data);
+	GdkPixbuf *pixbuf = job->pixbuf;
+	g_autoptr(GdkPixbuf) rotated = nullptr;
+
+	if (job->orientation != EXIF_ORIENTATION_TOP_LEFT)
+		{
+		rotated = pixbuf_apply_orientation(pixbuf, job->orientation);
+		pixbuf = rotated;
+		}
+
+	const gint sw = gdk_pixbuf_get_width(pixbuf);
+	const gint sh = gdk_pixbuf_get_height(pixbuf);
+	struct stat st;
+
+	/* do not save the thumbnail if the source file has changed meanwhile */
+	if ((sw > job->cache_size || sh > job->cache_size || job->shrunk) &&
+	    stat_utf8(job->source, &st) &&
+	    job->source_mtime == st.st_mtime &&
+	    job->source_size == st.st_size)
+		{
+		g_autoptr(GdkPixbuf) pixbuf_thumb = nullptr;
+		gint thumb_w;
+		gint thumb_h;
+
+		if (pixbuf_scale_aspect(job->cache_size, job->cache_size, sw, sh, thumb_w, thumb_h))
+			{
+			pixbuf_thumb = gdk_pixbuf_scale_simple(pixbuf, thumb_w, thumb_h, options->thumbnails.quality);
+			}
+		else
+			{
+			pixbuf_thumb = g_object_ref(pixbuf);
+			thumb_w = sw;
+			thumb_h = sh;
+			}
+
+		if (options->thumbnails.pack_store)
+			{
+			thumb_pack_write(job->source, job->source_mtime, job->source_size, job->pack_size, pixbuf_thumb);
+			}
+
+		if (!options->thumbnails.pack_store || options->thumbnails.pack_export_standard)
+			{
+			g_autofree gchar *thumb_path = thumb_std_cache_path(job->source, job->mark_uri, job->local,
+			                                                    thumb_std_cache_folder(thumb_w, thumb_h, FALSE));
+
+			if (thumb_path && thumb_std_save_file(thumb_path, pixbuf_thumb, job->source, job->mark_uri,
+			                                      job->source_mtime, job->source_mode, job->local))
+				{
+				job->index_status = thumb_std_index_status(thumb_w, thumb_h);
+				}
+			}
+		}
+
+	g_idle_add(thumb_std_store_done_cb, job);
+}
+
+/**
+ * @brief Hands a new thumbnail to the store workers, func_done is called when it is stored
+ */
+static void thumb_loader_std_store_async(ThumbLoaderStd *tl, GdkPixbuf *pixbuf, gboolean shrunk)
+{
+	static GThreadPool *store_pool = g_thread_pool_new(thumb_std_store_func, nullptr,
+	                                                   std::max(get_cpu_cores(), 1), FALSE, nullptr);
+
+	auto *job = g_new0(ThumbStoreJob, 1);
+
+	job->tl = tl;
+	job->pixbuf = g_object_ref(pixbuf);
+	job->shrunk = shrunk;
+	job->orientation = thumb_loader_std_orientation(tl);
+	job->cache_size = thumb_loader_std_cache_size(tl);
+	job->pack_size = thumb_loader_std_pack_size(tl);
+	job->source = g_strdup(tl->fd->path);
+	job->mark_uri = g_strdup(tl->cache_local ? tl->local_uri : tl->thumb_uri);
+	job->source_mtime = tl->source_mtime;
+	job->source_size = tl->source_size;
+	job->source_mode = tl->source_mode;
+	job->local = tl->cache_local;
+
+	tl->store_job = job;
+	g_thread_pool_push(store_pool, job, nullptr);
+}
+
 static gboolean thumb_loader_std_next_source(ThumbLoaderStd *tl, gboolean remove_broken)
 {
 	image_loader_free(tl->il);
@@ -529,10 +751,13 @@ static gboolean thumb_loader_std_next_source(ThumbLoaderStd *tl, gboolean remove
 			{
 			DEBUG_1("thumb broken, unlinking: %s", tl->thumb_path);
 			unlink_file(tl->thumb_path);
+			thumb_index_update(tl->fd->path, tl->source_mtime, tl->source_size,
+			                   0, thumb_std_index_status(tl->requested_width, tl->requested_height));
 			}
 
 		g_free(tl->thumb_path);
 		tl->thumb_path = nullptr;
+		tl->thumb_path_indexed = FALSE;
 
 		if (!tl->thumb_path_local)
 			{
@@ -556,7 +781,7 @@ static gboolean thumb_loader_std_next_source(ThumbLoaderStd *tl, gboolean remove
 		if (thumb_loader_std_setup(tl, tl->fd)) return TRUE;
 		}
 
-	thumb_loader_std_save(tl, nullptr);
+	thumb_loader_std_store(tl, nullptr);
 	return FALSE;
 }
 
@@ -576,7 +801,8 @@ static void thumb_loader_std_done_cb(ImageLoader *il, gpointer data)
 		return;
 		}
 
-	if (tl->thumb_path && !thumb_loader_std_validate(tl, pixbuf))
+	/* A thumbnail listed in the index was validated when it was listed */
+	if (tl->thumb_path && !tl->thumb_path_indexed && !thumb_loader_std_validate(tl, pixbuf))
 		{
 		if (thumb_loader_std_next_source(tl, TRUE)) return;
 
@@ -586,6 +812,18 @@ static void thumb_loader_std_done_cb(ImageLoader *il, gpointer data)
 
 	tl->cache_hit = (tl->thumb_path != nullptr);
 
+	if (tl->cache_hit && !tl->thumb_path_local && !tl->thumb_path_indexed)
+		{
+		thumb_index_update(tl->fd->path, tl->source_mtime, tl->source_size,
+		                   thumb_std_index_status(tl->requested_width, tl->requested_height), 0);
+		}
+
+	if (tl->store_only && tl->fd && tl->cache_enable && !tl->cache_hit)
+		{
+		thumb_loader_std_store_async(tl, pixbuf, image_loader_get_shrunk(il));
+		return;
+		}
+
 	if (tl->fd)
 		{
 		if (tl->fd->thumb_pixbuf) g_object_unref(tl->fd->thumb_pixbuf);
@@ -658,6 +896,17 @@ static gboolean thumb_loader_std_setup(ThumbLoaderStd *tl, FileData *fd)
 	return FALSE;
 }
 
+static gboolean thumb_loader_std_done_idle_cb(gpointer data)
+{
+	auto tl = static_cast<ThumbLoaderStd *>(data);
+
+	tl->idle_done_id = 0;
+
+	if (tl->func_done) tl->func_done(tl, tl->data);
+
+	return G_SOURCE_REMOVE;
+}
+
 /*
  * Note: Currently local_cache only specifies where to save a _new_ thumb, if
  *       a valid existing thumb is found anywhere the local thumb will not be created.
@@ -671,6 +920,19 @@ void thumb_loader_std_set_cache(ThumbLoaderStd *tl, gboolean enable_cache, gbool
 	tl->cache_retry = retry_failed;
 }
 
+/**
+ * @brief Only create the thumbnails missing from the cache, for the cache maintenance
+ *
+ * A new thumbnail is rotated, scaled and written out by a worker thread, next
+ * to the image loader threads, and fd->thumb_pixbuf is not set for it.
+ */
+void thumb_loader_std_set_store_only(ThumbLoaderStd *tl)
+{
+	if (!tl) return;
+
+	tl->store_only = TRUE;
+}
+
 gboolean thumb_loader_std_start(ThumbLoaderStd *tl, FileData *fd)
 {
 	struct stat st;
@@ -699,14 +961,51 @@ gboolean thumb_loader_std_start(ThumbLoaderStd *tl, FileData *fd)
 		tl->local_uri = filename_from_path(tl->thumb_uri);
 		}
 
+	if (tl->cache_enable && options->thumbnails.pack_store)
+		{
+		gboolean failed;
+		GdkPixbuf *pixbuf = thumb_pack_read(tl->fd->path, tl->source_mtime, tl->source_size, thumb_loader_std_pack_size(tl), failed);
+
+		if (pixbuf)
+			{
+			DEBUG_1("thumb pack hit: %s", tl->fd->path);
+
+			tl->cache_hit = TRUE;
+			if (tl->fd->thumb_pixbuf) g_object_unref(tl->fd->thumb_pixbuf);
+			tl->fd->thumb_pixbuf = thumb_loader_std_finish(tl, pixbuf, FALSE);
+			g_object_unref(pixbuf);
+
+			/* Callers do not expect the done callback before this returns */
+			tl->idle_done_id = g_idle_add(thumb_loader_std_done_idle_cb, tl);
+			return TRUE;
+			}
+
+		if (failed && !tl->cache_retry)
+			{
+			DEBUG_1("thumb pack fail valid: %s", tl->fd->path);
+			thumb_loader_std_set_fallback(tl);
+			return FALSE;
+			}
+		}
+
 	if (tl->cache_enable)
 		{
+		const guint32 indexed = thumb_index_lookup(tl->fd->path, tl->source_mtime, tl->source_size);
 		gint found;
 
+		if ((indexed & THUMB_INDEX_FAILED) && !tl->cache_retry)
+			{
+			DEBUG_1("thumb index fail valid: %s", tl->fd->path);
+			thumb_loader_std_set_fallback(tl);
+			return FALSE;
+			}
+
 		tl->thumb_path = thumb_loader_std_cache_path(tl, FALSE, nullptr, FALSE);
 		tl->thumb_path_local = FALSE;
+		tl->thumb_path_indexed = (indexed & thumb_std_index_status(tl->requested_width, tl->requested_height)) != 0;
 
-		found = isfile(tl->thumb_path);
+		/* If the thumbnail is known to be valid, its existence is not checked first */
+		found = tl->thumb_path_indexed || isfile(tl->thumb_path);
 		if (found)
 			{
 			FileData *fd = file_data_new_no_grouping(tl->thumb_path);
@@ -729,7 +1028,7 @@ gboolean thumb_loader_std_start(ThumbLoaderStd *tl, FileData *fd)
 
 	if (!thumb_loader_std_setup(tl, tl->fd))
 		{
-		thumb_loader_std_save(tl, nullptr);
+		thumb_loader_std_store(tl, nullptr);
 		thumb_loader_std_set_fallback(tl);
 		return FALSE;
 		}
@@ -926,6 +1225,49 @@ static void thumb_std_maint_remove_one(const gchar *source, const gchar *uri, gb
 		}
 }
 
+/**
+ * @brief Check for a thumbnail of source without loading it
+ * @param source file name of the image
+ * @param width requested thumbnail width, selects the size class
+ * @param height requested thumbnail height
+ * @param local look for the thumbnail local to the source instead of in the shared cache
+ * @returns TRUE if a thumbnail was written after the source was last modified
+ *
+ * Only the modification times are compared, the URI and time stored in the
+ * thumbnail are not read. This is meant for rendering many thumbnails, where
+ * loading each existing thumbnail to validate it costs as much as creating it.
+ */
+gboolean thumb_std_maint_cache_time_valid(const gchar *source, gint width, gint height, gboolean local)
+{
+	struct stat st;
+	if (!stat_utf8(source, &st)) return FALSE;
+
+	const gboolean large = (width > THUMB_SIZE_NORMAL || height > THUMB_SIZE_NORMAL);
+
+	if (options->thumbnails.pack_store &&
+	    thumb_pack_contains(source, st.st_mtime, st.st_size, large ? ThumbPackSize::LARGE : ThumbPackSize::NORMAL))
+		{
+		return TRUE;
+		}
+
+	if (!local && (thumb_index_lookup(source, st.st_mtime, st.st_size) & thumb_std_index_status(width, height)))
+		{
+		return TRUE;
+		}
+
+	g_autofree gchar *sourcel = path_from_utf8(source);
+	g_autofree gchar *uri = g_filename_to_uri(sourcel, nullptr, nullptr);
+	if (!uri) return FALSE;
+
+	g_autofree gchar *thumb_path = thumb_std_cache_path(source,
+	                                                    local ? filename_from_path(uri) : uri,
+	                                                    local,
+	                                                    large ? THUMB_FOLDER_LARGE : THUMB_FOLDER_NORMAL);
+	struct stat thumb_st;
+
+	return stat_utf8(thumb_path, &thumb_st) && thumb_st.st_mtime >= st.st_mtime;
+}
+
 /* this also removes local thumbnails (the source is gone so it makes sense) */
 void thumb_std_maint_removed(const gchar *source)
 {
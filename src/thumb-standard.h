@@ -33,6 +33,7 @@
 
 class FileData;
 struct ImageLoader;
+struct ThumbStoreJob;
 
 #define THUMB_FOLDER_GLOBAL "thumbnails"
 #define THUMB_FOLDER_LOCAL  ".thumblocal"
@@ -58,6 +59,7 @@ struct ThumbLoaderStd
 	const gchar *local_uri;
 
 	gboolean thumb_path_local;
+	gboolean thumb_path_indexed; /**< thumb_path is listed as valid in the validation index */
 
 	gint requested_width;
 	gint requested_height;
@@ -66,9 +68,13 @@ struct ThumbLoaderStd
 	gboolean cache_local;
 	gboolean cache_hit;
 	gboolean cache_retry;
+	gboolean store_only; /**< see thumb_loader_std_set_store_only() */
+	ThumbStoreJob *store_job; /**< the new thumbnail being stored, or nullptr */
 
 	gdouble progress;
 
+	guint idle_done_id; /* event source id */
+
 	using Func = void (*)(ThumbLoaderStd *, gpointer);
 	Func func_done;
 	Func func_error;
@@ -85,6 +91,7 @@ void thumb_loader_std_set_callbacks(ThumbLoaderStd *tl,
 				    ThumbLoaderStd::Func func_progress,
 				    gpointer data);
 void thumb_loader_std_set_cache(ThumbLoaderStd *tl, gboolean enable_cache, gboolean local, gboolean retry_failed);
+void thumb_loader_std_set_store_only(ThumbLoaderStd *tl);
 gboolean thumb_loader_std_start(ThumbLoaderStd *tl, FileData *fd);
 void thumb_loader_std_free(ThumbLoaderStd *tl);
 
@@ -98,6 +105,7 @@ ThumbLoaderStd *thumb_loader_std_thumb_file_validate(const gchar *thumb_path, gi
 void thumb_loader_std_thumb_file_validate_cancel(ThumbLoaderStd *tl);
 
 
+gboolean thumb_std_maint_cache_time_valid(const gchar *source, gint width, gint height, gboolean local);
 void thumb_std_maint_removed(const gchar *source);
 void thumb_std_maint_moved(const gchar *source, const gchar *dest);
 
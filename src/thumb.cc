@@ -304,6 +304,18 @@ void thumb_loader_set_cache(ThumbLoader *tl, gboolean enable_cache, gboolean loc
 	tl->cache_enable = enable_cache;
 }
 
+/**
+ * @brief Only create the thumbnails missing from the cache, see thumb_loader_std_set_store_only()
+ *
+ * The loader of the Geeqie thumbnail format still stores them in the main loop.
+ */
+void thumb_loader_set_store_only(ThumbLoader *tl)
+{
+	if (!tl || !tl->standard_loader) return;
+
+	thumb_loader_std_set_store_only(reinterpret_cast<ThumbLoaderStd *>(tl));
+}
+
 
 gboolean thumb_loader_start(ThumbLoader *tl, FileData *fd)
 {
@@ -62,6 +62,7 @@ void thumb_loader_set_callbacks(ThumbLoader *tl,
 				ThumbLoader::Func func_progress,
 				gpointer data);
 void thumb_loader_set_cache(ThumbLoader *tl, gboolean enable_cache, gboolean local, gboolean retry_failed);
+void thumb_loader_set_store_only(ThumbLoader *tl);
 
 gboolean thumb_loader_start(ThumbLoader *tl, FileData *fd);
 void thumb_loader_free(ThumbLoader *tl);
@@ -31,7 +31,6 @@
 #include "main-defines.h"
 
 struct LayoutWindow;
-struct ThumbLoader;
 
 enum FileViewType : guint {
 	FILEVIEW_LIST,
@@ -62,6 +61,7 @@ struct ViewFile
 
 	FileData *dir_fd;
 	GList *list;
+	GPtrArray *list_links; /**< the links of list in order, built on demand, see vf_list_nth() */
 
 	FileData *click_fd;
 
@@ -80,8 +80,10 @@ struct ViewFile
 
 	/* thumbs updates*/
 	gboolean thumbs_running;
-	ThumbLoader *thumbs_loader;
-	FileData *thumbs_filedata;
+	GHashTable *thumbs_loading; /**< ThumbLoader of each FileData being loaded */
+	guint thumbs_scroll_idle_id; /**< event source id */
+	gdouble thumbs_scroll_value;
+	gboolean thumbs_scroll_up;
 
 	/* marks */
 	gboolean marks_enabled;
@@ -96,6 +98,18 @@ struct ViewFile
 	guint refresh_idle_id; /**< event source id */
 	time_t time_refresh_set; /**< time when refresh_idle_id was set */
 
+	/* folder read in the background */
+	FileData::FileList::Scan *scan; /**< running read of dir_fd, or nullptr */
+	GList *scan_list; /**< files read so far */
+	gboolean scan_stream; /**< show the files while they are read */
+	gint64 scan_shown_time; /**< monotonic time the files read so far were last shown */
+	gboolean scan_again; /**< a refresh was requested while reading */
+	gboolean scan_read_metadata; /**< vf_read_metadata_in_idle() was requested while reading */
+
+	/* changes of single files */
+	GHashTable *notify_files; /**< FileData changed since the last update, referenced */
+	guint notify_idle_id; /**< event source id */
+
 	GList *editmenu_fd_list; /**< file list for edit menu */
 
 	guint read_metadata_in_idle_id;
@@ -132,6 +146,7 @@ GtkWidget *vf_pop_menu(ViewFile *vf);
 
 FileData *vf_index_get_data(ViewFile *vf, gint row);
 gint vf_index_by_fd(ViewFile *vf, FileData *in_fd);
+GList *vf_read_ahead_list(ViewFile *vf, gint row, gboolean forward);
 guint vf_count(ViewFile *vf, gint64 *bytes = nullptr);
 GList *vf_get_list(ViewFile *vf);
 
@@ -150,6 +165,9 @@ void vf_mark_to_selection(ViewFile *vf, gint mark, MarkToSelectionMode mode);
 void vf_selection_to_mark(ViewFile *vf, gint mark, SelectionToMarkMode mode);
 
 void vf_refresh_idle_cancel(ViewFile *vf);
+GList *vf_filter_list(ViewFile *vf, GList *list);
+GList *vf_list_nth(ViewFile *vf, gint n);
+void vf_list_changed(ViewFile *vf);
 void vf_notify_cb(FileData *fd, NotifyType type, gpointer data);
 
 void vf_thumb_update(ViewFile *vf);
@@ -136,9 +136,10 @@ void vficon_popup_destroy_cb(ViewFile *vf)
 
 static void vficon_send_layout_select(ViewFile *vf, FileData *fd)
 {
-	FileData *read_ahead_fd = nullptr;
+	g_autoptr(GList) read_ahead_list = nullptr;
 	FileData *sel_fd;
 	FileData *cur_fd;
+	gint row;
 
 	if (!vf->layout || !fd) return;
 
@@ -147,23 +148,10 @@ static void vficon_send_layout_select(ViewFile *vf, FileData *fd)
 	cur_fd = layout_image_get_fd(vf->layout);
 	if (sel_fd == cur_fd) return; /* no change */
 
-	if (options->image.enable_read_ahead)
-		{
-		gint row;
+	row = g_list_index(vf->list, fd);
+	read_ahead_list = vf_read_ahead_list(vf, row, row > vficon_index_by_fd(vf, cur_fd));
 
-		row = g_list_index(vf->list, fd);
-		if (row > vficon_index_by_fd(vf, cur_fd) &&
-		    static_cast<guint>(row + 1) < vf_count(vf))
-			{
-			read_ahead_fd = vf_index_get_data(vf, row + 1);
-			}
-		else if (row > 0)
-			{
-			read_ahead_fd = vf_index_get_data(vf, row - 1);
-			}
-		}
-
-	layout_image_set_with_ahead(vf->layout, sel_fd, read_ahead_fd);
+	layout_image_set_with_ahead(vf->layout, sel_fd, read_ahead_list);
 }
 
 static void vficon_toggle_filenames(ViewFile *vf)
@@ -1357,6 +1345,74 @@ static GList *vficon_add_row(ViewFile *vf, GtkTreeIter *iter)
 	return list;
 }
 
+/**
+ * @brief Refills the rows showing the files of vf->list from position @a first to @a last
+ * @param last Last position, or -1 to refill up to the end and add or remove rows there
+ *
+ * The other rows are left alone.
+ */
+static void vficon_populate_rows(ViewFile *vf, gint first, gint last)
+{
+	GtkTreeModel *store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
+	const gint columns = VFICON(vf)->columns;
+	const gint last_row = (last < 0) ? G_MAXINT : last / columns;
+	gint r = first / columns;
+	GtkTreeIter iter;
+	gboolean valid;
+	GList *work;
+
+	vficon_verify_selections(vf);
+
+	valid = gtk_tree_model_iter_nth_child(store, &iter, nullptr, r);
+	work = vf_list_nth(vf, r * columns);
+
+	while (work && r <= last_row)
+		{
+		GList *list;
+		gboolean changed = !valid;
+
+		if (valid)
+			{
+			gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
+			}
+		else
+			{
+			list = vficon_add_row(vf, &iter);
+			}
+
+		for (GList *cell = list; cell; cell = cell->next)
+			{
+			gpointer cell_fd = work ? work->data : nullptr;
+
+			if (cell->data != cell_fd)
+				{
+				cell->data = cell_fd;
+				changed = TRUE;
+				}
+			if (work) work = work->next;
+			}
+
+		/* rows showing the same files are not redrawn */
+		if (changed) gtk_list_store_set(GTK_LIST_STORE(store), &iter, FILE_COLUMN_POINTER, list, -1);
+
+		r++;
+		if (valid) valid = gtk_tree_model_iter_next(store, &iter);
+		}
+
+	if (last >= 0) return;
+
+	while (valid)
+		{
+		GList *list;
+
+		gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
+		valid = gtk_list_store_remove(GTK_LIST_STORE(store), &iter);
+		g_list_free(list);
+		}
+
+	VFICON(vf)->rows = r;
+}
+
 static void vficon_populate(ViewFile *vf, gboolean resize, gboolean keep_position)
 {
 	GtkTreeModel *store;
@@ -1582,36 +1638,25 @@ void vficon_set_thumb_fd(ViewFile *vf, FileData *fd)
 }
 
 /* Returns the next fd without a loaded pixbuf, so the thumb-loader can load the pixbuf for it. */
-FileData *vficon_thumb_next_fd(ViewFile *vf)
+/**
+ * @brief The files shown in a row, for the thumbnail scheduler
+ * @returns a new list, to be freed with g_list_free()
+ */
+GList *vficon_thumb_row_files(ViewFile *vf, GtkTreeIter *iter)
 {
-	/* First see if there are visible files that don't have a loaded thumb... */
-	if (g_autoptr(GtkTreePath) tpath = nullptr;
-	    gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(vf->listview), 0, 0, &tpath, nullptr, nullptr, nullptr))
-		{
-		GtkTreeModel *store;
-		GtkTreeIter iter;
-		gboolean valid = TRUE;
-
-		store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
-		gtk_tree_model_get_iter(store, &iter, tpath);
-
-		while (valid && tree_view_row_is_visible(GTK_TREE_VIEW(vf->listview), &iter, FALSE))
-			{
-			GList *list;
-			gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &list, -1);
+	GtkTreeModel *store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
+	GList *list;
 
-			/** @todo (xsdg): for loop here. */
-			for (; list; list = list->next)
-				{
-				auto fd = static_cast<FileData *>(list->data);
-				if (fd && !fd->thumb_pixbuf) return fd;
-				}
+	gtk_tree_model_get(store, iter, FILE_COLUMN_POINTER, &list, -1);
 
-			valid = gtk_tree_model_iter_next(store, &iter);
-			}
-		}
+	return g_list_copy(list);
+}
 
-	/* Then iterate through the entire list to load all of them. */
+/**
+ * @brief The next file without a thumbnail, once the rows near the view are done
+ */
+FileData *vficon_thumb_next_fd(ViewFile *vf)
+{
 	GList *work;
 	for (work = vf->list; work; work = work->next)
 		{
@@ -1619,7 +1664,7 @@ FileData *vficon_thumb_next_fd(ViewFile *vf)
 
 		// Note: This implementation differs from view-file-list.cc because sidecar files are not
 		// distinct list elements here, as they are in the list view.
-		if (!fd->thumb_pixbuf) return fd;
+		if (!fd->thumb_pixbuf && !g_hash_table_contains(vf->thumbs_loading, fd)) return fd;
 		}
 
 	return nullptr;
@@ -1706,15 +1751,20 @@ gint vficon_index_by_fd(const ViewFile *vf, const FileData *fd)
  *-----------------------------------------------------------------------------
  */
 
-static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
+/**
+ * @brief Updates the view to the files of @a new_filelist, which it takes
+ *
+ * @a new_filelist is the unfiltered content of the folder.
+ */
+void vficon_refresh_list(ViewFile *vf, GList *new_filelist, gboolean keep_position)
 {
-	gboolean ret = TRUE;
 	GList *work;
 	GList *new_work;
 	FileData *first_selected = nullptr;
-	GList *new_filelist = nullptr;
 	GList *new_fd_list = nullptr;
 	GList *old_selected = nullptr;
+	gint index = 0;
+	gint first_change = -1;
 	GtkTreeIter iter;
 	GtkTreeModel *store;
 
@@ -1724,23 +1774,26 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 
 	if (vf->dir_fd)
 		{
-		ret = filelist_read(vf->dir_fd, &new_filelist, nullptr);
-		new_filelist = file_data_filter_marks_list(new_filelist, vf_marks_get_filter(vf));
-
-		g_autoptr(GRegex) filter = vf_file_filter_get_filter(vf);
-		new_filelist = g_list_first(new_filelist);
-		new_filelist = file_data_filter_file_filter_list(new_filelist, filter);
-
-		new_filelist = g_list_first(new_filelist);
-		new_filelist = file_data_filter_class_list(new_filelist, vf_class_get_filter(vf));
-
-		new_filelist = g_list_first(new_filelist);
-		new_filelist = file_data_filter_rating_list(new_filelist, options->rating_filter);
+		new_filelist = vf_filter_list(vf, new_filelist);
 		}
 
-	vf->list = filelist_sort(vf->list, vf->sort); /* the list might not be sorted if there were renames */
+	/* the list might not be sorted if there were renames, or if metadata used by the sort were read */
+	GList *old_order = g_list_copy(vf->list);
+	vf->list = filelist_sort(vf->list, vf->sort);
 	new_filelist = filelist_sort(new_filelist, vf->sort);
 
+	work = old_order;
+	for (GList *sorted = vf->list; sorted; sorted = sorted->next, work = work->next, index++)
+		{
+		if (sorted->data != work->data)
+			{
+			first_change = index;
+			break;
+			}
+		}
+	g_list_free(old_order);
+	index = 0;
+
 	if (VFICON(vf)->selection)
 		{
 		old_selected = g_list_copy(VFICON(vf)->selection);
@@ -1769,6 +1822,7 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 				/* not changed, go to next */
 				work = work->next;
 				new_work = new_work->next;
+				index++;
 				if (fd->selected & SELECTION_SELECTED)
 					{
 					VFICON(vf)->selection = g_list_prepend(VFICON(vf)->selection, fd);
@@ -1792,6 +1846,8 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 			match = 1;
 			}
 
+		if (first_change < 0 || index < first_change) first_change = index;
+
 		if (match < 0)
 			{
 			/* file no longer exists, delete from vf->list */
@@ -1818,6 +1874,7 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 				}
 
 			new_work = new_work->next;
+			index++;
 			}
 		}
 
@@ -1825,6 +1882,7 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 		{
 		vf->list = g_list_concat(vf->list, g_list_reverse(new_fd_list));
 		}
+	vf_list_changed(vf);
 
 	VFICON(vf)->selection = g_list_reverse(VFICON(vf)->selection);
 
@@ -1848,7 +1906,19 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 
 	file_data_list_free(new_filelist);
 
-	vficon_populate(vf, TRUE, keep_position);
+	if (keep_position)
+		{
+		/* only the rows from the first difference on change */
+		if (first_change >= 0) vficon_populate_rows(vf, first_change, -1);
+
+		vf_send_update(vf);
+		vf_thumb_update(vf);
+		vf_star_update(vf);
+		}
+	else
+		{
+		vficon_populate(vf, TRUE, keep_position);
+		}
 
 	if (first_selected && !VFICON(vf)->selection)
 		{
@@ -1863,13 +1933,56 @@ static gboolean vficon_refresh_real(ViewFile *vf, gboolean keep_position)
 		{
 		gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(vf->listview), start_path, nullptr, FALSE, 0.0, 0.0);
 		}
+}
 
-	return ret;
+/**
+ * @brief Updates the rows after @a fd moved in vf->list from @a old_index to @a new_index
+ *
+ * Either index is -1 when @a fd was added or removed. Only the rows between the two
+ * positions, or from the position to the end, are refilled, and of those only the
+ * rows whose files differ are redrawn.
+ */
+void vficon_refresh_fd(ViewFile *vf, FileData *fd, gint old_index, gint new_index)
+{
+	if (new_index < 0)
+		{
+		VFICON(vf)->selection = g_list_remove(VFICON(vf)->selection, fd);
+		if (fd == VFICON(vf)->prev_selection) VFICON(vf)->prev_selection = nullptr;
+		if (fd == VFICON(vf)->focus_fd) VFICON(vf)->focus_fd = nullptr;
+		if (fd == vf->click_fd) vf->click_fd = nullptr;
+		}
+	else if (old_index < 0)
+		{
+		fd->selected = SELECTION_NONE;
+		}
+
+	if (old_index == new_index)
+		{
+		if (new_index >= 0) vficon_set_thumb_fd(vf, fd);
+		}
+	else if (old_index < 0 || new_index < 0)
+		{
+		vficon_populate_rows(vf, std::max(old_index, new_index), -1);
+		}
+	else
+		{
+		vficon_populate_rows(vf, std::min(old_index, new_index), std::max(old_index, new_index));
+		}
 }
 
 gboolean vficon_refresh(ViewFile *vf)
 {
-	return vficon_refresh_real(vf, TRUE);
+	gboolean ret = TRUE;
+	GList *new_filelist = nullptr;
+
+	if (vf->dir_fd)
+		{
+		ret = filelist_read(vf->dir_fd, &new_filelist, nullptr);
+		}
+
+	vficon_refresh_list(vf, new_filelist, TRUE);
+
+	return ret;
 }
 
 /*
@@ -2006,10 +2119,11 @@ static void vficon_append_column(ViewFile *vf, gint n)
  *-----------------------------------------------------------------------------
  */
 
+/**
+ * @brief Empties the view for the folder @a dir_fd, whose files are read by the caller
+ */
 gboolean vficon_set_fd(ViewFile *vf, FileData *dir_fd)
 {
-	gboolean ret;
-
 	if (!dir_fd) return FALSE;
 	if (vf->dir_fd == dir_fd) return TRUE;
 
@@ -2021,14 +2135,15 @@ gboolean vficon_set_fd(ViewFile *vf, FileData *dir_fd)
 
 	g_list_free(vf->list);
 	vf->list = nullptr;
+	vf_list_changed(vf);
 
 	/* NOTE: populate will clear the store for us */
-	ret = vficon_refresh_real(vf, FALSE);
+	vficon_refresh_list(vf, nullptr, FALSE);
 
 	VFICON(vf)->focus_fd = nullptr;
 	vficon_move_focus(vf, 0, 0, FALSE);
 
-	return ret;
+	return TRUE;
 }
 
 void vficon_destroy_cb(ViewFile *vf)
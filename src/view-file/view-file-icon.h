@@ -68,6 +68,8 @@ ViewFile *vficon_new(ViewFile *vf);
 
 gboolean vficon_set_fd(ViewFile *vf, FileData *dir_fd);
 gboolean vficon_refresh(ViewFile *vf);
+void vficon_refresh_list(ViewFile *vf, GList *new_filelist, gboolean keep_position);
+void vficon_refresh_fd(ViewFile *vf, FileData *fd, gint old_index, gint new_index);
 
 
 void vficon_marks_set(ViewFile *vf, gboolean enable);
@@ -101,6 +103,7 @@ void vficon_selection_to_mark(ViewFile *vf, gint mark, SelectionToMarkMode mode)
 void vficon_thumb_progress_count(const GList *list, gint &count, gint &done);
 void vficon_read_metadata_progress_count(const GList *list, gint &count, gint &done);
 void vficon_set_thumb_fd(ViewFile *vf, FileData *fd);
+GList *vficon_thumb_row_files(ViewFile *vf, GtkTreeIter *iter);
 FileData *vficon_thumb_next_fd(ViewFile *vf);
 
 FileData *vficon_star_next_fd(ViewFile *vf);
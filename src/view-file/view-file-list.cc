@@ -580,7 +580,7 @@ gboolean vflist_release_cb(ViewFile *vf, GtkWidget *widget, GdkEventButton *beve
 
 static void vflist_select_image(ViewFile *vf, FileData *sel_fd)
 {
-	FileData *read_ahead_fd = nullptr;
+	g_autoptr(GList) read_ahead_list = nullptr;
 	gint row;
 	FileData *cur_fd;
 
@@ -592,20 +592,12 @@ static void vflist_select_image(ViewFile *vf, FileData *sel_fd)
 	row = g_list_index(vf->list, sel_fd);
 	/** @FIXME sidecar data */
 
-	if (options->image.enable_read_ahead && row >= 0)
+	if (row >= 0)
 		{
-		if (row > g_list_index(vf->list, cur_fd) &&
-		    static_cast<guint>(row + 1) < vf_count(vf))
-			{
-			read_ahead_fd = vf_index_get_data(vf, row + 1);
-			}
-		else if (row > 0)
-			{
-			read_ahead_fd = vf_index_get_data(vf, row - 1);
-			}
+		read_ahead_list = vf_read_ahead_list(vf, row, row > g_list_index(vf->list, cur_fd));
 		}
 
-	layout_image_set_with_ahead(vf->layout, sel_fd, read_ahead_fd);
+	layout_image_set_with_ahead(vf->layout, sel_fd, read_ahead_list);
 }
 
 static gboolean vflist_select_idle_cb(gpointer data)
@@ -926,6 +918,7 @@ void vflist_sort_set(ViewFile *vf, FileData::FileList::SortSettings settings)
 
 	vf->sort = settings;
 	vf->list = filelist_sort(vf->list, vf->sort);
+	vf_list_changed(vf);
 
 	std::vector<gint> new_order;
 	new_order.reserve(i);
@@ -994,57 +987,50 @@ void vflist_set_thumb_fd(ViewFile *vf, FileData *fd)
 	gtk_tree_store_set(store, &iter, FILE_COLUMN_THUMB, fd->thumb_pixbuf, -1);
 }
 
-FileData *vflist_thumb_next_fd(ViewFile *vf)
+/**
+ * @brief The files shown in a row, for the thumbnail scheduler
+ * @returns a new list, to be freed with g_list_free()
+ */
+GList *vflist_thumb_row_files(ViewFile *vf, GtkTreeIter *iter)
 {
-	FileData *fd = nullptr;
-
-	/* first check the visible files */
-
-	if (g_autoptr(GtkTreePath) tpath = nullptr;
-	    gtk_tree_view_get_path_at_pos(GTK_TREE_VIEW(vf->listview), 0, 0, &tpath, nullptr, nullptr, nullptr))
-		{
-		GtkTreeModel *store;
-		GtkTreeIter iter;
-		gboolean valid = TRUE;
-
-		store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
-		gtk_tree_model_get_iter(store, &iter, tpath);
-
-		while (!fd && valid && tree_view_row_is_visible(GTK_TREE_VIEW(vf->listview), &iter, FALSE))
-			{
-			FileData *nfd;
+	GtkTreeModel *store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
+	FileData *fd;
 
-			gtk_tree_model_get(store, &iter, FILE_COLUMN_POINTER, &nfd, -1);
+	gtk_tree_model_get(store, iter, FILE_COLUMN_POINTER, &fd, -1);
 
-			if (!nfd->thumb_pixbuf) fd = nfd;
+	return g_list_prepend(nullptr, fd);
+}
 
-			valid = gtk_tree_model_iter_next(store, &iter);
-			}
-		}
+/**
+ * @brief The next file without a thumbnail, once the rows near the view are done
+ */
+FileData *vflist_thumb_next_fd(ViewFile *vf)
+{
+	FileData *fd = nullptr;
 
-	/* then find first undone */
+	const auto needs_thumb = [vf](FileData *fd_p)
+		{
+		return !fd_p->thumb_pixbuf && !g_hash_table_contains(vf->thumbs_loading, fd_p);
+		};
 
-	if (!fd)
+	GList *work = vf->list;
+	while (work && !fd)
 		{
-		GList *work = vf->list;
-		while (work && !fd)
+		auto fd_p = static_cast<FileData *>(work->data);
+		if (needs_thumb(fd_p))
+			fd = fd_p;
+		else
 			{
-			auto fd_p = static_cast<FileData *>(work->data);
-			if (!fd_p->thumb_pixbuf)
-				fd = fd_p;
-			else
-				{
-				GList *work2 = fd_p->sidecar_files;
+			GList *work2 = fd_p->sidecar_files;
 
-				while (work2 && !fd)
-					{
-					fd_p = static_cast<FileData *>(work2->data);
-					if (!fd_p->thumb_pixbuf) fd = fd_p;
-					work2 = work2->next;
-					}
+			while (work2 && !fd)
+				{
+				fd_p = static_cast<FileData *>(work2->data);
+				if (needs_thumb(fd_p)) fd = fd_p;
+				work2 = work2->next;
 				}
-			work = work->next;
 			}
+		work = work->next;
 		}
 
 	return fd;
@@ -1591,21 +1577,20 @@ static void vflist_populate_view(ViewFile *vf, gboolean force)
 	vf_star_update(vf);
 }
 
-gboolean vflist_refresh(ViewFile *vf)
+/**
+ * @brief Updates the view to the files of @a list, which it takes
+ *
+ * @a list is the unfiltered content of the folder.
+ */
+void vflist_refresh_list(ViewFile *vf, GList *list)
 {
 	GList *old_list;
-	gboolean ret = TRUE;
 
 	old_list = vf->list;
-	vf->list = nullptr;
+	vf->list = list;
 
-	DEBUG_1("%s vflist_refresh: read dir", get_exec_time());
 	if (vf->dir_fd)
 		{
-		file_data_unregister_notify_func(vf_notify_cb, vf); /* we don't need the notification of changes detected by filelist_read */
-
-		ret = filelist_read(vf->dir_fd, &vf->list, nullptr);
-
 		if (vf->marks_enabled)
 			{
 			// When marks are enabled, lock FileDatas so that we don't end up re-parsing XML
@@ -1619,23 +1604,12 @@ gboolean vflist_refresh(ViewFile *vf)
 			file_data_unlock_list(vf->list);
 			}
 
-		vf->list = file_data_filter_marks_list(vf->list, vf_marks_get_filter(vf));
-
-		g_autoptr(GRegex) filter = vf_file_filter_get_filter(vf);
-		vf->list = g_list_first(vf->list);
-		vf->list = file_data_filter_file_filter_list(vf->list, filter);
-
-		vf->list = g_list_first(vf->list);
-		vf->list = file_data_filter_class_list(vf->list, vf_class_get_filter(vf));
-
-		vf->list = g_list_first(vf->list);
-		vf->list = file_data_filter_rating_list(vf->list, options->rating_filter);
-
-		file_data_register_notify_func(vf_notify_cb, vf, NOTIFY_PRIORITY_MEDIUM);
+		vf->list = vf_filter_list(vf, vf->list);
 
 		DEBUG_1("%s vflist_refresh: sort", get_exec_time());
 		vf->list = filelist_sort(vf->list, vf->sort);
 		}
+	vf_list_changed(vf);
 
 	DEBUG_1("%s vflist_refresh: populate view", get_exec_time());
 
@@ -1645,6 +1619,89 @@ gboolean vflist_refresh(ViewFile *vf)
 
 	file_data_list_free(old_list);
 	DEBUG_1("%s vflist_refresh: done", get_exec_time());
+}
+
+static void vflist_store_remove_row(GtkTreeStore *store, GtkTreeIter *iter)
+{
+	GtkTreeIter child;
+	FileData *fd;
+	gboolean valid = gtk_tree_model_iter_children(GTK_TREE_MODEL(store), &child, iter);
+
+	while (valid)
+		{
+		gtk_tree_model_get(GTK_TREE_MODEL(store), &child, FILE_COLUMN_POINTER, &fd, -1);
+		file_data_unref(fd);
+		valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(store), &child);
+		}
+
+	gtk_tree_model_get(GTK_TREE_MODEL(store), iter, FILE_COLUMN_POINTER, &fd, -1);
+	file_data_unref(fd);
+	gtk_tree_store_remove(store, iter);
+}
+
+/**
+ * @brief Moves the row of @a fd from position @a old_index to @a new_index, as in vf->list
+ *
+ * Either index is -1 when @a fd was added or removed. When the position is the same,
+ * the row is only redrawn.
+ */
+void vflist_refresh_fd(ViewFile *vf, FileData *fd, gint old_index, gint new_index)
+{
+	auto store = GTK_TREE_STORE(gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview)));
+	GtkTreeSelection *selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(vf->listview));
+	gboolean selected = FALSE;
+	GtkTreeIter iter;
+
+	if (old_index >= 0 && gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(store), &iter, nullptr, old_index))
+		{
+		if (old_index == new_index)
+			{
+			vflist_setup_iter(vf, store, &iter, fd);
+			vflist_setup_iter_recursive(vf, store, &iter, fd->sidecar_files, nullptr, TRUE);
+			return;
+			}
+
+		selected = gtk_tree_selection_iter_is_selected(selection, &iter);
+		vflist_store_remove_row(store, &iter);
+		}
+
+	if (new_index < 0) return;
+
+	GtkTreeIter sibling;
+	if (gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(store), &sibling, nullptr, new_index))
+		{
+		gtk_tree_store_insert_before(store, &iter, nullptr, &sibling);
+		}
+	else
+		{
+		gtk_tree_store_append(store, &iter, nullptr);
+		}
+
+	if (old_index < 0 && vf->marks_enabled) file_data_lock(fd);
+
+	vflist_setup_iter(vf, store, &iter, file_data_ref(fd));
+	vflist_setup_iter_recursive(vf, store, &iter, fd->sidecar_files, nullptr, FALSE);
+
+	/* a renamed file keeps its selection */
+	if (selected) gtk_tree_selection_select_iter(selection, &iter);
+}
+
+gboolean vflist_refresh(ViewFile *vf)
+{
+	GList *list = nullptr;
+	gboolean ret = TRUE;
+
+	DEBUG_1("%s vflist_refresh: read dir", get_exec_time());
+	if (vf->dir_fd)
+		{
+		file_data_unregister_notify_func(vf_notify_cb, vf); /* we don't need the notification of changes detected by filelist_read */
+
+		ret = filelist_read(vf->dir_fd, &list, nullptr);
+
+		file_data_register_notify_func(vf_notify_cb, vf, NOTIFY_PRIORITY_MEDIUM);
+		}
+
+	vflist_refresh_list(vf, list);
 
 	return ret;
 }
@@ -1790,9 +1847,11 @@ static void vflist_listview_add_column_toggle(ViewFile *vf, gint n, const gchar
  *-----------------------------------------------------------------------------
  */
 
+/**
+ * @brief Empties the view for the folder @a dir_fd, whose files are read by the caller
+ */
 gboolean vflist_set_fd(ViewFile *vf, FileData *dir_fd)
 {
-	gboolean ret;
 	if (!dir_fd) return FALSE;
 	if (vf->dir_fd == dir_fd) return TRUE;
 
@@ -1804,10 +1863,10 @@ gboolean vflist_set_fd(ViewFile *vf, FileData *dir_fd)
 
 	file_data_list_free(vf->list);
 	vf->list = nullptr;
+	vf_list_changed(vf);
 
-	ret = vflist_refresh(vf);
-	gtk_tree_view_columns_autosize(GTK_TREE_VIEW(vf->listview));
-	return ret;
+	vflist_refresh_list(vf, nullptr);
+	return TRUE;
 }
 
 void vflist_destroy_cb(ViewFile *vf)
@@ -57,6 +57,8 @@ ViewFile *vflist_new(ViewFile *vf);
 
 gboolean vflist_set_fd(ViewFile *vf, FileData *dir_fd);
 gboolean vflist_refresh(ViewFile *vf);
+void vflist_refresh_list(ViewFile *vf, GList *list);
+void vflist_refresh_fd(ViewFile *vf, FileData *fd, gint old_index, gint new_index);
 
 void vflist_thumb_set(ViewFile *vf, gboolean enable);
 void vflist_marks_set(ViewFile *vf, gboolean enable);
@@ -91,6 +93,7 @@ void vflist_color_set(ViewFile *vf, FileData *fd, gboolean color_set);
 void vflist_thumb_progress_count(const GList *list, gint &count, gint &done);
 void vflist_read_metadata_progress_count(const GList *list, gint &count, gint &done);
 void vflist_set_thumb_fd(ViewFile *vf, FileData *fd);
+GList *vflist_thumb_row_files(ViewFile *vf, GtkTreeIter *iter);
 FileData *vflist_thumb_next_fd(ViewFile *vf);
 
 FileData *vflist_star_next_fd(ViewFile *vf);
@@ -35,6 +35,7 @@
 #include "history-list.h"
 #include "img-view.h"
 #include "intl.h"
+#include "layout-image.h"
 #include "layout.h"
 #include "main-defines.h"
 #include "main.h"
@@ -53,6 +54,15 @@
 #include "view-file/view-file-list.h"
 #include "window.h"
 
+namespace
+{
+
+constexpr guint VF_THUMB_LOADERS_MAX = 8; /**< upper limit of thumbnails loaded in parallel */
+constexpr gint64 VF_SCAN_SHOW_INTERVAL = 250 * G_TIME_SPAN_MILLISECOND; /**< between updates of a folder being read */
+constexpr guint VF_SCAN_APPLY_MAX = 64; /**< differences found by a refresh that are applied one file at a time */
+
+} // namespace
+
 /*
  *-----------------------------------------------------------------------------
  * signals
@@ -85,9 +95,48 @@ void vf_sort_set(ViewFile *vf, FileData::FileList::SortSettings settings)
  *-----------------------------------------------------------------------------
  */
 
+static GPtrArray *vf_list_links(ViewFile *vf)
+{
+	if (!vf->list_links)
+		{
+		vf->list_links = g_ptr_array_new();
+		for (GList *work = vf->list; work; work = work->next)
+			{
+			g_ptr_array_add(vf->list_links, work);
+			}
+		}
+
+	return vf->list_links;
+}
+
+/**
+ * @brief The link of vf->list at position @a n, nullptr if there is none
+ *
+ * Unlike g_list_nth() it takes constant time, once the list is unchanged.
+ */
+GList *vf_list_nth(ViewFile *vf, gint n)
+{
+	GPtrArray *links = vf_list_links(vf);
+
+	if (n < 0 || static_cast<guint>(n) >= links->len) return nullptr;
+
+	return static_cast<GList *>(g_ptr_array_index(links, n));
+}
+
+/**
+ * @brief To be called after vf->list was replaced or reordered, other than by vf_update_fd()
+ */
+void vf_list_changed(ViewFile *vf)
+{
+	if (vf->list_links) g_ptr_array_free(vf->list_links, TRUE);
+	vf->list_links = nullptr;
+}
+
 FileData *vf_index_get_data(ViewFile *vf, gint row)
 {
-	return static_cast<FileData *>(g_list_nth_data(vf->list, row));
+	GList *link = vf_list_nth(vf, row);
+
+	return link ? static_cast<FileData *>(link->data) : nullptr;
 }
 
 gint vf_index_by_fd(ViewFile *vf, FileData *fd)
@@ -104,6 +153,39 @@ gint vf_index_by_fd(ViewFile *vf, FileData *fd)
 	return ret;
 }
 
+/**
+ * @brief Lists the images to read ahead when \a row is displayed
+ * @param forward direction of travel
+ * @returns FileData, nearest first, free the list with g_list_free()
+ *
+ * These are the next options->image.read_ahead_next images in the
+ * direction of travel, followed by options->image.read_ahead_previous
+ * images in the opposite direction.
+ */
+GList *vf_read_ahead_list(ViewFile *vf, gint row, gboolean forward)
+{
+	GList *current = g_list_nth(vf->list, row);
+	if (!current) return nullptr;
+
+	GList *list = nullptr;
+	const auto add = [&list, current](gint count, gboolean next)
+	{
+		GList *work = current;
+		for (gint i = 0; i < count; i++)
+			{
+			work = next ? work->next : work->prev;
+			if (!work) break;
+
+			list = g_list_prepend(list, work->data);
+			}
+	};
+
+	add(options->image.read_ahead_next, forward);
+	add(options->image.read_ahead_previous, !forward);
+
+	return g_list_reverse(list);
+}
+
 guint vf_count(ViewFile *vf, gint64 *bytes)
 {
 	if (bytes)
@@ -838,10 +920,130 @@ GtkWidget *vf_pop_menu(ViewFile *vf)
 	return menu;
 }
 
+/*
+ *-----------------------------------------------------------------------------
+ * folder read in the background
+ *-----------------------------------------------------------------------------
+ */
+
+static void vf_scan_cancel(ViewFile *vf)
+{
+	filelist_read_async_cancel(vf->scan);
+	vf->scan = nullptr;
+
+	file_data_list_free(vf->scan_list);
+	vf->scan_list = nullptr;
+}
+
+/**
+ * @brief Keeps the image of the layout and the selection in step while a new folder is shown
+ *
+ * This is what layout_set_fd() does once the list is complete.
+ */
+static void vf_scan_sync_layout(ViewFile *vf)
+{
+	FileData *fd = layout_image_get_fd(vf->layout);
+
+	if (fd)
+		{
+		if (vf_index_by_fd(vf, fd) >= 0) vf_select_by_fd(vf, fd);
+		}
+	else if (vf->list && !options->lazy_image_sync)
+		{
+		layout_image_set_index(vf->layout, 0);
+		}
+}
+
+/**
+ * @brief Replaces the files of @a vf with @a list, which the view takes
+ */
+static void vf_scan_show(ViewFile *vf, GList *list)
+{
+	const gboolean keep_position = !vf->scan_stream || vf->scan_shown_time;
+
+	switch (vf->type)
+	{
+	case FILEVIEW_LIST: vflist_refresh_list(vf, list); break;
+	case FILEVIEW_ICON: vficon_refresh_list(vf, list, keep_position); break;
+	}
+
+	vf->scan_shown_time = g_get_monotonic_time();
+
+	if (vf->scan_stream && vf->layout) vf_scan_sync_layout(vf);
+}
+
+static gboolean vf_scan_apply(ViewFile *vf, GList *list);
+
+static void vf_scan_cb(GList *files, gboolean done, gpointer data)
+{
+	auto vf = static_cast<ViewFile *>(data);
+
+	vf->scan_list = g_list_concat(files, vf->scan_list);
+
+	if (done)
+		{
+		GList *list = g_steal_pointer(&vf->scan_list);
+
+		vf->scan = nullptr;
+		if (vf->scan_stream || !vf_scan_apply(vf, list)) vf_scan_show(vf, list);
+
+		if (vf->scan_stream && vf->type == FILEVIEW_LIST)
+			{
+			gtk_tree_view_columns_autosize(GTK_TREE_VIEW(vf->listview));
+			}
+
+		if (vf->scan_read_metadata)
+			{
+			vf->scan_read_metadata = FALSE;
+			vf_read_metadata_in_idle(vf);
+			}
+
+		if (vf->scan_again)
+			{
+			vf->scan_again = FALSE;
+			vf_refresh_idle(vf);
+			}
+		return;
+		}
+
+	/* the first batch is about a screenful, show it at once */
+	if (!vf->scan_stream || !vf->scan_list) return;
+	if (vf->scan_shown_time && g_get_monotonic_time() - vf->scan_shown_time < VF_SCAN_SHOW_INTERVAL) return;
+
+	vf_scan_show(vf, filelist_copy(vf->scan_list));
+}
+
+/**
+ * @brief Reads the folder of @a vf in the background
+ * @param stream Whether to show the files while they are read; for a view that starts empty
+ *
+ * Without @a stream the view keeps its files until the read is complete, which suits
+ * a refresh of the same folder.
+ */
+static void vf_scan_start(ViewFile *vf, gboolean stream)
+{
+	vf_scan_cancel(vf);
+	vf->scan_again = FALSE;
+
+	if (!vf->dir_fd) return;
+
+	vf->scan = filelist_read_async(vf->dir_fd, vf_scan_cb, vf);
+	if (!vf->scan)
+		{
+		vf_refresh(vf);
+		return;
+		}
+
+	vf->scan_stream = stream;
+	vf->scan_shown_time = 0;
+}
+
 gboolean vf_refresh(ViewFile *vf)
 {
 	gboolean ret;
 
+	vf_scan_cancel(vf);
+
 	switch (vf->type)
 	{
 	case FILEVIEW_LIST: ret = vflist_refresh(vf); break;
@@ -849,21 +1051,32 @@ gboolean vf_refresh(ViewFile *vf)
 	default: ret = FALSE;
 	}
 
+	if (vf->scan_read_metadata)
+		{
+		vf->scan_read_metadata = FALSE;
+		vf_read_metadata_in_idle(vf);
+		}
+
 	return ret;
 }
 
+/**
+ * @brief Shows the folder @a dir_fd, whose files are read in the background
+ */
 gboolean vf_set_fd(ViewFile *vf, FileData *dir_fd)
 {
-	gboolean ret;
+	if (!dir_fd) return FALSE;
+	if (vf->dir_fd == dir_fd) return TRUE;
 
 	switch (vf->type)
 	{
-	case FILEVIEW_LIST: ret = vflist_set_fd(vf, dir_fd); break;
-	case FILEVIEW_ICON: ret = vficon_set_fd(vf, dir_fd); break;
-	default: ret = FALSE;
+	case FILEVIEW_LIST: vflist_set_fd(vf, dir_fd); break;
+	case FILEVIEW_ICON: vficon_set_fd(vf, dir_fd); break;
 	}
 
-	return ret;
+	vf_scan_start(vf, TRUE);
+
+	return TRUE;
 }
 
 static void vf_destroy_cb(GtkWidget *, gpointer data)
@@ -887,6 +1100,13 @@ static void vf_destroy_cb(GtkWidget *, gpointer data)
 		{
 		g_idle_remove_by_data(vf);
 		}
+	vf_scan_cancel(vf);
+	g_clear_handle_id(&vf->notify_idle_id, g_source_remove);
+	if (vf->notify_files) g_hash_table_destroy(vf->notify_files);
+	vf_list_changed(vf);
+	g_signal_handlers_disconnect_by_data(gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(vf->scrolled)), vf);
+	g_clear_handle_id(&vf->thumbs_scroll_idle_id, g_source_remove);
+	g_hash_table_destroy(vf->thumbs_loading);
 	file_data_unref(vf->dir_fd);
 	g_free(vf->info);
 	g_free(vf);
@@ -1331,6 +1551,8 @@ void vf_mark_filter_toggle(ViewFile *vf, gint mark)
 	gtk_toggle_button_set_active(filter_check, !gtk_toggle_button_get_active(filter_check));
 }
 
+static void vf_thumb_scroll_cb(GtkAdjustment *adjustment, gpointer data);
+
 ViewFile *vf_new(FileViewType type, FileData *dir_fd)
 {
 	ViewFile *vf;
@@ -1340,6 +1562,7 @@ ViewFile *vf_new(FileViewType type, FileData *dir_fd)
 	vf->type = type;
 	vf->sort = { SORT_NAME, TRUE, FALSE };
 	vf->read_metadata_in_idle_id = 0;
+	vf->thumbs_loading = g_hash_table_new_full(nullptr, nullptr, nullptr, reinterpret_cast<GDestroyNotify>(thumb_loader_free));
 
 	vf->scrolled = gq_gtk_scrolled_window_new(nullptr, nullptr);
 	gq_gtk_scrolled_window_set_shadow_type(GTK_SCROLLED_WINDOW(vf->scrolled), GTK_SHADOW_IN);
@@ -1378,6 +1601,9 @@ ViewFile *vf_new(FileViewType type, FileData *dir_fd)
 	gq_gtk_container_add(vf->scrolled, vf->listview);
 	gtk_widget_show(vf->listview);
 
+	g_signal_connect(G_OBJECT(gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(vf->scrolled))), "value-changed",
+			 G_CALLBACK(vf_thumb_scroll_cb), vf);
+
 	if (dir_fd) vf_set_fd(vf, dir_fd);
 
 	return vf;
@@ -1405,7 +1631,7 @@ void vf_thumb_set(ViewFile *vf, gboolean enable)
 }
 
 
-static gboolean vf_thumb_next(ViewFile *vf);
+static void vf_thumb_fill(ViewFile *vf);
 
 static gdouble vf_thumb_progress(ViewFile *vf)
 {
@@ -1467,10 +1693,8 @@ void vf_thumb_cleanup(ViewFile *vf)
 
 	vf->thumbs_running = FALSE;
 
-	thumb_loader_free(vf->thumbs_loader);
-	vf->thumbs_loader = nullptr;
-
-	vf->thumbs_filedata = nullptr;
+	g_hash_table_remove_all(vf->thumbs_loading);
+	g_clear_handle_id(&vf->thumbs_scroll_idle_id, g_source_remove);
 }
 
 void vf_thumb_stop(ViewFile *vf)
@@ -1481,13 +1705,21 @@ void vf_thumb_stop(ViewFile *vf)
 static void vf_thumb_common_cb(ThumbLoader *tl, gpointer data)
 {
 	auto vf = static_cast<ViewFile *>(data);
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
 
-	if (vf->thumbs_filedata && vf->thumbs_loader == tl)
+	g_hash_table_iter_init(&iter, vf->thumbs_loading);
+	while (g_hash_table_iter_next(&iter, &key, &value))
 		{
-		vf_thumb_do(vf, vf->thumbs_filedata);
+		if (value != tl) continue;
+
+		g_hash_table_iter_remove(&iter);
+		vf_thumb_do(vf, static_cast<FileData *>(key));
+		break;
 		}
 
-	while (vf_thumb_next(vf));
+	vf_thumb_fill(vf);
 }
 
 static void vf_thumb_error_cb(ThumbLoader *tl, gpointer data)
@@ -1500,50 +1732,202 @@ static void vf_thumb_done_cb(ThumbLoader *tl, gpointer data)
 	vf_thumb_common_cb(tl, data);
 }
 
-static gboolean vf_thumb_next(ViewFile *vf)
+static GList *vf_thumb_row_files(ViewFile *vf, GtkTreeIter *iter)
+{
+	switch (vf->type)
+	{
+	case FILEVIEW_LIST: return vflist_thumb_row_files(vf, iter);
+	case FILEVIEW_ICON: return vficon_thumb_row_files(vf, iter);
+	}
+
+	return nullptr;
+}
+
+/**
+ * @brief Adds the files of a row in reverse order, for a band built backwards
+ */
+static GList *vf_thumb_band_prepend_row(ViewFile *vf, GList *band, GtkTreeIter *iter)
+{
+	return g_list_concat(g_list_reverse(vf_thumb_row_files(vf, iter)), band);
+}
+
+/**
+ * @brief The files that should get their thumbnails first
+ * @returns the files of the visible rows, then of as many rows again
+ * ahead in the scroll direction, to be freed with g_list_free()
+ */
+static GList *vf_thumb_band(ViewFile *vf)
 {
+	g_autoptr(GtkTreePath) start_path = nullptr;
+	g_autoptr(GtkTreePath) end_path = nullptr;
+
+	if (!gtk_tree_view_get_visible_range(GTK_TREE_VIEW(vf->listview), &start_path, &end_path)) return nullptr;
+
+	/* Sidecar rows of the list view are covered by their parent row */
+	while (gtk_tree_path_get_depth(start_path) > 1) gtk_tree_path_up(start_path);
+
+	GtkTreeModel *store = gtk_tree_view_get_model(GTK_TREE_VIEW(vf->listview));
+	GtkTreeIter iter;
+	GList *band = nullptr;
+	gint rows = 0;
+
+	if (!gtk_tree_model_get_iter(store, &iter, start_path)) return nullptr;
+
+	GtkTreeIter first = iter;
+	gboolean valid = TRUE;
+
+	while (valid)
+		{
+		g_autoptr(GtkTreePath) tpath = gtk_tree_model_get_path(store, &iter);
+		if (gtk_tree_path_compare(tpath, end_path) > 0) break;
+
+		band = vf_thumb_band_prepend_row(vf, band, &iter);
+		rows++;
+
+		valid = gtk_tree_model_iter_next(store, &iter);
+		}
+
+	if (vf->thumbs_scroll_up)
+		{
+		iter = first;
+		valid = gtk_tree_model_iter_previous(store, &iter);
+		}
+
+	for (gint i = 0; valid && i < rows; i++)
+		{
+		band = vf_thumb_band_prepend_row(vf, band, &iter);
+
+		valid = vf->thumbs_scroll_up ? gtk_tree_model_iter_previous(store, &iter) : gtk_tree_model_iter_next(store, &iter);
+		}
+
+	return g_list_reverse(band);
+}
+
+static gboolean vf_thumb_needed(ViewFile *vf, FileData *fd)
+{
+	return fd && !fd->thumb_pixbuf && !g_hash_table_contains(vf->thumbs_loading, fd);
+}
+
+static FileData *vf_thumb_next_fd(ViewFile *vf)
+{
+	GList *band = vf_thumb_band(vf);
 	FileData *fd = nullptr;
 
-	if (!gtk_widget_get_realized(vf->listview))
+	for (GList *work = band; work && !fd; work = work->next)
 		{
-		vf_thumb_status(vf, 0.0, nullptr);
-		return FALSE;
+		if (vf_thumb_needed(vf, static_cast<FileData *>(work->data))) fd = static_cast<FileData *>(work->data);
 		}
+	g_list_free(band);
+
+	if (fd) return fd;
 
+	/* Then the rest of the list, to load all of them */
 	switch (vf->type)
 	{
-	case FILEVIEW_LIST: fd = vflist_thumb_next_fd(vf); break;
-	case FILEVIEW_ICON: fd = vficon_thumb_next_fd(vf); break;
+	case FILEVIEW_LIST: return vflist_thumb_next_fd(vf);
+	case FILEVIEW_ICON: return vficon_thumb_next_fd(vf);
 	}
 
-	if (!fd)
+	return nullptr;
+}
+
+static guint vf_thumb_loaders_max()
+{
+	return CLAMP(g_get_num_processors(), 2, VF_THUMB_LOADERS_MAX);
+}
+
+/**
+ * @brief Start thumbnail loaders for the next files, until enough are running
+ *
+ * The files are taken from the visible rows first, then from the rows ahead
+ * in the scroll direction, then from the rest of the list.
+ */
+static void vf_thumb_fill(ViewFile *vf)
+{
+	if (!gtk_widget_get_realized(vf->listview))
+		{
+		vf_thumb_status(vf, 0.0, nullptr);
+		return;
+		}
+
+	while (g_hash_table_size(vf->thumbs_loading) < vf_thumb_loaders_max())
+		{
+		FileData *fd = vf_thumb_next_fd(vf);
+		if (!fd) break;
+
+		ThumbLoader *tl = thumb_loader_new(options->thumbnails.max_width, options->thumbnails.max_height);
+		thumb_loader_set_callbacks(tl,
+					   vf_thumb_done_cb,
+					   vf_thumb_error_cb,
+					   nullptr,
+					   vf);
+
+		g_hash_table_insert(vf->thumbs_loading, fd, tl);
+
+		if (!thumb_loader_start(tl, fd))
+			{
+			/* set icon to unknown, continue */
+			DEBUG_1("thumb loader start failed %s", fd->path);
+			g_hash_table_remove(vf->thumbs_loading, fd);
+			vf_thumb_do(vf, fd);
+			}
+		}
+
+	if (g_hash_table_size(vf->thumbs_loading) == 0)
 		{
 		/* done */
 		vf_thumb_cleanup(vf);
-		return FALSE;
 		}
+}
 
-	vf->thumbs_filedata = fd;
+static gboolean vf_thumb_scroll_idle_cb(gpointer data)
+{
+	auto vf = static_cast<ViewFile *>(data);
+
+	vf->thumbs_scroll_idle_id = 0;
 
-	thumb_loader_free(vf->thumbs_loader);
+	if (!vf->thumbs_running) return G_SOURCE_REMOVE;
 
-	vf->thumbs_loader = thumb_loader_new(options->thumbnails.max_width, options->thumbnails.max_height);
-	thumb_loader_set_callbacks(vf->thumbs_loader,
-				   vf_thumb_done_cb,
-				   vf_thumb_error_cb,
-				   nullptr,
-				   vf);
+	GList *band = vf_thumb_band(vf);
+
+	/* Loads of files that left the band make way for the files in it,
+	 * they are started again when their turn comes */
+	gboolean band_needed = FALSE;
+	for (GList *work = band; work && !band_needed; work = work->next)
+		{
+		band_needed = vf_thumb_needed(vf, static_cast<FileData *>(work->data));
+		}
 
-	if (!thumb_loader_start(vf->thumbs_loader, fd))
+	if (band_needed)
 		{
-		/* set icon to unknown, continue */
-		DEBUG_1("thumb loader start failed %s", fd->path);
-		vf_thumb_do(vf, fd);
+		GHashTableIter iter;
+		gpointer key;
 
-		return TRUE;
+		g_hash_table_iter_init(&iter, vf->thumbs_loading);
+		while (g_hash_table_iter_next(&iter, &key, nullptr))
+			{
+			if (!g_list_find(band, key)) g_hash_table_iter_remove(&iter);
+			}
 		}
+	g_list_free(band);
 
-	return FALSE;
+	vf_thumb_fill(vf);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void vf_thumb_scroll_cb(GtkAdjustment *adjustment, gpointer data)
+{
+	auto vf = static_cast<ViewFile *>(data);
+	const gdouble value = gtk_adjustment_get_value(adjustment);
+
+	if (value != vf->thumbs_scroll_value) vf->thumbs_scroll_up = (value < vf->thumbs_scroll_value);
+	vf->thumbs_scroll_value = value;
+
+	if (vf->thumbs_running && !vf->thumbs_scroll_idle_id)
+		{
+		vf->thumbs_scroll_idle_id = g_idle_add(vf_thumb_scroll_idle_cb, vf);
+		}
 }
 
 static void vf_thumb_reset_all(ViewFile *vf)
@@ -1576,7 +1960,7 @@ void vf_thumb_update(ViewFile *vf)
 		thumb_format_changed = FALSE;
 		}
 
-	while (vf_thumb_next(vf));
+	vf_thumb_fill(vf);
 }
 
 void vf_star_cleanup(ViewFile *vf)
@@ -1759,8 +2143,18 @@ static gboolean vf_refresh_idle_cb(gpointer data)
 {
 	auto vf = static_cast<ViewFile *>(data);
 
-	vf_refresh(vf);
 	vf->refresh_idle_id = 0;
+
+	if (vf->scan)
+		{
+		/* the folder is still being read, look again when it is complete */
+		vf->scan_again = TRUE;
+		}
+	else
+		{
+		vf_scan_start(vf, FALSE);
+		}
+
 	return G_SOURCE_REMOVE;
 }
 
@@ -1787,10 +2181,298 @@ void vf_refresh_idle(ViewFile *vf)
 		}
 }
 
+/**
+ * @brief Applies the views filters to @a list, freeing the files left out
+ */
+GList *vf_filter_list(ViewFile *vf, GList *list)
+{
+	list = file_data_filter_marks_list(list, vf_marks_get_filter(vf));
+
+	g_autoptr(GRegex) filter = vf_file_filter_get_filter(vf);
+	list = g_list_first(list);
+	list = file_data_filter_file_filter_list(list, filter);
+
+	list = g_list_first(list);
+	list = file_data_filter_class_list(list, vf_class_get_filter(vf));
+
+	list = g_list_first(list);
+	list = file_data_filter_rating_list(list, options->rating_filter);
+
+	return list;
+}
+
+static gint vf_sort_compare_cb(gconstpointer a, gconstpointer b, gpointer data)
+{
+	return filelist_sort_compare_filedata(static_cast<const FileData *>(a), static_cast<const FileData *>(b),
+	                                      static_cast<FileData::FileList::SortSettings *>(data));
+}
+
+/**
+ * @brief Whether @a fd passes the view filters
+ */
+static gboolean vf_file_filtered_in(ViewFile *vf, FileData *fd)
+{
+	GList *list = vf_filter_list(vf, g_list_prepend(nullptr, file_data_ref(fd)));
+	const gboolean wanted = (list != nullptr);
+	file_data_list_free(list);
+
+	return wanted;
+}
+
+/**
+ * @brief Whether @a fd belongs in the view, judged on this file alone
+ */
+static gboolean vf_file_wanted(ViewFile *vf, FileData *fd)
+{
+	g_autofree gchar *base = remove_level_from_path(fd->path);
+	if (g_strcmp0(base, vf->dir_fd->path) != 0) return FALSE;
+
+	if (!filelist_is_listed(fd)) return FALSE;
+
+	return vf_file_filtered_in(vf, fd);
+}
+
+/**
+ * @brief The first position in @a links whose file does not sort before @a fd
+ */
+static guint vf_list_links_search(ViewFile *vf, GPtrArray *links, FileData *fd)
+{
+	guint low = 0;
+	guint high = links->len;
+
+	while (low < high)
+		{
+		const guint mid = low + ((high - low) / 2);
+		auto *link = static_cast<GList *>(g_ptr_array_index(links, mid));
+
+		if (vf_sort_compare_cb(link->data, fd, &vf->sort) < 0)
+			{
+			low = mid + 1;
+			}
+		else
+			{
+			high = mid;
+			}
+		}
+
+	return low;
+}
+
+/**
+ * @returns the position of @a fd in @a links, -1 if it is not there
+ */
+static gint vf_list_links_find(ViewFile *vf, GPtrArray *links, FileData *fd)
+{
+	const guint pos = vf_list_links_search(vf, links, fd);
+
+	if (pos < links->len && static_cast<GList *>(g_ptr_array_index(links, pos))->data == fd) return pos;
+
+	/* the sort key of fd changed, as by a rename, or it is not listed */
+	for (guint i = 0; i < links->len; i++)
+		{
+		if (static_cast<GList *>(g_ptr_array_index(links, i))->data == fd) return i;
+		}
+
+	return -1;
+}
+
+/**
+ * @brief Adds, removes or moves @a fd in vf->list and updates its row
+ * @param wanted Whether @a fd belongs in the view, see vf_file_wanted()
+ */
+static void vf_update_fd(ViewFile *vf, FileData *fd, gboolean wanted)
+{
+	GPtrArray *links = vf_list_links(vf);
+	const gint old_index = vf_list_links_find(vf, links, fd);
+	GList *link = (old_index >= 0) ? static_cast<GList *>(g_ptr_array_index(links, old_index)) : nullptr;
+	gint new_index = -1;
+
+	if (!link && !wanted) return;
+
+	if (link && wanted &&
+	    (!link->prev || vf_sort_compare_cb(link->prev->data, fd, &vf->sort) <= 0) &&
+	    (!link->next || vf_sort_compare_cb(fd, link->next->data, &vf->sort) <= 0))
+		{
+		new_index = old_index;
+		}
+	else
+		{
+		/* the list keeps its reference while the view is updated */
+		if (link)
+			{
+			g_ptr_array_remove_index(links, old_index);
+			vf->list = g_list_delete_link(vf->list, link);
+			}
+
+		if (wanted)
+			{
+			const guint pos = vf_list_links_search(vf, links, fd);
+			GList *new_link = g_list_prepend(nullptr, link ? fd : file_data_ref(fd));
+
+			if (pos < links->len)
+				{
+				auto *sibling = static_cast<GList *>(g_ptr_array_index(links, pos));
+
+				vf->list = g_list_insert_before_link(vf->list, sibling, new_link);
+				}
+			else
+				{
+				/* concatenating to the last link does not walk the list */
+				GList *last = (links->len > 0) ? static_cast<GList *>(g_ptr_array_index(links, links->len - 1)) : nullptr;
+
+				last = g_list_concat(last, new_link);
+				if (!vf->list) vf->list = last;
+				}
+
+			g_ptr_array_insert(links, pos, new_link);
+			new_index = pos;
+			}
+		}
+
+	switch (vf->type)
+	{
+	case FILEVIEW_LIST: vflist_refresh_fd(vf, fd, old_index, new_index); break;
+	case FILEVIEW_ICON: vficon_refresh_fd(vf, fd, old_index, new_index); break;
+	}
+
+	if (new_index < 0)
+		{
+		/* vflist_refresh_fd() locked the file when it was added */
+		if (vf->type == FILEVIEW_LIST && vf->marks_enabled) file_data_unlock(fd);
+		file_data_unref(fd);
+		}
+}
+
+/**
+ * @brief Applies the differences between @a list, the files of the folder read again, and the view
+ * @returns FALSE, leaving @a list to the caller, when there are too many differences for single updates
+ *
+ * A change of the folder itself is mostly a file or two added or removed behind our
+ * back, which is cheaper to apply file by file than by filling the view again.
+ */
+static gboolean vf_scan_apply(ViewFile *vf, GList *list)
+{
+	g_autoptr(GHashTable) gone = g_hash_table_new(g_direct_hash, g_direct_equal);
+	GList *added = nullptr;
+
+	for (GList *work = vf->list; work; work = work->next)
+		{
+		g_hash_table_add(gone, work->data);
+		}
+
+	for (GList *work = list; work; work = work->next)
+		{
+		if (!g_hash_table_remove(gone, work->data)) added = g_list_prepend(added, work->data);
+		}
+
+	if (g_hash_table_size(gone) + g_list_length(added) > VF_SCAN_APPLY_MAX)
+		{
+		g_list_free(added);
+		return FALSE;
+		}
+
+	GHashTableIter iter;
+	gpointer key;
+
+	g_hash_table_iter_init(&iter, gone);
+	while (g_hash_table_iter_next(&iter, &key, nullptr))
+		{
+		vf_update_fd(vf, static_cast<FileData *>(key), FALSE);
+		}
+
+	/* the read lists the files of the folder only, the view filters are left */
+	for (GList *work = added; work; work = work->next)
+		{
+		auto *fd = static_cast<FileData *>(work->data);
+
+		vf_update_fd(vf, fd, vf_file_filtered_in(vf, fd));
+		}
+
+	g_list_free(added);
+	file_data_list_free(list);
+
+	vf_send_update(vf);
+	vf_thumb_update(vf);
+	vf_star_update(vf);
+
+	return TRUE;
+}
+
+static void vf_notify_files_unref_cb(gpointer data)
+{
+	file_data_unref(static_cast<FileData *>(data));
+}
+
+/**
+ * @brief Applies the changes of single files collected since the last call
+ *
+ * It runs once per main loop iteration, before the frame is drawn, however many
+ * notifications came in. The cost is proportional to the number of changed files.
+ */
+static gboolean vf_notify_idle_cb(gpointer data)
+{
+	auto vf = static_cast<ViewFile *>(data);
+	g_autoptr(GHashTable) files = g_steal_pointer(&vf->notify_files);
+
+	vf->notify_idle_id = 0;
+
+	if (vf->refresh_idle_id || !vf->dir_fd) return G_SOURCE_REMOVE;
+
+	if (vf->scan)
+		{
+		/* the folder read may have missed these changes */
+		vf->scan_again = TRUE;
+		return G_SOURCE_REMOVE;
+		}
+
+	GHashTableIter iter;
+	gpointer key;
+
+	g_hash_table_iter_init(&iter, files);
+	while (g_hash_table_iter_next(&iter, &key, nullptr))
+		{
+		auto *fd = static_cast<FileData *>(key);
+
+		vf_update_fd(vf, fd, vf_file_wanted(vf, fd));
+		}
+
+	vf_send_update(vf);
+	vf_thumb_update(vf);
+	vf_star_update(vf);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void vf_notify_file(ViewFile *vf, FileData *fd)
+{
+	if (!vf->notify_files)
+		{
+		vf->notify_files = g_hash_table_new_full(g_direct_hash, g_direct_equal, vf_notify_files_unref_cb, nullptr);
+		}
+
+	if (!g_hash_table_contains(vf->notify_files, fd))
+		{
+		g_hash_table_add(vf->notify_files, file_data_ref(fd));
+		}
+
+	/* the row of the parent lists its sidecars */
+	if (fd->parent && !g_hash_table_contains(vf->notify_files, fd->parent))
+		{
+		g_hash_table_add(vf->notify_files, file_data_ref(fd->parent));
+		}
+
+	if (!vf->notify_idle_id)
+		{
+		vf->notify_idle_id = g_idle_add_full(G_PRIORITY_HIGH_IDLE + 10, vf_notify_idle_cb, vf, nullptr);
+		}
+}
+
 void vf_notify_cb(FileData *fd, NotifyType type, gpointer data)
 {
 	auto vf = static_cast<ViewFile *>(data);
-	gboolean refresh;
+	gboolean in_folder;
+	gboolean copied_in = FALSE;
+	gboolean moved_out = FALSE;
 
 	auto interested = static_cast<NotifyType>(NOTIFY_CHANGE | NOTIFY_REREAD | NOTIFY_GROUPING);
 	if (options->show_star_rating)
@@ -1802,34 +2484,47 @@ void vf_notify_cb(FileData *fd, NotifyType type, gpointer data)
 
 	if (!(type & interested) || vf->refresh_idle_id || !vf->dir_fd) return;
 
-	refresh = (fd == vf->dir_fd);
-
-	if (!refresh)
+	if (fd == vf->dir_fd)
 		{
-		g_autofree gchar *base = remove_level_from_path(fd->path);
-		refresh = (g_strcmp0(base, vf->dir_fd->path) == 0);
+		/* files were added or removed behind our back, only a read tells which */
+		DEBUG_1("Notify vf: %s %04x", fd->path, type);
+		vf_refresh_idle(vf);
+		return;
 		}
 
+	g_autofree gchar *base = remove_level_from_path(fd->path);
+	in_folder = (g_strcmp0(base, vf->dir_fd->path) == 0);
+
 	if ((type & NOTIFY_CHANGE) && fd->change)
 		{
-		if (!refresh && fd->change->dest)
+		if (fd->change->dest)
 			{
 			g_autofree gchar *dest_base = remove_level_from_path(fd->change->dest);
-			refresh = (g_strcmp0(dest_base, vf->dir_fd->path) == 0);
+			copied_in = (g_strcmp0(dest_base, vf->dir_fd->path) == 0 && g_strcmp0(fd->change->dest, fd->path) != 0);
 			}
 
-		if (!refresh && fd->change->source)
+		if (fd->change->source)
 			{
 			g_autofree gchar *source_base = remove_level_from_path(fd->change->source);
-			refresh = (g_strcmp0(source_base, vf->dir_fd->path) == 0);
+			moved_out = (g_strcmp0(source_base, vf->dir_fd->path) == 0);
 			}
 		}
 
-	if (refresh)
+	if (!in_folder && !copied_in && !moved_out) return;
+
+	DEBUG_1("Notify vf: %s %04x", fd->path, type);
+
+	if (copied_in)
 		{
-		DEBUG_1("Notify vf: %s %04x", fd->path, type);
-		vf_refresh_idle(vf);
+		/* the copy is a new file, with its own FileData */
+		FileData *dest_fd = file_data_new_group(fd->change->dest);
+
+		vf_notify_file(vf, dest_fd);
+		file_data_unref(dest_fd);
 		}
+
+	/* the source of a move out goes, a changed file in the folder is updated */
+	if (in_folder || moved_out) vf_notify_file(vf, fd);
 }
 
 static gboolean vf_read_metadata_in_idle_cb(gpointer data)
@@ -1884,6 +2579,12 @@ void vf_read_metadata_in_idle(ViewFile *vf)
 {
 	if (!vf) return;
 
+	if (vf->scan)
+		{
+		vf->scan_read_metadata = TRUE;
+		return;
+		}
+
 	if (vf->read_metadata_in_idle_id)
 		{
 		g_idle_remove_by_data(vf);
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *
+ * Unit tests for fast-hash.cc
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+#include <glib.h>
+
+#include "fast-hash.h"
+
+namespace {
+
+// For convenience.
+namespace t = ::testing;
+
+class FastHashTest : public t::Test
+{
+    protected:
+	static std::string pattern(gsize length)
+	{
+		std::string data(length, '\0');
+
+		for (gsize i = 0; i < length; i++)
+			{
+			data[i] = static_cast<gchar>((i * 31) + 7);
+			}
+
+		return data;
+	}
+
+	static FastHashDigest hash(const std::string &data, gsize chunk_size = G_MAXSIZE)
+	{
+		FastHash hash;
+
+		for (gsize offset = 0; offset < data.size(); offset += chunk_size)
+			{
+			hash.update(reinterpret_cast<const guchar *>(data.data()) + offset, std::min(chunk_size, data.size() - offset));
+			}
+
+		return hash.digest();
+	}
+
+	static std::string text(const FastHashDigest &digest)
+	{
+		g_autofree gchar *text = fast_hash_digest_to_text(digest);
+
+		return text;
+	}
+};
+
+/* Any change of these requires a new FAST_HASH_ALGORITHM, cached digests become invalid */
+TEST_F(FastHashTest, KnownAnswers)
+{
+	EXPECT_EQ(text(hash("")), "be6f714f02cfeb36206e490065a9dfe3");
+	EXPECT_EQ(text(hash("a")), "7bc3ddf13d315dfc15b107739db28313");
+	EXPECT_EQ(text(hash("abc")), "237875621fd9951e1b8a08ca82ac74f4");
+	EXPECT_EQ(text(hash("The quick brown fox jumps over the lazy dog")), "59cdd559321664bfc9e61c2de901f5f2");
+	EXPECT_EQ(text(hash(pattern(64))), "6b07e2a6a1bfb0136f6a83110c27eea9");
+	EXPECT_EQ(text(hash(pattern(1024))), "dee49fc999112355ed02564bb5e86f18");
+	EXPECT_EQ(text(hash(pattern(1025))), "509815a7c84dbb5930a69527a567b816");
+	EXPECT_EQ(text(hash(pattern(100000))), "2986fa0f18d1652c2c677e79302b87c4");
+}
+
+TEST_F(FastHashTest, LengthBoundaries)
+{
+	constexpr gsize stripe = FastHash::STRIPE_SIZE;
+	constexpr gsize block = FastHash::STRIPE_SIZE * FastHash::STRIPES_PER_BLOCK;
+	const gsize lengths[] = {0, 1, 7, 8, 9,
+	                         stripe - 1, stripe, stripe + 1,
+	                         (2 * stripe) - 1, 2 * stripe, (2 * stripe) + 1,
+	                         block - 1, block, block + 1,
+	                         (2 * block) - 1, 2 * block, (2 * block) + 1};
+	std::set<std::string> digests;
+
+	for (const gsize length : lengths)
+		{
+		const std::string data = pattern(length);
+		const FastHashDigest expected = hash(data);
+
+		/* The split of the input must not matter */
+		for (const gsize chunk_size : {static_cast<gsize>(1), static_cast<gsize>(7), stripe - 1, stripe, stripe + 1, block + 3})
+			{
+			EXPECT_EQ(hash(data, chunk_size), expected) << "length " << length << ", chunks of " << chunk_size;
+			}
+
+		digests.insert(text(expected));
+		}
+
+	EXPECT_EQ(digests.size(), G_N_ELEMENTS(lengths));
+
+	/* The zero padding of the last stripe is told apart by the length */
+	EXPECT_NE(hash(std::string("a", 1)), hash(std::string("a\0", 2)));
+	EXPECT_NE(hash(""), hash(std::string(stripe, '\0')));
+	EXPECT_NE(hash(std::string(stripe - 1, '\0')), hash(std::string(stripe, '\0')));
+}
+
+TEST_F(FastHashTest, TextRoundTrip)
+{
+	const FastHashDigest digest = hash("abc");
+	FastHashDigest parsed{};
+
+	ASSERT_TRUE(fast_hash_digest_from_text("237875621FD9951E1B8A08CA82AC74F4", parsed));
+	EXPECT_EQ(parsed, digest);
+
+	EXPECT_FALSE(fast_hash_digest_from_text("237875621fd9951e1b8a08ca82ac74f", parsed));
+	EXPECT_FALSE(fast_hash_digest_from_text("237875621fd9951e1b8a08ca82ac74fg", parsed));
+	EXPECT_FALSE(fast_hash_digest_from_text("", parsed));
+}
+
+}  // anonymous namespace
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
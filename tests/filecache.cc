@@ -24,6 +24,9 @@
 
 #include "gtest/gtest.h"
 
+#include <chrono>
+#include <vector>
+
 #include <glib.h>
 
 #include "filecache.h"
@@ -173,6 +176,208 @@ TEST_F(FileCacheTest, ReentrantNotifyPutGet)
 	ASSERT_EQ(1, cache_and_fds.trigger_count);
 }
 
+std::vector<FileData *> released_fds;
+
+void recording_cache_release(FileData *fd)
+{
+	released_fds.push_back(fd);
+}
+
+/**
+ * Ensures that among the least recently used entries, the cheapest one is evicted first, and
+ * that evictions are counted.
+ **/
+TEST_F(FileCacheTest, CostWeightedEviction)
+{
+	std::vector<FileData *> fds;
+	for (gint i = 0; i < 4; i++)
+		{
+		g_autofree gchar *path = g_strdup_printf("/does/not/exist%d.jpg", i);
+		fds.push_back(FileData::file_data_new_simple(path, &context));
+		}
+
+	released_fds.clear();
+	FileCacheData *fc = file_cache_new(recording_cache_release, /*max_size=*/3);
+
+	file_cache_put(fc, fds[0], /*size=*/1, /*cost=*/10);
+	file_cache_put(fc, fds[1], /*size=*/1, /*cost=*/1);
+	file_cache_put(fc, fds[2], /*size=*/1, /*cost=*/10);
+	ASSERT_TRUE(released_fds.empty());
+
+	file_cache_put(fc, fds[3], /*size=*/1, /*cost=*/10);
+	ASSERT_EQ(1U, released_fds.size());
+	ASSERT_EQ(fds[1], released_fds[0]);
+
+	// Trimming keeps the maximum size.
+	file_cache_trim(fc, 1);
+	ASSERT_EQ(3U, released_fds.size());
+
+	const FileCacheStats stats = file_cache_get_stats(fc);
+	ASSERT_EQ(3U, stats.evictions);
+	ASSERT_EQ(1U, stats.entries);
+	ASSERT_EQ(1UL, stats.size);
+	ASSERT_EQ(3UL, stats.max_size);
+
+	file_cache_set_max_size(fc, 0);
+	ASSERT_EQ(4U, released_fds.size());
+
+	for (FileData *&entry_fd : fds)
+		{
+		g_clear_pointer(&entry_fd, g_free);
+		}
+}
+
+/**
+ * Ensures that the minimum number of entries is kept even when they are over the maximum size.
+ **/
+TEST_F(FileCacheTest, MinimumEntries)
+{
+	std::vector<FileData *> fds;
+	for (gint i = 0; i < 3; i++)
+		{
+		g_autofree gchar *path = g_strdup_printf("/does/not/exist%d.jpg", i);
+		fds.push_back(FileData::file_data_new_simple(path, &context));
+		}
+
+	released_fds.clear();
+	FileCacheData *fc = file_cache_new(recording_cache_release, /*max_size=*/1);
+	file_cache_set_min_entries(fc, 2);
+
+	file_cache_put(fc, fds[0], /*size=*/5);
+	file_cache_put(fc, fds[1], /*size=*/5);
+	ASSERT_TRUE(released_fds.empty());
+
+	file_cache_put(fc, fds[2], /*size=*/5);
+	ASSERT_EQ(1U, released_fds.size());
+	ASSERT_EQ(fds[0], released_fds[0]);
+	ASSERT_EQ(2U, file_cache_get_stats(fc).entries);
+
+	file_cache_set_min_entries(fc, 0);
+	ASSERT_EQ(3U, released_fds.size());
+
+	for (FileData *&entry_fd : fds)
+		{
+		g_clear_pointer(&entry_fd, g_free);
+		}
+}
+
+struct ShrinkWhileChecking
+{
+	FileCacheData *fc;
+	std::vector<FileData *> &fds;
+	gint trigger_count = 0;
+	gsize released_during_check = 0;
+};
+
+void shrink_while_checking_notify_cb(FileData *, NotifyType, gpointer data)
+{
+	auto *shrink = static_cast<ShrinkWhileChecking *>(data);
+	if (shrink->trigger_count++ > 0) return;
+
+	// The entry being checked is now the least recently used one.
+	file_cache_put(shrink->fc, shrink->fds[1], /*size=*/1);
+	file_cache_put(shrink->fc, shrink->fds[2], /*size=*/1);
+	file_cache_set_max_size(shrink->fc, 0);
+
+	shrink->released_during_check = released_fds.size();
+}
+
+/**
+ * Ensures that skipping an entry that is being checked does not make the most recently used
+ * entries candidates for eviction.
+ **/
+TEST_F(FileCacheTest, MinimumEntriesWhileChecking)
+{
+	std::vector<FileData *> fds;
+	for (gint i = 0; i < 3; i++)
+		{
+		g_autofree gchar *path = g_strdup_printf("/does/not/exist%d.jpg", i);
+		fds.push_back(FileData::file_data_new_simple(path, &context));
+		}
+
+	released_fds.clear();
+	FileCacheData *fc = file_cache_new(recording_cache_release, /*max_size=*/5);
+	file_cache_set_min_entries(fc, 2);
+
+	ShrinkWhileChecking shrink{fc, fds};
+	register_notify_func_with_cleanup(shrink_while_checking_notify_cb, &shrink, NOTIFY_PRIORITY_HIGH);
+
+	file_cache_put(fc, fds[0], /*size=*/1);
+	ASSERT_FALSE(file_cache_get(fc, fds[0]));
+	ASSERT_GE(shrink.trigger_count, 1);
+	ASSERT_EQ(0U, shrink.released_during_check);
+
+	// Only the changed entry is gone once it has been checked.
+	ASSERT_EQ(1U, released_fds.size());
+	ASSERT_EQ(fds[0], released_fds[0]);
+	ASSERT_EQ(2U, file_cache_get_stats(fc).entries);
+
+	file_cache_set_min_entries(fc, 0);
+	ASSERT_EQ(3U, released_fds.size());
+
+	for (FileData *&entry_fd : fds)
+		{
+		g_clear_pointer(&entry_fd, g_free);
+		}
+}
+
+gint benchmark_release_count = 0;
+
+void benchmark_cache_release(FileData *)
+{
+	++benchmark_release_count;
+}
+
+/**
+ * Microbenchmark for the cache lookup and eviction paths.  Each put, get, and eviction should
+ * be O(1), so the timings should grow linearly with the number of entries.
+ * Run with --gtest_also_run_disabled_tests.
+ **/
+TEST_F(FileCacheTest, DISABLED_LookupAndEvictionBenchmark)
+{
+	constexpr gint entry_count = 20000;
+
+	std::vector<FileData *> fds;
+	fds.reserve(entry_count);
+	for (gint i = 0; i < entry_count; i++)
+		{
+		g_autofree gchar *path = g_strdup_printf("/does/not/exist%d.jpg", i);
+		fds.push_back(FileData::file_data_new_simple(path, &context));
+		}
+
+	benchmark_release_count = 0;
+	FileCacheData *fc = file_cache_new(benchmark_cache_release, /*max_size=*/entry_count / 2);
+
+	// Every put after the first half of the entries evicts the least recently used entry.
+	const auto put_start = std::chrono::steady_clock::now();
+	for (FileData *entry_fd : fds)
+		{
+		file_cache_put(fc, entry_fd, /*size=*/1);
+		}
+	const auto put_end = std::chrono::steady_clock::now();
+	ASSERT_EQ(entry_count / 2, benchmark_release_count);
+
+	// The first half of the entries are misses.  The second half are hits, which are then
+	// evicted because the underlying files don't exist.
+	const auto get_start = std::chrono::steady_clock::now();
+	for (FileData *entry_fd : fds)
+		{
+		ASSERT_FALSE(file_cache_get(fc, entry_fd));
+		}
+	const auto get_end = std::chrono::steady_clock::now();
+	ASSERT_EQ(entry_count, benchmark_release_count);
+
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+	std::cerr << entry_count << " puts: " << duration_cast<microseconds>(put_end - put_start).count() << "us, "
+	          << entry_count << " gets: " << duration_cast<microseconds>(get_end - get_start).count() << "us\n";
+
+	for (FileData *&entry_fd : fds)
+		{
+		g_clear_pointer(&entry_fd, g_free);
+		}
+}
+
 }  // anonymous namespace
 
 /* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
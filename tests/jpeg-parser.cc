@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *
+ * Unit tests for the fast tag reader of jpeg-parser.cc
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glib.h>
+
+#include "jpeg-parser.h"
+
+namespace {
+
+// For convenience.
+namespace t = ::testing;
+
+struct TiffEntry
+{
+	guint16 tag;
+	guint16 format;
+	guint32 count;
+	std::string data;
+};
+
+class ExifFastParseTest : public t::Test
+{
+    protected:
+	static std::string le16(guint v)
+	{
+		return {static_cast<gchar>(v & 0xff), static_cast<gchar>((v >> 8) & 0xff)};
+	}
+
+	static std::string le32(guint v)
+	{
+		return le16(v & 0xffff) + le16(v >> 16);
+	}
+
+	static std::string be16(guint v)
+	{
+		return {static_cast<gchar>((v >> 8) & 0xff), static_cast<gchar>(v & 0xff)};
+	}
+
+	static TiffEntry ascii(guint16 tag, const std::string &text)
+	{
+		return {tag, 2, static_cast<guint32>(text.size() + 1), text + std::string(1, '\0')};
+	}
+
+	static TiffEntry number(guint16 tag, guint v)
+	{
+		return {tag, 4, 1, le32(v)};
+	}
+
+	static TiffEntry rationals(guint16 tag, const std::vector<std::pair<guint, guint>> &values)
+	{
+		std::string data;
+		for (const auto &[numerator, denominator] : values) data += le32(numerator) + le32(denominator);
+
+		return {tag, 5, static_cast<guint32>(values.size()), data};
+	}
+
+	/* Appends an IFD with its out of line values, returns its offset */
+	static guint add_ifd(std::string &tiff, const std::vector<TiffEntry> &entries, guint next)
+	{
+		if (tiff.size() % 2) tiff.push_back('\0');
+
+		const guint offset = tiff.size();
+		guint data_offset = offset + 2 + (entries.size() * 12) + 4;
+		std::string table = le16(entries.size());
+		std::string data;
+
+		for (const TiffEntry &e : entries)
+			{
+			table += le16(e.tag) + le16(e.format) + le32(e.count);
+			if (e.data.size() <= 4)
+				{
+				table += e.data + std::string(4 - e.data.size(), '\0');
+				}
+			else
+				{
+				table += le32(data_offset + data.size());
+				data += e.data;
+				}
+			}
+		table += le32(next);
+
+		tiff += table + data;
+
+		return offset;
+	}
+
+	static std::string jpeg_stream(guint width, guint height, guchar frame = 0xc0)
+	{
+		std::string jpeg = "\xff\xd8";
+		jpeg += std::string("\xff") + static_cast<gchar>(frame) + be16(11) + "\x08" + be16(height) + be16(width) + std::string("\x01\x01\x11\x00", 4);
+		jpeg += "\xff\xd9";
+
+		return jpeg;
+	}
+
+	static std::string app1(const std::string &magic, const std::string &payload)
+	{
+		return "\xff\xe1" + be16(2 + magic.size() + payload.size()) + magic + payload;
+	}
+
+	static std::string exif_tiff(std::string &thumbnail)
+	{
+		std::string tiff = std::string("II*\0", 4) + le32(0);
+
+		const guint exif_ifd = add_ifd(tiff, {ascii(0x9003, "2021:06:05 14:03:02"),
+		                                      number(0xa002, 4000),
+		                                      number(0xa003, 3000),
+		                                      ascii(0xa434, "EF 50mm f/1.8")}, 0);
+		const guint gps_ifd = add_ifd(tiff, {ascii(1, "N"),
+		                                     rationals(2, {{48, 1}, {30, 1}, {0, 1}}),
+		                                     ascii(3, "W"),
+		                                     rationals(4, {{2, 1}, {15, 1}, {36, 1}})}, 0);
+
+		thumbnail = jpeg_stream(160, 120);
+		const guint thumbnail_offset = tiff.size();
+		tiff += thumbnail;
+
+		const guint ifd1 = add_ifd(tiff, {number(0x0201, thumbnail_offset),
+		                                  number(0x0202, thumbnail.size())}, 0);
+		const guint ifd0 = add_ifd(tiff, {ascii(0x010f, "Canon"),
+		                                  ascii(0x0110, "Canon EOS 80D"),
+		                                  {0x0112, 3, 1, le16(6)},
+		                                  number(0x8769, exif_ifd),
+		                                  number(0x8825, gps_ifd)}, ifd1);
+		tiff.replace(4, 4, le32(ifd0));
+
+		return tiff;
+	}
+
+	static std::string jpeg_file(const std::string &xmp)
+	{
+		std::string thumbnail;
+		std::string jpeg = "\xff\xd8";
+
+		jpeg += app1(std::string("Exif\0\0", 6), exif_tiff(thumbnail));
+		if (!xmp.empty()) jpeg += app1(std::string("http://ns.adobe.com/xap/1.0/\0", 29), xmp);
+		jpeg += "\xff\xda" + be16(2) + std::string(64, '\x55') + "\xff\xd9";
+
+		return jpeg;
+	}
+
+	static bool parse(const std::string &file, ExifFastData &fast)
+	{
+		return exif_fast_parse(reinterpret_cast<const guchar *>(file.data()), file.size(), fast);
+	}
+};
+
+TEST_F(ExifFastParseTest, JpegTags)
+{
+	const std::string file = jpeg_file(R"(<x:xmpmeta><rdf:RDF><rdf:Description xmp:Rating="3">)"
+	                                   R"(<dc:subject><rdf:Bag><rdf:li>Paris</rdf:li><rdf:li>a &amp; b</rdf:li><rdf:li/></rdf:Bag></dc:subject>)"
+	                                   R"(</rdf:Description></rdf:RDF></x:xmpmeta>)");
+	ExifFastData fast;
+
+	ASSERT_TRUE(parse(file, fast));
+	EXPECT_TRUE(fast.complete);
+	EXPECT_EQ(fast.date_time_original, "2021:06:05 14:03:02");
+	EXPECT_EQ(fast.date_time_digitized, "");
+	EXPECT_EQ(fast.make, "Canon");
+	EXPECT_EQ(fast.model, "Canon EOS 80D");
+	EXPECT_EQ(fast.lens, "EF 50mm f/1.8");
+	EXPECT_EQ(fast.orientation, 6U);
+	EXPECT_EQ(fast.width, 4000U);
+	EXPECT_EQ(fast.height, 3000U);
+	EXPECT_EQ(fast.rating, 3);
+	EXPECT_EQ(fast.keywords, (std::vector<std::string>{"Paris", "a & b"}));
+
+	ASSERT_TRUE(fast.has_gps);
+	EXPECT_DOUBLE_EQ(fast.latitude, 48.5);
+	EXPECT_DOUBLE_EQ(fast.longitude, -2.26);
+
+	ASSERT_EQ(fast.previews.size(), 1U);
+	EXPECT_EQ(fast.previews[0].width, 160U);
+	EXPECT_EQ(fast.previews[0].height, 120U);
+	EXPECT_EQ(file.compare(fast.previews[0].offset, fast.previews[0].length, jpeg_stream(160, 120)), 0);
+}
+
+TEST_F(ExifFastParseTest, XmpMergedByExiv2IsIncomplete)
+{
+	ExifFastData fast;
+
+	ASSERT_TRUE(parse(jpeg_file(R"(<rdf:Description tiff:Orientation="1"/>)"), fast));
+	EXPECT_FALSE(fast.complete);
+
+	ASSERT_TRUE(parse(jpeg_file(R"(<rdf:Description><xmp:Rating>-1</xmp:Rating></rdf:Description>)"), fast));
+	EXPECT_TRUE(fast.complete);
+	EXPECT_EQ(fast.rating, -1);
+}
+
+TEST_F(ExifFastParseTest, XmpNamespacePrefixes)
+{
+	const auto packet = [](const std::string &declarations, const std::string &properties)
+	{
+		return R"(<x:xmpmeta xmlns:x="adobe:ns:meta/"><rdf:RDF xmlns:rdf="http://www.w3.org/1999/02/22-rdf-syntax-ns#">)"
+		       "<rdf:Description " + declarations + " " + properties + "/></rdf:RDF></x:xmpmeta>";
+	};
+	ExifFastData fast;
+
+	ASSERT_TRUE(parse(jpeg_file(packet(R"(xmlns:xmp="http://ns.adobe.com/xap/1.0/")", R"(xmp:Rating="3")")), fast));
+	EXPECT_TRUE(fast.complete);
+	EXPECT_EQ(fast.rating, 3);
+
+	/* The older prefix of the same namespace */
+	ASSERT_TRUE(parse(jpeg_file(packet(R"(xmlns:xap="http://ns.adobe.com/xap/1.0/")", R"(xap:Rating="3")")), fast));
+	EXPECT_FALSE(fast.complete);
+
+	/* The usual prefix bound to another namespace */
+	ASSERT_TRUE(parse(jpeg_file(packet(R"(xmlns:xmp='http://example.com/xmp/')", R"(xmp:Rating="3")")), fast));
+	EXPECT_FALSE(fast.complete);
+
+	/* TIFF properties under another prefix are still merged by Exiv2 */
+	ASSERT_TRUE(parse(jpeg_file(packet(R"(xmlns:t="http://ns.adobe.com/tiff/1.0/")", R"(t:Orientation="1")")), fast));
+	EXPECT_FALSE(fast.complete);
+}
+
+TEST_F(ExifFastParseTest, IptcReadByExiv2IsIncomplete)
+{
+	std::string file = jpeg_file("");
+	const std::string iptc = std::string("Photoshop 3.0\0", 14) + "8BIM" + std::string(8, '\0');
+	file.insert(file.find("\xff\xda"), "\xff\xed" + be16(2 + iptc.size()) + iptc);
+	ExifFastData fast;
+
+	ASSERT_TRUE(parse(file, fast));
+	EXPECT_FALSE(fast.complete);
+	EXPECT_EQ(fast.model, "Canon EOS 80D");
+
+	/* The IPTC and Photoshop tags of TIFF based files */
+	for (const guint16 tag : {0x83bb, 0x8649})
+		{
+		std::string tiff = std::string("II*\0", 4) + le32(0);
+		const guint ifd0 = add_ifd(tiff, {ascii(0x0110, "DSC-RX100"), {tag, 7, 4, "8BIM"}}, 0);
+		tiff.replace(4, 4, le32(ifd0));
+
+		ASSERT_TRUE(parse(tiff, fast));
+		EXPECT_FALSE(fast.complete) << tag;
+		EXPECT_EQ(fast.model, "DSC-RX100");
+		}
+}
+
+TEST_F(ExifFastParseTest, TiffPreviews)
+{
+	std::string tiff = std::string("MM\0*", 4) + std::string(4, '\0');
+	const std::string preview = jpeg_stream(1620, 1080);
+	const std::string raw = jpeg_stream(6000, 4000, 0xc3);
+
+	/* Big endian values for this one */
+	const auto be32 = [](guint v) { return be16(v >> 16) + be16(v & 0xffff); };
+	const auto entry = [&be32](guint tag, guint v) { return be16(tag) + be16(4) + be32(1) + be32(v); };
+
+	const guint preview_offset = tiff.size();
+	tiff += preview;
+	const guint raw_offset = tiff.size();
+	tiff += raw;
+
+	const guint sub_ifd = tiff.size();
+	tiff += be16(3) + entry(0x0103, 7) + entry(0x0111, raw_offset) + entry(0x0117, raw.size()) + be32(0);
+	const guint ifd0 = tiff.size();
+	tiff += be16(4) + entry(0x0103, 6) + entry(0x0111, preview_offset) + entry(0x0117, preview.size()) + entry(0x014a, sub_ifd) + be32(0);
+	tiff.replace(4, 4, be32(ifd0));
+
+	ExifFastData fast;
+	ASSERT_TRUE(parse(tiff, fast));
+
+	/* The lossless raw data is not a preview */
+	ASSERT_EQ(fast.previews.size(), 1U);
+	EXPECT_EQ(fast.previews[0].offset, preview_offset);
+	EXPECT_EQ(fast.previews[0].width, 1620U);
+	EXPECT_EQ(fast.previews[0].height, 1080U);
+}
+
+TEST_F(ExifFastParseTest, TruncatedFiles)
+{
+	const std::string file = jpeg_file(R"(<rdf:Description xmp:Rating="5"/>)");
+	ExifFastData fast;
+
+	for (size_t size = 0; size < file.size(); size++)
+		{
+		const std::string truncated = file.substr(0, size);
+		parse(truncated, fast);
+
+		for (const ExifFastPreview &preview : fast.previews)
+			{
+			EXPECT_LE(preview.offset + preview.length, size);
+			}
+		}
+
+	EXPECT_FALSE(parse("not an image", fast));
+}
+
+}  // anonymous namespace
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *
+ * Unit tests for pixbuf-resample.cc
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib.h>
+
+#include "pixbuf-resample.h"
+
+namespace {
+
+// For convenience.
+namespace t = ::testing;
+
+using Pixels = guchar (*)(gint x, gint y, gint channel);
+
+constexpr PixbufResampleFilter all_filters[] = {PixbufResampleFilter::BOX, PixbufResampleFilter::BILINEAR, PixbufResampleFilter::LANCZOS3};
+constexpr PixbufResampleSimd all_simd[] = {PixbufResampleSimd::SSE4_1, PixbufResampleSimd::AVX2, PixbufResampleSimd::NEON};
+
+class PixbufResampleTest : public t::Test
+{
+    protected:
+	void SetUp() override
+	{
+		default_simd = pixbuf_resample_get_simd();
+	}
+
+	void TearDown() override
+	{
+		pixbuf_resample_set_simd(default_simd);
+	}
+
+	static GdkPixbuf *new_pixbuf(gint width, gint height, Pixels pixels)
+	{
+		GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+		const gint rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+		guchar *data = gdk_pixbuf_get_pixels(pixbuf);
+
+		for (gint y = 0; y < height; y++)
+			{
+			for (gint x = 0; x < width; x++)
+				{
+				for (gint c = 0; c < 3; c++)
+					{
+					data[(y * rowstride) + (x * 3) + c] = pixels ? pixels(x, y, c) : 0;
+					}
+				}
+			}
+
+		return pixbuf;
+	}
+
+	static gint max_diff(GdkPixbuf *a, GdkPixbuf *b, gint border)
+	{
+		const gint width = gdk_pixbuf_get_width(a);
+		const gint height = gdk_pixbuf_get_height(a);
+		const guchar *pa = gdk_pixbuf_read_pixels(a);
+		const guchar *pb = gdk_pixbuf_read_pixels(b);
+		gint diff = 0;
+
+		for (gint y = border; y < height - border; y++)
+			{
+			for (gint x = border * 3; x < (width - border) * 3; x++)
+				{
+				diff = std::max(diff, std::abs(pa[(y * gdk_pixbuf_get_rowstride(a)) + x] -
+				                               pb[(y * gdk_pixbuf_get_rowstride(b)) + x]));
+				}
+			}
+
+		return diff;
+	}
+
+	static GdkPixbuf *resample(GdkPixbuf *src, gint width, gint height, PixbufResampleFilter filter)
+	{
+		GdkPixbuf *dest = new_pixbuf(width, height, nullptr);
+		const gdouble scale_x = static_cast<gdouble>(width) / gdk_pixbuf_get_width(src);
+		const gdouble scale_y = static_cast<gdouble>(height) / gdk_pixbuf_get_height(src);
+
+		pixbuf_resample(src, dest, 0, 0, width, height, 0.0, 0.0, scale_x, scale_y, filter);
+
+		return dest;
+	}
+
+	static guchar noise(gint x, gint y, gint channel)
+	{
+		return (((x * 7919) ^ (y * 104729) ^ (channel * 31)) * 2654435761U) >> 24;
+	}
+
+	static guchar gradient(gint x, gint y, gint channel)
+	{
+		return x + y + (channel * 40);
+	}
+
+	PixbufResampleSimd default_simd;
+};
+
+TEST_F(PixbufResampleTest, SimdMatchesPlainC)
+{
+	g_autoptr(GdkPixbuf) src = new_pixbuf(173, 121, noise);
+	const gint sizes[][2] = {{61, 47}, {173, 121}, {410, 299}, {17, 250}};
+
+	for (const PixbufResampleSimd simd : all_simd)
+		{
+		if (!pixbuf_resample_simd_supported(simd)) continue;
+
+		for (const PixbufResampleFilter filter : all_filters)
+			{
+			for (const auto &size : sizes)
+				{
+				pixbuf_resample_set_simd(PixbufResampleSimd::NONE);
+				g_autoptr(GdkPixbuf) expected = resample(src, size[0], size[1], filter);
+
+				ASSERT_EQ(pixbuf_resample_set_simd(simd), simd);
+				g_autoptr(GdkPixbuf) actual = resample(src, size[0], size[1], filter);
+
+				EXPECT_EQ(max_diff(expected, actual, 0), 0) << "simd " << static_cast<gint>(simd)
+				                                            << " filter " << static_cast<gint>(filter)
+				                                            << " size " << size[0] << "x" << size[1];
+				}
+			}
+		}
+}
+
+TEST_F(PixbufResampleTest, ConstantImageIsPreserved)
+{
+	g_autoptr(GdkPixbuf) src = new_pixbuf(97, 83, [](gint, gint, gint channel) -> guchar { return 60 + (channel * 70); });
+
+	for (const PixbufResampleFilter filter : all_filters)
+		{
+		g_autoptr(GdkPixbuf) smaller = resample(src, 31, 29, filter);
+		g_autoptr(GdkPixbuf) expected_smaller = new_pixbuf(31, 29, [](gint, gint, gint channel) -> guchar { return 60 + (channel * 70); });
+		EXPECT_EQ(max_diff(smaller, expected_smaller, 0), 0);
+
+		g_autoptr(GdkPixbuf) larger = resample(src, 250, 190, filter);
+		g_autoptr(GdkPixbuf) expected_larger = new_pixbuf(250, 190, [](gint, gint, gint channel) -> guchar { return 60 + (channel * 70); });
+		EXPECT_EQ(max_diff(larger, expected_larger, 0), 0);
+		}
+}
+
+TEST_F(PixbufResampleTest, CloseToGdkPixbuf)
+{
+	g_autoptr(GdkPixbuf) src = new_pixbuf(100, 60, gradient);
+	g_autoptr(GdkPixbuf) actual = resample(src, 50, 30, PixbufResampleFilter::BILINEAR);
+	g_autoptr(GdkPixbuf) expected = new_pixbuf(50, 30, nullptr);
+
+	gdk_pixbuf_scale(src, expected, 0, 0, 50, 30, 0.0, 0.0, 0.5, 0.5, GDK_INTERP_BILINEAR);
+
+	/* Away from the edges, only rounding should differ */
+	EXPECT_LE(max_diff(actual, expected, 4), 2);
+}
+
+/* Run with --gtest_also_run_disabled_tests, or meson test --benchmark */
+TEST_F(PixbufResampleTest, DISABLED_Benchmark)
+{
+	constexpr gint width = 2000;
+	constexpr gint height = 1500;
+	constexpr gint runs = 5;
+	const gdouble scales[] = {0.23, 0.5, 1.7};
+	const std::pair<PixbufResampleFilter, GdkInterpType> filters[] = {
+		{PixbufResampleFilter::BOX, GDK_INTERP_TILES},
+		{PixbufResampleFilter::BILINEAR, GDK_INTERP_BILINEAR},
+		{PixbufResampleFilter::LANCZOS3, GDK_INTERP_HYPER}};
+
+	g_autoptr(GdkPixbuf) src = new_pixbuf(width, height, noise);
+
+	for (const gdouble scale : scales)
+		{
+		const gint dest_width = width * scale;
+		const gint dest_height = height * scale;
+		g_autoptr(GdkPixbuf) expected = new_pixbuf(dest_width, dest_height, nullptr);
+		g_autoptr(GdkPixbuf) actual = new_pixbuf(dest_width, dest_height, nullptr);
+
+		for (const auto &filter : filters)
+			{
+			auto start = std::chrono::steady_clock::now();
+			for (gint i = 0; i < runs; i++)
+				{
+				gdk_pixbuf_scale(src, expected, 0, 0, dest_width, dest_height, 0.0, 0.0, scale, scale, filter.second);
+				}
+			const std::chrono::duration<gdouble> gdk_time = std::chrono::steady_clock::now() - start;
+
+			start = std::chrono::steady_clock::now();
+			for (gint i = 0; i < runs; i++)
+				{
+				pixbuf_resample(src, actual, 0, 0, dest_width, dest_height, 0.0, 0.0, scale, scale, filter.first);
+				}
+			const std::chrono::duration<gdouble> resample_time = std::chrono::steady_clock::now() - start;
+
+			const gdouble mpixels = static_cast<gdouble>(dest_width) * dest_height * runs / 1e6;
+			std::cout << "scale " << scale << " filter " << static_cast<gint>(filter.first)
+			          << " simd " << static_cast<gint>(pixbuf_resample_get_simd())
+			          << ": gdk " << mpixels / gdk_time.count() << " Mpx/s"
+			          << ", resample " << mpixels / resample_time.count() << " Mpx/s"
+			          << ", max diff " << max_diff(actual, expected, 4) << "\n";
+			}
+		}
+}
+
+}  // anonymous namespace
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 The Geeqie Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *
+ * Unit tests for thumb-pack.cc
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+
+#include <string>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gio/gio.h>
+#include <glib.h>
+
+#include "cache.h"
+#include "options.h"
+#include "thumb-pack.h"
+#include "ui-fileops.h"
+
+namespace {
+
+// For convenience.
+namespace t = ::testing;
+
+class ThumbPackTest : public t::Test
+{
+    protected:
+	static GdkPixbuf *new_pixbuf(gint width, gint height, gboolean has_alpha)
+	{
+		GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, has_alpha, 8, width, height);
+		const gint rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+		const gint channels = gdk_pixbuf_get_n_channels(pixbuf);
+		guchar *data = gdk_pixbuf_get_pixels(pixbuf);
+
+		/* Flat areas, gradients and noise, to use all operations */
+		for (gint y = 0; y < height; y++)
+			{
+			for (gint x = 0; x < width; x++)
+				{
+				guchar *p = data + (y * rowstride) + (x * channels);
+				for (gint c = 0; c < channels; c++)
+					{
+					if (y < height / 3)
+						p[c] = (c == 3) ? 255 : 40;
+					else if (y < 2 * height / 3)
+						p[c] = (c == 3) ? 255 - x : x + (y * c);
+					else
+						p[c] = (((x * 7919) ^ (y * 104729) ^ (c * 31)) * 2654435761U) >> 24;
+					}
+				}
+			}
+
+		return pixbuf;
+	}
+
+	static bool same_pixels(GdkPixbuf *a, GdkPixbuf *b)
+	{
+		if (gdk_pixbuf_get_width(a) != gdk_pixbuf_get_width(b) ||
+		    gdk_pixbuf_get_height(a) != gdk_pixbuf_get_height(b) ||
+		    gdk_pixbuf_get_n_channels(a) != gdk_pixbuf_get_n_channels(b)) return false;
+
+		const gint row_length = gdk_pixbuf_get_width(a) * gdk_pixbuf_get_n_channels(a);
+		for (gint y = 0; y < gdk_pixbuf_get_height(a); y++)
+			{
+			if (memcmp(gdk_pixbuf_read_pixels(a) + (y * gdk_pixbuf_get_rowstride(a)),
+			           gdk_pixbuf_read_pixels(b) + (y * gdk_pixbuf_get_rowstride(b)), row_length) != 0) return false;
+			}
+
+		return true;
+	}
+};
+
+class ThumbPackFileTest : public ThumbPackTest
+{
+    protected:
+	void SetUp() override
+	{
+		dir = g_dir_make_tmp("geeqie_thumb_pack_XXXXXX", nullptr);
+		ASSERT_NE(dir, nullptr);
+
+		/* The packs are put in the .thumbnails folder next to the sources */
+		saved_options = options;
+		options = g_new0(ConfOptions, 1);
+		options->thumbnails.cache_into_dirs = TRUE;
+	}
+
+	void TearDown() override
+	{
+		thumb_pack_flush();
+
+		g_free(options);
+		options = saved_options;
+
+		if (dir)
+			{
+			g_autoptr(GFile) file = g_file_new_for_path(dir);
+			rmdir_recursive(file, nullptr, nullptr);
+			g_free(dir);
+			}
+	}
+
+	std::string source(gint i) const
+	{
+		g_autofree gchar *name = g_strdup_printf("%02d.jpg", i);
+		g_autofree gchar *path = g_build_filename(dir, name, NULL);
+
+		return path;
+	}
+
+	std::string pack_path() const
+	{
+		g_autofree gchar *path = g_build_filename(dir, GQ_CACHE_LOCAL_THUMB, GQ_CACHE_THUMB_PACK_LARGE, NULL);
+
+		return path;
+	}
+
+	static goffset file_size(const std::string &path)
+	{
+		struct stat st;
+
+		return (stat(path.c_str(), &st) == 0) ? st.st_size : -1;
+	}
+
+	gchar *dir = nullptr;
+	ConfOptions *saved_options = nullptr;
+};
+
+TEST_F(ThumbPackTest, RoundTrip)
+{
+	for (const gboolean has_alpha : {FALSE, TRUE})
+		{
+		g_autoptr(GdkPixbuf) pixbuf = new_pixbuf(128, 93, has_alpha);
+
+		const std::string data = thumb_pack_encode(pixbuf);
+		EXPECT_LT(data.size(), 128U * 93U * gdk_pixbuf_get_n_channels(pixbuf));
+
+		g_autoptr(GdkPixbuf) decoded = thumb_pack_decode(reinterpret_cast<const guchar *>(data.data()), data.size(), 128, 93, has_alpha);
+		ASSERT_NE(decoded, nullptr);
+		EXPECT_TRUE(same_pixels(pixbuf, decoded)) << "alpha " << has_alpha;
+		}
+}
+
+TEST_F(ThumbPackTest, BrokenDataIsRejected)
+{
+	g_autoptr(GdkPixbuf) pixbuf = new_pixbuf(64, 48, FALSE);
+	const std::string data = thumb_pack_encode(pixbuf);
+	const auto *bytes = reinterpret_cast<const guchar *>(data.data());
+
+	EXPECT_EQ(thumb_pack_decode(bytes, data.size() - 1, 64, 48, FALSE), nullptr);
+	EXPECT_EQ(thumb_pack_decode(bytes, data.size(), 64, 47, FALSE), nullptr);
+	EXPECT_EQ(thumb_pack_decode(bytes, data.size(), 64, 49, FALSE), nullptr);
+	EXPECT_EQ(thumb_pack_decode(bytes, 0, 64, 48, FALSE), nullptr);
+}
+
+TEST_F(ThumbPackFileTest, WriteFlushAndCompact)
+{
+	constexpr gint count = 16;
+	constexpr time_t mtime = 1000000;
+	g_autoptr(GdkPixbuf) pixbuf = new_pixbuf(256, 256, TRUE);
+	gboolean failed;
+
+	for (gint i = 0; i < count; i++)
+		{
+		ASSERT_TRUE(g_file_set_contents(source(i).c_str(), "x", 1, nullptr));
+		thumb_pack_write(source(i).c_str(), mtime + i, 1, ThumbPackSize::LARGE, (i == 1) ? nullptr : pixbuf);
+		}
+
+	/* Not yet in the index, read from the appended records */
+	g_autoptr(GdkPixbuf) appended = thumb_pack_read(source(0).c_str(), mtime, 1, ThumbPackSize::LARGE, failed);
+	ASSERT_NE(appended, nullptr);
+	EXPECT_TRUE(same_pixels(pixbuf, appended));
+
+	thumb_pack_flush();
+	const goffset full_size = file_size(pack_path());
+	ASSERT_GT(full_size, 1024 * 1024) << "too small to be compacted";
+
+	/* Read through the index of the mapped file */
+	for (gint i = 0; i < count; i++)
+		{
+		EXPECT_TRUE(thumb_pack_contains(source(i).c_str(), mtime + i, 1, ThumbPackSize::LARGE)) << i;
+		EXPECT_FALSE(thumb_pack_contains(source(i).c_str(), mtime + i, 1, ThumbPackSize::NORMAL)) << i;
+		}
+
+	g_autoptr(GdkPixbuf) indexed = thumb_pack_read(source(2).c_str(), mtime + 2, 1, ThumbPackSize::LARGE, failed);
+	ASSERT_NE(indexed, nullptr);
+	EXPECT_FALSE(failed);
+	EXPECT_TRUE(same_pixels(pixbuf, indexed));
+
+	EXPECT_EQ(thumb_pack_read(source(1).c_str(), mtime + 1, 1, ThumbPackSize::LARGE, failed), nullptr);
+	EXPECT_TRUE(failed);
+
+	/* A changed source is a miss */
+	EXPECT_FALSE(thumb_pack_contains(source(2).c_str(), mtime + 3, 1, ThumbPackSize::LARGE));
+	EXPECT_EQ(thumb_pack_read(source(2).c_str(), mtime + 3, 1, ThumbPackSize::LARGE, failed), nullptr);
+	EXPECT_FALSE(failed);
+	EXPECT_EQ(thumb_pack_read(source(2).c_str(), mtime + 2, 2, ThumbPackSize::LARGE, failed), nullptr);
+
+	/* Most sources removed, the next flush drops their thumbnails and compacts the file */
+	for (gint i = 3; i < count; i++)
+		{
+		ASSERT_TRUE(unlink_file(source(i).c_str()));
+		}
+	thumb_pack_write(source(0).c_str(), mtime + 100, 1, ThumbPackSize::LARGE, pixbuf);
+	thumb_pack_flush();
+
+	EXPECT_LT(file_size(pack_path()), full_size / 4);
+
+	for (gint i = 3; i < count; i++)
+		{
+		EXPECT_FALSE(thumb_pack_contains(source(i).c_str(), mtime + i, 1, ThumbPackSize::LARGE)) << i;
+		}
+	EXPECT_FALSE(thumb_pack_contains(source(0).c_str(), mtime, 1, ThumbPackSize::LARGE));
+
+	g_autoptr(GdkPixbuf) rewritten = thumb_pack_read(source(0).c_str(), mtime + 100, 1, ThumbPackSize::LARGE, failed);
+	ASSERT_NE(rewritten, nullptr);
+	EXPECT_TRUE(same_pixels(pixbuf, rewritten));
+
+	g_autoptr(GdkPixbuf) kept = thumb_pack_read(source(2).c_str(), mtime + 2, 1, ThumbPackSize::LARGE, failed);
+	ASSERT_NE(kept, nullptr);
+	EXPECT_TRUE(same_pixels(pixbuf, kept));
+
+	EXPECT_EQ(thumb_pack_read(source(1).c_str(), mtime + 1, 1, ThumbPackSize::LARGE, failed), nullptr);
+	EXPECT_TRUE(failed);
+}
+
+}  // anonymous namespace
+
+/* vim: set shiftwidth=8 softtabstop=0 cindent cinoptions={1s: */